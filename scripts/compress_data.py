@@ -0,0 +1,54 @@
+# Сжатие веб-ресурсов перед сборкой образа LittleFS
+#
+# Подключается в platformio.ini: extra_scripts = pre:scripts/compress_data.py
+# Файлы из data/ с текстовыми расширениями сжимаются gzip в .pio/data_gz/,
+# остальные копируются как есть. Образ ФС (pio run -t buildfs / uploadfs)
+# собирается из .pio/data_gz/, исходники в data/ остаются несжатыми.
+# Веб-сервер отдает *.gz с Content-Encoding: gzip и ETag.
+
+import gzip
+import os
+import shutil
+
+Import("env")
+
+COMPRESS_EXTENSIONS = (".html", ".css", ".js", ".json", ".svg", ".txt")
+
+src_dir = env.subst("$PROJECT_DATA_DIR")
+out_dir = os.path.join(env.subst("$PROJECT_WORKSPACE_DIR"), "data_gz")
+
+
+def compress_data_dir():
+    if os.path.isdir(out_dir):
+        shutil.rmtree(out_dir)
+    os.makedirs(out_dir)
+
+    total_src = 0
+    total_out = 0
+    for root, _, files in os.walk(src_dir):
+        rel = os.path.relpath(root, src_dir)
+        dst_root = os.path.normpath(os.path.join(out_dir, rel))
+        os.makedirs(dst_root, exist_ok=True)
+        for name in sorted(files):
+            src = os.path.join(root, name)
+            with open(src, "rb") as f:
+                data = f.read()
+            if name.lower().endswith(COMPRESS_EXTENSIONS):
+                dst = os.path.join(dst_root, name + ".gz")
+                # mtime=0: одинаковый вход -> одинаковый .gz -> стабильный ETag
+                with open(dst, "wb") as f:
+                    f.write(gzip.compress(data, compresslevel=9, mtime=0))
+            else:
+                dst = os.path.join(dst_root, name)
+                shutil.copyfile(src, dst)
+            out_size = os.path.getsize(dst)
+            total_src += len(data)
+            total_out += out_size
+            print("  %-24s %7d -> %7d bytes" % (os.path.relpath(src, src_dir), len(data), out_size))
+
+    print("data/: %d -> %d bytes (%.0f%%)" % (total_src, total_out, 100.0 * total_out / max(total_src, 1)))
+
+
+if os.path.isdir(src_dir):
+    compress_data_dir()
+    env.Replace(PROJECT_DATA_DIR=out_dir)
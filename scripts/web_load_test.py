@@ -0,0 +1,299 @@
+#!/usr/bin/env python3
+# Нагрузочный тест веб-API радио (запускается на ПК, нагрузка идет на реальное устройство)
+#
+#   python3 scripts/web_load_test.py 192.168.1.100 -u admin -p secret -c 4 -d 60
+#
+# Параллельные клиенты гоняют сценарии: список станций, логи, изменение громкости
+# (серия как при перетаскивании слайдера) и загрузку главной страницы. Отчет:
+#   - задержка p50/p99/max по сценариям (со стороны клиента) и ошибки (503, таймауты)
+#   - время обработчиков на устройстве по гистограммам /api/metrics (прирост за тест)
+#   - минимум свободного heap за тест (/api/status, system_heap_min_free_bytes если есть)
+#   - голодание аудио: минимум буфера, доля замеров ниже AUDIO_BUFFER_LOW_THRESHOLD,
+#     переходы в buffering (опрос /api/status)
+# Только стандартная библиотека Python 3.
+
+import argparse
+import http.client
+import json
+import random
+import re
+import threading
+import time
+import urllib.parse
+
+AUDIO_BUFFER_LOW_THRESHOLD = 20  # Как в config.h
+STATUS_POLL_INTERVAL = 0.2       # Частота опроса /api/status (с)
+
+SCENARIOS = ("stations", "logs", "volume", "page")
+
+
+class Device:
+    def __init__(self, host, timeout):
+        self.host = host
+        self.timeout = timeout
+        self.cookie = ""
+
+    # Новое соединение на каждый запрос: AsyncWebServer закрывает keep-alive
+    def request(self, method, path, body=None, headers=None):
+        hdrs = {"Connection": "close"}
+        if self.cookie:
+            hdrs["Cookie"] = self.cookie
+        if body is not None:
+            body = urllib.parse.urlencode(body)
+            hdrs["Content-Type"] = "application/x-www-form-urlencoded"
+        if headers:
+            hdrs.update(headers)
+        conn = http.client.HTTPConnection(self.host, timeout=self.timeout)
+        try:
+            conn.request(method, path, body=body, headers=hdrs)
+            resp = conn.getresponse()
+            data = resp.read()
+            return resp.status, resp.getheaders(), data
+        finally:
+            conn.close()
+
+    def login(self, username, password):
+        status, headers, _ = self.request("POST", "/login",
+                                          {"username": username, "password": password})
+        for name, value in headers:
+            if name.lower() == "set-cookie" and value.startswith("session="):
+                self.cookie = value.split(";", 1)[0]
+        if status != 302 or not self.cookie:
+            raise SystemExit(f"Вход не удался (HTTP {status})")
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latency = {name: [] for name in SCENARIOS}
+        self.errors = {name: {} for name in SCENARIOS}
+
+    def add(self, scenario, seconds, status):
+        with self.lock:
+            if status == 200:
+                self.latency[scenario].append(seconds)
+            else:
+                errs = self.errors[scenario]
+                errs[status] = errs.get(status, 0) + 1
+
+
+def percentile(values, p):
+    if not values:
+        return float("nan")
+    values = sorted(values)
+    index = min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))
+    return values[index]
+
+
+def run_scenario(device, scenario):
+    if scenario == "stations":
+        return device.request("GET", "/api/stations")[0]
+    if scenario == "logs":
+        return device.request("GET", "/api/logs")[0]
+    if scenario == "page":
+        return device.request("GET", "/", headers={"Accept-Encoding": "gzip"})[0]
+    # Перетаскивание слайдера: серия из 5 значений подряд, в зачет идет последний ответ
+    status = 0
+    volume = random.uniform(0.1, 0.9)
+    for _ in range(5):
+        volume = min(1.0, max(0.0, volume + random.uniform(-0.05, 0.05)))
+        status = device.request("POST", "/api/player/volume", {"volume": f"{volume:.2f}"})[0]
+        if status != 200:
+            break
+    return status
+
+
+def client_worker(device, stats, deadline, mix, think):
+    while time.monotonic() < deadline:
+        scenario = random.choice(mix)
+        start = time.monotonic()
+        try:
+            status = run_scenario(device, scenario)
+        except (OSError, http.client.HTTPException):
+            status = "timeout"
+        stats.add(scenario, time.monotonic() - start, status)
+        if think > 0:
+            time.sleep(think)
+
+
+class AudioMonitor(threading.Thread):
+    """Опрашивает /api/status: heap, буфер потока и состояние плеера."""
+
+    def __init__(self, device, deadline):
+        super().__init__(daemon=True)
+        self.device = device
+        self.deadline = deadline
+        self.samples = 0
+        self.heap_min_kb = None
+        self.buffer_min = None
+        self.buffer_low = 0
+        self.buffering_entries = 0
+        self.failed = 0
+        self._last_state = None
+
+    def run(self):
+        while time.monotonic() < self.deadline:
+            try:
+                status, _, data = self.device.request("GET", "/api/status")
+                if status == 200:
+                    self.sample(json.loads(data))
+                else:
+                    self.failed += 1
+            except (OSError, ValueError, http.client.HTTPException):
+                self.failed += 1
+            time.sleep(STATUS_POLL_INTERVAL)
+
+    def sample(self, status):
+        self.samples += 1
+        heap = status.get("heap")
+        if heap is not None:
+            self.heap_min_kb = heap if self.heap_min_kb is None else min(self.heap_min_kb, heap)
+        state = status.get("state")
+        buffer = status.get("buffer")
+        if state == "playing" and buffer is not None and buffer >= 0:
+            self.buffer_min = buffer if self.buffer_min is None else min(self.buffer_min, buffer)
+            if buffer < AUDIO_BUFFER_LOW_THRESHOLD:
+                self.buffer_low += 1
+        if state == "buffering" and self._last_state == "playing":
+            self.buffering_entries += 1
+        self._last_state = state
+
+
+METRIC_LINE = re.compile(r'^([a-zA-Z_:][a-zA-Z0-9_:]*)(\{[^}]*\})?\s+(\S+)$')
+
+
+def read_metrics(device):
+    """Метрики Prometheus как {(имя, метки): значение}."""
+    try:
+        status, _, data = device.request("GET", "/api/metrics")
+    except (OSError, http.client.HTTPException):
+        return {}
+    if status != 200:
+        return {}
+    metrics = {}
+    for line in data.decode("utf-8", "replace").splitlines():
+        match = METRIC_LINE.match(line)
+        if match:
+            try:
+                metrics[(match.group(1), match.group(2) or "")] = float(match.group(3))
+            except ValueError:
+                pass
+    return metrics
+
+
+def device_route_latency(before, after):
+    """Прирост гистограмм web_request_duration_seconds: {route: (count, p50, p99)}."""
+    buckets = {}
+    for (name, labels), value in after.items():
+        if name != "web_request_duration_seconds_bucket":
+            continue
+        le = re.search(r'le="([^"]+)"', labels).group(1)
+        route = re.sub(r',?le="[^"]+"', "", labels)
+        delta = value - before.get((name, labels), 0.0)
+        buckets.setdefault(route, []).append((float("inf") if le == "+Inf" else float(le), delta))
+
+    result = {}
+    for route, items in buckets.items():
+        items.sort()
+        total = items[-1][1]
+        if total <= 0:
+            continue
+        # Верхняя граница корзины, в которую попал перцентиль
+        def bound(p):
+            for le, count in items:
+                if count >= total * p:
+                    return le
+            return float("inf")
+        result[route] = (int(total), bound(0.5), bound(0.99))
+    return result
+
+
+def format_ms(seconds):
+    if seconds != seconds:  # nan
+        return "-"
+    if seconds == float("inf"):
+        return ">max"
+    return f"{seconds * 1000:.1f}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Нагрузочный тест веб-API радио")
+    parser.add_argument("host", help="адрес устройства (ip[:port])")
+    parser.add_argument("-u", "--username", required=True)
+    parser.add_argument("-p", "--password", required=True)
+    parser.add_argument("-c", "--clients", type=int, default=4, help="параллельных клиентов")
+    parser.add_argument("-d", "--duration", type=float, default=30, help="длительность (с)")
+    parser.add_argument("-s", "--scenarios", default=",".join(SCENARIOS),
+                        help="сценарии через запятую: " + ",".join(SCENARIOS))
+    parser.add_argument("--think", type=float, default=0.0, help="пауза клиента между запросами (с)")
+    parser.add_argument("--timeout", type=float, default=10.0, help="таймаут запроса (с)")
+    args = parser.parse_args()
+
+    mix = [s.strip() for s in args.scenarios.split(",") if s.strip()]
+    for s in mix:
+        if s not in SCENARIOS:
+            parser.error(f"неизвестный сценарий: {s}")
+
+    device = Device(args.host, args.timeout)
+    device.login(args.username, args.password)
+    metrics_before = read_metrics(device)
+
+    stats = Stats()
+    deadline = time.monotonic() + args.duration
+    monitor = AudioMonitor(device, deadline)
+    monitor.start()
+    workers = [threading.Thread(target=client_worker,
+                                args=(device, stats, deadline, mix, args.think), daemon=True)
+               for _ in range(args.clients)]
+    for w in workers:
+        w.start()
+    for w in workers:
+        w.join()
+    monitor.join()
+
+    metrics_after = read_metrics(device)
+
+    print(f"\n== Клиент: {args.clients} x {args.duration:.0f} с, сценарии {','.join(mix)} ==")
+    print(f"{'сценарий':<10} {'ok':>6} {'p50 мс':>8} {'p99 мс':>8} {'max мс':>8}  ошибки")
+    for scenario in mix:
+        values = stats.latency[scenario]
+        errors = ", ".join(f"{k}: {v}" for k, v in sorted(stats.errors[scenario].items(), key=str)) or "-"
+        print(f"{scenario:<10} {len(values):>6} {format_ms(percentile(values, 50)):>8} "
+              f"{format_ms(percentile(values, 99)):>8} "
+              f"{format_ms(max(values) if values else float('nan')):>8}  {errors}")
+
+    routes = device_route_latency(metrics_before, metrics_after)
+    if routes:
+        print("\n== Устройство: время обработчика (верхняя граница корзины) ==")
+        print(f"{'маршрут':<48} {'вызовов':>8} {'p50 мс':>8} {'p99 мс':>8}")
+        for route, (count, p50, p99) in sorted(routes.items(), key=lambda r: -r[1][0]):
+            print(f"{route:<48} {count:>8} {format_ms(p50):>8} {format_ms(p99):>8}")
+
+    rejected = {labels: value - metrics_before.get((name, labels), 0.0)
+                for (name, labels), value in metrics_after.items()
+                if name == "web_requests_rejected_total"}
+    if any(rejected.values()):
+        print("Отказы по памяти (503): " +
+              ", ".join(f"{labels} {int(v)}" for labels, v in rejected.items() if v))
+
+    print("\n== Heap и аудио ==")
+    heap_min = metrics_after.get(("system_heap_min_free_bytes", ""))
+    if heap_min is not None:
+        print(f"минимум свободного heap с загрузки: {int(heap_min)} байт")
+    if monitor.heap_min_kb is not None:
+        print(f"минимум свободного heap за тест (опрос): {monitor.heap_min_kb} КБ")
+    print(f"замеров статуса: {monitor.samples} (ошибок {monitor.failed})")
+    if monitor.buffer_min is None:
+        print("аудио не играло - голодание не оценивается")
+    else:
+        share = 100.0 * monitor.buffer_low / max(1, monitor.samples)
+        print(f"буфер потока: минимум {monitor.buffer_min}%, ниже {AUDIO_BUFFER_LOW_THRESHOLD}% "
+              f"в {share:.1f}% замеров, уходов в buffering: {monitor.buffering_entries}")
+    underruns = metrics_after.get(("audio_underruns_total", ""))
+    if underruns is not None:
+        print(f"опустошений буфера за тест: "
+              f"{int(underruns - metrics_before.get(('audio_underruns_total', ''), 0.0))}")
+
+
+if __name__ == "__main__":
+    main()
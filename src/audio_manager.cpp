@@ -9,6 +9,7 @@
 #include "wifi_manager.h"
 #include "url_validator.h"
 #include "string_utils.h"
+#include "telemetry.h"
 #include <WiFi.h>
 
 // --- РЕАЛИЗАЦИЯ ВИЗУАЛИЗАТОРА ЧЕРЕЗ ConsumeSample ---
@@ -47,7 +48,10 @@ public:
         buffer_pos = 0;
     }
     
-    return AudioOutputI2S::ConsumeSample(sample);
+    // false - I2S занят, декодер повторит этот же сэмпл (не считаем дважды)
+    bool consumed = AudioOutputI2S::ConsumeSample(sample);
+    if (consumed) audioDecodedSamples.add();
+    return consumed;
   }
 };
 
@@ -71,6 +75,8 @@ unsigned long audioStateTime = 0;
 // 🎯 Флаг приоритета аудио над display
 std::atomic<bool> audio_decoding_active(false);
 
+unsigned long audioDecodeMicros = 0;
+
 // 🚫 Защита от повторных вызовов next_station во время переключения
 static bool isChangingStation = false;
 
@@ -159,13 +165,26 @@ void IRAM_ATTR loop_audio() {
     if (audioState == AUDIO_PLAYING && mp3 && mp3->isRunning()) {
         // 🎯 Устанавливаем приоритет на время декодирования
         audio_decoding_active.store(true, std::memory_order_relaxed);
+        unsigned long decodeStart = micros();
         
         if (!mp3->loop()) {
             log_message("Поток завершен");
             audioState = AUDIO_IDLE;
         }
         
+        unsigned long decodeSpent = micros() - decodeStart;
+        audioDecodeMicros += decodeSpent;
+        audioDecodeTime.add_micros(decodeSpent);
         audio_decoding_active.store(false, std::memory_order_relaxed);
+        
+        // 📊 Заполнение буфера и опустошения (считается переход в 0, а не каждая итерация)
+        if (buff) {
+            static bool bufferEmpty = false;
+            uint32_t fill = buff->getFillLevel();
+            telemetry_sample_audio_fill(fill * 100 / AUDIO_BUFFER_SIZE);
+            if (fill == 0 && !bufferEmpty) audioUnderruns.add();
+            bufferEmpty = (fill == 0);
+        }
     } else {
         // Не декодируем - сбрасываем флаг
         audio_decoding_active.store(false, std::memory_order_relaxed);
@@ -217,6 +236,30 @@ void IRAM_ATTR previous_station() {
     isChangingStation = false;  // Снимаем блокировку
 }
 
+bool select_station(int index) {
+    if (isChangingStation) return false;
+
+    STATIONS_LOCK();
+    bool valid = index >= 0 && index < (int)stations.size();
+    String name = valid ? stations[index].name : String();
+    STATIONS_UNLOCK();
+    if (!valid) return false;
+
+    isChangingStation = true;
+
+    audioState = AUDIO_IDLE;
+    cleanup_audio();
+    currentStation = index;
+
+    log_message(formatString("Select: %s", name.c_str()));
+
+    reset_inactivity_timer();
+    audioState = AUDIO_IDLE;
+
+    isChangingStation = false;
+    return true;
+}
+
 void IRAM_ATTR set_volume(float new_volume) {
     volume = new_volume;
     if (out_with_visualizer) {
@@ -230,6 +273,11 @@ void force_audio_reset() {
     cleanup_audio();
 }
 
+int get_audio_buffer_fill_percent() {
+    if (audioState != AUDIO_PLAYING || !buff) return -1;
+    return (int)((uint64_t)buff->getFillLevel() * 100 / AUDIO_BUFFER_SIZE);
+}
+
 void cleanup_audio() {
     if (mp3) {
         mp3->stop();
@@ -309,6 +357,7 @@ bool init_audio_non_blocking() {
                 String safeURL = sanitizeURLForLog(url);
                 log_message(formatString("URL: %s", safeURL.c_str()));
                 
+                audioStreamConnects.add();
                 file = new AudioFileSourceHTTPStream(url.c_str());
                 if (file) {
                     buff = new AudioFileSourceBuffer(file, AUDIO_BUFFER_SIZE);
@@ -365,6 +414,7 @@ bool init_audio_non_blocking() {
         }
             
         case AUDIO_ERROR: {
+            audioStationFailures.add();
             log_message("❌ Ошибка подключения к станции. Переключаюсь на следующую...");
             mark_station_as_unavailable(currentStation);
             next_station(); // Автоматически переключаем на следующую
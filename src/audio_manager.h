@@ -22,11 +22,17 @@ extern AudioState audioState;
 // ATOMIC: используется между audio loop и main loop
 extern std::atomic<bool> audio_decoding_active;
 
+// ⏱️ Суммарное время в mp3->loop() (мкс) - для оценки запаса CPU декодера по разнице
+// за окно (переполняется за 71 минуту; накопительный счетчик - audioDecodeTime в telemetry.h)
+extern unsigned long audioDecodeMicros;
+
 void setup_audio();
 void loop_audio();
 void next_station();
 void previous_station();
+bool select_station(int index);  // Переключение на станцию по номеру (false - нет такой)
 void set_volume(float new_volume);
 void force_audio_reset();
+int get_audio_buffer_fill_percent();  // Заполнение буфера потока (0-100), -1 если не играет
 
 #endif // AUDIO_MANAGER_H
@@ -1,6 +1,7 @@
 #include "config.h"
 #include "audio_manager.h"
 #include "display_manager.h"
+#include "telemetry.h"
 #include <LittleFS.h>
 #include <ArduinoJson.h>
 #include <mbedtls/md.h>
@@ -9,6 +10,10 @@
 WiFiCredentials wifiConfig;  // Одна WiFi сеть
 std::vector<RadioStation> stations;
 int totalStations = 0;
+uint32_t stationsRevision = 0;
+uint32_t stationsSavedRevision = 0;
+unsigned long stationsSaveCount = 0;
+unsigned long stationsBytesWritten = 0;
 WebCredentials webCredentials;
 
 // 🛡️ Мьютекс для защиты stations от race condition
@@ -19,7 +24,7 @@ VisualizerStyle visualizerStyle = STYLE_BARS;
 uint8_t displayRotation = 2; // По умолчанию flipped
 
 // Сессия и автологин
-String sessionToken = "";
+char sessionTokens[WEB_SESSION_SLOTS][SESSION_TOKEN_LENGTH + 1] = {{0}};
 int rebootCounter = 0;
 
 // --- Инициализация файловой системы ---
@@ -32,6 +37,7 @@ void setup_filesystem() {
         ESP.restart();
     }
     Serial.println("✅ stationsMutex создан успешно");
+    stationsRevision = esp_random() >> 8;  // Старшие байты остаются запасом до переполнения
     
     if (!LittleFS.begin()) {
         Serial.println("Ошибка монтирования LittleFS!");
@@ -95,7 +101,9 @@ bool save_wifi_config() {
     obj["ssid"] = wifiConfig.ssid;
     obj["password"] = wifiConfig.password;
 
-    if (serializeJson(doc, configFile) == 0) {
+    size_t written = serializeJson(doc, configFile);
+    telemetry_flash_written(written);
+    if (written == 0) {
         Serial.println("Ошибка записи в wifi.json.");
         configFile.close();
         return false;
@@ -108,6 +116,22 @@ bool save_wifi_config() {
 
 // --- Управление конфигурацией станций ---
 
+void mark_stations_changed(size_t from, size_t to) {
+    stationsRevision++;
+    for (size_t i = from; i < to && i < stations.size(); i++) {
+        stations[i].revision = stationsRevision;
+    }
+}
+
+void mark_stations_diff(const std::vector<RadioStation>& before) {
+    stationsRevision++;
+    for (size_t i = 0; i < stations.size(); i++) {
+        if (i >= before.size() || stations[i].name != before[i].name || stations[i].url != before[i].url) {
+            stations[i].revision = stationsRevision;
+        }
+    }
+}
+
 bool load_stations_config() {
     File configFile = LittleFS.open("/stations.json", "r");
     if (!configFile) {
@@ -128,6 +152,7 @@ bool load_stations_config() {
     }
 
     JsonArray array = doc.as<JsonArray>();
+    STATIONS_LOCK();
     stations.clear();
     for (JsonObject obj : array) {
         stations.push_back({
@@ -137,6 +162,9 @@ bool load_stations_config() {
         });
     }
     totalStations = stations.size();
+    mark_stations_changed(0, stations.size());
+    stationsSavedRevision = stationsRevision;
+    STATIONS_UNLOCK();
     Serial.println("Конфигурация станций загружена.");
     return true;
 }
@@ -151,13 +179,16 @@ bool save_stations_config() {
     JsonDocument doc;
     JsonArray array = doc.to<JsonArray>();
 
+    uint32_t savingRevision = stationsRevision;
     for (const auto& station : stations) {
         JsonObject obj = array.add<JsonObject>();
         obj["name"] = station.name;
         obj["url"] = station.url;
     }
 
-    if (serializeJson(doc, configFile) == 0) {
+    size_t written = serializeJson(doc, configFile);
+    telemetry_flash_written(written);
+    if (written == 0) {
         Serial.println("Ошибка записи в stations.json.");
         configFile.close();
         return false;
@@ -165,7 +196,11 @@ bool save_stations_config() {
 
     configFile.close();
     totalStations = stations.size();
-    Serial.println("Конфигурация станций сохранена.");
+    stationsSavedRevision = savingRevision;
+    stationsSaveCount++;
+    stationsBytesWritten += written;
+    Serial.printf("Конфигурация станций сохранена (%u байт, всего %lu записей / %lu байт).\n",
+                  (unsigned)written, stationsSaveCount, stationsBytesWritten);
     return true;
 }
 
@@ -192,12 +227,25 @@ bool load_state() {
     displayRotation = doc["displayRotation"] | 2; // default: 2 (flipped)
     visualizerStyle = (VisualizerStyle)(doc["visualizerStyle"] | STYLE_BARS);
     
-    // Загружаем сессию и счетчик перезагрузок
-    sessionToken = doc["sessionToken"] | "";
+    // Загружаем сессии и счетчик перезагрузок
+    memset(sessionTokens, 0, sizeof(sessionTokens));
+    int sessions = 0;
+    JsonArrayConst tokens = doc["sessions"].as<JsonArrayConst>();
+    if (tokens.isNull() && doc["sessionToken"].is<const char*>()) {
+        // state.json до таблицы сессий: один общий токен
+        const char* legacy = doc["sessionToken"];
+        if (strlen(legacy) == SESSION_TOKEN_LENGTH) strlcpy(sessionTokens[sessions++], legacy, SESSION_TOKEN_LENGTH + 1);
+    }
+    for (JsonVariantConst token : tokens) {
+        const char* value = token | "";
+        if (sessions < WEB_SESSION_SLOTS && strlen(value) == SESSION_TOKEN_LENGTH) {
+            strlcpy(sessionTokens[sessions++], value, SESSION_TOKEN_LENGTH + 1);
+        }
+    }
     rebootCounter = doc["rebootCounter"] | 0;
     
-    if (sessionToken.length() > 0) {
-        Serial.printf("🔑 Session token загружен: %s...\n", sessionToken.substring(0, 8).c_str());
+    if (sessions > 0) {
+        Serial.printf("🔑 Сессий загружено: %d\n", sessions);
     } else {
         Serial.println("❌ Session token отсутствует.");
     }
@@ -208,7 +256,7 @@ bool load_state() {
     // Каждые 25 перезагрузок - очищаем сессию
     if (rebootCounter >= 25) {
         Serial.println("❗ 25 перезагрузок - очистка сессии!");
-        sessionToken = "";
+        memset(sessionTokens, 0, sizeof(sessionTokens));
         rebootCounter = 0;
     }
     
@@ -230,10 +278,15 @@ void save_state() {
     doc["station"] = currentStation;
     doc["displayRotation"] = displayRotation;
     doc["visualizerStyle"] = (int)visualizerStyle;
-    doc["sessionToken"] = sessionToken;
+    JsonArray tokens = doc["sessions"].to<JsonArray>();
+    for (int i = 0; i < WEB_SESSION_SLOTS; i++) {
+        if (sessionTokens[i][0] != '\0') tokens.add(sessionTokens[i]);
+    }
     doc["rebootCounter"] = rebootCounter;
 
-    if (serializeJson(doc, configFile) == 0) {
+    size_t written = serializeJson(doc, configFile);
+    telemetry_flash_written(written);
+    if (written == 0) {
         Serial.println("Ошибка записи в state.json.");
     } else {
         Serial.println("Состояние сохранено.");
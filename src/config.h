@@ -22,17 +22,30 @@
 //   GPIO2, 3, 10    - Энкодер KY-040
 //   GPIO4, 5, 6     - I2S (MAX98357A)
 //   GPIO8, 9        - I2C (OLED SSD1306)
+//                     или SCK/MOSI при -DDISPLAY_TRANSPORT_SPI
 //
 // СВОБОДНЫЕ: GPIO20, GPIO21 (для будущих расширений)
+//            при SPI OLED заняты под DC и CS
 // ========================================
 
 // === OLED ДИСПЛЕЙ ===
 #define OLED_SDA 8
 #define OLED_SCL 9
 #define OLED_RESET -1
+#define OLED_I2C_ADDRESS 0x3C
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 32
 
+// === OLED SPI (опционально, сборка с -DDISPLAY_TRANSPORT_SPI) ===
+// Используются пины I2C + свободные GPIO20/21, RST модуля на EN или RC-цепочку
+#define OLED_SPI_SCK   8         // Вместо SDA
+#define OLED_SPI_MOSI  9         // Вместо SCL
+#define OLED_SPI_DC    20
+#define OLED_SPI_CS    21
+#define OLED_SPI_FREQ  8000000   // 8 MHz - SSD1306 держит до 10 MHz (tCYCLE 100ns)
+
+#define DISPLAY_BUS_BENCHMARK_FRAMES 50  // Кадров в бенчмарке шины (-DDISPLAY_BUS_BENCHMARK)
+
 // === I2C КОНФИГУРАЦИЯ ===
 #define I2C_FAST_MODE_FREQ          400000   // Частота I2C Fast Mode (400kHz) - оптимально для OLED
 #define I2C_STANDARD_MODE_FREQ      100000   // Частота I2C Standard Mode (100kHz)
@@ -66,6 +79,7 @@
 #define WIFI_AUTO_RECONNECT_INTERVAL 10000   // Интервал проверки авто-реконнекта (10 сек)
 #define WIFI_MANUAL_RECONNECT_TIMEOUT 50000  // Время на ручное переподключение (50 сек)
 #define WIFI_REBOOT_COUNTDOWN       5        // Обратный отсчет перед перезагрузкой (секунды)
+#define WIFI_APPLY_DELAY            500      // Пауза между ответом на /save и сменой AP -> STA (мс)
 
 #define SYSTEM_STATUS_INTERVAL      60000    // Интервал вывода статуса системы
 
@@ -77,7 +91,31 @@
 
 #define DISPLAY_INACTIVITY_TIMEOUT  15000    // Таймаут неактивности для визуализатора
 #define DISPLAY_INIT_DELAY          1000     // Задержка после инициализации дисплея
-// 📝 Дисплей: 60 FPS (16ms), I2C 400 kHz, приоритет аудио (в main.cpp)
+#define DISPLAY_RSSI_POLL_INTERVAL  1000     // Как часто опрашивать WiFi.RSSI() для INFO экрана (мс)
+#define DISPLAY_RSSI_BUCKET         2        // Шаг округления RSSI на экране (dBm) - гасит дрожание ±1
+#define DISPLAY_MARQUEE_STEP_MS     40       // Бегущая строка: сдвиг на 1 пиксель каждые 40мс (25 px/s)
+#define DISPLAY_MARQUEE_PAUSE_MS    1500     // Пауза в начале каждого круга бегущей строки
+#define DISPLAY_MARQUEE_GAP         24       // Отступ между концом и началом текста (пикселей)
+#define DISPLAY_MARQUEE_MAX_WIDTH   384      // Максимальная ширина pre-rendered полосы (64 символа)
+// 📝 Дисплей: до 60 FPS (16ms), I2C 400 kHz, приоритет аудио (frame_pacer.cpp)
+// 📝 Статичные экраны (INFO, AP_MODE, MESSAGE) перерисовываются только при смене render key
+
+// === СКАН СЕТЕЙ В РЕЖИМЕ AP (wifi_scan.cpp) ===
+#define WIFI_SCAN_INTERVAL          30000    // Фоновое обновление, пока к точке доступа кто-то подключен (мс)
+#define WIFI_SCAN_MIN_AGE           10000    // /api/scan моложе этого не пересканирует - отдаст кэш (мс)
+#define WIFI_SCAN_MAX_NETWORKS      16       // Сетей в кэше (после слияния по SSID, сильнейшие)
+#define WIFI_SCAN_JSON_SIZE         1536     // Буфер готового JSON списка сетей
+
+// === АДАПТИВНЫЙ FPS ДИСПЛЕЯ (frame_pacer.cpp) ===
+#define PACER_FPS_MAX               60       // FPS при здоровом буфере и свободном CPU
+#define PACER_FPS_MIN               10       // FPS при почти пустом буфере
+#define PACER_FPS_STEP              10       // Шаг квантования целевого FPS (меньше дрожания и логов)
+#define PACER_BUFFER_HEALTHY        50       // Заполнение буфера (%), начиная с которого FPS максимален
+#define PACER_DECODE_SHARE_LOW      30       // Доля декодера в секунде (%), до которой FPS не снижается
+#define PACER_DECODE_SHARE_HIGH     70       // Доля декодера в секунде (%), при которой FPS минимален
+#define PACER_DISPLAY_BUDGET        25       // Максимум процентов каждой секунды на дисплей (остальное - аудио)
+#define PACER_WINDOW_MS             1000     // Окно учета времени
+#define PACER_LOG_INTERVAL          5000     // Не чаще одного лога смены FPS (мс)
 
 #define VOLUME_STEP                 0.02f    // Шаг изменения громкости
 #define VOLUME_MIN                  0.0f     // Минимальная громкость
@@ -91,6 +129,62 @@
 #define VISUALIZER_MAX_AMPLITUDE    15000    // Максимальная амплитуда для map() (int16_t диапазон)
 #define VISUALIZER_MIN_STACK        512      // Минимум свободного стека для безопасной обработки (байт)
 
+// === ВЕБ-СЕРВЕР: ОТДАЧА ФАЙЛОВ ===
+// AsyncTCP (приоритет 5) вытесняет loop() с аудио на одноядерном C3,
+// поэтому файлы читаются из LittleFS небольшими кусками - по одному на ACK клиента
+#define WEB_FILE_CHUNK_MAX          1436     // Максимальный кусок (≈ один TCP сегмент)
+#define WEB_FILE_CHUNK_MIN          256      // Минимальный кусок
+#define WEB_FILE_CHUNK_BUDGET_US    1000     // Бюджет CPU на чтение одного куска (мкс)
+
+// === ВЕБ-СЕРВЕР: LIVE СТАТУС (SSE /api/events) ===
+#define WEB_EVENTS_MAX_CLIENTS      3        // Одновременных подписчиков (остальным - отказ с retry)
+#define WEB_EVENTS_CLIENT_QUEUE     4        // Недоставленных событий на клиента, после - изменения копятся
+#define WEB_EVENTS_INTERVAL         250      // Не чаще одного события в 250мс (debounce)
+#define WEB_EVENTS_BUFFER_STEP      5        // Шаг заполнения буфера (%) - гасит дрожание
+#define WEB_EVENTS_RSSI_STEP        3        // Шаг RSSI (dBm)
+#define WEB_EVENTS_BUSY_RETRY       30000    // Через сколько отвергнутый клиент переподключится (мс)
+#define WEB_STATUS_BUFFER_SIZE      384      // Буфер снапшота /api/status (полный статус ~200 байт + название станции)
+#define WEB_STATUS_NAME_MAX         64       // Название станции в статусе обрезается до 64 символов
+
+// === ВЕБ-СЕРВЕР: ЛОГИ (/api/logs, SSE /api/logs/tail) ===
+#define WEB_LOG_TAIL_BYTES          8192     // /api/logs без смещения - последние 8KB
+#define WEB_LOG_TAIL_CHUNK          1024     // Максимум байт лога в одном событии SSE
+#define WEB_LOG_TAIL_MAX_CLIENTS    2        // Одновременных подписчиков хвоста лога
+
+// === ВЕБ-СЕРВЕР: КАНАЛ УПРАВЛЕНИЯ (WebSocket /api/control) ===
+#define WEB_CONTROL_MAX_CLIENTS     2        // Одновременных подключений к каналу управления
+
+// === ВЕБ-СЕРВЕР: СПЕКТР (WebSocket /api/spectrum) ===
+#define WEB_SPECTRUM_MAX_CLIENTS    2        // Одновременных подписчиков спектра
+#define WEB_SPECTRUM_FPS_DEFAULT    20       // Кадров/с, пока клиент не запросил другую частоту
+#define WEB_SPECTRUM_FPS_MIN        5
+#define WEB_SPECTRUM_FPS_MAX        30
+
+// === ВЕБ-СЕРВЕР: ЗЕРКАЛО OLED (WebSocket /api/display/mirror) ===
+#define WEB_MIRROR_MAX_CLIENTS      2        // Одновременных зрителей экрана
+#define WEB_MIRROR_FPS_MAX          15       // Не чаще, промежуточные flush сливаются в одну дельту
+
+// === ВЕБ-СЕРВЕР: УЧЕТ МАРШРУТОВ (/api/metrics) ===
+#define WEB_ROUTE_STATS_MAX         48       // Маршрутов с гистограммами (STA + AP)
+
+// === ТЕЛЕМЕТРИЯ (telemetry.cpp, /api/metrics) ===
+#define TELEMETRY_FILL_SAMPLE_INTERVAL 100   // Замер заполнения буфера для гистограммы (мс)
+
+// === ВЕБ-СЕРВЕР: ДОПУСК ПО ПАМЯТИ (защита аудио) ===
+#define WEB_ADMIT_MIN_FREE_HEAP     24576    // Свободный heap (за вычетом резерва потоковых ответов), ниже - 503
+#define WEB_ADMIT_MIN_BLOCK         8192     // Наибольший свободный блок, ниже - 503 (AsyncTCP, pbuf lwIP)
+#define WEB_ADMIT_STREAM_COST       3072     // Резерв на один потоковый ответ в полете (буферы TCP)
+#define WEB_ADMIT_MAX_STREAMS       4        // Потоковых ответов в полете одновременно
+#define WEB_ADMIT_RETRY_AFTER       2        // Retry-After для 503 (секунды)
+
+// === ВЕБ-СЕРВЕР: JSON ОТВЕТЫ (json_writer.h) ===
+#define WEB_JSON_STREAM_BUFFER      256      // Начальный буфер AsyncResponseStream для коротких JSON
+
+// === ВЕБ-СЕРВЕР: ИМПОРТ СТАНЦИЙ ===
+#define WEB_IMPORT_ENTRY_MAX        2560     // Буфер одной станции при импорте (URL до 2048 + имя)
+#define WEB_IMPORT_MAX_DEPTH        8        // Максимальная вложенность JSON внутри станции
+#define STATIONS_IMPORT_TEMP        "/stations.tmp"  // Временный файл импорта (заменяет stations.json через rename)
+
 // === FREERTOS КОНФИГУРАЦИЯ ===
 #define COMMAND_QUEUE_SIZE          10       // Размер очереди команд между веб-сервером и основным loop
 
@@ -120,11 +214,31 @@ struct RadioStation {
     String name;
     String url;
     bool isAvailable;
+    uint32_t revision;  // stationsRevision, при которой эта позиция списка последний раз менялась
 };
 
 extern std::vector<RadioStation> stations;
 extern int totalStations;
 
+// === РЕВИЗИЯ СПИСКА СТАНЦИЙ ===
+// Растет при каждом изменении списка (ETag /api/stations, дельты ?since=rev).
+// Начинается со случайного значения - ревизии разных загрузок не путаются.
+extern uint32_t stationsRevision;
+extern uint32_t stationsSavedRevision;  // Ревизия, записанная в /stations.json (ETag экспорта)
+
+// Новая ревизия + отметка позиций [from, to) как измененных.
+// После вставки/удаления отмечать все сдвинувшиеся позиции до конца списка.
+// Вызывать под STATIONS_LOCK
+void mark_stations_changed(size_t from, size_t to);
+
+// Новая ревизия + отметка позиций, отличающихся от before (после пакетного изменения).
+// Вызывать под STATIONS_LOCK
+void mark_stations_diff(const std::vector<RadioStation>& before);
+
+// 📊 Запись /stations.json: сколько раз и сколько байт (без служебных данных LittleFS)
+extern unsigned long stationsSaveCount;
+extern unsigned long stationsBytesWritten;
+
 // === ЗАЩИТА ОТ RACE CONDITION ===
 // Мьютекс для защиты stations вектора от одновременного доступа
 // из main loop (audio) и асинхронного веб-сервера
@@ -148,8 +262,9 @@ extern uint8_t displayRotation; // 0=Normal, 2=Flipped 180°
 
 // === СЕССИЯ И АВТОЛОГИН ===
 #define SESSION_TOKEN_LENGTH        32       // Длина токена сессии (символов)
+#define WEB_SESSION_SLOTS           4        // Одновременных сессий (web_session.h)
 
-extern String sessionToken;      // Токен для автоматического входа
+extern char sessionTokens[WEB_SESSION_SLOTS][SESSION_TOKEN_LENGTH + 1];  // Токены автологина, "" - слот свободен
 extern int rebootCounter;        // Счетчик перезагрузок (очистка каждые 25)
 
 // === ФУНКЦИИ УПРАВЛЕНИЯ КОНФИГУРАЦИЕЙ ===
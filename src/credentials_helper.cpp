@@ -1,4 +1,5 @@
 #include "config.h"
+#include "telemetry.h"
 #include <LittleFS.h>
 #include <ArduinoJson.h>
 #include <mbedtls/md.h>
@@ -74,7 +75,9 @@ bool save_credentials(const String& username, const String& password) {
     doc["username"] = username;
     doc["passwordHash"] = passwordHash;
 
-    if (serializeJson(doc, configFile) == 0) {
+    size_t written = serializeJson(doc, configFile);
+    telemetry_flash_written(written);
+    if (written == 0) {
         Serial.println("Ошибка записи в credentials.json.");
         configFile.close();
         return false;
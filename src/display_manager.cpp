@@ -1,12 +1,23 @@
 #include <Wire.h>
+#include <SPI.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include <WiFi.h>
 #include "config.h"
 #include "display_manager.h"
 #include "audio_manager.h"
+#include "telemetry.h"
 
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+// === ТРАНСПОРТ OLED (выбирается при сборке) ===
+// По умолчанию I2C 400 kHz. С -DDISPLAY_TRANSPORT_SPI - SPI на OLED_SPI_FREQ.
+// Весь код отрисовки общий, различаются только функции display_transport_*.
+#ifdef DISPLAY_TRANSPORT_SPI
+Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &SPI, OLED_SPI_DC, OLED_RESET, OLED_SPI_CS, OLED_SPI_FREQ);
+#else
+// Частота и после транзакций библиотеки: по умолчанию Adafruit возвращает 100 kHz,
+// и бегущая строка (display_transport_write_data) шла бы вчетверо медленнее
+Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET, I2C_FAST_MODE_FREQ, I2C_FAST_MODE_FREQ);
+#endif
 DisplayMode currentDisplayMode = INFO;
 unsigned long lastInteractionTime = 0;
 const unsigned long inactivityTimeout = DISPLAY_INACTIVITY_TIMEOUT;
@@ -26,6 +37,299 @@ bool ip_display_paused = false;
 // Для плавной шкалы громкости
 float displayVolume = 0.0;
 
+// === МЕМОИЗАЦИЯ СТАТИЧНЫХ ЭКРАНОВ ===
+// INFO, AP_MODE и MESSAGE меняются несколько раз в минуту, а loop_display()
+// вызывается до 60 раз в секунду. Ключ содержит все входные данные экрана:
+// если он не изменился - пропускаем и отрисовку, и flush по I2C.
+struct RenderKey {
+    DisplayMode mode;
+    uint8_t rotation;
+    bool wifiConnected;
+    int station;
+    int rssi;           // Уже округлен до DISPLAY_RSSI_BUCKET
+    int volumeFill;     // Ширина заливки шкалы громкости в пикселях
+    uint32_t textHash;  // Хеш текста экрана (имя станции / сообщение / IP)
+    int scroll;         // Сдвиг бегущей строки (0 если текст помещается)
+
+    // Совпадает всё, кроме сдвига бегущей строки
+    bool sameContent(const RenderKey& other) const {
+        return mode == other.mode && rotation == other.rotation &&
+               wifiConnected == other.wifiConnected && station == other.station &&
+               rssi == other.rssi && volumeFill == other.volumeFill &&
+               textHash == other.textHash;
+    }
+
+    bool operator==(const RenderKey& other) const {
+        return sameContent(other) && scroll == other.scroll;
+    }
+};
+
+static RenderKey lastRenderKey;
+static bool renderKeyValid = false;
+
+unsigned long displayFramesRendered = 0;
+unsigned long displayFramesSkipped = 0;
+
+// Хеши текста считаются один раз при изменении, а не каждый кадр
+static uint32_t apScreenHash = 0;
+static uint32_t messageScreenHash = 0;
+
+// RSSI опрашиваем не чаще DISPLAY_RSSI_POLL_INTERVAL
+static int cachedRssiBucket = 0;
+static unsigned long lastRssiPoll = 0;
+
+// === УЧЕТ ШИНЫ ДИСПЛЕЯ ===
+#define DISPLAY_BUFFER_BYTES  (SCREEN_WIDTH * SCREEN_HEIGHT / 8)
+#ifdef DISPLAY_TRANSPORT_SPI
+// SPI: команды и данные идут без префиксов (D/C линией): 5 + 1 команд + буфер
+#define DISPLAY_COMMAND_BUS_BYTES    1
+#define DISPLAY_FULL_FRAME_BUS_BYTES (6 + DISPLAY_BUFFER_BYTES)
+#else
+// Байт по I2C за один display() в Adafruit_SSD1306 (адресные байты не считаем):
+// список команд 1+5, COLUMNADDR end 1+1, буфер + control byte на каждые 127 байт
+#define DISPLAY_COMMAND_BUS_BYTES    2
+#define DISPLAY_FULL_FRAME_BUS_BYTES (8 + DISPLAY_BUFFER_BYTES + (DISPLAY_BUFFER_BYTES + 126) / 127)
+#endif
+
+unsigned long displayFlushes = 0;
+unsigned long displayBusBytes = 0;
+unsigned long displayBusMicros = 0;
+unsigned long displayLastFlushBytes = 0;
+
+// Наблюдатель flush (зеркало экрана в веб-интерфейсе): получает буфер сразу после отправки на OLED
+static DisplayFlushHook flushHook = nullptr;
+
+void set_display_flush_hook(DisplayFlushHook hook) {
+    flushHook = hook;
+}
+
+// Все полные кадры уходят на OLED только через эту функцию
+static void flush_display() {
+    unsigned long t0 = micros();
+    display.display();
+    unsigned long spent = micros() - t0;
+    displayBusMicros += spent;
+    displayBusTime.add_micros(spent);
+    displayFlushes++;
+    displayBusBytes += DISPLAY_FULL_FRAME_BUS_BYTES;
+    displayLastFlushBytes = DISPLAY_FULL_FRAME_BUS_BYTES;
+    if (flushHook) flushHook(display.getBuffer());
+}
+
+// Инициализация шины и контроллера
+static bool display_transport_begin() {
+#ifdef DISPLAY_TRANSPORT_SPI
+    // periphBegin=false: SPI.begin() без аргументов занял бы пины I2S (GPIO4-6)
+    SPI.begin(OLED_SPI_SCK, -1, OLED_SPI_MOSI, -1);
+    return display.begin(SSD1306_SWITCHCAPVCC, 0, true, false);
+#else
+    // ⚡ Fast Mode I2C (I2C_FAST_MODE_FREQ) для уменьшения времени блокировки
+    // Стандартный режим: 100 kHz (~10-15ms на кадр)
+    // Fast Mode: 400 kHz (~3-5ms на кадр)
+    Wire.begin(OLED_SDA, OLED_SCL);
+    Wire.setClock(I2C_FAST_MODE_FREQ);
+    return display.begin(SSD1306_SWITCHCAPVCC, OLED_I2C_ADDRESS);
+#endif
+}
+
+static void display_transport_end() {
+#ifdef DISPLAY_TRANSPORT_SPI
+    SPI.end();
+#else
+    Wire.end();
+#endif
+}
+
+// Отправка блока данных в GDDRAM (после PAGEADDR/COLUMNADDR)
+// Возвращает число байт на шине
+static unsigned long display_transport_write_data(const uint8_t* data, int len) {
+#ifdef DISPLAY_TRANSPORT_SPI
+    SPI.beginTransaction(SPISettings(OLED_SPI_FREQ, MSBFIRST, SPI_MODE0));
+    digitalWrite(OLED_SPI_DC, HIGH);  // D/C=1: данные
+    digitalWrite(OLED_SPI_CS, LOW);
+    SPI.writeBytes(data, len);
+    digitalWrite(OLED_SPI_CS, HIGH);
+    SPI.endTransaction();
+    return len;
+#else
+    unsigned long bytes = 0;
+    while (len > 0) {
+        int chunk = min(len, 32);  // Wire буфер ESP32 - 128 байт, берем с запасом
+        Wire.beginTransmission(OLED_I2C_ADDRESS);
+        Wire.write((uint8_t)0x40); // Co=0, D/C=1: далее данные
+        Wire.write(data, chunk);
+        Wire.endTransmission();
+        bytes += chunk + 1;
+        data += chunk;
+        len -= chunk;
+    }
+    return bytes;
+#endif
+}
+
+static const char* display_transport_name() {
+#ifdef DISPLAY_TRANSPORT_SPI
+    return "SPI";
+#else
+    return "I2C";
+#endif
+}
+
+static unsigned long display_transport_freq() {
+#ifdef DISPLAY_TRANSPORT_SPI
+    return OLED_SPI_FREQ;
+#else
+    return I2C_FAST_MODE_FREQ;
+#endif
+}
+
+// FNV-1a: дешевый хеш для коротких строк
+static uint32_t hash_text(const char* text, uint32_t seed = 2166136261u) {
+    uint32_t hash = seed;
+    while (*text) {
+        hash ^= (uint8_t)*text++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// true - экран нужно перерисовать (ключ запоминается)
+static bool render_key_changed(const RenderKey& key) {
+    if (renderKeyValid && key == lastRenderKey) {
+        displayFramesSkipped++;
+        return false;
+    }
+    lastRenderKey = key;
+    renderKeyValid = true;
+    displayFramesRendered++;
+    return true;
+}
+
+// Анимированные экраны (визуализатор, IP, выключение) рисуются каждый кадр без ключа.
+// Поверх них лежит уже не последний запомненный кадр - следующий экран с ключом
+// обязан перерисоваться, даже если его содержимое не изменилось
+static void render_unkeyed_frame() {
+    renderKeyValid = false;
+    displayFramesRendered++;
+}
+
+static int poll_rssi_bucket() {
+    unsigned long now = millis();
+    if (lastRssiPoll == 0 || now - lastRssiPoll >= DISPLAY_RSSI_POLL_INTERVAL) {
+        lastRssiPoll = now;
+        int rssi = WiFi.RSSI();
+        // Округляем к ближайшему шагу (RSSI отрицательный)
+        cachedRssiBucket = -(((-rssi) + DISPLAY_RSSI_BUCKET / 2) / DISPLAY_RSSI_BUCKET) * DISPLAY_RSSI_BUCKET;
+    }
+    return cachedRssiBucket;
+}
+
+// === БЕГУЩАЯ СТРОКА (MARQUEE) ===
+// Длинное имя станции рендерится через Adafruit GFX ОДИН раз в off-screen
+// полосу высотой 8px (1 байт = 1 столбец, как страница SSD1306). Каждый кадр
+// анимации - это копирование окна из полосы в буфер дисплея и flush только
+// одной страницы вместо print() + полного display() (512 байт).
+// Аппаратный scroll SSD1306 не подходит: он двигает всю страницу вместе с RSSI.
+class MarqueeStrip : public Adafruit_GFX {
+public:
+    uint8_t columns[DISPLAY_MARQUEE_MAX_WIDTH];
+    int16_t length;     // Ширина текста + DISPLAY_MARQUEE_GAP
+
+    MarqueeStrip() : Adafruit_GFX(DISPLAY_MARQUEE_MAX_WIDTH, 8), length(0) {}
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        if (x < 0 || x >= DISPLAY_MARQUEE_MAX_WIDTH || y < 0 || y >= 8) return;
+        if (color == SSD1306_WHITE) {
+            columns[x] |= (1 << y);
+        } else {
+            columns[x] &= ~(1 << y);
+        }
+    }
+
+    void render(const char* text) {
+        memset(columns, 0, sizeof(columns));
+        setTextWrap(false);
+        setTextSize(1);
+        setTextColor(SSD1306_WHITE);
+        setCursor(0, 0);
+        print(text);
+        length = min((int)(strlen(text) * 6 + DISPLAY_MARQUEE_GAP), DISPLAY_MARQUEE_MAX_WIDTH);
+    }
+};
+
+static MarqueeStrip marqueeStrip;
+static uint32_t marqueeTextHash = 0;
+static unsigned long marqueeStartTime = 0;
+static int marqueeAreaWidth = 0;    // Ширина области имени (0 - бегущая строка выключена)
+
+unsigned long marqueeFrames = 0;
+unsigned long marqueeMicros = 0;
+unsigned long marqueeBusBytes = 0;
+
+static inline uint8_t reverse_bits(uint8_t b) {
+    b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+    b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+    b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+    return b;
+}
+
+// Текущий сдвиг: пауза в начале круга, затем 1px каждые DISPLAY_MARQUEE_STEP_MS
+static int marquee_offset() {
+    unsigned long period = DISPLAY_MARQUEE_PAUSE_MS + (unsigned long)marqueeStrip.length * DISPLAY_MARQUEE_STEP_MS;
+    unsigned long t = (millis() - marqueeStartTime) % period;
+    if (t < DISPLAY_MARQUEE_PAUSE_MS) return 0;
+    return (t - DISPLAY_MARQUEE_PAUSE_MS) / DISPLAY_MARQUEE_STEP_MS;
+}
+
+// Физическая страница первой текстовой строки (y=0..7) с учетом поворота
+static inline uint8_t marquee_page() {
+    return displayRotation == 2 ? (SCREEN_HEIGHT / 8 - 1) : 0;
+}
+
+// Копирует окно полосы в буфер дисплея напрямую (без GFX)
+// Поддерживаются повороты 0 и 2 (единственные, что разрешает API)
+static void marquee_blit(int offset) {
+    uint8_t* row = display.getBuffer() + marquee_page() * SCREEN_WIDTH;
+    int src = offset % marqueeStrip.length;
+    for (int x = 0; x < marqueeAreaWidth; x++) {
+        uint8_t column = marqueeStrip.columns[src];
+        if (displayRotation == 2) {
+            row[SCREEN_WIDTH - 1 - x] = reverse_bits(column);
+        } else {
+            row[x] = column;
+        }
+        if (++src >= marqueeStrip.length) src = 0;
+    }
+}
+
+// Отправка на OLED только столбцов области имени в одной странице
+static void marquee_flush() {
+    uint8_t page = marquee_page();
+    int colStart = displayRotation == 2 ? SCREEN_WIDTH - marqueeAreaWidth : 0;
+    int colEnd = colStart + marqueeAreaWidth - 1;
+
+    unsigned long t0 = micros();
+    unsigned long bytes = 6 * DISPLAY_COMMAND_BUS_BYTES;
+    display.ssd1306_command(SSD1306_PAGEADDR);
+    display.ssd1306_command(page);
+    display.ssd1306_command(page);
+    display.ssd1306_command(SSD1306_COLUMNADDR);
+    display.ssd1306_command(colStart);
+    display.ssd1306_command(colEnd);
+
+    const uint8_t* data = display.getBuffer() + page * SCREEN_WIDTH + colStart;
+    bytes += display_transport_write_data(data, marqueeAreaWidth);
+
+    marqueeBusBytes += bytes;
+    displayLastFlushBytes = bytes;
+    displayFlushes++;
+    displayBusBytes += bytes;
+    unsigned long spent = micros() - t0;
+    displayBusMicros += spent;
+    displayBusTime.add_micros(spent);
+    if (flushHook) flushHook(display.getBuffer());
+}
+
 void draw_info_screen();
 void draw_visualizer();
 void draw_ap_mode_screen();
@@ -37,16 +341,30 @@ void draw_shutdown_screen();
 static bool displayInitialized = false;
 static unsigned long lastDisplayInitAttempt = 0;
 
+// === БЕНЧМАРК ШИНЫ (-DDISPLAY_BUS_BENCHMARK) ===
+// Гоняет DISPLAY_BUS_BENCHMARK_FRAMES полных кадров при старте и печатает
+// время на кадр. Собрать с I2C и с SPI и сравнить две строки в Serial.
+#ifdef DISPLAY_BUS_BENCHMARK
+static void run_display_bus_benchmark() {
+    display.clearDisplay();
+    for (int i = 0; i < DISPLAY_BUFFER_BYTES; i += 2) {
+        display.getBuffer()[i] = 0xAA;  // Шахматка - не пустой кадр
+    }
+    unsigned long t0 = micros();
+    for (int i = 0; i < DISPLAY_BUS_BENCHMARK_FRAMES; i++) {
+        display.display();
+    }
+    unsigned long perFrame = (micros() - t0) / DISPLAY_BUS_BENCHMARK_FRAMES;
+    Serial.printf("⏱️ Бенчмарк шины OLED [%s %lu Hz]: %lu мкс/кадр, %d байт/кадр, макс %lu FPS\n",
+                  display_transport_name(), display_transport_freq(), perFrame,
+                  DISPLAY_FULL_FRAME_BUS_BYTES, perFrame > 0 ? 1000000UL / perFrame : 0);
+}
+#endif
+
 void setup_display() {
-    Wire.begin(OLED_SDA, OLED_SCL);
-    
-    // ⚡ Fast Mode I2C (I2C_FAST_MODE_FREQ) для уменьшения времени блокировки
-    // Стандартный режим: 100 kHz (~10-15ms на кадр)
-    // Fast Mode: 400 kHz (~3-5ms на кадр)
-    Wire.setClock(I2C_FAST_MODE_FREQ);
-    Serial.printf("⚡ I2C Fast Mode: %d Hz\n", I2C_FAST_MODE_FREQ);
+    Serial.printf("⚡ OLED шина: %s %lu Hz\n", display_transport_name(), display_transport_freq());
     
-    if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
+    if (!display_transport_begin()) {
         Serial.printf("⚠️ ОЛЕД не найден! Повторные попытки каждые %d мс...\n", I2C_RETRY_INTERVAL);
         displayInitialized = false;
         lastDisplayInitAttempt = millis();
@@ -54,14 +372,18 @@ void setup_display() {
     }
     
     displayInitialized = true;
-    Serial.printf("✅ OLED инициализирован успешно (0x3C, %dkHz)\n", I2C_FAST_MODE_FREQ / 1000);
+    Serial.printf("✅ OLED инициализирован успешно (%s, %lukHz)\n", display_transport_name(), display_transport_freq() / 1000);
+    
+#ifdef DISPLAY_BUS_BENCHMARK
+    run_display_bus_benchmark();
+#endif
     
     display.setRotation(displayRotation); // Применяем сохраненную настройку
     display.clearDisplay();
     display.setTextSize(1);
     display.setTextColor(SSD1306_WHITE);
     display.println("Radio Ready!");
-    display.display();
+    flush_display();
     delay(DISPLAY_INIT_DELAY);
     reset_inactivity_timer();
 }
@@ -76,14 +398,12 @@ void try_reinit_display() {
     lastDisplayInitAttempt = now;
     Serial.println("🔄 Попытка переинициализации OLED...");
     
-    // 🛡️ GRACEFUL CLEANUP: очищаем I2C шину перед реинициализацией
+    // 🛡️ GRACEFUL CLEANUP: очищаем шину перед реинициализацией
     // Предотвращаем конфликты с предыдущими командами
-    Wire.end();
+    display_transport_end();
     delay(100); // Даем время на очистку I2Cбуферов
-    Wire.begin(OLED_SDA, OLED_SCL);
-    Wire.setClock(I2C_FAST_MODE_FREQ);
     
-    if (display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
+    if (display_transport_begin()) {
         displayInitialized = true;
         Serial.println("✅ OLED инициализирован после повторной попытки!");
         display.setRotation(displayRotation);
@@ -91,7 +411,8 @@ void try_reinit_display() {
         display.setTextSize(1);
         display.setTextColor(SSD1306_WHITE);
         display.println("Display recovered!");
-        display.display();
+        flush_display();
+        invalidate_display();
         reset_inactivity_timer();
     }
 }
@@ -141,12 +462,18 @@ void reset_inactivity_timer() {
     if (currentDisplayMode != INFO && currentDisplayMode != AP_MODE && currentDisplayMode != IP_DISPLAY) {
         currentDisplayMode = INFO;
         display.clearDisplay();
+        invalidate_display();  // Буфер очищен - INFO должен перерисоваться целиком
     }
 }
 
+void invalidate_display() {
+    renderKeyValid = false;
+}
+
 void set_display_mode_ap(String ip) {
     currentDisplayMode = AP_MODE;
     ap_ip_address = ip;
+    apScreenHash = hash_text(ap_ip_address.c_str());
     loop_display(); // Обновить экран сразу
 }
 
@@ -157,13 +484,14 @@ void show_shutdown_progress(float progress) {
 
 void turn_off_display() {
     display.clearDisplay();
-    display.display();
+    flush_display();
     display.ssd1306_command(SSD1306_DISPLAYOFF);
 }
 
 void show_message(const String& line1, const String& line2, int delay_ms) {
     message_line1 = line1;
     message_line2 = line2;
+    messageScreenHash = hash_text(message_line2.c_str(), hash_text(message_line1.c_str()));
     currentDisplayMode = MESSAGE;
     loop_display(); 
     if (delay_ms > 0) delay(delay_ms);
@@ -205,20 +533,73 @@ bool is_ip_display_paused() {
 }
 
 void draw_info_screen() {
+    bool hasStations = !stations.empty();
+    bool wifiConnected = (WiFi.status() == WL_CONNECTED);
+    int station = hasStations ? currentStation : -1;
+
+    RenderKey key = {};
+    key.mode = INFO;
+    key.rotation = displayRotation;
+    key.wifiConnected = wifiConnected;
+    key.station = station;
+    if (hasStations) {
+        key.rssi = wifiConnected ? poll_rssi_bucket() : 0;
+        key.volumeFill = (int)(displayVolume * (SCREEN_WIDTH - 4));
+        key.textHash = hash_text(stations[station].name.c_str());
+    } else if (wifiConnected) {
+        key.textHash = (uint32_t)WiFi.localIP();
+    }
+
+    // Бегущая строка, если имя не помещается слева от RSSI
+    int nameAreaWidth = SCREEN_WIDTH;
+    char rssi_str[12];
+    int rssi_len = 0;
+    if (hasStations && wifiConnected) {
+        rssi_len = snprintf(rssi_str, sizeof(rssi_str), "%ddBm", key.rssi);
+        nameAreaWidth = SCREEN_WIDTH - rssi_len * 6 - 4;
+    }
+    bool marquee = hasStations && (displayRotation == 0 || displayRotation == 2) &&
+                   (int)stations[station].name.length() * 6 > nameAreaWidth;
+    if (marquee) {
+        if (marqueeAreaWidth == 0 || key.textHash != marqueeTextHash) {
+            marqueeStrip.render(stations[station].name.c_str());
+            marqueeTextHash = key.textHash;
+            marqueeStartTime = millis();
+        }
+        key.scroll = marquee_offset();
+    }
+
+    bool scrollOnly = renderKeyValid && marquee && marqueeAreaWidth == nameAreaWidth &&
+                      key.sameContent(lastRenderKey);
+    if (!render_key_changed(key)) return;
+
+    if (scrollOnly) {
+        // Изменился только сдвиг - копируем окно и шлем одну страницу
+        unsigned long t0 = micros();
+        marquee_blit(key.scroll);
+        marquee_flush();
+        marqueeMicros += micros() - t0;
+        marqueeFrames++;
+        return;
+    }
+    marqueeAreaWidth = marquee ? nameAreaWidth : 0;
+
     display.clearDisplay();
     display.setTextSize(1);
     display.setTextColor(SSD1306_WHITE);
     
     // Название станции или IP адрес
-    if (!stations.empty()) {
+    if (marquee) {
+        marquee_blit(key.scroll);
+    } else if (hasStations) {
         display.setCursor(0, 0);
-        display.print(stations[currentStation].name);
+        display.print(stations[station].name);
     } else {
         // Нет станций - показываем IP адрес
         display.setCursor(0, 0);
         display.print("No stations");
         
-        if (WiFi.status() == WL_CONNECTED) {
+        if (wifiConnected) {
             display.setCursor(0, 10);
             display.print("IP:");
             display.setCursor(0, 20);
@@ -227,14 +608,13 @@ void draw_info_screen() {
     }
     
     // Статус WiFi (только если есть станции)
-    if (!stations.empty() && WiFi.status() == WL_CONNECTED) {
-        String rssi_str = String(WiFi.RSSI()) + "dBm";
-        display.setCursor(SCREEN_WIDTH - rssi_str.length() * 6, 0);
+    if (rssi_len > 0) {
+        display.setCursor(SCREEN_WIDTH - rssi_len * 6, 0);
         display.print(rssi_str);
     }
 
     // Шкала громкости (только если есть станции)
-    if (!stations.empty()) {
+    if (hasStations) {
         int bar_x = 0;
         int bar_y = 22;
         int bar_w = SCREEN_WIDTH;
@@ -243,16 +623,17 @@ void draw_info_screen() {
         // Рисуем контур
         display.drawRoundRect(bar_x, bar_y, bar_w, bar_h, corner_radius, SSD1306_WHITE);
         // Рисуем заполнение
-        int fill_w = (int)(displayVolume * (bar_w - 4));
+        int fill_w = key.volumeFill;
         if (fill_w > 0) {
             display.fillRoundRect(bar_x + 2, bar_y + 2, fill_w, bar_h - 4, corner_radius - 1, SSD1306_WHITE);
         }
     }
     
-    display.display();
+    flush_display();
 }
 
 void draw_shutdown_screen() {
+    render_unkeyed_frame();  // Анимированный экран - рисуем каждый кадр
     display.clearDisplay();
     display.setTextSize(1);
     display.setTextColor(SSD1306_WHITE);
@@ -268,17 +649,24 @@ void draw_shutdown_screen() {
     display.drawRect(bar_x, bar_y, bar_w, bar_h, SSD1306_WHITE);
     display.fillRect(bar_x, bar_y, (int)(bar_w * shutdownProgress), bar_h, SSD1306_WHITE);
     
-    display.display();
+    flush_display();
 }
 
 // Визуализатор - делегируем рисование менеджеру
 void draw_visualizer() {
+    render_unkeyed_frame();  // Анимированный экран - рисуем каждый кадр
     display.clearDisplay();
     visualizerManager.draw(display, visualizerBands, 16);
-    display.display();
+    flush_display();
 }
 
 void draw_ap_mode_screen() {
+    RenderKey key = {};
+    key.mode = AP_MODE;
+    key.rotation = displayRotation;
+    key.textHash = apScreenHash;
+    if (!render_key_changed(key)) return;
+
     display.clearDisplay();
     display.setTextSize(1);
     display.setTextColor(SSD1306_WHITE);
@@ -289,10 +677,16 @@ void draw_ap_mode_screen() {
     display.setCursor(0, 24);
     display.print("IP: ");
     display.print(ap_ip_address);
-    display.display();
+    flush_display();
 }
 
 void draw_message_screen() {
+    RenderKey key = {};
+    key.mode = MESSAGE;
+    key.rotation = displayRotation;
+    key.textHash = messageScreenHash;
+    if (!render_key_changed(key)) return;
+
     display.clearDisplay();
     display.setTextSize(1);
     display.setTextColor(SSD1306_WHITE);
@@ -302,10 +696,11 @@ void draw_message_screen() {
         display.setCursor(0, 18);
         display.println(message_line2);
     }
-    display.display();
+    flush_display();
 }
 
 void draw_ip_display_screen() {
+    render_unkeyed_frame();  // Анимированный экран - рисуем каждый кадр
     display.clearDisplay();
     display.setTextSize(1);
     display.setTextColor(SSD1306_WHITE);
@@ -360,7 +755,7 @@ void draw_ip_display_screen() {
         display.fillRect(bar_x, bar_y, (int)(bar_w * progress), bar_h, SSD1306_WHITE);
     }
     
-    display.display();
+    flush_display();
 }
 
 // Изменение поворота дисплея
@@ -369,4 +764,29 @@ void set_display_rotation(uint8_t rotation) {
     display.setRotation(displayRotation);
     // Перерисуем текущий экран
     reset_inactivity_timer();
-}
\ No newline at end of file
+}
+
+// === СНИМОК ЭКРАНА (PBM) ===
+// P4: бинарный 1bpp, строки по 8 пикселей в байте, старший бит слева.
+// Буфер копируется целиком до конвертации, чтобы не ловить половину кадра
+// из main loop (обработчик веб-сервера работает в задаче AsyncTCP).
+void write_display_snapshot_pbm(Print& out) {
+    uint8_t frame[DISPLAY_BUFFER_BYTES];
+    memcpy(frame, display.getBuffer(), sizeof(frame));
+    bool flipped = (displayRotation == 2);
+
+    out.printf("P4\n%d %d\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+    uint8_t row[SCREEN_WIDTH / 8];
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        memset(row, 0, sizeof(row));
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            // Снимок в логической ориентации - как видит пользователь
+            int px = flipped ? SCREEN_WIDTH - 1 - x : x;
+            int py = flipped ? SCREEN_HEIGHT - 1 - y : y;
+            if (frame[(py / 8) * SCREEN_WIDTH + px] & (1 << (py & 7))) {
+                row[x / 8] |= 0x80 >> (x & 7);
+            }
+        }
+        out.write(row, sizeof(row));
+    }
+}
@@ -17,6 +17,23 @@ enum DisplayMode {
 extern int visualizerBands[16];
 extern uint8_t displayRotation; // 0=Normal, 2=Flipped 180°
 
+// 📊 Статистика кадров (накопительные счетчики с момента старта)
+// rendered - кадр отрисован и отправлен на OLED
+// skipped  - render key не изменился, отрисовка и flush пропущены
+extern unsigned long displayFramesRendered;
+extern unsigned long displayFramesSkipped;
+
+// 📊 Бегущая строка: кадры, где менялся только сдвиг (blit + flush одной страницы)
+extern unsigned long marqueeFrames;
+extern unsigned long marqueeMicros;    // Суммарное время blit + flush (мкс)
+extern unsigned long marqueeBusBytes;  // Суммарно отправлено по I2C (команды + данные)
+
+// 📊 Учет шины: каждый flush на OLED (полный кадр или страница бегущей строки)
+extern unsigned long displayFlushes;
+extern unsigned long displayBusBytes;       // Байт по шине (без адресных байт I2C)
+extern unsigned long displayBusMicros;      // Время, проведенное в flush (мкс, переполняется за 71 минуту)
+extern unsigned long displayLastFlushBytes; // Байт в последнем flush
+
 void setup_display();
 void set_display_rotation(uint8_t rotation);
 void loop_display();
@@ -30,5 +47,12 @@ bool is_ip_display_active();
 bool is_ip_display_paused();
 void show_shutdown_progress(float progress);
 void turn_off_display();
+void invalidate_display();  // Принудительная перерисовка статичного экрана в следующем кадре
+void write_display_snapshot_pbm(Print& out);  // Снимок текущего буфера OLED (PBM P4)
+
+// Вызывается из main loop после каждого flush (полный кадр или страница бегущей строки)
+// с буфером SSD1306: SCREEN_WIDTH * SCREEN_HEIGHT / 8 байт, страницы по 8 строк
+typedef void (*DisplayFlushHook)(const uint8_t* buffer);
+void set_display_flush_hook(DisplayFlushHook hook);
 
 #endif // DISPLAY_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "config.h"
+#include "frame_pacer.h"
+#include "audio_manager.h"
+#include "display_manager.h"
+#include "log_manager.h"
+#include "string_utils.h"
+
+// === АДАПТИВНЫЙ FPS ДИСПЛЕЯ ===
+// Раз в PACER_WINDOW_MS пересчитываем целевой FPS по заполнению буфера потока
+// и доле CPU, которую занял декодер. Внутри окна дисплей не может потратить
+// больше PACER_DISPLAY_BUDGET процентов времени - остальное гарантированно
+// остается аудио, даже если отдельные кадры оказались дорогими.
+
+// Текущее окно учета
+static unsigned long windowStart = 0;
+static unsigned long windowDisplayMicros = 0;
+static unsigned long windowRenderedStart = 0;  // displayFramesRendered на начало окна
+static unsigned long windowDecodeStart = 0;  // audioDecodeMicros на начало окна
+static bool windowBudgetHit = false;
+
+static unsigned long lastFrameTime = 0;
+static unsigned long frameInterval = 1000 / PACER_FPS_MAX;
+
+// Итоги прошлого окна. Читается веб-сервером без блокировки:
+// поля однобайтовые, рассогласование между полями допустимо для диагностики
+static FramePacerStatus pacerStatus = {0, PACER_FPS_MAX, -1, 0, 0, PACER_REASON_NONE};
+
+static unsigned long lastPacerLog = 0;
+static uint8_t lastLoggedFps = PACER_FPS_MAX;
+static FramePacerReason lastLoggedReason = PACER_REASON_NONE;
+
+// Линейно переводит показатель в FPS:
+// value на стороне atMax -> PACER_FPS_MAX, на стороне atMin -> PACER_FPS_MIN
+static int fps_between(int value, int atMax, int atMin) {
+    int t = (value - atMax) * 100 / (atMin - atMax);  // 0..100 - насколько плохо
+    t = constrain(t, 0, 100);
+    return PACER_FPS_MAX - (PACER_FPS_MAX - PACER_FPS_MIN) * t / 100;
+}
+
+static void close_window(unsigned long now) {
+    unsigned long elapsed = now - windowStart;
+    if (elapsed == 0) elapsed = 1;
+    unsigned long decodeMicros = audioDecodeMicros - windowDecodeStart;
+
+    // Только перерисованные кадры: пропуски по ключу отрисовки тоже проходят через пейсер
+    pacerStatus.fps = min((displayFramesRendered - windowRenderedStart) * 1000 / elapsed, 255UL);
+    pacerStatus.decodeShare = min(decodeMicros / (elapsed * 10), 100UL);
+    pacerStatus.displayShare = min(windowDisplayMicros / (elapsed * 10), 100UL);
+
+    int fill = get_audio_buffer_fill_percent();
+    pacerStatus.bufferFill = fill;
+
+    // Без потока буфер не ограничивает (AP режим, нет станций, буферизация)
+    int fpsBuffer = (fill < 0) ? PACER_FPS_MAX : fps_between(fill, PACER_BUFFER_HEALTHY, AUDIO_BUFFER_LOW_THRESHOLD);
+    int fpsDecoder = fps_between(pacerStatus.decodeShare, PACER_DECODE_SHARE_LOW, PACER_DECODE_SHARE_HIGH);
+
+    int target = PACER_FPS_MAX;
+    FramePacerReason reason = PACER_REASON_NONE;
+    if (fpsBuffer < target) {
+        target = fpsBuffer;
+        reason = PACER_REASON_BUFFER;
+    }
+    if (fpsDecoder < target) {
+        target = fpsDecoder;
+        reason = PACER_REASON_DECODER;
+    }
+    if (windowBudgetHit) {
+        reason = PACER_REASON_BUDGET;
+    }
+
+    // Квантование гасит дрожание цели при колебаниях буфера
+    target = max(PACER_FPS_MIN, target / PACER_FPS_STEP * PACER_FPS_STEP);
+    pacerStatus.targetFps = target;
+    pacerStatus.reason = reason;
+    frameInterval = 1000 / target;
+
+    if ((target != lastLoggedFps || reason != lastLoggedReason) &&
+        now - lastPacerLog >= PACER_LOG_INTERVAL) {
+        log_message(formatString("🎞️ FPS дисплея: %d -> %d (%s, буфер %d%%, декодер %d%%, дисплей %d%%)",
+                                 lastLoggedFps, target, frame_pacer_reason_name(reason),
+                                 fill, pacerStatus.decodeShare, pacerStatus.displayShare));
+        lastLoggedFps = target;
+        lastLoggedReason = reason;
+        lastPacerLog = now;
+    }
+
+    windowStart = now;
+    windowDisplayMicros = 0;
+    windowRenderedStart = displayFramesRendered;
+    windowDecodeStart = audioDecodeMicros;
+    windowBudgetHit = false;
+}
+
+bool frame_pacer_due() {
+    unsigned long now = millis();
+    if (now - windowStart >= PACER_WINDOW_MS) {
+        close_window(now);
+    }
+
+    // Гарантия для аудио: бюджет дисплея в окне исчерпан - ждем следующего окна
+    if (windowDisplayMicros >= (unsigned long)PACER_WINDOW_MS * 10 * PACER_DISPLAY_BUDGET) {
+        windowBudgetHit = true;
+        return false;
+    }
+
+    if (now - lastFrameTime < frameInterval) return false;
+    lastFrameTime = now;
+    return true;
+}
+
+void frame_pacer_frame_done(unsigned long frameMicros) {
+    windowDisplayMicros += frameMicros;
+}
+
+FramePacerStatus get_frame_pacer_status() {
+    return pacerStatus;
+}
+
+const char* frame_pacer_reason_name(FramePacerReason reason) {
+    switch (reason) {
+        case PACER_REASON_NONE:    return "ok";
+        case PACER_REASON_BUFFER:  return "buffer";
+        case PACER_REASON_DECODER: return "decoder";
+        case PACER_REASON_BUDGET:  return "budget";
+        default:                   return "unknown";
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <Arduino.h>
+
+// Почему FPS ограничен в текущем окне
+enum FramePacerReason {
+    PACER_REASON_NONE,      // Ограничений нет (PACER_FPS_MAX)
+    PACER_REASON_BUFFER,    // Буфер потока опустел ниже PACER_BUFFER_HEALTHY
+    PACER_REASON_DECODER,   // Декодер занимает большую долю CPU
+    PACER_REASON_BUDGET     // Дисплей исчерпал PACER_DISPLAY_BUDGET в этой секунде
+};
+
+struct FramePacerStatus {
+    uint8_t fps;            // Фактически перерисовано кадров за прошлое окно (без пропусков по ключу)
+    uint8_t targetFps;      // Текущий целевой FPS
+    int8_t bufferFill;      // Заполнение буфера (%), -1 если аудио не играет
+    uint8_t decodeShare;    // Доля декодера в прошлом окне (%)
+    uint8_t displayShare;   // Доля дисплея в прошлом окне (%)
+    FramePacerReason reason;
+};
+
+// Вызывается из main loop: пора ли рисовать следующий кадр
+bool frame_pacer_due();
+
+// Вызывается после loop_display() с временем кадра
+void frame_pacer_frame_done(unsigned long frameMicros);
+
+FramePacerStatus get_frame_pacer_status();
+const char* frame_pacer_reason_name(FramePacerReason reason);
+
+#endif // FRAME_PACER_H
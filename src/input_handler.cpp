@@ -182,6 +182,13 @@ void loop_input() {
     }
 }
 
+// === ОТЛОЖЕННОЕ СОХРАНЕНИЕ ГРОМКОСТИ ИЗ ВЕБ-ИНТЕРФЕЙСА ===
+// Вызывается из loop() при применении громкости из почтового ящика настроек
+void schedule_volume_save() {
+    volumePendingSave = true;
+    lastVolumeSaveTime = millis();
+}
+
 // === ПРИНУДИТЕЛЬНОЕ СОХРАНЕНИЕ ГРОМКОСТИ ===
 // Вызывается при shutdown для сохранения отложенной громкости
 void force_save_volume() {
@@ -3,6 +3,7 @@
 
 void setup_input();
 void loop_input();
+void schedule_volume_save();  // Отложенное сохранение громкости (громкость из веб-интерфейса)
 void force_save_volume();  // Принудительное сохранение громкости (при shutdown)
 
 #endif // INPUT_HANDLER_H
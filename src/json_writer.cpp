@@ -0,0 +1,101 @@
+#include "json_writer.h"
+
+JsonWriter::JsonWriter(Print& out) : _out(out), _depth(0), _afterKey(false) {
+    _first[0] = true;
+}
+
+// Запятая перед вторым и следующими элементами (после ключа - не нужна)
+void JsonWriter::separator() {
+    if (_afterKey) {
+        _afterKey = false;
+        return;
+    }
+    if (!_first[_depth]) _out.write(',');
+    _first[_depth] = false;
+}
+
+void JsonWriter::open(char bracket) {
+    separator();
+    _out.write(bracket);
+    if (_depth + 1 < JSON_WRITER_MAX_DEPTH) _depth++;
+    _first[_depth] = true;
+}
+
+void JsonWriter::close(char bracket) {
+    _out.write(bracket);
+    if (_depth > 0) _depth--;
+}
+
+JsonWriter& JsonWriter::beginObject() { open('{'); return *this; }
+JsonWriter& JsonWriter::endObject()   { close('}'); return *this; }
+JsonWriter& JsonWriter::beginArray()  { open('['); return *this; }
+JsonWriter& JsonWriter::endArray()    { close(']'); return *this; }
+
+JsonWriter& JsonWriter::key(const char* name) {
+    value(name);
+    _out.write(':');
+    _afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* text) {
+    separator();
+    _out.write('"');
+    for (const char* p = text; *p; p++) {
+        char c = *p;
+        if (c == '"' || c == '\\') {
+            _out.write('\\');
+            _out.write(c);
+        } else if ((uint8_t)c < 0x20) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            _out.print(esc);
+        } else {
+            _out.write(c);
+        }
+    }
+    _out.write('"');
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const String& text) {
+    return value(text.c_str());
+}
+
+JsonWriter& JsonWriter::value(long number) {
+    separator();
+    _out.print(number);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(unsigned long number) {
+    separator();
+    _out.print(number);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    separator();
+    _out.print(flag ? "true" : "false");
+    return *this;
+}
+
+size_t WindowPrint::write(uint8_t c) {
+    if (_total >= _skip && _total - _skip < _size) {
+        _buffer[_total - _skip] = c;
+    }
+    _total++;
+    return 1;  // Всегда "записано" - иначе Print прервет вывод
+}
+
+size_t WindowPrint::write(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        write(data[i]);
+    }
+    return len;
+}
+
+size_t WindowPrint::stored() const {
+    if (_total <= _skip) return 0;
+    return min(_total - _skip, _size);
+}
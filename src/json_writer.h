@@ -0,0 +1,75 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+
+// === ПОТОКОВАЯ ЗАПИСЬ JSON ===
+// Пишет JSON прямо в Print (AsyncResponseStream, WindowPrint) без JsonDocument
+// и промежуточных String. Запятые между элементами расставляются автоматически.
+//
+// Пример:
+//   JsonWriter json(*response);
+//   json.beginObject().field("current", 3).field("max", 25).endObject();
+
+#define JSON_WRITER_MAX_DEPTH 8  // Максимальная вложенность объектов/массивов
+
+class JsonWriter {
+public:
+    explicit JsonWriter(Print& out);
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    JsonWriter& key(const char* name);
+    JsonWriter& value(const char* text);   // Строка с экранированием
+    JsonWriter& value(const String& text);
+    JsonWriter& value(long number);
+    JsonWriter& value(unsigned long number);
+    JsonWriter& value(int number) { return value((long)number); }
+    JsonWriter& value(unsigned int number) { return value((unsigned long)number); }
+    JsonWriter& value(bool flag);
+
+    template <typename T>
+    JsonWriter& field(const char* name, const T& v) {
+        key(name);
+        return value(v);
+    }
+
+private:
+    void separator();
+    void open(char bracket);
+    void close(char bracket);
+
+    Print& _out;
+    uint8_t _depth;
+    bool _first[JSON_WRITER_MAX_DEPTH];
+    bool _afterKey;
+};
+
+// === PRINT В ФИКСИРОВАННЫЙ БУФЕР ===
+// Сохраняет только окно [skip, skip + size) из всего, что в него записали,
+// и считает общий объем. Позволяет отдавать большой элемент (станция с URL до 2KB)
+// по частям в chunked-ответе: элемент пишется заново, уже отправленное пропускается.
+// При skip = 0 - обычный буфер фиксированного размера с контролем переполнения.
+class WindowPrint : public Print {
+public:
+    WindowPrint(uint8_t* buffer, size_t size, size_t skip = 0)
+        : _buffer(buffer), _size(size), _skip(skip), _total(0) {}
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t len) override;
+
+    size_t total() const { return _total; }  // Записано всего (включая пропущенное)
+    size_t stored() const;                    // Байт в буфере
+    bool complete() const { return _total <= _skip + _size; }  // Все после skip поместилось
+
+private:
+    uint8_t* _buffer;
+    size_t _size;
+    size_t _skip;
+    size_t _total;
+};
+
+#endif // JSON_WRITER_H
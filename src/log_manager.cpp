@@ -1,10 +1,21 @@
 #include "log_manager.h"
 #include "string_utils.h"
+#include "telemetry.h"
 #include <LittleFS.h>
 
-#define LOG_FILE "/log.txt"
 #define MAX_LOG_SIZE 20480  // 20KB - максимальный размер лог-файла
-#define MAX_LOG_RESPONSE 8192  // 8KB - максимум для веб-ответа
+
+static uint32_t logRevision = 0;
+
+// Логические смещения: logBase - сколько байт было в удаленных файлах,
+// logSize - размер текущего файла. Клиенты /api/logs?from= продолжают с того же места
+// и после очистки файла (пропущенное просто недоступно).
+// Пишут и loop(), и задача AsyncTCP (логи веб-обработчиков): изменение и чтение пары -
+// в критической секции, иначе += теряет запись, а get_log_end() видит base от новой
+// очистки и size от старого файла. Сама работа с файлом - снаружи секции
+static uint32_t logBase = 0;
+static uint32_t logSize = 0;
+static portMUX_TYPE logOffsetsMux = portMUX_INITIALIZER_UNLOCKED;
 
 void setup_logging() {
     clear_logs();
@@ -15,56 +26,49 @@ void log_message(const String& message) {
     // Дублируем в Serial
     Serial.println(message);
 
-    // Проверяем размер лог-файла
-    if (LittleFS.exists(LOG_FILE)) {
-        File checkFile = LittleFS.open(LOG_FILE, "r");
-        if (checkFile && checkFile.size() > MAX_LOG_SIZE) {
-            checkFile.close();
-            // Файл слишком большой - очищаем
-            LittleFS.remove(LOG_FILE);
-        } else if (checkFile) {
-            checkFile.close();
-        }
+    // Файл слишком большой - очищаем (размер известен, без лишнего open)
+    taskENTER_CRITICAL(&logOffsetsMux);
+    bool full = logSize > MAX_LOG_SIZE;
+    taskEXIT_CRITICAL(&logOffsetsMux);
+    if (full) {
+        clear_logs();
     }
 
     // Записываем в файл
+    size_t written = 0;
     File logFile = LittleFS.open(LOG_FILE, "a");
     if (logFile) {
-        logFile.println(message);
+        written = logFile.println(message);
+        telemetry_flash_written(written);
         logFile.close();
     }
+    taskENTER_CRITICAL(&logOffsetsMux);
+    logSize += written;
+    logRevision++;
+    taskEXIT_CRITICAL(&logOffsetsMux);
+    logWrites.fetch_add(1, std::memory_order_relaxed);
 }
 
 void clear_logs() {
     if (LittleFS.exists(LOG_FILE)) {
         LittleFS.remove(LOG_FILE);
     }
+    taskENTER_CRITICAL(&logOffsetsMux);
+    logBase += logSize;
+    logSize = 0;
+    taskEXIT_CRITICAL(&logOffsetsMux);
 }
 
-String get_logs() {
-    File logFile = LittleFS.open(LOG_FILE, "r");
-    if (!logFile) {
-        return "Логи отсутствуют.";
-    }
-    
-    size_t fileSize = logFile.size();
-    
-    // Если файл большой - читаем только последние 8KB
-    if (fileSize > MAX_LOG_RESPONSE) {
-        logFile.seek(fileSize - MAX_LOG_RESPONSE);
-        // Пропускаем неполную первую строку
-        logFile.readStringUntil('\n');
-    }
-    
-    String logs = logFile.readString();
-    logFile.close();
-    
-    // Добавляем инфо если логи были обрезаны
-    if (fileSize > MAX_LOG_RESPONSE) {
-        char truncMsg[64];
-        snprintf(truncMsg, sizeof(truncMsg), "[...обрезано %dKB...]\n", (fileSize - MAX_LOG_RESPONSE) / 1024);
-        logs = String(truncMsg) + logs; // Одна конкатенация вместо трех
-    }
-    
-    return logs;
+uint32_t get_log_revision() {
+    taskENTER_CRITICAL(&logOffsetsMux);
+    uint32_t revision = logRevision;
+    taskEXIT_CRITICAL(&logOffsetsMux);
+    return revision;
+}
+
+void get_log_range(uint32_t& base, uint32_t& end) {
+    taskENTER_CRITICAL(&logOffsetsMux);
+    base = logBase;
+    end = logBase + logSize;
+    taskEXIT_CRITICAL(&logOffsetsMux);
 }
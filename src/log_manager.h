@@ -3,9 +3,17 @@
 
 #include <Arduino.h>
 
+#define LOG_FILE "/log.txt"
+
 void setup_logging();
 void log_message(const String& message);
 void clear_logs();
-String get_logs();
+uint32_t get_log_revision();  // Растет с каждой записью - веб-клиенты перечитывают логи только при изменении
+
+// Логические смещения лога (не сбрасываются при очистке файла):
+// байт с логическим смещением N лежит в LOG_FILE по позиции N - base
+// base - смещение начала текущего файла, end - конца (сколько байт записано с момента
+// старта). Пара читается одним согласованным снимком
+void get_log_range(uint32_t& base, uint32_t& end);
 
 #endif // LOG_MANAGER_H
@@ -1,4 +1,6 @@
 #include <Arduino.h>
+#include <WiFi.h>
+#include <atomic>
 #include "wifi_manager.h"
 #include "audio_manager.h"
 #include "display_manager.h"
@@ -6,6 +8,9 @@
 #include "input_handler.h"
 #include "system_manager.h"
 #include "log_manager.h"
+#include "frame_pacer.h"
+#include "wifi_scan.h"
+#include "telemetry.h"
 #include "string_utils.h"
 #include "config.h"
 
@@ -13,39 +18,122 @@
 // Типы команд от веб-интерфейса
 enum CommandType {
     CMD_NONE = 0,
-    CMD_VOLUME,          // Изменить громкость
     CMD_NEXT_STATION,    // Следующая станция
     CMD_PREV_STATION,    // Предыдущая станция
     CMD_REBOOT,          // Перезагрузка
-    CMD_SAVE_STATIONS    // Сохранить конфигурацию станций
+    CMD_SAVE_STATIONS,   // Сохранить конфигурацию станций
+    CMD_SELECT_STATION,  // Переключиться на станцию по номеру
+    CMD_APPLY_WIFI       // Применить сохраненный WiFi без перезагрузки (AP -> STA)
 };
 
 struct SystemCommand {
     CommandType type;
-    float floatValue;    // Для CMD_VOLUME
+    float floatValue;    // Параметр команды (пока не используется)
+    int intValue;        // Для CMD_SELECT_STATION; для CMD_APPLY_WIFI - millis() приема /save
 };
 
 // Очередь команд (потокобезопасная)
 QueueHandle_t commandQueue = nullptr;
+std::atomic<uint32_t> commandQueueRejected(0);  // Очередь была полна
+
+// === ПОЧТОВЫЙ ЯЩИК НАСТРОЕК (последнее значение) ===
+// Громкость, стиль визуализатора и поворот экрана - идемпотентные настройки:
+// важно только последнее значение. Слайдер шлет десятки POST в секунду, и через
+// очередь каждый из них применялся бы по очереди (или получал 503 при полной очереди).
+// Веб-задача записывает значение и взводит бит, loop() раз за итерацию забирает
+// все взведенные биты и применяет последние значения. Без блокировок и без отказов.
+enum SettingBit : uint8_t {
+    SETTING_VOLUME     = 1 << 0,
+    SETTING_VISUALIZER = 1 << 1,
+    SETTING_ROTATION   = 1 << 2
+};
+
+static std::atomic<uint8_t> settingsPending(0);
+static std::atomic<uint32_t> pendingVolumeBits(0);  // float как uint32_t
+static std::atomic<uint8_t> pendingVisualizer(0);
+static std::atomic<uint8_t> pendingRotation(0);
+static std::atomic<uint32_t> settingsPostedAt(0);   // micros() последней записи
+
+// 📊 Счетчики для /api/metrics
+std::atomic<uint32_t> settingsPosted(0);     // Записей от веб-сервера
+std::atomic<uint32_t> settingsCoalesced(0);  // Перезаписано до применения
+std::atomic<uint32_t> settingsApplied(0);    // Применений в loop()
+std::atomic<uint32_t> settingsLagMicros(0);  // Сумма задержек "последняя запись -> применение"
+std::atomic<uint32_t> settingsLagMaxMicros(0);
+
+static void postSetting(SettingBit bit) {
+    settingsPostedAt.store(micros(), std::memory_order_relaxed);
+    uint8_t before = settingsPending.fetch_or(bit, std::memory_order_release);
+    settingsPosted.fetch_add(1, std::memory_order_relaxed);
+    if (before & bit) settingsCoalesced.fetch_add(1, std::memory_order_relaxed);
+}
+
+// === ПРИМЕНЕНИЕ WIFI БЕЗ ПЕРЕЗАГРУЗКИ (AP -> STA) ===
+// После /save раньше был ESP.restart(): полная загрузка (SERIAL_INIT_DELAY,
+// DISPLAY_INIT_DELAY, монтирование ФС, чтение конфигов) до первого звука.
+// Теперь loop() снимает маршруты AP, подключается и запускает STA на месте;
+// не подключились - точка доступа поднимается снова.
+static bool wifiApplyPending = false;
+static unsigned long wifiApplyRequestedAt = 0;  // millis() в обработчике /save
+static bool wifiApplyAwaitAudio = false;
+unsigned long wifiApplyToAudioMs = 0;  // 📊 От /save до первого звука (0 - не было)
+
+static void applyWifiConfigLive() {
+    log_message("📶 Применение настроек WiFi без перезагрузки...");
+    stop_web_server();
+    WiFi.scanDelete();
+    WiFi.softAPdisconnect(true);
+
+    unsigned long connectStart = millis();
+    if (connect_to_wifi()) {
+        systemState = STATE_STA;
+        log_message(formatString("Подключено к WiFi за %lu мс. Режим станции (STA) без перезагрузки.",
+                                 millis() - connectStart));
+        setup_audio();
+        start_web_server_sta();
+        wifiApplyAwaitAudio = true;
+    } else {
+        log_message("❌ Не удалось подключиться с новыми настройками. Возврат в режим точки доступа (AP).");
+        setup_ap_mode();
+        start_web_server_ap();
+    }
+    reset_inactivity_timer();
+}
 
 // === ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ДЛЯ ОТПРАВКИ КОМАНД ===
 // Используются в web_server_manager.cpp
 
-bool sendCommand(CommandType type, float value = 0.0f) {
+bool sendCommand(CommandType type, float value = 0.0f, int intValue = 0) {
     if (commandQueue == nullptr) return false;
     
     SystemCommand cmd;
     cmd.type = type;
     cmd.floatValue = value;
+    cmd.intValue = intValue;
     
     // Попытка отправить команду в очередь (без ожидания)
     BaseType_t result = xQueueSend(commandQueue, &cmd, 0);
+    if (result != pdTRUE) commandQueueRejected.fetch_add(1, std::memory_order_relaxed);
     return (result == pdTRUE);
 }
 
 // Удобные обертки
-bool sendVolumeCommand(float volume) {
-    return sendCommand(CMD_VOLUME, volume);
+// Настройки - через почтовый ящик, всегда успешно
+void postVolumeSetting(float volume) {
+    uint32_t bits;
+    memcpy(&bits, &volume, sizeof(bits));
+    pendingVolumeBits.store(bits, std::memory_order_relaxed);
+    postSetting(SETTING_VOLUME);
+}
+
+void postVisualizerStyleSetting(uint8_t style) {
+    pendingVisualizer.store(style, std::memory_order_relaxed);
+    postSetting(SETTING_VISUALIZER);
+}
+
+void postRotationSetting(uint8_t rotation) {
+    pendingRotation.store(rotation, std::memory_order_relaxed);
+    postSetting(SETTING_ROTATION);
 }
 
 bool sendNextStationCommand() {
@@ -64,6 +152,15 @@ bool sendSaveStationsCommand() {
     return sendCommand(CMD_SAVE_STATIONS);
 }
 
+bool sendSelectStationCommand(int index) {
+    return sendCommand(CMD_SELECT_STATION, 0.0f, index);
+}
+
+// Время ставит обработчик /save: замер включает и ожидание в очереди команд
+bool sendApplyWifiCommand(unsigned long requestedAt) {
+    return sendCommand(CMD_APPLY_WIFI, 0.0f, (int)requestedAt);
+}
+
 void setup() {
     Serial.begin(SERIAL_BAUD_RATE);
     delay(SERIAL_INIT_DELAY);
@@ -118,17 +215,56 @@ void setup() {
     print_system_status();
 }
 
+// Применение настроек из почтового ящика: одно значение на настройку за итерацию
+static void applyPendingSettings() {
+    uint8_t pending = settingsPending.exchange(0, std::memory_order_acquire);
+    if (pending == 0) return;
+
+    uint32_t lag = micros() - settingsPostedAt.load(std::memory_order_relaxed);
+    settingsApplied.fetch_add(1, std::memory_order_relaxed);
+    settingsLagMicros.fetch_add(lag, std::memory_order_relaxed);
+    if (lag > settingsLagMaxMicros.load(std::memory_order_relaxed)) {
+        settingsLagMaxMicros.store(lag, std::memory_order_relaxed);
+    }
+
+    if (pending & SETTING_VOLUME) {
+        uint32_t bits = pendingVolumeBits.load(std::memory_order_relaxed);
+        float newVolume;
+        memcpy(&newVolume, &bits, sizeof(newVolume));
+        set_volume(newVolume);
+        schedule_volume_save();  // ✅ Сохранение через debounce в loop_input()
+        Serial.printf("🔊 Громкость: %.2f\n", newVolume);
+    }
+
+    bool changed = false;
+    if (pending & SETTING_VISUALIZER) {
+        uint8_t style = pendingVisualizer.load(std::memory_order_relaxed);
+        if (style < VISUALIZER_STYLE_COUNT && style != visualizerStyle) {
+            visualizerStyle = (VisualizerStyle)style;
+            visualizerManager.setStyle(visualizerStyle);
+            changed = true;
+        }
+    }
+    if (pending & SETTING_ROTATION) {
+        uint8_t rotation = pendingRotation.load(std::memory_order_relaxed);
+        if (rotation != displayRotation) {
+            set_display_rotation(rotation);
+            changed = true;
+        }
+    }
+    if (changed) save_state();
+}
+
 void loop() {
+    unsigned long loopStart = micros();
+    
+    // === НАСТРОЙКИ ИЗ ПОЧТОВОГО ЯЩИКА (последние значения) ===
+    applyPendingSettings();
+
     // === ОБРАБОТКА КОМАНД ИЗ ОЧЕРЕДИ (потокобезопасно) ===
     SystemCommand cmd;
     while (xQueueReceive(commandQueue, &cmd, 0) == pdTRUE) {
         switch (cmd.type) {
-            case CMD_VOLUME:
-                set_volume(cmd.floatValue);
-                // ✅ Сохранение громкости теперь через debounce в loop_input()
-                log_message(formatString("🔊 Громкость: %.2f", cmd.floatValue));
-                break;
-                
             case CMD_NEXT_STATION:
                 next_station();
                 log_message("⏭️ Следующая станция");
@@ -150,43 +286,62 @@ void loop() {
                 log_message("💾 Конфигурация станций сохранена");
                 break;
                 
+            case CMD_SELECT_STATION:
+                if (!select_station(cmd.intValue)) {
+                    log_message(formatString("⚠️ Нет станции #%d", cmd.intValue));
+                }
+                break;
+                
+            case CMD_APPLY_WIFI:
+                // Переход - чуть позже, чтобы ответ на /save успел уйти клиенту
+                wifiApplyPending = true;
+                wifiApplyRequestedAt = (unsigned long)(uint32_t)cmd.intValue;
+                break;
+                
             default:
                 break;
         }
     }
 
     // ПРИОРИТЕТ 1: Audio (КАЖДУЮ итерацию для плавного стрима!)
-    // НО! ПРИОСТАНОВИТЬ если веб-сервер загружает HTML!
-    static unsigned long htmlLoadStartTime = 0;
-    // ATOMIC: memory_order_relaxed - не нужен строгий порядок, только атомарность
-    if (web_loading_html.load(std::memory_order_relaxed)) {
-        if (htmlLoadStartTime == 0) {
-            htmlLoadStartTime = millis();
-        }
-        // Автосброс через 200ms (на случай если зависло)
-        if (millis() - htmlLoadStartTime > 200) {
-            web_loading_html.store(false, std::memory_order_relaxed);
-            htmlLoadStartTime = 0;
-        }
-        // ПРОПУСКАЕМ audio во время загрузки HTML
-    } else {
-        htmlLoadStartTime = 0;
-        if (systemState == STATE_STA) {
-            loop_audio();  // Без задержек!
-        }
+    // Веб-сервер отдает файлы кусками (web_server_manager.cpp) - пауза не нужна
+    if (systemState == STATE_STA) {
+        loop_audio();  // Без задержек!
     }
     
     // ПРИОРИТЕТ 2: Input (часто, для отзывчивости)
     loop_input();
     
-    // ПРИОРИТЕТ 3: Display (только каждые 16ms = 60 FPS)
+    // ПРИОРИТЕТ 3: Display (10-60 FPS в зависимости от здоровья аудио буфера)
     // 🎯 ПРОПУСКАЕМ display во время активного декодирования MP3
-    static unsigned long lastDisplayUpdate = 0;
+    // 🎞️ frame_pacer ограничивает долю каждой секунды, отданную дисплею
     bool audioDecoding = audio_decoding_active.load(std::memory_order_relaxed);
     
-    if (!audioDecoding && millis() - lastDisplayUpdate >= 16) {
+    if (!audioDecoding && frame_pacer_due()) {
+        unsigned long frameStart = micros();
         loop_display();
-        lastDisplayUpdate = millis();
+        frame_pacer_frame_done(micros() - frameStart);
+    }
+    
+    // Live статус для веб-клиентов: снапшот /api/status и дельты SSE (сам ограничивает частоту)
+    if (systemState == STATE_STA) {
+        loop_web_events();
+    }
+    
+    // Режим настройки: фоновый скан сетей для /api/scan-results
+    if (systemState == STATE_AP) {
+        loop_wifi_scan();
+        if (wifiApplyPending && millis() - wifiApplyRequestedAt >= WIFI_APPLY_DELAY) {
+            wifiApplyPending = false;
+            applyWifiConfigLive();
+        }
+    }
+    
+    // Замер после живого перехода: от /save до первого звука
+    if (wifiApplyAwaitAudio && audioState == AUDIO_PLAYING) {
+        wifiApplyAwaitAudio = false;
+        wifiApplyToAudioMs = millis() - wifiApplyRequestedAt;
+        log_message(formatString("⏱️ От сохранения WiFi до звука: %lu мс", wifiApplyToAudioMs));
     }
     
     // ПРИОРИТЕТ 4: WiFi Recovery (каждые 500ms для точного мониторинга)
@@ -207,6 +362,9 @@ void loop() {
         }
     }
     
+    // 📊 Время итерации (до yield - без времени других задач)
+    telemetry_loop_done(micros() - loopStart);
+    
     // НЕТ delay()! Максимальная скорость для audio!
     yield();  // Даем время WiFi/веб-серверу
 }
@@ -9,6 +9,7 @@
 #include "display_manager.h"
 #include "input_handler.h"
 #include "log_manager.h"
+#include "web_server_manager.h"
 #include "string_utils.h"
 
 // Определяем глобальную переменную состояния
@@ -154,6 +155,30 @@ void print_system_status() {
         Serial.println("Аудио: Нет станций для воспроизведения.");
     }
     
+    // 📊 Кадры дисплея с прошлого вывода статуса (≈ за минуту)
+    // "запрошено" - сколько раз рисовали бы без мемоизации
+    static unsigned long lastFramesRendered = 0;
+    static unsigned long lastFramesSkipped = 0;
+    unsigned long rendered = displayFramesRendered - lastFramesRendered;
+    unsigned long skipped = displayFramesSkipped - lastFramesSkipped;
+    lastFramesRendered = displayFramesRendered;
+    lastFramesSkipped = displayFramesSkipped;
+    Serial.printf("Дисплей: %lu кадров отрисовано / %lu запрошено\n", rendered, rendered + skipped);
+    if (displayFlushes > 0) {
+        Serial.printf("Шина OLED: %lu flush, %lu байт/flush, %lu мкс/flush\n",
+                      displayFlushes, displayBusBytes / displayFlushes, displayBusMicros / displayFlushes);
+    }
+    if (marqueeFrames > 0) {
+        // Сравнивать с полным кадром: print() + display() = 512 байт данных
+        Serial.printf("Бегущая строка: %lu кадров, %lu мкс/кадр, %lu байт I2C/кадр\n",
+                      marqueeFrames, marqueeMicros / marqueeFrames, marqueeBusBytes / marqueeFrames);
+    }
+
+    if (systemState == STATE_STA) {
+        Serial.printf("Live статус: %d клиентов, %lu событий, %lu отложено\n",
+                      get_web_events_clients(), webEventsSent, webEventsDeferred);
+    }
+
     Serial.printf("RAM: %d байт\n", ESP.getFreeHeap());
     Serial.printf("Время: %lu мин\n", millis() / 60000);
     Serial.println("=================");
@@ -0,0 +1,229 @@
+#include "config.h"
+#include "telemetry.h"
+#include "audio_manager.h"
+#include "display_manager.h"
+#include "frame_pacer.h"
+
+TelemetryKiloCounter audioDecodedSamples;
+TelemetryCounter audioUnderruns;
+TelemetryCounter audioStreamConnects;
+TelemetryCounter audioStationFailures;
+TelemetryCounter audioFillBuckets[TELEMETRY_FILL_BUCKETS];
+static TelemetryCounter audioFillSum;  // Сумма замеров (%) для _sum гистограммы
+TelemetryMillisCounter audioDecodeTime;
+
+TelemetryMillisCounter displayBusTime;
+
+TelemetryCounter wifiDisconnects;
+TelemetryCounter wifiReconnects;
+
+std::atomic<uint32_t> logWrites(0);
+std::atomic<uint32_t> flashBytesWritten(0);
+
+// Границы корзин времени итерации loop() (мкс)
+static const uint32_t loopBucketsUs[TELEMETRY_LOOP_BUCKETS] = {100, 500, 1000, 5000, 10000, 50000, 100000, 500000};
+static TelemetryCounter loopBuckets[TELEMETRY_LOOP_BUCKETS + 1];  // Последняя - больше 500мс
+static TelemetryMillisCounter loopTime;
+static std::atomic<uint32_t> loopMaxMicros(0);
+
+static unsigned long lastFillSample = 0;
+
+void telemetry_sample_audio_fill(int fillPercent) {
+    unsigned long now = millis();
+    if (now - lastFillSample < TELEMETRY_FILL_SAMPLE_INTERVAL) return;
+    lastFillSample = now;
+    fillPercent = constrain(fillPercent, 0, 100);
+    int bucket = fillPercent * TELEMETRY_FILL_BUCKETS / 100;
+    audioFillBuckets[min(bucket, TELEMETRY_FILL_BUCKETS - 1)].add();
+    audioFillSum.add(fillPercent);
+}
+
+void telemetry_loop_done(uint32_t micros) {
+    size_t bucket = 0;
+    while (bucket < TELEMETRY_LOOP_BUCKETS && micros > loopBucketsUs[bucket]) bucket++;
+    loopBuckets[bucket].add();
+
+    loopTime.add_micros(micros);
+    if (micros > loopMaxMicros.load(std::memory_order_relaxed)) {
+        loopMaxMicros.store(micros, std::memory_order_relaxed);
+    }
+}
+
+void telemetry_flash_written(size_t bytes) {
+    flashBytesWritten.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void telemetry_snapshot(TelemetrySnapshot& t) {
+    t.decodedKilosamples = audioDecodedSamples.get_kilo();
+    t.underruns = audioUnderruns.get();
+    t.streamConnects = audioStreamConnects.get();
+    t.stationFailures = audioStationFailures.get();
+    for (int i = 0; i < TELEMETRY_FILL_BUCKETS; i++) t.fillBuckets[i] = audioFillBuckets[i].get();
+    t.fillSum = audioFillSum.get();
+    t.decodeMillis = audioDecodeTime.get();
+
+    t.wifiDisconnects = wifiDisconnects.get();
+    t.wifiReconnects = wifiReconnects.get();
+    t.logWrites = logWrites.load(std::memory_order_relaxed);
+    t.flashBytes = flashBytesWritten.load(std::memory_order_relaxed);
+
+    t.framesRendered = displayFramesRendered;
+    t.framesSkipped = displayFramesSkipped;
+    t.flushes = displayFlushes;
+    t.busBytes = displayBusBytes;
+    t.busMillis = displayBusTime.get();
+    FramePacerStatus pacer = get_frame_pacer_status();
+    t.displayFps = pacer.fps;
+    t.displayTargetFps = pacer.targetFps;
+
+    t.freeHeap = ESP.getFreeHeap();
+    t.minFreeHeap = ESP.getMinFreeHeap();
+    t.maxAllocHeap = ESP.getMaxAllocHeap();
+
+    for (int i = 0; i <= TELEMETRY_LOOP_BUCKETS; i++) t.loopBuckets[i] = loopBuckets[i].get();
+    t.loopMillisTotal = loopTime.get();
+    t.loopMaxMicros = loopMaxMicros.load(std::memory_order_relaxed);
+    t.uptime = millis() / 1000;
+}
+
+// Секунды из микросекунд/миллисекунд без float
+static void print_micros_as_seconds(Print& out, uint32_t micros) {
+    out.printf("%lu.%06lu", (unsigned long)(micros / 1000000), (unsigned long)(micros % 1000000));
+}
+
+static void print_millis_as_seconds(Print& out, uint32_t ms) {
+    out.printf("%lu.%03lu", (unsigned long)(ms / 1000), (unsigned long)(ms % 1000));
+}
+
+bool write_telemetry_part(Print& out, const TelemetrySnapshot& t, size_t part) {
+    switch (part) {
+        case 0:
+            out.printf("# HELP audio_decoded_samples_total Stereo samples produced by the MP3 decoder\n"
+                       "# TYPE audio_decoded_samples_total counter\n"
+                       "audio_decoded_samples_total %lu",
+                       (unsigned long)t.decodedKilosamples);
+            // Тысячи -> сэмплы без 64-битного printf
+            out.print(t.decodedKilosamples ? "000\n" : "\n");
+            out.print("# HELP audio_decode_seconds_total Time spent in the MP3 decoder\n"
+                      "# TYPE audio_decode_seconds_total counter\n"
+                      "audio_decode_seconds_total ");
+            print_millis_as_seconds(out, t.decodeMillis);
+            out.printf("\n# HELP audio_underruns_total Stream buffer ran empty while playing\n"
+                       "# TYPE audio_underruns_total counter\n"
+                       "audio_underruns_total %lu\n"
+                       "# HELP audio_stream_connects_total Connections opened to a station stream\n"
+                       "# TYPE audio_stream_connects_total counter\n"
+                       "audio_stream_connects_total %lu\n"
+                       "# HELP audio_station_failures_total Stations that failed to start (bad URL, timeout, decoder)\n"
+                       "# TYPE audio_station_failures_total counter\n"
+                       "audio_station_failures_total %lu\n",
+                       (unsigned long)t.underruns, (unsigned long)t.streamConnects,
+                       (unsigned long)t.stationFailures);
+            return true;
+
+        case 1: {
+            // Замеры раз в TELEMETRY_FILL_SAMPLE_INTERVAL во время воспроизведения
+            out.print("# HELP audio_buffer_fill_percent Stream buffer fill, sampled while playing\n"
+                      "# TYPE audio_buffer_fill_percent histogram\n");
+            uint32_t cumulative = 0;
+            for (int i = 0; i < TELEMETRY_FILL_BUCKETS; i++) {
+                cumulative += t.fillBuckets[i];
+                if (i < TELEMETRY_FILL_BUCKETS - 1) {
+                    out.printf("audio_buffer_fill_percent_bucket{le=\"%d\"} %lu\n",
+                               (i + 1) * 100 / TELEMETRY_FILL_BUCKETS, (unsigned long)cumulative);
+                }
+            }
+            out.printf("audio_buffer_fill_percent_bucket{le=\"+Inf\"} %lu\n"
+                       "audio_buffer_fill_percent_sum %lu\n"
+                       "audio_buffer_fill_percent_count %lu\n",
+                       (unsigned long)cumulative, (unsigned long)t.fillSum, (unsigned long)cumulative);
+            return true;
+        }
+
+        case 2:
+            out.printf("# HELP wifi_disconnects_total WiFi connection lost in station mode\n"
+                       "# TYPE wifi_disconnects_total counter\n"
+                       "wifi_disconnects_total %lu\n"
+                       "# HELP wifi_reconnects_total WiFi connection restored (automatic or manual)\n"
+                       "# TYPE wifi_reconnects_total counter\n"
+                       "wifi_reconnects_total %lu\n"
+                       "# HELP log_writes_total Lines written to the log\n"
+                       "# TYPE log_writes_total counter\n"
+                       "log_writes_total %lu\n"
+                       "# HELP flash_bytes_written_total Bytes written to LittleFS (log, configs, import)\n"
+                       "# TYPE flash_bytes_written_total counter\n"
+                       "flash_bytes_written_total %lu\n",
+                       (unsigned long)t.wifiDisconnects, (unsigned long)t.wifiReconnects,
+                       (unsigned long)t.logWrites, (unsigned long)t.flashBytes);
+            return true;
+
+        case 3:
+            out.printf("# HELP display_frames_total Display frames by result\n"
+                       "# TYPE display_frames_total counter\n"
+                       "display_frames_total{result=\"rendered\"} %lu\n"
+                       "display_frames_total{result=\"skipped\"} %lu\n"
+                       "# HELP display_flushes_total Flushes to the OLED\n"
+                       "# TYPE display_flushes_total counter\n"
+                       "display_flushes_total %lu\n"
+                       "# HELP display_bus_bytes_total Bytes sent to the OLED over I2C/SPI\n"
+                       "# TYPE display_bus_bytes_total counter\n"
+                       "display_bus_bytes_total %lu\n"
+                       "# HELP display_bus_seconds_total Time spent in display flushes\n"
+                       "# TYPE display_bus_seconds_total counter\n"
+                       "display_bus_seconds_total ",
+                       (unsigned long)t.framesRendered, (unsigned long)t.framesSkipped,
+                       (unsigned long)t.flushes, (unsigned long)t.busBytes);
+            print_millis_as_seconds(out, t.busMillis);
+            out.printf("\n# HELP display_fps Frames drawn in the last pacer window\n"
+                       "# TYPE display_fps gauge\n"
+                       "display_fps %u\n"
+                       "# HELP display_target_fps Current frame pacer target\n"
+                       "# TYPE display_target_fps gauge\n"
+                       "display_target_fps %u\n",
+                       (unsigned)t.displayFps, (unsigned)t.displayTargetFps);
+            return true;
+
+        case 4:
+            out.printf("# HELP system_heap_free_bytes Free heap\n"
+                       "# TYPE system_heap_free_bytes gauge\n"
+                       "system_heap_free_bytes %lu\n"
+                       "# HELP system_heap_min_free_bytes Lowest free heap since boot\n"
+                       "# TYPE system_heap_min_free_bytes gauge\n"
+                       "system_heap_min_free_bytes %lu\n"
+                       "# HELP system_heap_largest_block_bytes Largest allocatable heap block\n"
+                       "# TYPE system_heap_largest_block_bytes gauge\n"
+                       "system_heap_largest_block_bytes %lu\n"
+                       "# HELP system_uptime_seconds Time since boot\n"
+                       "# TYPE system_uptime_seconds gauge\n"
+                       "system_uptime_seconds %lu\n",
+                       (unsigned long)t.freeHeap, (unsigned long)t.minFreeHeap,
+                       (unsigned long)t.maxAllocHeap, (unsigned long)t.uptime);
+            return true;
+
+        case 5: {
+            out.print("# HELP main_loop_duration_seconds Time of one loop() iteration (audio, input, display, web events)\n"
+                      "# TYPE main_loop_duration_seconds histogram\n");
+            uint32_t cumulative = 0;
+            for (int i = 0; i <= TELEMETRY_LOOP_BUCKETS; i++) {
+                cumulative += t.loopBuckets[i];
+                out.print("main_loop_duration_seconds_bucket{le=\"");
+                if (i == TELEMETRY_LOOP_BUCKETS) out.print("+Inf");
+                else print_micros_as_seconds(out, loopBucketsUs[i]);
+                out.printf("\"} %lu\n", (unsigned long)cumulative);
+            }
+            out.print("main_loop_duration_seconds_sum ");
+            print_millis_as_seconds(out, t.loopMillisTotal);
+            out.printf("\nmain_loop_duration_seconds_count %lu\n"
+                       "# HELP main_loop_max_seconds Longest loop() iteration since boot\n"
+                       "# TYPE main_loop_max_seconds gauge\n"
+                       "main_loop_max_seconds ",
+                       (unsigned long)cumulative);
+            print_micros_as_seconds(out, t.loopMaxMicros);
+            out.print('\n');
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// === ТЕЛЕМЕТРИЯ ПОДСИСТЕМ (/api/metrics) ===
+// Счетчики пишутся с горячих путей (декодер, main loop), поэтому без блокировок.
+// У ESP32-C3 (RV32IMC) нет атомарных инструкций: fetch_add на std::atomic уходит
+// в __atomic_* из libatomic с запретом прерываний. TelemetryCounter с одним писателем
+// обходится relaxed load + store - это обычные lw/sw. Веб-сервер только читает.
+// Счетчики, которые пишут и loop(), и AsyncTCP (лог, запись во flash), - fetch_add:
+// они не на горячем пути.
+
+class TelemetryCounter {
+public:
+    void add(uint32_t n = 1) {
+        _value.store(_value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    uint32_t get() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> _value{0};
+};
+
+// Время в мс из замеров в мкс: 32-битная сумма мкс переполнилась бы за 71 минуту.
+// Остаток меньше миллисекунды переносится в следующий замер. Один писатель
+class TelemetryMillisCounter {
+public:
+    void add_micros(uint32_t micros) {
+        _remainder += micros;
+        if (_remainder >= 1000) {
+            _millis.add(_remainder / 1000);
+            _remainder %= 1000;
+        }
+    }
+    uint32_t get() const { return _millis.get(); }
+
+private:
+    TelemetryCounter _millis;
+    uint32_t _remainder = 0;
+};
+
+// Счет тысячами: сэмплы идут по одному, 44100 в секунду - 32 бита кончились бы
+// за 27 часов, тысяч хватит на 3 года. 64-битный атомик на RV32 - снова libatomic.
+// Остаток меньше тысячи ждет следующих сэмплов. Один писатель
+class TelemetryKiloCounter {
+public:
+    void add(uint32_t n = 1) {
+        _remainder += n;
+        if (_remainder >= 1000) {
+            _kilo.add(_remainder / 1000);
+            _remainder %= 1000;
+        }
+    }
+    uint32_t get_kilo() const { return _kilo.get(); }
+
+private:
+    TelemetryCounter _kilo;
+    uint32_t _remainder = 0;
+};
+
+#define TELEMETRY_FILL_BUCKETS  10  // Гистограмма заполнения буфера: по 10%
+#define TELEMETRY_LOOP_BUCKETS  8   // Гистограмма времени итерации loop()
+
+// --- Аудио (пишет loop) ---
+extern TelemetryKiloCounter audioDecodedSamples;  // Стерео-сэмплов на выходе декодера
+extern TelemetryCounter audioUnderruns;        // Буфер потока опустел во время воспроизведения
+extern TelemetryCounter audioStreamConnects;   // Подключений к потоку станции
+extern TelemetryCounter audioStationFailures;  // Станция не запустилась (URL, таймаут, декодер)
+extern TelemetryCounter audioFillBuckets[TELEMETRY_FILL_BUCKETS];
+extern TelemetryMillisCounter audioDecodeTime;   // Время в декодере MP3
+
+// --- Дисплей (пишет loop) ---
+extern TelemetryMillisCounter displayBusTime;    // Время в flush на OLED
+
+// --- WiFi (пишет loop) ---
+extern TelemetryCounter wifiDisconnects;       // Потерь связи в режиме STA
+extern TelemetryCounter wifiReconnects;        // Восстановлений (авто и ручных)
+
+// --- Лог и flash (пишут обе задачи) ---
+extern std::atomic<uint32_t> logWrites;
+extern std::atomic<uint32_t> flashBytesWritten;  // Все записи в LittleFS: лог, конфиги, импорт
+
+void telemetry_sample_audio_fill(int fillPercent);  // Из loop_audio, сам ограничивает частоту
+void telemetry_loop_done(uint32_t micros);          // Конец итерации loop()
+void telemetry_flash_written(size_t bytes);
+
+// Снимок для /api/metrics: берется целиком в начале ответа
+struct TelemetrySnapshot {
+    uint32_t decodedKilosamples, underruns, streamConnects, stationFailures;
+    uint32_t fillBuckets[TELEMETRY_FILL_BUCKETS];
+    uint32_t fillSum;
+    uint32_t decodeMillis;
+    uint32_t wifiDisconnects, wifiReconnects;
+    uint32_t logWrites, flashBytes;
+    uint32_t framesRendered, framesSkipped, flushes, busBytes, busMillis;
+    uint8_t displayFps, displayTargetFps;
+    uint32_t freeHeap, minFreeHeap, maxAllocHeap;
+    uint32_t loopBuckets[TELEMETRY_LOOP_BUCKETS + 1];
+    uint32_t loopMillisTotal, loopMaxMicros;
+    uint32_t uptime;
+};
+
+void telemetry_snapshot(TelemetrySnapshot& t);
+
+// Часть part ответа /api/metrics (chunked, по части за раз); false - частей больше нет
+bool write_telemetry_part(Print& out, const TelemetrySnapshot& t, size_t part);
+
+#endif // TELEMETRY_H
@@ -2,6 +2,9 @@
 #include <ArduinoJson.h>
 #include <AsyncJson.h>
 #include <LittleFS.h>
+#include <memory>
+#include <array>
+#include <atomic>
 #include "config.h"
 #include "web_server_manager.h"
 #include "wifi_manager.h"
@@ -10,66 +13,1743 @@
 #include "credentials_helper.h"
 #include "log_manager.h"
 #include "system_manager.h"
+#include "frame_pacer.h"
 #include "url_validator.h"
 #include "string_utils.h"
+#include "json_writer.h"
+#include "web_session.h"
+#include "wifi_scan.h"
+#include "telemetry.h"
 
 // Веб-сервер
 AsyncWebServer server(80);
 
 // === ФУНКЦИИ ОТПРАВКИ КОМАНД (из main.cpp) ===
-extern bool sendVolumeCommand(float volume);
+extern void postVolumeSetting(float volume);
+extern void postVisualizerStyleSetting(uint8_t style);
+extern void postRotationSetting(uint8_t rotation);
 extern bool sendNextStationCommand();
 extern bool sendPrevStationCommand();
 extern bool sendRebootCommand();
 extern bool sendSaveStationsCommand();
-
-// Флаг: веб-сервер загружает большой файл (приостановить audio)
-// ATOMIC: memory-safe для асинхронного доступа
-std::atomic<bool> web_loading_html(false);
+extern bool sendSelectStationCommand(int index);
+extern bool sendApplyWifiCommand(unsigned long requestedAt);
+extern unsigned long wifiApplyToAudioMs;
+extern std::atomic<uint32_t> commandQueueRejected;
+extern std::atomic<uint32_t> settingsPosted;
+extern std::atomic<uint32_t> settingsCoalesced;
+extern std::atomic<uint32_t> settingsApplied;
+extern std::atomic<uint32_t> settingsLagMicros;
+extern std::atomic<uint32_t> settingsLagMaxMicros;
 
 // Состояние авторизации
 static bool isRegistered = false;
-static bool isAuthenticated = false;
+// Слот сессии по cookie или заголовку X-Session-Token запроса, или -1. Без String: заголовок ищется перебором
+// (name() и value() - ссылки на уже разобранные строки), cookie разбирается на месте
+static int request_session(AsyncWebServerRequest *request) {
+    size_t count = request->headers();
+    for (size_t i = 0; i < count; i++) {
+        const AsyncWebHeader* header = request->getHeader(i);
+        if (!header) continue;
+        int slot = -1;
+        if (header->name().equalsIgnoreCase("Cookie")) {
+            slot = web_session_from_cookie(header->value().c_str());
+        } else if (header->name().equalsIgnoreCase("X-Session-Token")) {
+            slot = web_session_find(header->value().c_str(), header->value().length());
+        }
+        if (slot >= 0) return slot;
+    }
+    return -1;
+}
+
+// Фильтр обработчика, доступного только с сессией. Фильтры вызываются для каждого
+// запроса до canHandle, поэтому чужой URL пропускаем сразу (его отсеет canHandle) -
+// заголовки разбираются только для запросов к самому обработчику
+static bool session_filter(AsyncWebServerRequest *request, const char* url) {
+    return request->url() != url || request_session(request) >= 0;
+}
+
+// === ДОПУСК ПО ПАМЯТИ ===
+// Без PSRAM большие ответы конкурируют за heap с AudioFileSourceBuffer (128KB при
+// каждом переподключении) и буферами AsyncTCP. Перед вызовом обработчика маршрута
+// проверяем свободный heap и наибольший свободный блок; потоковые ответы в полете
+// еще будут занимать буферы TCP, поэтому их резерв вычитается из свободной памяти заранее.
+// Не прошел - 503 с Retry-After, обработчик не вызывается. Счетчики и тикеты
+// меняет только задача AsyncTCP - блокировки не нужны.
+enum AdmitReason {
+    ADMIT_OK,
+    ADMIT_HEAP,        // Мало свободного heap
+    ADMIT_BLOCK,       // Heap фрагментирован - нет блока WEB_ADMIT_MIN_BLOCK
+    ADMIT_INFLIGHT,    // Уже WEB_ADMIT_MAX_STREAMS потоковых ответов
+    ADMIT_REASONS
+};
 
-// Макрос для проверки авторизации (включая токен)
-#define CHECK_AUTH() \
-    if (checkSessionToken(request)) isAuthenticated = true; \
-    if (!isAuthenticated) return request->send(401);
+static const char* const admitReasonNames[ADMIT_REASONS] = {"ok", "heap", "block", "inflight"};
+static uint32_t admitRejected[ADMIT_REASONS] = {0};
+static uint8_t inflightStreams = 0;
+static unsigned long lastAdmitLog = 0;
 
-// Генерация случайного сессионного токена
-String generateSessionToken() {
-    const char* chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-    String token = "";
-    token.reserve(SESSION_TOKEN_LENGTH); // Предварительное выделение памяти
-    for (int i = 0; i < SESSION_TOKEN_LENGTH; i++) {
-        token += chars[random(0, 62)];
+// Живет в состоянии потокового ответа: пока ответ отдается, держит резерв памяти
+struct InflightTicket {
+    InflightTicket() { inflightStreams++; }
+    ~InflightTicket() { inflightStreams--; }
+    InflightTicket(const InflightTicket&) = delete;
+    InflightTicket& operator=(const InflightTicket&) = delete;
+};
+
+static AdmitReason web_admit() {
+    if (inflightStreams >= WEB_ADMIT_MAX_STREAMS) return ADMIT_INFLIGHT;
+    uint32_t reserve = (uint32_t)inflightStreams * WEB_ADMIT_STREAM_COST;
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < WEB_ADMIT_MIN_FREE_HEAP + reserve) return ADMIT_HEAP;
+    if (ESP.getMaxAllocHeap() < WEB_ADMIT_MIN_BLOCK) return ADMIT_BLOCK;
+    return ADMIT_OK;
+}
+
+static void send_busy(AsyncWebServerRequest *request) {
+    AsyncWebServerResponse *response = request->beginResponse(503, "application/json; charset=utf-8",
+                                                              "{\"error\":\"Server busy\"}");
+    response->addHeader("Retry-After", String(WEB_ADMIT_RETRY_AFTER));
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
+// Проверка допуска: отказ - отвечает 503 и возвращает false
+static bool admit_request(AsyncWebServerRequest *request) {
+    AdmitReason reason = web_admit();
+    if (reason == ADMIT_OK) return true;
+
+    admitRejected[reason]++;
+    if (millis() - lastAdmitLog >= 5000) {
+        Serial.printf("🚦 503 %s: %s (heap %u, блок %u, потоков %u)\n",
+                      request->url().c_str(), admitReasonNames[reason], ESP.getFreeHeap(),
+                      ESP.getMaxAllocHeap(), inflightStreams);
+        lastAdmitLog = millis();
     }
-    return token;
+    send_busy(request);
+    return false;
 }
 
-// Проверка сессионного токена из куки
-bool checkSessionToken(AsyncWebServerRequest *request) {
-    if (sessionToken.length() == 0) return false;
-    
-    // Проверяем куки
-    if (request->hasHeader("Cookie")) {
-        String cookie = request->header("Cookie");
-        int tokenPos = cookie.indexOf("session=");
-        if (tokenPos != -1) {
-            int tokenStart = tokenPos + 8;
-            int tokenEnd = cookie.indexOf(";", tokenStart);
-            String clientToken = (tokenEnd == -1) ? 
-                cookie.substring(tokenStart) : 
-                cookie.substring(tokenStart, tokenEnd);
-            
-            if (clientToken == sessionToken) {
-                return true;
+// === ОТДАЧА ФАЙЛОВ КУСКАМИ ===
+// Вместо AsyncFileResponse и паузы аудио: файл читается из LittleFS кусками
+// не больше WEB_FILE_CHUNK_MAX, по одному куску на каждый ACK клиента.
+// Между кусками задача AsyncTCP спит и loop() с декодером работает.
+// Если чтение куска дольше WEB_FILE_CHUNK_BUDGET_US - кусок уменьшается.
+// start/length - отдать только часть файла (логи с заданного смещения).
+// Ответ chunked: если файл укоротили во время отдачи (очистка лога на лимите),
+// чтение вернет 0 и ответ честно закончится, а не повиснет в ожидании
+// обещанного Content-Length.
+struct SlicedFileState {
+    InflightTicket ticket;
+    File file;
+    String path;
+    size_t chunkSize;
+    uint16_t chunks;
+    unsigned long maxChunkMicros;
+};
+
+static AsyncWebServerResponse* begin_sliced_file_response(AsyncWebServerRequest *request,
+                                                          const String& fsPath,
+                                                          const char* contentType,
+                                                          size_t start = 0,
+                                                          size_t length = SIZE_MAX) {
+    std::shared_ptr<SlicedFileState> state = std::make_shared<SlicedFileState>();
+    state->file = LittleFS.open(fsPath, "r");
+    if (!state->file) return nullptr;
+    state->path = fsPath;
+    state->chunkSize = WEB_FILE_CHUNK_MAX;
+    state->chunks = 0;
+    state->maxChunkMicros = 0;
+    size_t fileSize = state->file.size();
+    if (start > fileSize) start = fileSize;
+    size_t total = min(fileSize - start, length);
+    if (start > 0) state->file.seek(start);
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse(contentType,
+        [state, total](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            if (!state->file || index >= total) return 0;
+            size_t want = min(min(maxLen, state->chunkSize), total - index);
+
+            unsigned long t0 = micros();
+            size_t n = state->file.read(buffer, want);
+            unsigned long spent = micros() - t0;
+
+            // Адаптация размера куска под бюджет CPU
+            if (spent > WEB_FILE_CHUNK_BUDGET_US && state->chunkSize > WEB_FILE_CHUNK_MIN) {
+                state->chunkSize = max((size_t)WEB_FILE_CHUNK_MIN, state->chunkSize / 2);
+            } else if (spent < WEB_FILE_CHUNK_BUDGET_US / 2 && state->chunkSize < WEB_FILE_CHUNK_MAX) {
+                state->chunkSize = min((size_t)WEB_FILE_CHUNK_MAX, state->chunkSize * 2);
             }
+            state->chunks++;
+            if (spent > state->maxChunkMicros) state->maxChunkMicros = spent;
+
+            if (n == 0 || index + n >= total) {
+                Serial.printf("📄 %s: %u байт, %u кусков, макс %lu мкс/кусок\n",
+                              state->path.c_str(), (unsigned)(index + n), state->chunks, state->maxChunkMicros);
+                state->file.close();
+            }
+            return n;
+        });
+
+    if (fsPath.endsWith(".gz")) {
+        response->addHeader("Content-Encoding", "gzip");
+    }
+    return response;
+}
+
+// === JSON ОТВЕТЫ БЕЗ JsonDocument ===
+// 📊 Пик heap обработчика: разница между свободной памятью на входе
+// и минимумом, замеченным во время сборки/отдачи ответа
+struct WebHeapProbe {
+    uint32_t before;
+    uint32_t lowest;
+
+    WebHeapProbe() : before(ESP.getFreeHeap()), lowest(before) {}
+
+    void sample() {
+        uint32_t freeHeap = ESP.getFreeHeap();
+        if (freeHeap < lowest) lowest = freeHeap;
+    }
+
+    void report(const char* route, size_t bytes) {
+        Serial.printf("📊 %s: %u байт, пик heap %u байт\n", route, (unsigned)bytes, (unsigned)(before - lowest));
+    }
+};
+
+// Список станций потоком (chunked): без копии вектора, JsonDocument и String.
+// Каждая станция пишется прямо в буфер TCP под коротким STATIONS_LOCK.
+// Станция, не поместившаяся в кусок, пишется заново в следующем и
+// WindowPrint пропускает уже отправленные байты.
+//
+// Режим дельты (?since=rev): {"rev":R,"count":N,"changes":[{"index":i,"name":..,"url":..}]}
+// - только позиции, измененные после rev. Клиент обрезает список до count
+// и заменяет перечисленные позиции.
+//
+// Ревизия фиксируется в начале запроса (по ней же ETag). Если список изменили
+// посреди отдачи, поток обрывается до закрывающей скобки: клиент получит
+// невалидный JSON и перезапросит, а не смесь старых и новых станций. Закешированный
+// обрывок не всплывет по If-None-Match - эта ревизия больше не повторится.
+struct StationsStreamState {
+    InflightTicket ticket;
+    bool delta;
+    uint32_t since;
+    uint32_t revision;      // stationsRevision на начало запроса
+    bool opened;
+    bool closed;
+    bool aborted;           // Список изменился посреди отдачи
+    size_t index;           // Следующая станция
+    size_t emitted;         // Отправлено элементов (для запятых)
+    size_t offset;          // Уже отправлено байт текущего элемента
+    size_t bytes;
+    WebHeapProbe probe;
+};
+
+// Пишет текущий элемент потока: заголовок, станцию (или ничего, если она не менялась) или конец.
+// Возвращает true, если записан элемент массива. Список изменился - ничего не пишет
+// и выставляет state.aborted
+static bool write_stations_stream_part(StationsStreamState& state, Print& out, bool& closing) {
+    closing = false;
+    bool element = false;
+    STATIONS_LOCK();
+    if (stationsRevision != state.revision) {
+        state.aborted = true;
+    } else if (!state.opened) {
+        if (state.delta) {
+            out.print("{\"rev\":");
+            out.print(state.revision);
+            out.print(",\"count\":");
+            out.print(stations.size());
+            out.print(",\"changes\":[");
+        } else {
+            out.write('[');
+        }
+    } else if (state.index < stations.size()) {
+        const RadioStation& station = stations[state.index];
+        if (!state.delta || station.revision > state.since) {
+            if (state.emitted > 0) out.write(',');
+            JsonWriter json(out);
+            json.beginObject();
+            if (state.delta) json.field("index", state.index);
+            json.field("name", station.name).field("url", station.url).endObject();
+            element = true;
+        }
+    } else {
+        closing = true;
+        out.print(state.delta ? "]}" : "]");
+    }
+    STATIONS_UNLOCK();
+    return element;
+}
+
+static AsyncWebServerResponse* begin_stations_json_response(AsyncWebServerRequest *request,
+                                                            uint32_t revision, bool delta, uint32_t since) {
+    std::shared_ptr<StationsStreamState> state = std::make_shared<StationsStreamState>();
+    state->delta = delta;
+    state->since = since;
+    state->revision = revision;
+    state->opened = false;
+    state->closed = false;
+    state->aborted = false;
+    state->index = 0;
+    state->emitted = 0;
+    state->offset = 0;
+    state->bytes = 0;
+
+    return request->beginChunkedResponse("application/json; charset=utf-8",
+        [state](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            size_t len = 0;
+            while (!state->closed && len < maxLen) {
+                WindowPrint out(buffer + len, maxLen - len, state->offset);
+                bool closing;
+                bool element = write_stations_stream_part(*state, out, closing);
+                if (state->aborted) {
+                    state->closed = true;
+                    break;
+                }
+                len += out.stored();
+                if (!out.complete()) {
+                    state->offset += out.stored();
+                    break;
+                }
+                state->offset = 0;
+                if (!state->opened) {
+                    state->opened = true;
+                } else if (closing) {
+                    state->closed = true;
+                } else {
+                    if (element) state->emitted++;
+                    state->index++;
+                }
+            }
+            state->bytes += len;
+            state->probe.sample();
+            if (state->closed && len == 0) {
+                if (state->aborted) {
+                    Serial.printf("📋 /api/stations: список изменен во время отдачи (ревизия %lu), поток оборван\n",
+                                  (unsigned long)state->revision);
+                }
+                state->probe.report(state->delta ? "/api/stations?since" : "/api/stations", state->bytes);
+            }
+            return len;
+        });
+}
+
+// ETag по ревизии: If-None-Match совпал - отвечает 304 и возвращает true
+static bool send_not_modified(AsyncWebServerRequest *request, const char* etag) {
+    AsyncWebHeader* ifNoneMatch = request->getHeader("If-None-Match");
+    if (!ifNoneMatch || !ifNoneMatch->value().equals(etag)) return false;
+    AsyncWebServerResponse *response = request->beginResponse(304);
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+    return true;
+}
+
+// === КАНАЛ УПРАВЛЕНИЯ (WebSocket /api/control) ===
+// Двоичные команды вместо POST на каждое действие: соединение открывается
+// один раз с cookie сессии, дальше команда - 2-4 байта без заголовков HTTP.
+// Команда: [op][seq][аргументы], ответ на каждую: [op | 0x80][seq][status].
+// Подтверждение означает "принято" (очередь команд или почтовый ящик настроек),
+// применяет loop(). Соединение привязано к токену сессии на момент подключения:
+// после /logout или смены токена следующая команда закрывает соединение.
+enum ControlOp : uint8_t {
+    CONTROL_PING       = 0x00,  // Без аргументов - замер RTT
+    CONTROL_VOLUME     = 0x01,  // [u8 громкость 0-100]
+    CONTROL_NEXT       = 0x02,
+    CONTROL_PREV       = 0x03,
+    CONTROL_SELECT     = 0x04,  // [u16 LE номер станции]
+    CONTROL_VISUALIZER = 0x05   // [u8 стиль]
+};
+
+enum ControlStatus : uint8_t {
+    CONTROL_OK,
+    CONTROL_BAD_ARGS,      // Длина или значение вне диапазона
+    CONTROL_BUSY,          // Очередь команд заполнена - повторить позже
+    CONTROL_UNKNOWN,       // Неизвестная команда
+    CONTROL_UNAUTHORIZED,  // Сессия закончилась - соединение закрывается
+    CONTROL_STATUSES
+};
+
+static const char* const controlStatusNames[CONTROL_STATUSES] = {"ok", "bad_args", "busy", "unknown", "unauthorized"};
+
+struct ControlClient {
+    uint32_t id;                           // 0 - слот свободен
+    char token[SESSION_TOKEN_LENGTH + 1];  // Токен сессии при подключении
+};
+
+static AsyncWebSocket controlSocket("/api/control");
+static ControlClient controlClients[WEB_CONTROL_MAX_CLIENTS];
+static uint32_t controlAcks[CONTROL_STATUSES] = {0};
+
+static ControlClient* control_slot(uint32_t id) {
+    for (size_t i = 0; i < WEB_CONTROL_MAX_CLIENTS; i++) {
+        if (controlClients[i].id == id) return &controlClients[i];
+    }
+    return nullptr;
+}
+
+static ControlStatus run_control_command(const uint8_t* data, size_t len) {
+    switch (data[0]) {
+        case CONTROL_PING:
+            return len == 2 ? CONTROL_OK : CONTROL_BAD_ARGS;
+
+        case CONTROL_VOLUME:
+            if (len != 3 || data[2] > 100) return CONTROL_BAD_ARGS;
+            postVolumeSetting(data[2] / 100.0f);
+            return CONTROL_OK;
+
+        case CONTROL_NEXT:
+            if (len != 2) return CONTROL_BAD_ARGS;
+            return sendNextStationCommand() ? CONTROL_OK : CONTROL_BUSY;
+
+        case CONTROL_PREV:
+            if (len != 2) return CONTROL_BAD_ARGS;
+            return sendPrevStationCommand() ? CONTROL_OK : CONTROL_BUSY;
+
+        case CONTROL_SELECT: {
+            if (len != 4) return CONTROL_BAD_ARGS;
+            size_t index = data[2] | (data[3] << 8);
+            STATIONS_LOCK();
+            bool valid = index < stations.size();
+            STATIONS_UNLOCK();
+            if (!valid) return CONTROL_BAD_ARGS;
+            return sendSelectStationCommand(index) ? CONTROL_OK : CONTROL_BUSY;
+        }
+
+        case CONTROL_VISUALIZER:
+            if (len != 3 || data[2] >= VISUALIZER_STYLE_COUNT) return CONTROL_BAD_ARGS;
+            postVisualizerStyleSetting(data[2]);
+            return CONTROL_OK;
+
+        default:
+            return CONTROL_UNKNOWN;
+    }
+}
+
+static void on_control_event(AsyncWebSocket *socket, AsyncWebSocketClient *client,
+                             AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    if (type == WS_EVT_CONNECT) {
+        // arg - запрос upgrade этого клиента. Сессию берем из него, а не из фильтра:
+        // между фильтром и подключением успевают пройти другие запросы, а сессия -
+        // закончиться
+        int session = request_session((AsyncWebServerRequest*)arg);
+        if (session < 0) {
+            client->close(1008);  // Policy Violation
+            return;
+        }
+        ControlClient* slot = control_slot(0);
+        if (!slot) {
+            client->close(1013);  // Try Again Later
+            Serial.printf("🎛️ /api/control: отказ, уже %d клиентов\n", WEB_CONTROL_MAX_CLIENTS);
+            return;
+        }
+        slot->id = client->id();
+        strlcpy(slot->token, web_session_token(session), sizeof(slot->token));
+        Serial.printf("🎛️ /api/control: клиент #%lu подключен\n", (unsigned long)client->id());
+    } else if (type == WS_EVT_DISCONNECT) {
+        ControlClient* slot = control_slot(client->id());
+        if (slot) slot->id = 0;
+    } else if (type == WS_EVT_DATA) {
+        // Команды короткие: принимаем только целый двоичный кадр
+        AwsFrameInfo* info = (AwsFrameInfo*)arg;
+        if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_BINARY || len < 2) return;
+
+        uint8_t ack[3] = {(uint8_t)(data[0] | 0x80), data[1], CONTROL_OK};
+        ControlClient* slot = control_slot(client->id());
+        if (!slot || web_session_find(slot->token, strlen(slot->token)) < 0) {
+            ack[2] = CONTROL_UNAUTHORIZED;
+            controlAcks[CONTROL_UNAUTHORIZED]++;
+            client->binary(ack, sizeof(ack));
+            client->close(1008);  // Policy Violation
+            return;
+        }
+        ack[2] = run_control_command(data, len);
+        controlAcks[ack[2]]++;
+        client->binary(ack, sizeof(ack));
+    }
+}
+
+static void setup_control_socket() {
+    // Только с действующим cookie сессии: без нее upgrade отклоняется фильтром,
+    // токен для повторных проверок запоминается в WS_EVT_CONNECT
+    controlSocket.setFilter([](AsyncWebServerRequest *request) {
+        return session_filter(request, controlSocket.url());
+    });
+    controlSocket.onEvent(on_control_event);
+    server.addHandler(&controlSocket);
+}
+
+// === СЛОТЫ КЛИЕНТОВ WEBSOCKET, КОТОРЫМ ПИШЕТ MAIN LOOP ===
+// Спектр и зеркало OLED отправляют кадры из loop(), а слоты клиентов заполняют и
+// освобождают WS_EVT_CONNECT/DISCONNECT в задаче AsyncTCP. Библиотека шлет DISCONNECT
+// из деструктора клиента: пока обработчик не вернулся, объект жив. Поэтому слот хранит
+// сам указатель на клиента, а loop() берет его и вызывает queueIsFull()/binary() под
+// wsSlotsMutex - DISCONNECT ждет конца отправки и только потом очищает слот.
+// Порядок захвата: обработчики событий уже держат блокировку сокета, затем wsSlotsMutex;
+// loop() под wsSlotsMutex не вызывает методы сокета (client(), count()) - только клиента
+static SemaphoreHandle_t wsSlotsMutex = nullptr;
+#define WS_SLOTS_LOCK()   xSemaphoreTake(wsSlotsMutex, portMAX_DELAY)
+#define WS_SLOTS_UNLOCK() xSemaphoreGive(wsSlotsMutex)
+
+// === СПЕКТР ДЛЯ ВЕБ-ИНТЕРФЕЙСА (WebSocket /api/spectrum) ===
+// Те же 16 полос, что рисует OLED: кадр - 16 байт visualizerBands (0-32).
+// Кадры собирает main loop из уже посчитанного массива, декодер ничего
+// дополнительно не делает. Частоту выбирает клиент: [0x01, fps] -> ответ
+// [0x81, принятая fps] в пределах WEB_SPECTRUM_FPS_MIN..MAX. Если очередь
+// клиента заполнена (WS_MAX_QUEUED_MESSAGES), кадр для него отбрасывается -
+// отставать на старых кадрах бессмысленно. Неизменившийся кадр не отправляется.
+// Слоты - под wsSlotsMutex
+struct SpectrumClient {
+    AsyncWebSocketClient* client;     // nullptr - слот свободен
+    uint8_t fps;
+    unsigned long lastFrame;
+    uint8_t last[VISUALIZER_BANDS];   // Последний отправленный кадр
+};
+
+static AsyncWebSocket spectrumSocket("/api/spectrum");
+static SpectrumClient spectrumClients[WEB_SPECTRUM_MAX_CLIENTS];
+static std::atomic<uint32_t> spectrumFramesSent{0};     // Пишет loop(), читает /api/metrics
+static std::atomic<uint32_t> spectrumFramesDropped{0};
+
+// Вызывать под WS_SLOTS_LOCK
+static SpectrumClient* spectrum_slot(AsyncWebSocketClient* client) {
+    for (size_t i = 0; i < WEB_SPECTRUM_MAX_CLIENTS; i++) {
+        if (spectrumClients[i].client == client) return &spectrumClients[i];
+    }
+    return nullptr;
+}
+
+static void on_spectrum_event(AsyncWebSocket *socket, AsyncWebSocketClient *client,
+                              AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    if (type == WS_EVT_CONNECT) {
+        WS_SLOTS_LOCK();
+        SpectrumClient* slot = spectrum_slot(nullptr);
+        if (slot) {
+            slot->fps = WEB_SPECTRUM_FPS_DEFAULT;
+            slot->lastFrame = 0;
+            memset(slot->last, 0xFF, sizeof(slot->last));  // Первый кадр уйдет в любом случае
+            slot->client = client;
+        }
+        WS_SLOTS_UNLOCK();
+        if (!slot) client->close(1013);  // Try Again Later
+    } else if (type == WS_EVT_DISCONNECT) {
+        WS_SLOTS_LOCK();
+        SpectrumClient* slot = spectrum_slot(client);
+        if (slot) slot->client = nullptr;
+        WS_SLOTS_UNLOCK();
+    } else if (type == WS_EVT_DATA) {
+        AwsFrameInfo* info = (AwsFrameInfo*)arg;
+        if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_BINARY) return;
+        if (len != 2 || data[0] != 0x01) return;
+        // Ответ - под тем же мьютексом: между queueIsFull() и binary() в loop() очередь не растет
+        WS_SLOTS_LOCK();
+        SpectrumClient* slot = spectrum_slot(client);
+        if (slot) {
+            slot->fps = constrain(data[1], WEB_SPECTRUM_FPS_MIN, WEB_SPECTRUM_FPS_MAX);
+            uint8_t ack[2] = {0x81, slot->fps};
+            client->binary(ack, sizeof(ack));
+        }
+        WS_SLOTS_UNLOCK();
+    }
+}
+
+// Из main loop (loop_web_events): раздать кадр тем, кому пора
+static void loop_spectrum_stream() {
+    if (spectrumSocket.count() == 0) return;
+
+    uint8_t frame[VISUALIZER_BANDS];
+    bool built = false;
+    unsigned long now = millis();
+    WS_SLOTS_LOCK();
+    for (size_t i = 0; i < WEB_SPECTRUM_MAX_CLIENTS; i++) {
+        SpectrumClient& slot = spectrumClients[i];
+        if (!slot.client || now - slot.lastFrame < 1000UL / slot.fps) continue;
+        slot.lastFrame = now;
+
+        if (!built) {
+            for (size_t b = 0; b < VISUALIZER_BANDS; b++) frame[b] = (uint8_t)visualizerBands[b];
+            built = true;
+        }
+        if (memcmp(frame, slot.last, sizeof(frame)) == 0) continue;
+
+        if (slot.client->queueIsFull()) {
+            spectrumFramesDropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        slot.client->binary(frame, sizeof(frame));
+        memcpy(slot.last, frame, sizeof(frame));
+        spectrumFramesSent.fetch_add(1, std::memory_order_relaxed);
+    }
+    WS_SLOTS_UNLOCK();
+}
+
+static void setup_spectrum_socket() {
+    spectrumSocket.setFilter([](AsyncWebServerRequest *request) {
+        return session_filter(request, spectrumSocket.url());
+    });
+    spectrumSocket.onEvent(on_spectrum_event);
+    server.addHandler(&spectrumSocket);
+}
+
+// === ЗЕРКАЛО OLED (WebSocket /api/display/mirror) ===
+// Буфер SSD1306 (512 байт) уходит зрителям прямо из flush дисплея, без повторной
+// отрисовки. Кадр кодируется один раз для всех: XOR с прошлым отправленным кадром
+// (меняется обычно несколько страниц) и PackBits. Сообщение:
+// [тип][seq][поворот][PackBits...], тип 0x01 - дельта (XOR), 0x02 - ключевой кадр.
+// Ключевой кадр получает новый зритель и тот, у кого кадр был отброшен из-за
+// заполненной очереди - цепочка дельт у него прервалась.
+// Частота ограничена WEB_MIRROR_FPS_MAX: flush между отправками только помечает
+// кадр, он уходит из loop_web_events следующей дельтой. Кадр копируется при flush:
+// буфер дисплея меняют и вне отрисовки (reset_inactivity_timer очищает его без
+// flush), а зрители должны видеть только то, что было на OLED.
+#define MIRROR_FRAME_BYTES   (SCREEN_WIDTH * SCREEN_HEIGHT / 8)
+#define MIRROR_HEADER_BYTES  3
+#define MIRROR_MESSAGE_MAX   (MIRROR_HEADER_BYTES + MIRROR_FRAME_BYTES + (MIRROR_FRAME_BYTES + 127) / 128)
+
+// Слоты - под wsSlotsMutex (как у спектра)
+struct MirrorClient {
+    AsyncWebSocketClient* client;  // nullptr - слот свободен
+    uint32_t id;
+    bool needKey;
+    uint32_t frames;
+    uint32_t bytes;
+    uint32_t dropped;
+    unsigned long connectedAt;
+};
+
+static AsyncWebSocket mirrorSocket("/api/display/mirror");
+static MirrorClient mirrorClients[WEB_MIRROR_MAX_CLIENTS];
+static uint8_t mirrorBase[MIRROR_FRAME_BYTES];      // Последний закодированный кадр
+static uint8_t mirrorMessage[MIRROR_MESSAGE_MAX];
+static uint8_t mirrorFrame[MIRROR_FRAME_BYTES];     // Копия кадра последнего flush
+static bool mirrorFrameValid = false;                 // Был хотя бы один flush
+static bool mirrorPending = false;                    // mirrorFrame ждет отправки (только loop())
+static std::atomic<bool> mirrorKeyRequested{false};   // Новый зритель ждет ключевой кадр
+static unsigned long lastMirrorFrame = 0;
+static uint8_t mirrorSeq = 0;
+
+// Вызывать под WS_SLOTS_LOCK
+static MirrorClient* mirror_slot(AsyncWebSocketClient* client) {
+    for (size_t i = 0; i < WEB_MIRROR_MAX_CLIENTS; i++) {
+        if (mirrorClients[i].client == client) return &mirrorClients[i];
+    }
+    return nullptr;
+}
+
+static inline uint8_t mirror_byte(const uint8_t* frame, const uint8_t* base, size_t i) {
+    return base ? frame[i] ^ base[i] : frame[i];
+}
+
+// PackBits: n 0..127 - далее n+1 байт как есть, n 129..255 - следующий байт повторить 257-n раз.
+// Кодирует frame XOR base (base == nullptr - сам кадр)
+static size_t mirror_pack(const uint8_t* frame, const uint8_t* base, uint8_t* out) {
+    size_t len = 0;
+    size_t i = 0;
+    while (i < MIRROR_FRAME_BYTES) {
+        uint8_t value = mirror_byte(frame, base, i);
+        size_t run = 1;
+        while (i + run < MIRROR_FRAME_BYTES && run < 128 && mirror_byte(frame, base, i + run) == value) run++;
+        if (run >= 3) {
+            out[len++] = (uint8_t)(257 - run);
+            out[len++] = value;
+            i += run;
+            continue;
+        }
+        // Литералы до начала следующего повтора из 3+ байт (повтор из 2 не короче литерала)
+        size_t start = len++;
+        size_t count = 0;
+        while (i < MIRROR_FRAME_BYTES && count < 128) {
+            if (count > 0 && i + 2 < MIRROR_FRAME_BYTES &&
+                mirror_byte(frame, base, i) == mirror_byte(frame, base, i + 1) &&
+                mirror_byte(frame, base, i) == mirror_byte(frame, base, i + 2)) break;
+            out[len++] = mirror_byte(frame, base, i);
+            i++;
+            count++;
         }
+        out[start] = (uint8_t)(count - 1);
+    }
+    return len;
+}
+
+static void mirror_send(const uint8_t* frame) {
+    mirrorPending = false;
+    WS_SLOTS_LOCK();
+    bool keyNeeded = false;
+    for (size_t i = 0; i < WEB_MIRROR_MAX_CLIENTS; i++) {
+        if (mirrorClients[i].client && mirrorClients[i].needKey) keyNeeded = true;
+    }
+    bool changed = memcmp(frame, mirrorBase, MIRROR_FRAME_BYTES) != 0;
+    if (!changed && !keyNeeded) {
+        WS_SLOTS_UNLOCK();
+        return;
+    }
+
+    size_t deltaLength = 0;
+    mirrorSeq++;
+    if (changed) {
+        mirrorMessage[0] = 0x01;
+        mirrorMessage[1] = mirrorSeq;
+        mirrorMessage[2] = displayRotation;
+        deltaLength = MIRROR_HEADER_BYTES + mirror_pack(frame, mirrorBase, mirrorMessage + MIRROR_HEADER_BYTES);
+    }
+
+    // Сначала дельта (сообщение копируется в очередь клиента), затем ключевые кадры тем, кому нужно
+    for (size_t i = 0; i < WEB_MIRROR_MAX_CLIENTS && changed; i++) {
+        MirrorClient& slot = mirrorClients[i];
+        if (!slot.client || slot.needKey) continue;
+        if (slot.client->queueIsFull()) {
+            slot.dropped++;
+            slot.needKey = true;
+            continue;
+        }
+        slot.client->binary(mirrorMessage, deltaLength);
+        slot.frames++;
+        slot.bytes += deltaLength;
+    }
+
+    if (keyNeeded) {
+        mirrorMessage[0] = 0x02;
+        mirrorMessage[1] = mirrorSeq;
+        mirrorMessage[2] = displayRotation;
+        size_t keyLength = MIRROR_HEADER_BYTES + mirror_pack(frame, nullptr, mirrorMessage + MIRROR_HEADER_BYTES);
+        for (size_t i = 0; i < WEB_MIRROR_MAX_CLIENTS; i++) {
+            MirrorClient& slot = mirrorClients[i];
+            if (!slot.client || !slot.needKey || slot.client->queueIsFull()) continue;
+            slot.client->binary(mirrorMessage, keyLength);
+            slot.needKey = false;
+            slot.frames++;
+            slot.bytes += keyLength;
+        }
+    }
+    WS_SLOTS_UNLOCK();
+
+    memcpy(mirrorBase, frame, MIRROR_FRAME_BYTES);
+    lastMirrorFrame = millis();
+}
+
+// DisplayFlushHook: main loop, сразу после отправки кадра на OLED
+static void on_display_flush(const uint8_t* buffer) {
+    memcpy(mirrorFrame, buffer, MIRROR_FRAME_BYTES);
+    mirrorFrameValid = true;
+    if (mirrorSocket.count() == 0) return;
+    if (millis() - lastMirrorFrame < 1000UL / WEB_MIRROR_FPS_MAX) {
+        mirrorPending = true;
+        return;
     }
+    mirror_send(mirrorFrame);
+}
+
+// Из loop_web_events: отложенный кадр, когда подошло время. Запрос ключевого
+// кадра от WS_EVT_CONNECT забирается атомарно - пришедший во время отправки
+// останется до следующей итерации
+static void loop_display_mirror() {
+    if (mirrorKeyRequested.exchange(false)) mirrorPending = mirrorFrameValid;
+    if (!mirrorPending) return;
+    if (mirrorSocket.count() == 0) {
+        mirrorPending = false;
+        return;
+    }
+    if (millis() - lastMirrorFrame >= 1000UL / WEB_MIRROR_FPS_MAX) mirror_send(mirrorFrame);
+}
+
+static void on_mirror_event(AsyncWebSocket *socket, AsyncWebSocketClient *client,
+                            AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    if (type == WS_EVT_CONNECT) {
+        WS_SLOTS_LOCK();
+        MirrorClient* slot = mirror_slot(nullptr);
+        if (slot) {
+            slot->needKey = true;
+            slot->frames = 0;
+            slot->bytes = 0;
+            slot->dropped = 0;
+            slot->connectedAt = millis();
+            slot->id = client->id();
+            slot->client = client;
+        }
+        WS_SLOTS_UNLOCK();
+        if (!slot) {
+            client->close(1013);  // Try Again Later
+            return;
+        }
+        // Статичный экран может долго не делать flush - ключевой кадр отправит loop_web_events
+        mirrorKeyRequested.store(true);
+    } else if (type == WS_EVT_DISCONNECT) {
+        WS_SLOTS_LOCK();
+        MirrorClient* slot = mirror_slot(client);
+        MirrorClient stats = {};
+        if (slot) {
+            stats = *slot;
+            slot->client = nullptr;
+        }
+        WS_SLOTS_UNLOCK();
+        if (!slot) return;
+        unsigned long seconds = max(1UL, (millis() - stats.connectedAt) / 1000);
+        log_message(formatString("🪞 Зеркало OLED #%lu: %lu кадров, %lu байт (%lu Б/с), отброшено %lu",
+                                 (unsigned long)stats.id, (unsigned long)stats.frames, (unsigned long)stats.bytes,
+                                 (unsigned long)(stats.bytes / seconds), (unsigned long)stats.dropped));
+    }
+}
+
+static void setup_display_mirror() {
+    mirrorSocket.setFilter([](AsyncWebServerRequest *request) {
+        return session_filter(request, mirrorSocket.url());
+    });
+    mirrorSocket.onEvent(on_mirror_event);
+    server.addHandler(&mirrorSocket);
+    set_display_flush_hook(on_display_flush);
+}
+
+// === УЧЕТ ВРЕМЕНИ И ПАМЯТИ ОБРАБОТЧИКОВ ===
+// Каждый маршрут регистрируется через on_route()/timed_route(): время синхронной
+// части обработчика и изменение свободного heap за вызов (сколько памяти осталось
+// занято ответом) раскладываются по корзинам гистограммы. Пишет и читает только
+// задача AsyncTCP - блокировки не нужны. Отдается в /api/metrics (формат Prometheus).
+// Перед обработчиком - проверка сессии (authorize_request) и допуска по памяти (admit_request).
+static const uint32_t routeLatencyBucketsUs[] = {100, 500, 1000, 5000, 10000, 50000, 100000, 500000};
+static const uint32_t routeHeapBuckets[] = {0, 256, 1024, 4096, 16384};
+#define ROUTE_LATENCY_BUCKETS (sizeof(routeLatencyBucketsUs) / sizeof(routeLatencyBucketsUs[0]))
+#define ROUTE_HEAP_BUCKETS    (sizeof(routeHeapBuckets) / sizeof(routeHeapBuckets[0]))
+
+struct RouteStats {
+    const char* path;
+    const char* method;
+    uint32_t count;
+    uint64_t totalMicros;
+    int64_t totalHeap;
+    uint32_t latency[ROUTE_LATENCY_BUCKETS + 1];  // Последняя - +Inf
+    uint32_t heap[ROUTE_HEAP_BUCKETS + 1];
+};
+
+static RouteStats routeStats[WEB_ROUTE_STATS_MAX];
+static size_t routeStatsCount = 0;
+
+static const char* method_name(WebRequestMethodComposite method) {
+    switch (method) {
+        case HTTP_GET:    return "GET";
+        case HTTP_POST:   return "POST";
+        case HTTP_DELETE: return "DELETE";
+        case HTTP_PUT:    return "PUT";
+        case HTTP_PATCH:  return "PATCH";
+        default:          return "ANY";
+    }
+}
+
+static RouteStats* route_stats(const char* path, WebRequestMethodComposite method) {
+    const char* name = method_name(method);
+    for (size_t i = 0; i < routeStatsCount; i++) {
+        if (strcmp(routeStats[i].path, path) == 0 && routeStats[i].method == name) return &routeStats[i];
+    }
+    if (routeStatsCount >= WEB_ROUTE_STATS_MAX) return nullptr;
+    RouteStats* stats = &routeStats[routeStatsCount++];
+    stats->path = path;
+    stats->method = name;
+    return stats;
+}
+
+static void record_route(RouteStats* stats, uint32_t micros, int32_t heapDelta) {
+    if (!stats) return;
+    stats->count++;
+    stats->totalMicros += micros;
+    stats->totalHeap += heapDelta;
+    size_t bucket = 0;
+    while (bucket < ROUTE_LATENCY_BUCKETS && micros > routeLatencyBucketsUs[bucket]) bucket++;
+    stats->latency[bucket]++;
+    bucket = 0;
+    while (bucket < ROUTE_HEAP_BUCKETS && heapDelta > (int32_t)routeHeapBuckets[bucket]) bucket++;
+    stats->heap[bucket]++;
+}
+
+// Доступ к маршруту проверяется один раз в обертке, а не в каждом обработчике
+enum RouteAccess {
+    ROUTE_PUBLIC,
+    ROUTE_SESSION   // Нужен cookie действующей сессии, иначе 401
+};
+
+static uint32_t authRejected = 0;
+
+static bool authorize_request(AsyncWebServerRequest *request, RouteAccess access) {
+    if (access == ROUTE_PUBLIC || request_session(request) >= 0) return true;
+    authRejected++;
+    request->send(401);
     return false;
 }
 
+static ArRequestHandlerFunction timed_route(const char* path, WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction handler,
+                                            RouteAccess access = ROUTE_PUBLIC) {
+    RouteStats* stats = route_stats(path, method);
+    return [stats, handler, access](AsyncWebServerRequest *request) {
+        if (!authorize_request(request, access)) return;
+        if (!admit_request(request)) return;
+        uint32_t heapBefore = ESP.getFreeHeap();
+        unsigned long start = micros();
+        handler(request);
+        record_route(stats, micros() - start, (int32_t)(heapBefore - ESP.getFreeHeap()));
+    };
+}
+
+// JSON маршруты меняют станции - всегда с сессией
+static ArJsonRequestHandlerFunction timed_json_route(const char* path, ArJsonRequestHandlerFunction handler) {
+    RouteStats* stats = route_stats(path, HTTP_POST);
+    return [stats, handler](AsyncWebServerRequest *request, JsonVariant &json) {
+        if (!authorize_request(request, ROUTE_SESSION)) return;
+        if (!admit_request(request)) return;
+        uint32_t heapBefore = ESP.getFreeHeap();
+        unsigned long start = micros();
+        handler(request, json);
+        record_route(stats, micros() - start, (int32_t)(heapBefore - ESP.getFreeHeap()));
+    };
+}
+
+static void on_route(const char* path, WebRequestMethodComposite method, ArRequestHandlerFunction handler) {
+    server.on(path, method, timed_route(path, method, handler));
+}
+
+static void on_session_route(const char* path, WebRequestMethodComposite method, ArRequestHandlerFunction handler) {
+    server.on(path, method, timed_route(path, method, handler, ROUTE_SESSION));
+}
+
+// Ответ из последовательности частей (chunked, без сборки целиком).
+// writePart(part, out) пишет часть с номером part и возвращает false, когда частей больше нет.
+// Часть, не поместившаяся в кусок, пишется заново - она должна быть одинаковой при повторе
+typedef std::function<bool(size_t part, Print& out)> PartWriter;
+
+static AsyncWebServerResponse* begin_parts_response(AsyncWebServerRequest *request,
+                                                    const char* contentType, PartWriter writePart) {
+    struct PartsState {
+        InflightTicket ticket;
+        size_t part;
+        size_t offset;
+        bool done;
+    };
+    std::shared_ptr<PartsState> state = std::make_shared<PartsState>();
+    state->part = 0;
+    state->offset = 0;
+    state->done = false;
+
+    return request->beginChunkedResponse(contentType,
+        [state, writePart](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            size_t len = 0;
+            while (!state->done && len < maxLen) {
+                WindowPrint out(buffer + len, maxLen - len, state->offset);
+                if (!writePart(state->part, out)) {
+                    state->done = true;
+                    break;
+                }
+                len += out.stored();
+                if (!out.complete()) {
+                    state->offset += out.stored();
+                    break;
+                }
+                state->offset = 0;
+                state->part++;
+            }
+            return len;
+        });
+}
+
+// Секунды с 6 знаками без float (uint64 мкс)
+static void print_seconds(Print& out, uint64_t micros) {
+    char text[24];
+    snprintf(text, sizeof(text), "%lu.%06lu", (unsigned long)(micros / 1000000), (unsigned long)(micros % 1000000));
+    out.print(text);
+}
+
+// Одна серия гистограммы: _bucket (накопительно), _sum, _count
+static void write_route_histogram(Print& out, const char* family, const RouteStats& stats, bool latency) {
+    const uint32_t* bounds = latency ? routeLatencyBucketsUs : routeHeapBuckets;
+    const uint32_t* counts = latency ? stats.latency : stats.heap;
+    size_t buckets = latency ? ROUTE_LATENCY_BUCKETS : ROUTE_HEAP_BUCKETS;
+    uint32_t cumulative = 0;
+    for (size_t i = 0; i <= buckets; i++) {
+        cumulative += counts[i];
+        out.printf("%s_bucket{route=\"%s\",method=\"%s\",le=\"", family, stats.path, stats.method);
+        if (i == buckets) out.print("+Inf");
+        else if (latency) print_seconds(out, bounds[i]);
+        else out.print(bounds[i]);
+        out.printf("\"} %lu\n", (unsigned long)cumulative);
+    }
+    out.printf("%s_sum{route=\"%s\",method=\"%s\"} ", family, stats.path, stats.method);
+    if (latency) print_seconds(out, stats.totalMicros);
+    else out.print((long)stats.totalHeap);
+    out.printf("\n%s_count{route=\"%s\",method=\"%s\"} %lu\n", family, stats.path, stats.method, (unsigned long)stats.count);
+}
+
+// Снимок всех счетчиков на момент запроса, чтобы повторно записываемые части совпадали побайтно
+struct MetricsSnapshot {
+    std::vector<RouteStats> routes;
+    uint32_t rejected[ADMIT_REASONS];
+    uint8_t inflight;
+    uint32_t settingsPosted;
+    uint32_t settingsCoalesced;
+    uint32_t settingsApplied;
+    uint32_t settingsLag;
+    uint32_t settingsLagMax;
+    uint32_t queueRejected;
+    uint32_t controlAcks[CONTROL_STATUSES];
+    uint8_t controlClients;
+    uint32_t spectrumSent;
+    uint32_t spectrumDropped;
+    uint8_t spectrumClients;
+    MirrorClient mirror[WEB_MIRROR_MAX_CLIENTS];
+    unsigned long now;
+    uint32_t authRejected;
+    uint8_t sessions;
+    unsigned long wifiApplyToAudioMs;
+    TelemetrySnapshot telemetry;
+};
+
+static AsyncWebServerResponse* begin_metrics_response(AsyncWebServerRequest *request) {
+    std::shared_ptr<MetricsSnapshot> m = std::make_shared<MetricsSnapshot>();
+    for (size_t i = 0; i < routeStatsCount; i++) {
+        if (routeStats[i].count > 0) m->routes.push_back(routeStats[i]);
+    }
+    memcpy(m->rejected, admitRejected, sizeof(m->rejected));
+    m->inflight = inflightStreams;
+    m->settingsPosted = settingsPosted.load(std::memory_order_relaxed);
+    m->settingsCoalesced = settingsCoalesced.load(std::memory_order_relaxed);
+    m->settingsApplied = settingsApplied.load(std::memory_order_relaxed);
+    m->settingsLag = settingsLagMicros.load(std::memory_order_relaxed);
+    m->settingsLagMax = settingsLagMaxMicros.load(std::memory_order_relaxed);
+    m->queueRejected = commandQueueRejected.load(std::memory_order_relaxed);
+    memcpy(m->controlAcks, controlAcks, sizeof(m->controlAcks));
+    m->controlClients = controlSocket.count();
+    m->spectrumSent = spectrumFramesSent.load(std::memory_order_relaxed);
+    m->spectrumDropped = spectrumFramesDropped.load(std::memory_order_relaxed);
+    m->spectrumClients = spectrumSocket.count();
+    WS_SLOTS_LOCK();
+    memcpy(m->mirror, mirrorClients, sizeof(m->mirror));
+    WS_SLOTS_UNLOCK();
+    m->now = millis();
+    m->authRejected = authRejected;
+    m->sessions = web_sessions_active();
+    m->wifiApplyToAudioMs = wifiApplyToAudioMs;
+    telemetry_snapshot(m->telemetry);
+
+    return begin_parts_response(request, "text/plain; version=0.0.4; charset=utf-8",
+        [m](size_t part, Print& out) -> bool {
+            size_t routes = m->routes.size();
+            if (part == 0) {
+                out.print("# HELP web_request_duration_seconds Time spent in the route handler\n"
+                          "# TYPE web_request_duration_seconds histogram\n");
+            } else if (part <= routes) {
+                write_route_histogram(out, "web_request_duration_seconds", m->routes[part - 1], true);
+            } else if (part == routes + 1) {
+                out.print("# HELP web_request_heap_bytes Free heap taken by the handler call (retained by the response)\n"
+                          "# TYPE web_request_heap_bytes histogram\n");
+            } else if (part <= 2 * routes + 1) {
+                write_route_histogram(out, "web_request_heap_bytes", m->routes[part - routes - 2], false);
+            } else if (part == 2 * routes + 2) {
+                out.print("# HELP web_requests_rejected_total Requests answered 503 by heap admission control\n"
+                          "# TYPE web_requests_rejected_total counter\n");
+                for (size_t i = ADMIT_HEAP; i < ADMIT_REASONS; i++) {
+                    out.printf("web_requests_rejected_total{reason=\"%s\"} %lu\n",
+                               admitReasonNames[i], (unsigned long)m->rejected[i]);
+                }
+            } else if (part == 2 * routes + 3) {
+                out.printf("# HELP web_inflight_streams Streaming responses currently being sent\n"
+                           "# TYPE web_inflight_streams gauge\n"
+                           "web_inflight_streams %u\n", (unsigned)m->inflight);
+            } else if (part == 2 * routes + 4) {
+                out.printf("# HELP settings_posted_total Volume/visualizer/rotation values posted to the settings mailbox\n"
+                           "# TYPE settings_posted_total counter\n"
+                           "settings_posted_total %lu\n"
+                           "# HELP settings_coalesced_total Posted values overwritten before the main loop applied them\n"
+                           "# TYPE settings_coalesced_total counter\n"
+                           "settings_coalesced_total %lu\n",
+                           (unsigned long)m->settingsPosted, (unsigned long)m->settingsCoalesced);
+                out.printf("# HELP settings_apply_lag_seconds Time from the latest post to apply in the main loop\n"
+                           "# TYPE settings_apply_lag_seconds summary\n"
+                           "settings_apply_lag_seconds_sum ");
+                print_seconds(out, m->settingsLag);
+                out.printf("\nsettings_apply_lag_seconds_count %lu\n"
+                           "# HELP settings_apply_lag_max_seconds Longest apply lag since boot\n"
+                           "# TYPE settings_apply_lag_max_seconds gauge\n"
+                           "settings_apply_lag_max_seconds ", (unsigned long)m->settingsApplied);
+                print_seconds(out, m->settingsLagMax);
+                out.printf("\n# HELP command_queue_rejected_total Discrete commands rejected because the queue was full\n"
+                           "# TYPE command_queue_rejected_total counter\n"
+                           "command_queue_rejected_total %lu\n", (unsigned long)m->queueRejected);
+            } else if (part == 2 * routes + 5) {
+                out.printf("# HELP web_control_clients Connected /api/control WebSocket clients\n"
+                           "# TYPE web_control_clients gauge\n"
+                           "web_control_clients %u\n"
+                           "# HELP web_control_commands_total Commands received on /api/control by ack status\n"
+                           "# TYPE web_control_commands_total counter\n", (unsigned)m->controlClients);
+                for (size_t i = 0; i < CONTROL_STATUSES; i++) {
+                    out.printf("web_control_commands_total{status=\"%s\"} %lu\n",
+                               controlStatusNames[i], (unsigned long)m->controlAcks[i]);
+                }
+            } else if (part == 2 * routes + 6) {
+                out.printf("# HELP web_spectrum_clients Connected /api/spectrum WebSocket clients\n"
+                           "# TYPE web_spectrum_clients gauge\n"
+                           "web_spectrum_clients %u\n"
+                           "# HELP web_spectrum_frames_total Spectrum frames by outcome (dropped: client queue full)\n"
+                           "# TYPE web_spectrum_frames_total counter\n"
+                           "web_spectrum_frames_total{result=\"sent\"} %lu\n"
+                           "web_spectrum_frames_total{result=\"dropped\"} %lu\n",
+                           (unsigned)m->spectrumClients, (unsigned long)m->spectrumSent,
+                           (unsigned long)m->spectrumDropped);
+            } else if (part == 2 * routes + 7) {
+                // Полоса на зрителя зеркала OLED: bytes_total / секунды с подключения
+                out.print("# HELP web_mirror_bytes_total Bytes sent to an /api/display/mirror client\n"
+                          "# TYPE web_mirror_bytes_total counter\n"
+                          "# HELP web_mirror_frames_total Frames sent to / dropped for an /api/display/mirror client\n"
+                          "# TYPE web_mirror_frames_total counter\n"
+                          "# HELP web_mirror_connected_seconds Time since the mirror client connected\n"
+                          "# TYPE web_mirror_connected_seconds gauge\n");
+                for (size_t i = 0; i < WEB_MIRROR_MAX_CLIENTS; i++) {
+                    const MirrorClient& c = m->mirror[i];
+                    if (!c.client) continue;
+                    out.printf("web_mirror_bytes_total{client=\"%lu\"} %lu\n"
+                               "web_mirror_frames_total{client=\"%lu\",result=\"sent\"} %lu\n"
+                               "web_mirror_frames_total{client=\"%lu\",result=\"dropped\"} %lu\n"
+                               "web_mirror_connected_seconds{client=\"%lu\"} %lu\n",
+                               (unsigned long)c.id, (unsigned long)c.bytes,
+                               (unsigned long)c.id, (unsigned long)c.frames,
+                               (unsigned long)c.id, (unsigned long)c.dropped,
+                               (unsigned long)c.id, (unsigned long)((m->now - c.connectedAt) / 1000));
+                }
+            } else if (part == 2 * routes + 8) {
+                out.printf("# HELP web_sessions_active Sessions in the session table\n"
+                           "# TYPE web_sessions_active gauge\n"
+                           "web_sessions_active %u\n"
+                           "# HELP web_auth_rejected_total Requests to session routes answered 401\n"
+                           "# TYPE web_auth_rejected_total counter\n"
+                           "web_auth_rejected_total %lu\n",
+                           (unsigned)m->sessions, (unsigned long)m->authRejected);
+            } else if (part == 2 * routes + 9) {
+                // Только после смены AP -> STA без перезагрузки (при обычной загрузке метрики нет)
+                if (m->wifiApplyToAudioMs == 0) return true;
+                out.print("# HELP wifi_apply_to_audio_seconds Time from WiFi setup submit to first audio (live AP to STA switch)\n"
+                          "# TYPE wifi_apply_to_audio_seconds gauge\n"
+                          "wifi_apply_to_audio_seconds ");
+                print_seconds(out, (uint64_t)m->wifiApplyToAudioMs * 1000);
+                out.print('\n');
+            } else {
+                // Аудио, WiFi, лог и flash, дисплей, heap, время итерации loop()
+                return write_telemetry_part(out, m->telemetry, part - (2 * routes + 10));
+            }
+            return true;
+        });
+}
+
+// === ИМПОРТ СТАНЦИЙ (потоковый, атомарный) ===
+// Загрузка разбирается по мере поступления: сканер отслеживает вложенность и строки,
+// каждый объект верхнего уровня копируется в ограниченный буфер и разбирается отдельно.
+// Проверенные станции (validateURL, без повторов имен, не больше MAX_RADIO_STATIONS)
+// пишутся во временный файл, который заменяет /stations.json только после успешного
+// завершения загрузки. Испорченный файл не трогает текущую конфигурацию.
+struct ImportSession {
+    AsyncWebServerRequest *request;
+    File file;
+    uint8_t depth;          // 0 - до '[', 1 - между станциями, 2+ - внутри станции
+    bool inString;
+    bool escape;
+    bool finished;          // Встретили закрывающую ']'
+    const char* error;
+    char entry[WEB_IMPORT_ENTRY_MAX];
+    size_t entryLength;
+    bool entryOverflow;
+    std::vector<RadioStation> accepted;
+    uint16_t invalid;
+    uint16_t duplicates;
+    uint16_t overLimit;
+};
+
+static ImportSession* importSession = nullptr;
+
+// Размер временного файла идет в учет записи во flash (даже если импорт отклонен)
+static void close_import_file(ImportSession& s) {
+    if (!s.file) return;
+    telemetry_flash_written(s.file.size());
+    s.file.close();
+}
+
+static void close_import_session(bool keepTemp) {
+    if (!importSession) return;
+    close_import_file(*importSession);
+    if (!keepTemp) LittleFS.remove(STATIONS_IMPORT_TEMP);
+    delete importSession;
+    importSession = nullptr;
+}
+
+// Разбор одной станции из буфера
+static void import_entry(ImportSession& s) {
+    if (s.entryOverflow) {
+        s.invalid++;
+        return;
+    }
+    JsonDocument doc;
+    if (deserializeJson(doc, s.entry, s.entryLength) || !doc.is<JsonObject>()) {
+        s.invalid++;
+        return;
+    }
+    String name = doc["name"] | "";
+    String url = doc["url"] | "";
+    if (name.length() == 0 || validateURL(url) != URL_VALID) {
+        s.invalid++;
+        return;
+    }
+    for (const auto& station : s.accepted) {
+        if (station.name == name) {
+            s.duplicates++;
+            return;
+        }
+    }
+    if (s.accepted.size() >= MAX_RADIO_STATIONS) {
+        s.overLimit++;
+        return;
+    }
+
+    if (!s.accepted.empty()) s.file.write(',');
+    JsonWriter json(s.file);
+    json.beginObject().field("name", name).field("url", url).endObject();
+    s.accepted.push_back({name, url, true});
+}
+
+static void import_feed(ImportSession& s, char c) {
+    if (s.error) return;
+
+    // Внутри станции: копируем в буфер, следим за строками и вложенностью
+    if (s.depth >= 2) {
+        if (s.entryLength < sizeof(s.entry)) s.entry[s.entryLength++] = c;
+        else s.entryOverflow = true;
+
+        if (s.inString) {
+            if (s.escape) s.escape = false;
+            else if (c == '\\') s.escape = true;
+            else if (c == '"') s.inString = false;
+            return;
+        }
+        if (c == '"') {
+            s.inString = true;
+        } else if (c == '{' || c == '[') {
+            if (++s.depth > WEB_IMPORT_MAX_DEPTH) s.error = "Too deeply nested";
+        } else if (c == '}' || c == ']') {
+            if (--s.depth == 1) import_entry(s);
+        }
+        return;
+    }
+
+    // Пробелы и BOM между элементами
+    if (c == ' ' || c == '\n' || c == '\r' || c == '\t' || (uint8_t)c >= 0x80) return;
+
+    if (s.finished) {
+        s.error = "Unexpected data after array";
+    } else if (s.depth == 0) {
+        if (c == '[') s.depth = 1;
+        else s.error = "Expected JSON array";
+    } else if (c == '{') {
+        s.depth = 2;
+        s.entry[0] = c;
+        s.entryLength = 1;
+        s.entryOverflow = false;
+    } else if (c == ']') {
+        s.depth = 0;
+        s.finished = true;
+    } else if (c != ',') {
+        s.error = "Expected station object";
+    }
+}
+
+static void handle_import_upload(AsyncWebServerRequest *request, size_t index, uint8_t *data, size_t len, bool final) {
+    if (index == 0) {
+        if (request_session(request) < 0) return;  // Без сессии ответит 401 обработчик маршрута
+        if (importSession) return;  // Другой импорт еще идет - ответит 409
+        // Разобранные станции копятся в памяти до конца загрузки - не начинаем при нехватке heap
+        if (web_admit() != ADMIT_OK) return;
+        importSession = new ImportSession();
+        importSession->request = request;
+        importSession->file = LittleFS.open(STATIONS_IMPORT_TEMP, "w");
+        if (!importSession->file) importSession->error = "Cannot create temp file";
+        else importSession->file.write('[');
+
+        // Клиент оборвал загрузку - убираем временный файл
+        request->onDisconnect([request]() {
+            if (importSession && importSession->request == request) close_import_session(false);
+        });
+    }
+
+    ImportSession* s = importSession;
+    if (!s || s->request != request) return;
+    for (size_t i = 0; i < len && !s->error; i++) {
+        import_feed(*s, (char)data[i]);
+    }
+
+    if (final && !s->error) {
+        if (!s->finished) s->error = "Truncated JSON";
+        else if (s->accepted.empty()) s->error = "No valid stations";
+    }
+}
+
+// Фиксация импорта и ответ (обработчик запроса вызывается после всей загрузки)
+static void finish_import(AsyncWebServerRequest *request) {
+    ImportSession* s = importSession;
+    if (!s || s->request != request) {
+        if (s) return request->send(409, "application/json; charset=utf-8", "{\"error\":\"Import already in progress\"}");
+        if (request->hasParam("file", true, true)) {
+            // Загрузка была, но сессию не открыли из-за нехватки памяти
+            admitRejected[ADMIT_HEAP]++;
+            return send_busy(request);
+        }
+        return request->send(400, "application/json; charset=utf-8", "{\"error\":\"No file\"}");
+    }
+
+    AsyncResponseStream *response = request->beginResponseStream("application/json; charset=utf-8", WEB_JSON_STREAM_BUFFER);
+    JsonWriter out(*response);
+
+    if (!s->error) {
+        s->file.write(']');
+        close_import_file(*s);
+        // rename заменяет файл целиком: либо старый список, либо новый
+        if (!LittleFS.rename(STATIONS_IMPORT_TEMP, "/stations.json")) {
+            LittleFS.remove("/stations.json");
+            if (!LittleFS.rename(STATIONS_IMPORT_TEMP, "/stations.json")) s->error = "Cannot replace stations.json";
+        }
+    }
+
+    if (s->error) {
+        response->setCode(400);
+        out.beginObject().field("error", s->error).endObject();
+        log_message(formatString("❌ Импорт станций отклонен: %s", s->error));
+        close_import_session(false);
+        return request->send(response);
+    }
+
+    // Данные уже разобраны - применяем без повторного чтения файла
+    size_t imported = s->accepted.size();
+    STATIONS_LOCK();
+    stations = std::move(s->accepted);
+    totalStations = stations.size();
+    mark_stations_changed(0, stations.size());
+    stationsSavedRevision = stationsRevision;
+    // Новый список короче: индекс текущей станции указывал бы за конец stations
+    if (currentStation >= (int)stations.size()) {
+        currentStation = 0;
+        save_state();  // И в state.json: после перезагрузки индекс тоже в пределах списка
+    }
+    STATIONS_UNLOCK();
+
+    out.beginObject()
+        .field("imported", imported)
+        .field("invalid", s->invalid)
+        .field("duplicates", s->duplicates)
+        .field("overLimit", s->overLimit)
+        .endObject();
+    log_message(formatString("📥 Импорт станций: %u принято, %u невалидных, %u повторов, %u сверх лимита",
+                             (unsigned)imported, s->invalid, s->duplicates, s->overLimit));
+    close_import_session(true);
+    request->send(response);
+}
+
+// === СТАТИЧЕСКИЕ СТРАНИЦЫ (gzip + ETag) ===
+// scripts/compress_data.py кладет в образ ФС только *.html.gz,
+// отдаем их с Content-Encoding: gzip. ETag - размер + FNV-1a содержимого, считается один раз
+// при запуске сервера (файлы меняются только через uploadfs + перезагрузку). Не в первом
+// запросе: чтение всей страницы - миллисекунды CPU в задаче AsyncTCP одним куском,
+// и DMA I2S успевает опустеть.
+struct StaticAsset {
+    const char* path;
+    String etag;
+};
+
+static StaticAsset staticAssets[] = {
+    {"/index.html", ""},
+    {"/register.html", ""},
+    {"/ap_mode.html", ""},
+};
+
+// Реальный путь в ФС: предпочитаем сжатую версию
+static String resolve_asset_path(const char* path) {
+    String gzPath = String(path) + ".gz";
+    if (LittleFS.exists(gzPath)) return gzPath;
+    return String(path);
+}
+
+static String compute_asset_etag(const String& fsPath) {
+    File file = LittleFS.open(fsPath, "r");
+    if (!file) return "";
+    uint32_t hash = 2166136261u;
+    uint8_t chunk[256];
+    size_t n;
+    while ((n = file.read(chunk, sizeof(chunk))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            hash ^= chunk[i];
+            hash *= 16777619u;
+        }
+    }
+    size_t size = file.size();
+    file.close();
+    char etag[24];
+    snprintf(etag, sizeof(etag), "\"%x-%08x\"", (unsigned)size, (unsigned)hash);
+    return String(etag);
+}
+
+// Из setup()/loop() перед server.begin(): до звука или пока буфер потока еще набирается
+static void compute_static_etags() {
+    for (auto& asset : staticAssets) {
+        if (asset.etag.length() == 0) asset.etag = compute_asset_etag(resolve_asset_path(asset.path));
+    }
+}
+
+// Отдает страницу с ETag: 304 без тела, если у клиента актуальная копия
+static void send_static_asset(AsyncWebServerRequest *request, const char* path) {
+    StaticAsset* asset = nullptr;
+    for (auto& a : staticAssets) {
+        if (strcmp(a.path, path) == 0) {
+            asset = &a;
+            break;
+        }
+    }
+
+    String fsPath = resolve_asset_path(path);
+
+    if (asset && asset->etag.length() > 0 && request->hasHeader("If-None-Match") &&
+        request->header("If-None-Match") == asset->etag) {
+        AsyncWebServerResponse *response = request->beginResponse(304);
+        response->addHeader("ETag", asset->etag);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+        Serial.printf("📄 %s: 304 Not Modified\n", path);
+        return;
+    }
+
+    AsyncWebServerResponse *response = begin_sliced_file_response(request, fsPath, "text/html; charset=utf-8");
+    if (!response) {
+        request->send(404, "text/plain", "Not found");
+        return;
+    }
+    if (asset && asset->etag.length() > 0) {
+        response->addHeader("ETag", asset->etag);
+    }
+    // no-cache: браузер хранит копию, но каждый раз перепроверяет по ETag
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+}
+
+// === LIVE СТАТУС: СНАПШОТ /api/status И ПОДПИСКА /api/events ===
+// Main loop раз в WEB_EVENTS_INTERVAL снимает статус. Если он изменился,
+// растет версия и JSON один раз сериализуется в заранее выделенный буфер -
+// /api/status и новые подписчики SSE отдают готовые байты, без сборки JSON и STATIONS_LOCK.
+// Буфер и RSSI квантуются, чтобы версия не росла от дрожания. Heap в версию не входит:
+// он меняется почти каждый тик, и ETag не совпадал бы ни разу - в снапшоте значение
+// на момент последнего изменения остальных полей (точное - в /api/metrics).
+//
+// Подписчики /api/events получают полный снапшот при подключении, дальше - только
+// изменившиеся поля (без heap). Если очереди клиентов заполнены, тик пропускается:
+// изменения не копятся в очереди, а сливаются в следующую дельту.
+//
+// events.send()/count()/avgPacketsWaiting() вызываются из loop(), а клиентов добавляет
+// и удаляет задача AsyncTCP. В отличие от WebSocket (wsSlotsMutex) своя блокировка тут
+// не нужна: в ESPAsyncWebServer-esphome 3.x AsyncEventSource обходит список клиентов
+// под своим _client_queue_lock, под ним же добавляет клиента и удаляет его при
+// отключении. Указателей на AsyncEventSourceClient прошивка не хранит - обращается
+// к ним только onConnect в задаче AsyncTCP. Версию ниже 3.x (список без блокировки,
+// как в me-no-dev 1.2.x) в platformio.ini не опускать.
+static AsyncEventSource events("/api/events");
+
+struct LiveStatus {
+    AudioState audio;
+    int station;
+    String name;
+    int volume;             // %
+    int buffer;             // %, -1 если не играет
+    int rssi;               // dBm
+    int visualizer;         // VisualizerStyle
+    uint32_t heapKb;        // Свободно heap (КБ), не версионируется
+    uint32_t logRevision;
+};
+
+// Двойной буфер: main loop пишет в неопубликованный и переключает индекс.
+// Обработчики (AsyncTCP, приоритет выше loop) копируют ~200 байт ответа в TCP буфер
+// синхронно в request->send() - main loop не может вклиниться посреди копирования.
+struct StatusSnapshot {
+    char json[WEB_STATUS_BUFFER_SIZE];
+    size_t length;
+    char etag[24];
+};
+
+static StatusSnapshot statusSnapshots[2];
+static volatile uint8_t publishedSnapshot = 0;
+static uint32_t statusVersion = 0;
+static uint32_t statusBootId = 0;     // ETag не совпадет с ответом до перезагрузки
+
+static LiveStatus snapshotStatus;     // Статус, из которого собран опубликованный снапшот
+static LiveStatus lastSentStatus;     // Последнее, что ушло подписчикам
+static bool lastSentValid = false;
+static unsigned long lastEventsTick = 0;
+static char deltaBuffer[WEB_STATUS_BUFFER_SIZE];
+
+unsigned long webEventsSent = 0;
+unsigned long webEventsDeferred = 0;
+
+static const char* audio_state_name(AudioState state) {
+    switch (state) {
+        case AUDIO_IDLE:       return "idle";
+        case AUDIO_CONNECTING: return "connecting";
+        case AUDIO_STARTING:   return "starting";
+        case AUDIO_BUFFERING:  return "buffering";
+        case AUDIO_PLAYING:    return "playing";
+        case AUDIO_ERROR:      return "error";
+        default:               return "unknown";
+    }
+}
+
+static LiveStatus collect_live_status() {
+    LiveStatus status;
+    status.audio = audioState;
+    status.volume = (int)lroundf(volume * 100);
+
+    STATIONS_LOCK();
+    status.station = currentStation;
+    if (currentStation >= 0 && currentStation < (int)stations.size()) {
+        status.name = stations[currentStation].name;
+    }
+    STATIONS_UNLOCK();
+    if (status.name.length() > WEB_STATUS_NAME_MAX) {
+        status.name.remove(WEB_STATUS_NAME_MAX);
+    }
+
+    int fill = get_audio_buffer_fill_percent();
+    status.buffer = (fill < 0) ? -1 : fill / WEB_EVENTS_BUFFER_STEP * WEB_EVENTS_BUFFER_STEP;
+    int rssi = (WiFi.status() == WL_CONNECTED) ? WiFi.RSSI() : 0;
+    status.rssi = rssi / WEB_EVENTS_RSSI_STEP * WEB_EVENTS_RSSI_STEP;
+    status.visualizer = (int)visualizerStyle;
+    status.heapKb = ESP.getFreeHeap() / 1024;
+    status.logRevision = get_log_revision();
+    return status;
+}
+
+// prev == nullptr - полный статус, иначе только отличающиеся поля (кроме heap).
+// Возвращает длину (строка завершена нулем), 0 - отличий нет или не поместилось
+static size_t build_status_json(char* buf, size_t size, const LiveStatus& status, const LiveStatus* prev) {
+    WindowPrint out((uint8_t*)buf, size - 1);
+    JsonWriter json(out);
+    bool changed = false;
+    json.beginObject();
+
+    if (!prev || status.audio != prev->audio) {
+        json.field("state", audio_state_name(status.audio));
+        changed = true;
+    }
+    if (!prev || status.station != prev->station || status.name != prev->name) {
+        json.field("station", status.station).field("name", status.name);
+        changed = true;
+    }
+    if (!prev || status.volume != prev->volume) {
+        json.field("volume", status.volume);
+        changed = true;
+    }
+    if (!prev || status.buffer != prev->buffer) {
+        json.field("buffer", status.buffer);
+        changed = true;
+    }
+    if (!prev || status.rssi != prev->rssi) {
+        json.field("rssi", status.rssi);
+        changed = true;
+    }
+    if (!prev || status.visualizer != prev->visualizer) {
+        json.field("visualizer", status.visualizer);
+        changed = true;
+    }
+    if (!prev) {
+        json.field("heap", status.heapKb);
+    }
+    if (!prev || status.logRevision != prev->logRevision) {
+        json.field("log", status.logRevision);
+        changed = true;
+    }
+    if (!prev) {
+        json.field("version", statusVersion);
+    }
+    json.endObject();
+
+    if (!changed || !out.complete()) return 0;
+    buf[out.total()] = '\0';
+    return out.total();
+}
+
+static bool status_changed(const LiveStatus& a, const LiveStatus& b) {
+    return a.audio != b.audio || a.station != b.station || a.name != b.name ||
+           a.volume != b.volume || a.buffer != b.buffer || a.rssi != b.rssi ||
+           a.visualizer != b.visualizer || a.logRevision != b.logRevision;
+}
+
+// Сериализация в неопубликованный буфер и переключение
+static void publish_status_snapshot(const LiveStatus& status) {
+    uint8_t next = publishedSnapshot ^ 1;
+    StatusSnapshot& snap = statusSnapshots[next];
+    statusVersion++;
+    size_t len = build_status_json(snap.json, sizeof(snap.json), status, nullptr);
+    if (len == 0) {
+        statusVersion--;
+        return;
+    }
+    snap.length = len;
+    snprintf(snap.etag, sizeof(snap.etag), "\"%08x-%lu\"", (unsigned)statusBootId, (unsigned long)statusVersion);
+    snapshotStatus = status;
+    publishedSnapshot = next;
+}
+
+// === ХВОСТ ЛОГА (SSE /api/logs/tail) ===
+// Новые строки лога рассылаются событием "log", id - логическое смещение конца.
+// Не больше WEB_LOG_TAIL_CHUNK за тик, остальное уйдет в следующих тиках.
+// logEvents.send()/count() из loop() - под блокировкой списка клиентов самой
+// библиотеки, как у events (см. выше); onConnect отказывает лишним в задаче AsyncTCP.
+static AsyncEventSource logEvents("/api/logs/tail");
+static uint32_t logTailOffset = 0;
+static char logTailBuffer[WEB_LOG_TAIL_CHUNK + 1];
+
+// Позиция начала следующей строки после pos (для хвоста без обрезанной первой строки)
+static size_t skip_to_line_start(const char* path, size_t pos) {
+    File file = LittleFS.open(path, "r");
+    if (!file) return pos;
+    file.seek(pos);
+    uint8_t chunk[64];
+    size_t n;
+    while ((n = file.read(chunk, sizeof(chunk))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (chunk[i] == '\n') {
+                file.close();
+                return pos + i + 1;
+            }
+        }
+        pos += n;
+    }
+    file.close();
+    return pos;
+}
+
+// Читает из лога [from, from + maxLen) по логическому смещению, обрезая до целой строки
+static size_t read_log_lines(uint32_t from, uint32_t base, char* buffer, size_t maxLen) {
+    File file = LittleFS.open(LOG_FILE, "r");
+    if (!file) return 0;
+    file.seek(from - base);
+    size_t n = file.read((uint8_t*)buffer, maxLen);
+    file.close();
+    size_t complete = n;
+    while (complete > 0 && buffer[complete - 1] != '\n') complete--;
+    // Строка длиннее буфера - отдаем как есть, иначе хвост никогда не сдвинется
+    return (complete > 0) ? complete : n;
+}
+
+static void loop_log_tail() {
+    uint32_t base, end;
+    get_log_range(base, end);
+    if (logEvents.count() == 0) {
+        logTailOffset = end;
+        return;
+    }
+    if (logTailOffset < base) logTailOffset = base;
+    if (logTailOffset >= end) return;
+    if (logEvents.avgPacketsWaiting() >= WEB_EVENTS_CLIENT_QUEUE) return;
+
+    size_t want = min((uint32_t)WEB_LOG_TAIL_CHUNK, end - logTailOffset);
+    size_t n = read_log_lines(logTailOffset, base, logTailBuffer, want);
+    if (n == 0) return;
+    logTailOffset += n;
+    // Последний перевод строки не нужен - каждая строка события станет отдельной "data:"
+    if (logTailBuffer[n - 1] == '\n') n--;
+    logTailBuffer[n] = '\0';
+    logEvents.send(logTailBuffer, "log", logTailOffset);
+}
+
+int get_web_events_clients() {
+    return events.count();
+}
+
+void loop_web_events() {
+    loop_spectrum_stream();
+    loop_display_mirror();
+
+    unsigned long now = millis();
+    if (now - lastEventsTick < WEB_EVENTS_INTERVAL) return;
+    lastEventsTick = now;
+
+    LiveStatus status = collect_live_status();
+    if (statusVersion == 0 || status_changed(status, snapshotStatus)) {
+        publish_status_snapshot(status);
+    }
+
+    loop_log_tail();
+
+    if (events.count() == 0) {
+        lastSentValid = false;
+        return;
+    }
+
+    // Медленный клиент еще не забрал прошлые события - копим изменения до следующего тика
+    if (events.avgPacketsWaiting() >= WEB_EVENTS_CLIENT_QUEUE) {
+        webEventsDeferred++;
+        return;
+    }
+
+    size_t len = build_status_json(deltaBuffer, sizeof(deltaBuffer), status,
+                                   lastSentValid ? &lastSentStatus : nullptr);
+    if (len == 0) return;
+
+    events.send(deltaBuffer, "status", now);
+    webEventsSent++;
+    lastSentStatus = status;
+    lastSentValid = true;
+}
+
+static void setup_web_events() {
+    statusBootId = esp_random();
+
+    // Кешированный статус: 304 по ETag или готовые байты из буфера
+    on_session_route("/api/status", HTTP_GET, [](AsyncWebServerRequest *request){
+        const StatusSnapshot& snap = statusSnapshots[publishedSnapshot];
+        if (statusVersion == 0) return request->send(503, "text/plain", "Status not ready");
+
+        AsyncWebHeader* ifNoneMatch = request->getHeader("If-None-Match");
+        AsyncWebServerResponse *response;
+        if (ifNoneMatch && ifNoneMatch->value().equals(snap.etag)) {
+            response = request->beginResponse(304);
+        } else {
+            response = request->beginResponse_P(200, "application/json; charset=utf-8",
+                                                (const uint8_t*)snap.json, snap.length);
+        }
+        response->addHeader("ETag", snap.etag);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+    });
+
+    events.setFilter([](AsyncWebServerRequest *request) {
+        return session_filter(request, events.url());
+    });
+
+    events.onConnect([](AsyncEventSourceClient *client) {
+        if (events.count() > WEB_EVENTS_MAX_CLIENTS) {
+            // retry в событии откладывает автопереподключение EventSource
+            client->send("busy", "busy", 0, WEB_EVENTS_BUSY_RETRY);
+            client->close();
+            Serial.printf("📡 /api/events: отказ, уже %d клиентов\n", WEB_EVENTS_MAX_CLIENTS);
+            return;
+        }
+        if (statusVersion > 0) {
+            client->send(statusSnapshots[publishedSnapshot].json, "status", millis());
+        }
+        Serial.printf("📡 /api/events: клиент подключен (%d)\n", (int)events.count());
+    });
+
+    server.addHandler(&events);
+
+    logEvents.setFilter([](AsyncWebServerRequest *request) {
+        return session_filter(request, logEvents.url());
+    });
+
+    logEvents.onConnect([](AsyncEventSourceClient *client) {
+        if (logEvents.count() > WEB_LOG_TAIL_MAX_CLIENTS) {
+            client->send("busy", "busy", 0, WEB_EVENTS_BUSY_RETRY);
+            client->close();
+        }
+    });
+
+    server.addHandler(&logEvents);
+}
+
 // --- HTML страницы ---
 const char* login_html = R"rawliteral(
 <!DOCTYPE html><html><head><title>Login</title>
@@ -157,36 +1837,28 @@ function confirmReset() {
 // --- Режим точки доступа (AP Mode) ---
 
 void start_web_server_ap() {
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
-        web_loading_html.store(true, std::memory_order_relaxed);
-        request->send(LittleFS, "/ap_mode.html", "text/html; charset=utf-8");
+    on_route("/", HTTP_GET, [](AsyncWebServerRequest *request){
+        send_static_asset(request, "/ap_mode.html");
     });
 
-    server.on("/api/scan", HTTP_GET, [](AsyncWebServerRequest *request){
-        WiFi.scanNetworks(true);
-        request->send(200, "text/plain", "Scan Started");
+    // Скан идет в фоне (wifi_scan.cpp) - здесь только просьба обновить кэш
+    on_route("/api/scan", HTTP_GET, [](AsyncWebServerRequest *request){
+        request->send(200, "text/plain", wifi_scan_request() ? "Scan Started" : "Cached");
     });
 
-    server.on("/api/scan-results", HTTP_GET, [](AsyncWebServerRequest *request){
-        int n = WiFi.scanComplete();
-        if (n == -1) {
+    on_route("/api/scan-results", HTTP_GET, [](AsyncWebServerRequest *request){
+        if (!wifi_scan_ready()) {
             request->send(202, "text/plain", "Scanning...");
-        } else {
-            JsonDocument doc;
-            JsonArray array = doc.to<JsonArray>();
-            for (int i = 0; i < n; ++i) {
-                JsonObject net = array.add<JsonObject>();
-                net["ssid"] = WiFi.SSID(i);
-                net["rssi"] = WiFi.RSSI(i);
-            }
-            WiFi.scanDelete();
-            String response;
-            serializeJson(doc, response);
-            request->send(200, "application/json; charset=utf-8", response);
+            return;
         }
+        AsyncResponseStream *response = request->beginResponseStream("application/json; charset=utf-8", WEB_JSON_STREAM_BUFFER);
+        wifi_scan_write(*response);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
     });
 
-    server.on("/save", HTTP_POST, [](AsyncWebServerRequest *request){
+    on_route("/save", HTTP_POST, [](AsyncWebServerRequest *request){
+        unsigned long receivedAt = millis();  // Начало замера wifi_apply_to_audio_seconds
         String ssid;
         if (request->hasParam("ssid_manual", true) && !request->getParam("ssid_manual", true)->value().isEmpty()) {
             ssid = request->getParam("ssid_manual", true)->value();
@@ -200,9 +1872,13 @@ void start_web_server_ap() {
             wifiConfig.ssid = ssid;
             wifiConfig.password = password;
             if (save_wifi_config()) {
-                request->send(200, "text/plain", "WiFi settings saved. Rebooting...");
-                delay(1000);
-                ESP.restart();
+                // Переход AP -> STA делает loop(), после того как ответ уйдет
+                if (!sendApplyWifiCommand(receivedAt)) {
+                    request->send(503, "text/plain", "Busy, try again.");
+                    return;
+                }
+                request->send(200, "text/plain", "WiFi settings saved. Connecting to " + ssid +
+                              "... If it fails, the ESP32-Radio-Setup network comes back.");
             } else {
                 request->send(500, "text/plain", "Failed to save WiFi settings.");
             }
@@ -211,10 +1887,17 @@ void start_web_server_ap() {
         }
     });
 
+    compute_static_etags();
     server.begin();
     Serial.println("Web-сервер запущен в режиме AP.");
 }
 
+void stop_web_server() {
+    server.end();
+    server.reset();  // Маршруты, onNotFound и serveStatic
+    Serial.println("Web-сервер остановлен.");
+}
+
 
 // --- Режим станции (STA Mode) ---
 
@@ -225,51 +1908,34 @@ void start_web_server_sta() {
     // API обработчики регистрируются ПЕРВЫМИ!
     
     // === МАРШРУТИЗАЦИЯ КОРНЕВОГО ПУТИ ===
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
+    on_route("/", HTTP_GET, [](AsyncWebServerRequest *request){
         if (!isRegistered) {
             request->redirect("/register");
             return;
         }
         
-        // Автоматическая авторизация по токену
-        if (checkSessionToken(request)) {
-            isAuthenticated = true;
-        }
-        
-        // Если не авторизован - на логин
-        if (!isAuthenticated) {
+        // Автоматическая авторизация по токену; нет сессии - на логин
+        if (request_session(request) < 0) {
             request->redirect("/login");
             return;
         }
         
-        // Авторизован - index.html с UTF-8 и no-cache
-        // ПРИОРИТЕТ: приостановить audio для быстрой отдачи HTML!
-        web_loading_html.store(true, std::memory_order_relaxed);
-        AsyncWebServerResponse *response = request->beginResponse(LittleFS, "/index.html", "text/html; charset=utf-8");
-        response->addHeader("Cache-Control", "no-cache, no-store, must-revalidate");
-        response->addHeader("Pragma", "no-cache");
-        response->addHeader("Expires", "0");
-        request->send(response);
-        // Флаг сбросится в main loop через 100ms
+        // Авторизован - index.html (gzip, ETag/304)
+        send_static_asset(request, "/index.html");
     });
     
     // === РЕГИСТРАЦИЯ (только при первом запуске) ===
-    server.on("/register", HTTP_GET, [](AsyncWebServerRequest *request){
+    on_route("/register", HTTP_GET, [](AsyncWebServerRequest *request){
         if (isRegistered) {
             // Уже зарегистрирован - редирект на логин
             request->redirect("/login");
             return;
         }
         
-        web_loading_html.store(true, std::memory_order_relaxed);
-        AsyncWebServerResponse *response = request->beginResponse(LittleFS, "/register.html", "text/html; charset=utf-8");
-        response->addHeader("Cache-Control", "no-cache, no-store, must-revalidate");
-        response->addHeader("Pragma", "no-cache");
-        response->addHeader("Expires", "0");
-        request->send(response);
+        send_static_asset(request, "/register.html");
     });
 
-    server.on("/register", HTTP_POST, [](AsyncWebServerRequest *request){
+    on_route("/register", HTTP_POST, [](AsyncWebServerRequest *request){
         if (isRegistered) {
             request->send(400, "text/plain", "Регистрация уже выполнена");
             return;
@@ -296,13 +1962,13 @@ void start_web_server_sta() {
     });
     
     // === ЛОГИН ===
-    server.on("/login", HTTP_GET, [](AsyncWebServerRequest *request){
+    on_route("/login", HTTP_GET, [](AsyncWebServerRequest *request){
         // Если не зарегистрирован - редирект на регистрацию
         if (!isRegistered) {
             request->redirect("/register");
         }
         // Если уже авторизован - на главную
-        else if (isAuthenticated) {
+        else if (request_session(request) >= 0) {
             request->redirect("/");
         }
         // Показываем страницу логина
@@ -311,27 +1977,28 @@ void start_web_server_sta() {
         }
     });
 
-    server.on("/login", HTTP_POST, [](AsyncWebServerRequest *request){
+    on_route("/login", HTTP_POST, [](AsyncWebServerRequest *request){
         if (request->hasParam("username", true) && request->hasParam("password", true)) {
             String username = request->getParam("username", true)->value();
             String password = request->getParam("password", true)->value();
             
             if (verify_credentials(username, password)) {
-                isAuthenticated = true;
-                
-                // Генерируем session token ТОЛЬКО если его нет
-                if (sessionToken.length() == 0) {
-                    sessionToken = generateSessionToken();
+                // У каждого клиента своя сессия; повторный вход с действующей - та же
+                int slot = request_session(request);
+                if (slot < 0) {
+                    slot = web_session_create();
                     save_state();  // Сохраняем токен
-                    Serial.println("🆕 Session token создан.");
+                    Serial.printf("🆕 Сессия создана (слот %d, активных %u).\n", slot, web_sessions_active());
                 } else {
                     Serial.println("♻️ Используем существующий session token.");
                 }
                 
                 // Отправляем токен в куки (действует до очистки)
+                char cookie[SESSION_TOKEN_LENGTH + 48];
+                snprintf(cookie, sizeof(cookie), "session=%s; Path=/; Max-Age=31536000", web_session_token(slot));
                 AsyncWebServerResponse *response = request->beginResponse(302);
                 response->addHeader("Location", "/");
-                response->addHeader("Set-Cookie", "session=" + sessionToken + "; Path=/; Max-Age=31536000");
+                response->addHeader("Set-Cookie", cookie);
                 request->send(response);
                 
                 Serial.println("✅ Успешная авторизация.");
@@ -343,12 +2010,13 @@ void start_web_server_sta() {
         }
     });
 
-    server.on("/logout", HTTP_GET, [](AsyncWebServerRequest *request){
-        isAuthenticated = false;
-        
-        // Очищаем session token
-        sessionToken = "";
-        save_state();
+    on_route("/logout", HTTP_GET, [](AsyncWebServerRequest *request){
+        // Закрываем только сессию этого клиента
+        int slot = request_session(request);
+        if (slot >= 0) {
+            web_session_revoke(slot);
+            save_state();
+        }
         
         // Очищаем куки
         AsyncWebServerResponse *response = request->beginResponse(302);
@@ -356,17 +2024,17 @@ void start_web_server_sta() {
         response->addHeader("Set-Cookie", "session=; Path=/; Max-Age=0");
         request->send(response);
         
-        Serial.println("🚪 Выход из системы. Session token очищен.");
+        Serial.println("🚪 Выход из системы. Сессия закрыта.");
     });
     
     // === ЗАБЫЛ ПАРОЛЬ (FACTORY RESET) ===
-    server.on("/forgot-password", HTTP_GET, [](AsyncWebServerRequest *request){
+    on_route("/forgot-password", HTTP_GET, [](AsyncWebServerRequest *request){
         // Показываем страницу предупреждения
         request->send(200, "text/html; charset=utf-8", forgot_password_html);
     });
     
     // API: Выполнение factory reset без пароля (для забывших пароль)
-    server.on("/api/forgot-password-reset", HTTP_POST, [](AsyncWebServerRequest *request){
+    on_route("/api/forgot-password-reset", HTTP_POST, [](AsyncWebServerRequest *request){
         // НЕ требуем авторизацию - это для тех, кто забыл пароль!
         
         log_message("⚠️ FACTORY RESET через 'Forgot Password'. Удаление всех данных...");
@@ -380,8 +2048,7 @@ void start_web_server_sta() {
         
         // Сбрасываем флаги
         isRegistered = false;
-        isAuthenticated = false;
-        sessionToken = "";
+        web_sessions_clear();
         
         Serial.println("🔥 Factory Reset выполнен! Перезагрузка...");
         
@@ -391,49 +2058,47 @@ void start_web_server_sta() {
     });
 
     // API: Информация о станциях (количество и лимит)
-    server.on("/api/stations/info", HTTP_GET, [](AsyncWebServerRequest *request){
-        if (checkSessionToken(request)) isAuthenticated = true;
-        if (!isAuthenticated) return request->send(401);
-        
+    on_session_route("/api/stations/info", HTTP_GET, [](AsyncWebServerRequest *request){
         // 🛡️ ЗАЩИТА ОТ RACE CONDITION
         STATIONS_LOCK();
         size_t currentSize = stations.size();
         STATIONS_UNLOCK();
         
-        String json = "{";
-        json += "\"current\":" + String(currentSize) + ",";
-        json += "\"max\":" + String(MAX_RADIO_STATIONS) + ",";
-        json += "\"available\":" + String(MAX_RADIO_STATIONS - currentSize);
-        json += "}";
-        request->send(200, "application/json; charset=utf-8", json);
+        WebHeapProbe probe;
+        AsyncResponseStream *response = request->beginResponseStream("application/json; charset=utf-8", WEB_JSON_STREAM_BUFFER);
+        JsonWriter json(*response);
+        json.beginObject()
+            .field("current", currentSize)
+            .field("max", MAX_RADIO_STATIONS)
+            .field("available", MAX_RADIO_STATIONS - currentSize)
+            .field("saves", stationsSaveCount)
+            .field("bytesWritten", stationsBytesWritten)
+            .endObject();
+        probe.sample();
+        size_t bytes = response->available();
+        request->send(response);
+        probe.report("/api/stations/info", bytes);
     });
 
-    server.on("/api/stations", HTTP_GET, [](AsyncWebServerRequest *request){
-        // Автоматическая авторизация по токену
-        if (checkSessionToken(request)) isAuthenticated = true;
-        if (!isAuthenticated) return request->send(401);
-        
-        // 🛡️ ЗАЩИТА ОТ RACE CONDITION: копируем stations под мьютексом
-        STATIONS_LOCK();
-        std::vector<RadioStation> stationsCopy = stations;
-        STATIONS_UNLOCK();
-        
-        // Оптимизация: уменьшаем размер JSON
-        JsonDocument doc;
-        JsonArray array = doc.to<JsonArray>();
-        for (const auto& station : stationsCopy) {
-            JsonObject obj = array.add<JsonObject>();
-            obj["name"] = station.name;
-            obj["url"] = station.url;
-        }
-        String response;
-        serializeJson(doc, response);
-        request->send(200, "application/json; charset=utf-8", response);
+    on_session_route("/api/stations", HTTP_GET, [](AsyncWebServerRequest *request){
+        // Одна ревизия на весь ответ: ETag, заголовок дельты и проверка в потоке
+        uint32_t revision = stationsRevision;
+        char etag[16];
+        snprintf(etag, sizeof(etag), "\"st-%lu\"", (unsigned long)revision);
+        if (send_not_modified(request, etag)) return;
+
+        bool delta = request->hasParam("since");
+        uint32_t since = delta ? strtoul(request->getParam("since")->value().c_str(), nullptr, 10) : 0;
+        // Ревизия из будущего (другая загрузка) - отдаем все позиции
+        if (since > revision) since = 0;
+
+        AsyncWebServerResponse *response = begin_stations_json_response(request, revision, delta, since);
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
     });
 
-    server.on("/api/add", HTTP_POST, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
-        
+    on_session_route("/api/add", HTTP_POST, [](AsyncWebServerRequest *request){
         // 🛡️ ЗАЩИТА ОТ RACE CONDITION: проверяем лимит под мьютексом
         STATIONS_LOCK();
         bool limitReached = stations.size() >= MAX_RADIO_STATIONS;
@@ -459,6 +2124,7 @@ void start_web_server_sta() {
             // 🛡️ Добавление под мьютексом
             STATIONS_LOCK();
             stations.push_back({name, url, true});
+            mark_stations_changed(stations.size() - 1, stations.size());
             STATIONS_UNLOCK();
             
             sendSaveStationsCommand();  // ✅ Через FreeRTOS Queue
@@ -468,14 +2134,18 @@ void start_web_server_sta() {
         }
     });
 
-    server.on("/api/delete", HTTP_POST, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
+    on_session_route("/api/delete", HTTP_POST, [](AsyncWebServerRequest *request){
         if (request->hasParam("name", true)) {
             String name = request->getParam("name", true)->value();
             
             // 🛡️ ЗАЩИТА ОТ RACE CONDITION: удаление под мьютексом
             STATIONS_LOCK();
-            stations.erase(std::remove_if(stations.begin(), stations.end(), [&](const RadioStation& s){ return s.name == name; }), stations.end());
+            auto first = std::find_if(stations.begin(), stations.end(), [&](const RadioStation& s){ return s.name == name; });
+            if (first != stations.end()) {
+                size_t from = first - stations.begin();
+                stations.erase(std::remove_if(first, stations.end(), [&](const RadioStation& s){ return s.name == name; }), stations.end());
+                mark_stations_changed(from, stations.size());  // Сдвинулись все позиции после удаленной
+            }
             STATIONS_UNLOCK();
             
             sendSaveStationsCommand();  // ✅ Через FreeRTOS Queue
@@ -485,8 +2155,7 @@ void start_web_server_sta() {
         }
     });
 
-    server.on("/api/update", HTTP_POST, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
+    on_session_route("/api/update", HTTP_POST, [](AsyncWebServerRequest *request){
         if (request->hasParam("originalName", true) && request->hasParam("name", true) && request->hasParam("url", true)) {
             String originalName = request->getParam("originalName", true)->value();
             String name = request->getParam("name", true)->value();
@@ -500,13 +2169,17 @@ void start_web_server_sta() {
                 return;
             }
             
-            for (auto& station : stations) {
-                if (station.name == originalName) {
-                    station.name = name;
-                    station.url = url;
+            // 🛡️ Изменение под мьютексом
+            STATIONS_LOCK();
+            for (size_t i = 0; i < stations.size(); i++) {
+                if (stations[i].name == originalName) {
+                    stations[i].name = name;
+                    stations[i].url = url;
+                    mark_stations_changed(i, i + 1);
                     break;
                 }
             }
+            STATIONS_UNLOCK();
             sendSaveStationsCommand();  // ✅ Через FreeRTOS Queue
             request->send(200, "text/plain", "OK");
         } else {
@@ -515,8 +2188,7 @@ void start_web_server_sta() {
     });
 
     // --- API пульта управления ---
-    server.on("/api/player/next", HTTP_POST, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
+    on_session_route("/api/player/next", HTTP_POST, [](AsyncWebServerRequest *request){
         if (sendNextStationCommand()) {
             request->send(200, "text/plain", "OK");
         } else {
@@ -524,8 +2196,7 @@ void start_web_server_sta() {
         }
     });
 
-    server.on("/api/player/previous", HTTP_POST, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
+    on_session_route("/api/player/previous", HTTP_POST, [](AsyncWebServerRequest *request){
         if (sendPrevStationCommand()) {
             request->send(200, "text/plain", "OK");
         } else {
@@ -533,34 +2204,27 @@ void start_web_server_sta() {
         }
     });
 
-    server.on("/api/player/volume", HTTP_POST, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
+    on_session_route("/api/player/volume", HTTP_POST, [](AsyncWebServerRequest *request){
         if (request->hasParam("volume", true)) {
             float vol = request->getParam("volume", true)->value().toFloat();
-            if (sendVolumeCommand(vol)) {
-                request->send(200, "text/plain", "OK");
-            } else {
-                request->send(503, "text/plain", "Queue full");
-            }
+            postVolumeSetting(constrain(vol, VOLUME_MIN, VOLUME_MAX));
+            request->send(200, "text/plain", "OK");
         } else {
             request->send(400, "text/plain", "Bad Request");
         }
     });
 
     // --- API дисплея ---
-    server.on("/api/display/rotation", HTTP_GET, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
+    on_session_route("/api/display/rotation", HTTP_GET, [](AsyncWebServerRequest *request){
         String json = jsonField("rotation", displayRotation);
         request->send(200, "application/json; charset=utf-8", json);
     });
 
-    server.on("/api/display/rotation", HTTP_POST, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
+    on_session_route("/api/display/rotation", HTTP_POST, [](AsyncWebServerRequest *request){
         if (request->hasParam("rotation", true)) {
             uint8_t rotation = request->getParam("rotation", true)->value().toInt();
             if (rotation == 0 || rotation == 2) {
-                set_display_rotation(rotation);
-                save_state(); // Сохраняем настройку
+                postRotationSetting(rotation);  // Применит и сохранит loop()
                 request->send(200, "text/plain", "OK");
             } else {
                 request->send(400, "text/plain", "Invalid rotation value");
@@ -570,10 +2234,30 @@ void start_web_server_sta() {
         }
     });
 
+    // Снимок экрана OLED (PBM) - для проверки отрисовки без доступа к устройству
+    on_session_route("/api/display/snapshot", HTTP_GET, [](AsyncWebServerRequest *request){
+        AsyncResponseStream *response = request->beginResponseStream("image/x-portable-bitmap");
+        response->addHeader("Cache-Control", "no-store");
+        write_display_snapshot_pbm(*response);
+        request->send(response);
+    });
+
+    // Статистика шины дисплея
+    on_session_route("/api/display/stats", HTTP_GET, [](AsyncWebServerRequest *request){
+        FramePacerStatus pacer = get_frame_pacer_status();
+        String json = formatString("{\"rendered\":%lu,\"skipped\":%lu,\"flushes\":%lu,\"busBytes\":%lu,\"busMicros\":%lu,\"lastFlushBytes\":%lu,"
+                                   "\"fps\":%u,\"targetFps\":%u,\"throttle\":\"%s\",\"bufferFill\":%d,\"decodeShare\":%u,\"displayShare\":%u}",
+                                   displayFramesRendered, displayFramesSkipped,
+                                   displayFlushes, displayBusBytes, displayBusMicros,
+                                   displayLastFlushBytes,
+                                   pacer.fps, pacer.targetFps, frame_pacer_reason_name(pacer.reason),
+                                   pacer.bufferFill, pacer.decodeShare, pacer.displayShare);
+        request->send(200, "application/json; charset=utf-8", json);
+    });
+
     // --- API визуализатора ---
     // GET - получить текущий стиль
-    server.on("/api/visualizer/style", HTTP_GET, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
+    on_session_route("/api/visualizer/style", HTTP_GET, [](AsyncWebServerRequest *request){
         String json = formatString("{\"style\":%d,\"name\":\"%s\"}", 
                                    (int)visualizerStyle, 
                                    visualizerManager.getCurrentStyleName());
@@ -581,14 +2265,11 @@ void start_web_server_sta() {
     });
 
     // POST - изменить стиль
-    server.on("/api/visualizer/style", HTTP_POST, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
+    on_session_route("/api/visualizer/style", HTTP_POST, [](AsyncWebServerRequest *request){
         if (request->hasParam("style", true)) {
             int style = request->getParam("style", true)->value().toInt();
             if (style >= 0 && style < VISUALIZER_STYLE_COUNT) {
-                visualizerStyle = (VisualizerStyle)style;
-                visualizerManager.setStyle(visualizerStyle);
-                save_state();
+                postVisualizerStyleSetting(style);  // Применит и сохранит loop()
                 request->send(200, "text/plain", "OK");
             } else {
                 request->send(400, "text/plain", "Invalid style");
@@ -599,20 +2280,26 @@ void start_web_server_sta() {
     });
 
     // GET - список всех стилей
-    server.on("/api/visualizer/styles", HTTP_GET, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
-        String json = "[";
+    on_session_route("/api/visualizer/styles", HTTP_GET, [](AsyncWebServerRequest *request){
+        WebHeapProbe probe;
+        AsyncResponseStream *response = request->beginResponseStream("application/json; charset=utf-8", WEB_JSON_STREAM_BUFFER);
+        JsonWriter json(*response);
+        json.beginArray();
         for (int i = 0; i < VISUALIZER_STYLE_COUNT; i++) {
-            if (i > 0) json += ",";
-            json += "{\"id\":" + String(i) + ",\"name\":\"" + VisualizerManager::getStyleName((VisualizerStyle)i) + "\"}";
+            json.beginObject()
+                .field("id", i)
+                .field("name", VisualizerManager::getStyleName((VisualizerStyle)i))
+                .endObject();
         }
-        json += "]";
-        request->send(200, "application/json; charset=utf-8", json);
+        json.endArray();
+        probe.sample();
+        size_t bytes = response->available();
+        request->send(response);
+        probe.report("/api/visualizer/styles", bytes);
     });
 
     // --- API системы ---
-    server.on("/api/system/reboot", HTTP_POST, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
+    on_session_route("/api/system/reboot", HTTP_POST, [](AsyncWebServerRequest *request){
         if (sendRebootCommand()) {
             request->send(200, "text/plain", "Rebooting...");
         } else {
@@ -620,9 +2307,7 @@ void start_web_server_sta() {
         }
     });
 
-    server.on("/api/factory-reset", HTTP_POST, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
-        
+    on_session_route("/api/factory-reset", HTTP_POST, [](AsyncWebServerRequest *request){
         if (request->hasParam("password", true)) {
             String password = request->getParam("password", true)->value();
             
@@ -648,20 +2333,91 @@ void start_web_server_sta() {
         }
     });
 
+    // --- Live статус (/api/status, SSE /api/events) ---
+    setup_web_events();
+    setup_control_socket();
+    wsSlotsMutex = xSemaphoreCreateMutex();
+    if (wsSlotsMutex == nullptr) {
+        Serial.println("❌ КРИТИЧНО: Не удалось создать wsSlotsMutex!");
+        delay(5000);
+        ESP.restart();
+    }
+    setup_spectrum_socket();
+    setup_display_mirror();
+
     // --- API логов ---
-    server.on("/api/logs", HTTP_GET, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
-        request->send(200, "text/plain", get_logs());
+    // Без параметров - последние WEB_LOG_TAIL_BYTES с начала строки.
+    // ?from=N или Range: bytes=N- - с логического смещения N (только новое).
+    // X-Log-Offset / X-Log-End - логические смещения отданного куска
+    on_session_route("/api/logs", HTTP_GET, [](AsyncWebServerRequest *request){
+        uint32_t base, end;
+        get_log_range(base, end);
+        uint32_t from;
+        bool tail = false;
+        bool range = false;
+        AsyncWebHeader* rangeHeader = request->getHeader("Range");
+
+        if (request->hasParam("from")) {
+            from = strtoul(request->getParam("from")->value().c_str(), nullptr, 10);
+        } else if (rangeHeader && rangeHeader->value().startsWith("bytes=")) {
+            from = strtoul(rangeHeader->value().c_str() + 6, nullptr, 10);
+            range = true;
+            if (from >= end) {
+                AsyncWebServerResponse *response = request->beginResponse(416);
+                response->addHeader("Content-Range", formatString("bytes */%lu", (unsigned long)end));
+                return request->send(response);
+            }
+        } else {
+            from = (end - base > WEB_LOG_TAIL_BYTES) ? end - WEB_LOG_TAIL_BYTES : base;
+            tail = true;
+        }
+
+        // Запрошенное уже удалено при очистке - отдаем с начала файла
+        if (from < base) from = base;
+        if (from > end) from = end;
+        size_t fileStart = from - base;
+        if (tail && fileStart > 0) {
+            fileStart = skip_to_line_start(LOG_FILE, fileStart);
+            from = base + fileStart;
+        }
+
+        AsyncWebServerResponse *response = (from < end)
+            ? begin_sliced_file_response(request, LOG_FILE, "text/plain; charset=utf-8", fileStart, end - from)
+            : nullptr;
+        if (!response) {
+            response = request->beginResponse(200, "text/plain; charset=utf-8", "");
+        } else if (range) {
+            response->setCode(206);
+            response->addHeader("Content-Range", formatString("bytes %lu-%lu/%lu",
+                                (unsigned long)from, (unsigned long)end - 1, (unsigned long)end));
+        }
+        response->addHeader("X-Log-Offset", String(from));
+        response->addHeader("X-Log-End", String(end));
+        response->addHeader("Cache-Control", "no-store");
+        request->send(response);
+    });
+
+    // --- Метрики (Prometheus) ---
+    on_session_route("/api/metrics", HTTP_GET, [](AsyncWebServerRequest *request){
+        request->send(begin_metrics_response(request));
     });
 
     // --- API управления станциями (расширенное) ---
-    server.on("/api/stations/export", HTTP_GET, [](AsyncWebServerRequest *request){
-        if (!isAuthenticated) return request->send(401);
-        request->send(LittleFS, "/stations.json", "application/json; charset=utf-8", true);
+    on_session_route("/api/stations/export", HTTP_GET, [](AsyncWebServerRequest *request){
+        // ETag по ревизии, записанной в файл (сохранение идет через очередь команд)
+        char etag[16];
+        snprintf(etag, sizeof(etag), "\"sf-%lu\"", (unsigned long)stationsSavedRevision);
+        if (send_not_modified(request, etag)) return;
+
+        AsyncWebServerResponse *response = begin_sliced_file_response(request, "/stations.json", "application/json; charset=utf-8");
+        if (!response) return request->send(404, "text/plain", "No stations");
+        response->addHeader("Content-Disposition", "attachment; filename=\"stations.json\"");
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
     });
 
-    AsyncCallbackJsonWebHandler* orderHandler = new AsyncCallbackJsonWebHandler("/api/stations/order", [](AsyncWebServerRequest *request, JsonVariant &json) {
-        if (!isAuthenticated) return request->send(401);
+    AsyncCallbackJsonWebHandler* orderHandler = new AsyncCallbackJsonWebHandler("/api/stations/order", timed_json_route("/api/stations/order", [](AsyncWebServerRequest *request, JsonVariant &json) {
         JsonArray newOrder = json.as<JsonArray>();
         std::vector<RadioStation> ordered_stations;
         
@@ -680,6 +2436,7 @@ void start_web_server_sta() {
         // 🛡️ Перезаписываем stations только если все станции валидны
         if (ordered_stations.size() == stations.size()) {
             stations = ordered_stations;
+            mark_stations_changed(0, stations.size());
             STATIONS_UNLOCK();
             sendSaveStationsCommand();  // ✅ Через FreeRTOS Queue
             request->send(200, "text/plain", "Order saved");
@@ -687,28 +2444,119 @@ void start_web_server_sta() {
             STATIONS_UNLOCK();
             request->send(400, "text/plain", "Invalid station order data");
         }
-    });
+    }));
     server.addHandler(orderHandler);
 
-    // Обработка загрузки файла для импорта
-    server.onFileUpload([](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final){
-        if (!isAuthenticated) return request->send(401);
-        if (request->url() == "/api/stations/import") {
-            if (!index) {
-                // Открываем файл для записи
-                request->_tempFile = LittleFS.open("/stations.json", "w");
+    // Пакетное изменение станций: все операции применяются атомарно под одной блокировкой
+    // и сохраняются одной записью /stations.json (вместо записи на каждую операцию).
+    // Тело: {"ops":[{"op":"add","name":..,"url":..}, {"op":"delete","name":..},
+    //               {"op":"update","originalName":..,"name":..,"url":..}, {"op":"order","names":[..]}]}
+    AsyncCallbackJsonWebHandler* batchHandler = new AsyncCallbackJsonWebHandler("/api/stations/batch", timed_json_route("/api/stations/batch", [](AsyncWebServerRequest *request, JsonVariant &json) {
+        JsonArray ops = json["ops"].as<JsonArray>();
+        if (ops.isNull() || ops.size() == 0) {
+            return request->send(400, "application/json; charset=utf-8", "{\"error\":\"No operations\"}");
+        }
+
+        // Ошибка операции index -> 400, список станций не меняется
+        auto reject = [request](size_t index, const String& error) {
+            AsyncResponseStream *response = request->beginResponseStream("application/json; charset=utf-8", WEB_JSON_STREAM_BUFFER);
+            response->setCode(400);
+            JsonWriter out(*response);
+            out.beginObject().field("op", index).field("error", error).endObject();
+            request->send(response);
+        };
+
+        // 1. Валидация URL до блокировки (самая дорогая часть)
+        size_t i = 0;
+        for (JsonObject op : ops) {
+            const char* type = op["op"] | "";
+            if (strcmp(type, "add") == 0 || strcmp(type, "update") == 0) {
+                String name = op["name"] | "";
+                if (name.length() == 0) return reject(i, "Empty name");
+                URLValidationResult validation = validateURL(op["url"] | "");
+                if (validation != URL_VALID) return reject(i, "Invalid URL: " + getValidationErrorMessage(validation));
+            } else if (strcmp(type, "delete") != 0 && strcmp(type, "order") != 0) {
+                return reject(i, "Unknown op");
             }
-            if (len) {
-                // Пишем данные в файл
-                request->_tempFile.write(data, len);
+            i++;
+        }
+
+        // 2. Применение к копии под одной блокировкой
+        STATIONS_LOCK();
+        std::vector<RadioStation> before = stations;
+        std::vector<RadioStation> edited = stations;
+        auto find = [&edited](const String& name) -> int {
+            for (size_t k = 0; k < edited.size(); k++) {
+                if (edited[k].name == name) return k;
             }
-            if (final) {
-                // Закрываем файл и перезагружаем конфиг
-                request->_tempFile.close();
-                load_stations_config();
-                request->send(200, "text/plain", "Import successful");
+            return -1;
+        };
+
+        i = 0;
+        String error;
+        for (JsonObject op : ops) {
+            const char* type = op["op"];
+            if (strcmp(type, "add") == 0) {
+                String name = op["name"].as<String>();
+                if (edited.size() >= MAX_RADIO_STATIONS) error = "Maximum stations limit reached";
+                else if (find(name) >= 0) error = "Station already exists";
+                else edited.push_back({name, op["url"].as<String>(), true});
+            } else if (strcmp(type, "delete") == 0) {
+                int index = find(op["name"] | "");
+                if (index < 0) error = "Station not found";
+                else edited.erase(edited.begin() + index);
+            } else if (strcmp(type, "update") == 0) {
+                int index = find(op["originalName"] | "");
+                String name = op["name"].as<String>();
+                int clash = find(name);
+                if (index < 0) error = "Station not found";
+                else if (clash >= 0 && clash != index) error = "Station already exists";
+                else {
+                    edited[index].name = name;
+                    edited[index].url = op["url"].as<String>();
+                }
+            } else {
+                JsonArray names = op["names"].as<JsonArray>();
+                std::vector<RadioStation> ordered;
+                for (JsonVariant v : names) {
+                    int index = find(v.as<String>());
+                    if (index < 0) break;
+                    ordered.push_back(edited[index]);
+                }
+                if (ordered.size() != edited.size() || names.size() != edited.size()) error = "Invalid station order";
+                else edited = ordered;
             }
+            if (error.length() > 0) break;
+            i++;
+        }
+
+        if (error.length() > 0) {
+            STATIONS_UNLOCK();
+            return reject(i, error);
         }
+
+        // 3. Фиксация
+        stations = edited;
+        mark_stations_diff(before);
+        uint32_t revision = stationsRevision;
+        size_t count = stations.size();
+        STATIONS_UNLOCK();
+
+        sendSaveStationsCommand();  // ✅ Одна запись на весь пакет
+        log_message(formatString("📦 Пакет станций: %u операций, ревизия %lu", (unsigned)ops.size(), (unsigned long)revision));
+
+        AsyncResponseStream *response = request->beginResponseStream("application/json; charset=utf-8", WEB_JSON_STREAM_BUFFER);
+        JsonWriter out(*response);
+        out.beginObject().field("applied", ops.size()).field("rev", revision).field("count", count).endObject();
+        request->send(response);
+    }));
+    server.addHandler(batchHandler);
+
+    // Импорт станций: загрузка разбирается потоком, ответ - после фиксации
+    server.on("/api/stations/import", HTTP_POST, timed_route("/api/stations/import", HTTP_POST, [](AsyncWebServerRequest *request){
+        finish_import(request);
+    }, ROUTE_SESSION), [](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final){
+        handle_import_upload(request, index, data, len, final);
     });
 
     // Статические файлы РЕГИСТРИРУЕМ В КОНЦЕ!
@@ -723,7 +2571,7 @@ void start_web_server_sta() {
             request->redirect("/register");
         }
         // Если не авторизован - на логин
-        else if (!isAuthenticated) {
+        else if (request_session(request) < 0) {
             request->redirect("/login");
         }
         // Авторизован - 404
@@ -732,6 +2580,7 @@ void start_web_server_sta() {
         }
     });
 
+    compute_static_etags();
     server.begin();
     Serial.println("Web-сервер запущен в режиме STA.");
 }
\ No newline at end of file
@@ -1,13 +1,14 @@
 #ifndef WEB_SERVER_MANAGER_H
 #define WEB_SERVER_MANAGER_H
 
-#include <atomic>
-
 void start_web_server_sta();
 void start_web_server_ap();
+void stop_web_server();  // Снять все маршруты и закрыть порт (смена режима без перезагрузки)
+void loop_web_events();  // Снапшот /api/status и рассылка изменений подписчикам /api/events (из main loop)
 
-// Флаг: веб-сервер загружает большой файл (приостановить audio)
-// ATOMIC: используется между async веб-сервером и main loop
-extern std::atomic<bool> web_loading_html;
+// 📊 Live статус: накопительные счетчики
+extern unsigned long webEventsSent;      // Отправлено событий status
+extern unsigned long webEventsDeferred;  // Тиков, отложенных из-за заполненных очередей клиентов
+int get_web_events_clients();
 
 #endif // WEB_SERVER_MANAGER_H
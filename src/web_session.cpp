@@ -0,0 +1,80 @@
+#include "config.h"
+#include "web_session.h"
+
+// Последнее использование слота (millis) - кого вытеснить при входе сверх лимита
+static unsigned long sessionLastUsed[WEB_SESSION_SLOTS] = {0};
+
+int web_session_find(const char* token, size_t length) {
+    if (length != SESSION_TOKEN_LENGTH) return -1;
+
+    // Все слоты и все символы сравниваются всегда: время не зависит от того,
+    // сколько символов совпало и в каком слоте
+    int found = -1;
+    for (int i = 0; i < WEB_SESSION_SLOTS; i++) {
+        uint8_t diff = (sessionTokens[i][0] == '\0');  // Пустой слот не совпадает ни с чем
+        for (size_t j = 0; j < SESSION_TOKEN_LENGTH; j++) {
+            diff |= (uint8_t)sessionTokens[i][j] ^ (uint8_t)token[j];
+        }
+        if (diff == 0) found = i;
+    }
+    if (found >= 0) sessionLastUsed[found] = millis();
+    return found;
+}
+
+int web_session_from_cookie(const char* cookie) {
+    // Пары "имя=значение" через ';', имя сравнивается целиком ("xsession=" не подходит)
+    const char* p = cookie;
+    while (p && *p) {
+        while (*p == ' ' || *p == ';') p++;
+        if (strncmp(p, "session=", 8) == 0) {
+            const char* value = p + 8;
+            size_t length = strcspn(value, "; ");
+            return web_session_find(value, length);
+        }
+        p = strchr(p, ';');
+    }
+    return -1;
+}
+
+int web_session_create() {
+    static const char chars[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+    int slot = 0;
+    for (int i = 0; i < WEB_SESSION_SLOTS; i++) {
+        if (sessionTokens[i][0] == '\0') {
+            slot = i;
+            break;
+        }
+        if (sessionLastUsed[i] < sessionLastUsed[slot]) slot = i;
+    }
+
+    // Аппаратный ГСЧ (esp_random) вместо random()
+    for (int j = 0; j < SESSION_TOKEN_LENGTH; j++) {
+        sessionTokens[slot][j] = chars[esp_random() % (sizeof(chars) - 1)];
+    }
+    sessionTokens[slot][SESSION_TOKEN_LENGTH] = '\0';
+    sessionLastUsed[slot] = millis();
+    return slot;
+}
+
+const char* web_session_token(int slot) {
+    if (slot < 0 || slot >= WEB_SESSION_SLOTS) return "";
+    return sessionTokens[slot];
+}
+
+void web_session_revoke(int slot) {
+    if (slot < 0 || slot >= WEB_SESSION_SLOTS) return;
+    memset(sessionTokens[slot], 0, sizeof(sessionTokens[slot]));
+}
+
+void web_sessions_clear() {
+    memset(sessionTokens, 0, sizeof(sessionTokens));
+}
+
+uint8_t web_sessions_active() {
+    uint8_t count = 0;
+    for (int i = 0; i < WEB_SESSION_SLOTS; i++) {
+        if (sessionTokens[i][0] != '\0') count++;
+    }
+    return count;
+}
@@ -0,0 +1,20 @@
+#ifndef WEB_SESSION_H
+#define WEB_SESSION_H
+
+#include <Arduino.h>
+
+// === ТАБЛИЦА СЕССИЙ ===
+// До WEB_SESSION_SLOTS одновременных входов (браузер, телефон, скрипт) - у каждого
+// свой токен, выход одного не разлогинивает остальных. Токены хранятся в state.json.
+// Проверка не выделяет память: cookie разбирается на месте, токен сравнивается
+// со всеми слотами за постоянное время. Вызывается только из задачи AsyncTCP.
+
+int web_session_find(const char* token, size_t length);  // Номер слота или -1
+int web_session_from_cookie(const char* cookie);          // Слот по "session=" из заголовка Cookie, или -1
+int web_session_create();                  // Новый токен в свободном или самом давнем слоте
+const char* web_session_token(int slot);
+void web_session_revoke(int slot);
+void web_sessions_clear();
+uint8_t web_sessions_active();
+
+#endif // WEB_SESSION_H
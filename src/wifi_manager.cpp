@@ -8,6 +8,7 @@
 #include "string_utils.h"
 #include "system_manager.h"
 #include "audio_manager.h"
+#include "telemetry.h"
 
 #include "log_manager.h"
 
@@ -106,6 +107,7 @@ void handle_wifi_recovery() {
         }
         
         // WiFi потерян! Запускаем авто-реконнект
+        wifiDisconnects.add();
         wifiRecoveryState = WIFI_AUTO_RECONNECTING;
         wifiDisconnectTime = millis();
         autoReconnectChecks = 0;
@@ -121,6 +123,7 @@ void handle_wifi_recovery() {
         // Если переподключилось автоматически
         if (isConnected) {
             wifiRecoveryState = WIFI_OK;
+            wifiReconnects.add();
             log_message("✅ WiFi восстановлен автоматически!");
             show_ip_address(WiFi.localIP().toString(), 2000);
             // IP display handled in main loop
@@ -160,6 +163,7 @@ void handle_wifi_recovery() {
             if (connect_to_wifi()) {
                 // Успешное переподключение!
                 wifiRecoveryState = WIFI_OK;
+                wifiReconnects.add();
                 log_message("✅ WiFi восстановлен вручную!");
                 reset_inactivity_timer();
                 return;
@@ -0,0 +1,180 @@
+#include <WiFi.h>
+#include <atomic>
+#include "config.h"
+#include "wifi_scan.h"
+#include "json_writer.h"
+#include "log_manager.h"
+#include "string_utils.h"
+
+struct ScanNetwork {
+    char ssid[33];
+    int8_t rssi;
+    wifi_auth_mode_t auth;
+};
+
+// Готовый JSON в двух буферах: loop() пишет в неопубликованный и переключает индекс,
+// веб-сервер читает опубликованный (копирует сразу в ответ)
+struct ScanSnapshot {
+    char json[WIFI_SCAN_JSON_SIZE];
+    size_t length;
+    unsigned long scannedAt;
+};
+
+static ScanSnapshot scanSnapshots[2];
+static std::atomic<int8_t> publishedScan(-1);  // -1 - сканов еще не было
+static std::atomic<bool> scanRequested(true);  // Первый скан сразу после запуска AP
+static std::atomic<bool> scanRunning(false);
+static unsigned long lastScanStart = 0;
+
+static const char* auth_name(wifi_auth_mode_t auth) {
+    switch (auth) {
+        case WIFI_AUTH_OPEN:            return "open";
+        case WIFI_AUTH_WEP:             return "WEP";
+        case WIFI_AUTH_WPA_PSK:         return "WPA";
+        case WIFI_AUTH_WPA2_PSK:        return "WPA2";
+        case WIFI_AUTH_WPA_WPA2_PSK:    return "WPA/WPA2";
+        case WIFI_AUTH_WPA2_ENTERPRISE: return "WPA2-EAP";
+        case WIFI_AUTH_WPA3_PSK:        return "WPA3";
+        case WIFI_AUTH_WPA2_WPA3_PSK:   return "WPA2/WPA3";
+        default:                        return "other";
+    }
+}
+
+// Слияние по SSID (сильнейший сигнал), скрытые сети пропускаются.
+// Результат отсортирован по убыванию RSSI
+static int collect_networks(int found, ScanNetwork* nets) {
+    int count = 0;
+    for (int i = 0; i < found; i++) {
+        String ssid = WiFi.SSID(i);
+        if (ssid.isEmpty()) continue;
+        int8_t rssi = WiFi.RSSI(i);
+
+        int j = 0;
+        while (j < count && strcmp(nets[j].ssid, ssid.c_str()) != 0) j++;
+        if (j < count) {
+            if (rssi > nets[j].rssi) {
+                nets[j].rssi = rssi;
+                nets[j].auth = WiFi.encryptionType(i);
+            }
+            continue;
+        }
+
+        // Места нет - вытесняем самую слабую, если новая сильнее
+        if (count == WIFI_SCAN_MAX_NETWORKS) {
+            int weakest = 0;
+            for (int k = 1; k < count; k++) {
+                if (nets[k].rssi < nets[weakest].rssi) weakest = k;
+            }
+            if (rssi <= nets[weakest].rssi) continue;
+            j = weakest;
+        } else {
+            j = count++;
+        }
+        strlcpy(nets[j].ssid, ssid.c_str(), sizeof(nets[j].ssid));
+        nets[j].rssi = rssi;
+        nets[j].auth = WiFi.encryptionType(i);
+    }
+
+    // Вставками: сетей не больше WIFI_SCAN_MAX_NETWORKS
+    for (int i = 1; i < count; i++) {
+        ScanNetwork net = nets[i];
+        int j = i - 1;
+        while (j >= 0 && nets[j].rssi < net.rssi) {
+            nets[j + 1] = nets[j];
+            j--;
+        }
+        nets[j + 1] = net;
+    }
+    return count;
+}
+
+static size_t serialize_networks(char* buf, size_t size, const ScanNetwork* nets, int count) {
+    // Не поместилось (длинные SSID с экранированием) - отбрасываем самые слабые
+    for (; count >= 0; count--) {
+        WindowPrint out((uint8_t*)buf, size);
+        JsonWriter json(out);
+        json.beginArray();
+        for (int i = 0; i < count; i++) {
+            json.beginObject()
+                .field("ssid", nets[i].ssid)
+                .field("rssi", (int)nets[i].rssi)
+                .field("encryption", auth_name(nets[i].auth))
+                .endObject();
+        }
+        json.endArray();
+        if (out.complete()) return out.total();
+    }
+    return 0;
+}
+
+static void publish_scan(int found) {
+    ScanNetwork nets[WIFI_SCAN_MAX_NETWORKS];
+    int count = collect_networks(found, nets);
+    WiFi.scanDelete();
+
+    int8_t next = (publishedScan.load() == 0) ? 1 : 0;
+    ScanSnapshot& snap = scanSnapshots[next];
+    snap.length = serialize_networks(snap.json, sizeof(snap.json), nets, count);
+    snap.scannedAt = millis();
+    publishedScan.store(next);
+
+    log_message(formatString("📶 Скан WiFi: %d точек, %d сетей (%u байт JSON)",
+                             found, count, (unsigned)snap.length));
+}
+
+void loop_wifi_scan() {
+    unsigned long now = millis();
+
+    if (scanRunning.load()) {
+        int found = WiFi.scanComplete();
+        if (found == WIFI_SCAN_RUNNING) return;
+        scanRunning.store(false);
+        if (found >= 0) {
+            publish_scan(found);
+        } else {
+            log_message("⚠️ Скан WiFi не удался");
+        }
+        return;
+    }
+
+    // Фоновое обновление только для подключенных к точке доступа: скан переключает
+    // каналы, и без клиентов незачем мешать радиомодулю
+    bool periodic = WiFi.softAPgetStationNum() > 0 && now - lastScanStart >= WIFI_SCAN_INTERVAL;
+    if (!scanRequested.load() && !periodic) return;
+
+    scanRequested.store(false);
+    if (WiFi.scanNetworks(true) == WIFI_SCAN_FAILED) {
+        log_message("⚠️ Не удалось запустить скан WiFi");
+        lastScanStart = now;  // Повтор не раньше следующего интервала
+        return;
+    }
+    lastScanStart = now;
+    scanRunning.store(true);
+}
+
+bool wifi_scan_request() {
+    if (scanRunning.load() || scanRequested.load()) return false;
+    int8_t published = publishedScan.load();
+    if (published >= 0 && millis() - scanSnapshots[published].scannedAt < WIFI_SCAN_MIN_AGE) {
+        return false;
+    }
+    scanRequested.store(true);
+    return true;
+}
+
+bool wifi_scan_ready() {
+    return publishedScan.load() >= 0;
+}
+
+bool wifi_scan_write(Print& out) {
+    int8_t published = publishedScan.load();
+    if (published < 0) return false;
+    const ScanSnapshot& snap = scanSnapshots[published];
+
+    bool scanning = scanRunning.load() || scanRequested.load();
+    out.printf("{\"age\":%lu,\"scanning\":%s,\"networks\":",
+               (millis() - snap.scannedAt) / 1000, scanning ? "true" : "false");
+    out.write((const uint8_t*)snap.json, snap.length);
+    out.print('}');
+    return true;
+}
@@ -0,0 +1,19 @@
+#ifndef WIFI_SCAN_H
+#define WIFI_SCAN_H
+
+#include <Arduino.h>
+
+// === КЭШ СКАНА СЕТЕЙ (режим AP) ===
+// Скан идет в фоне из main loop: сразу после запуска точки доступа и затем раз в
+// WIFI_SCAN_INTERVAL, пока к ней кто-то подключен. Сети с одинаковым SSID сливаются
+// (остается сильнейший сигнал), список сериализуется в JSON один раз после скана.
+// /api/scan-results отдает готовые байты и возраст скана, не трогая драйвер WiFi.
+
+void loop_wifi_scan();      // Из main loop в режиме AP
+bool wifi_scan_request();   // Из веб-сервера: true - скан запланирован, false - кэш свежий или скан уже идет
+bool wifi_scan_ready();     // Есть хотя бы один завершенный скан
+
+// {"age":<с>,"scanning":<bool>,"networks":[...]}; false - ни одного скана еще не было
+bool wifi_scan_write(Print& out);
+
+#endif // WIFI_SCAN_H
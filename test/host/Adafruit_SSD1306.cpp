@@ -0,0 +1,336 @@
+#include "Adafruit_SSD1306.h"
+#include "host_env.h"
+
+// Как в библиотеке: максимум байт в одной I2C транзакции (с control byte)
+#define WIRE_MAX (min(256, I2C_BUFFER_LENGTH) - 1)
+
+// Шина одна - один дисплей на ней
+static Adafruit_SSD1306* panelOwner = nullptr;
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi, int8_t rst_pin,
+                                   uint32_t clkDuring, uint32_t clkAfter)
+    : Adafruit_GFX(w, h), wire(twi ? twi : &Wire), rstPin(rst_pin),
+      wireClk(clkDuring), restoreClk(clkAfter) {
+    memset(panelRam, 0, sizeof(panelRam));
+}
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, SPIClass* spi, int8_t dc_pin, int8_t rst_pin,
+                                   int8_t cs_pin, uint32_t bitrate)
+    : Adafruit_GFX(w, h), spi(spi ? spi : &SPI), spiSettings(bitrate, MSBFIRST, SPI_MODE0),
+      dcPin(dc_pin), csPin(cs_pin), rstPin(rst_pin), wireClk(0), restoreClk(0) {
+    memset(panelRam, 0, sizeof(panelRam));
+}
+
+Adafruit_SSD1306::~Adafruit_SSD1306() {
+    if (panelOwner == this) panelOwner = nullptr;
+    free(buffer);
+}
+
+// === ТРАНЗАКЦИИ (как TRANSACTION_START/END в библиотеке) ===
+void Adafruit_SSD1306::transaction_start() {
+    if (wire) {
+        wire->setClock(wireClk);
+    } else {
+        spi->beginTransaction(spiSettings);
+        digitalWrite(csPin, LOW);
+    }
+}
+
+void Adafruit_SSD1306::transaction_end() {
+    if (wire) {
+        wire->setClock(restoreClk);
+    } else {
+        digitalWrite(csPin, HIGH);
+        spi->endTransaction();
+    }
+}
+
+void Adafruit_SSD1306::ssd1306_command1(uint8_t c) {
+    if (wire) {
+        wire->beginTransmission(i2caddr);
+        wire->write((uint8_t)0x00);  // Co=0, D/C=0: далее команды
+        wire->write(c);
+        wire->endTransmission();
+    } else {
+        digitalWrite(dcPin, LOW);
+        spi->transfer(c);
+    }
+}
+
+void Adafruit_SSD1306::ssd1306_commandList(const uint8_t* c, uint8_t n) {
+    if (wire) {
+        wire->beginTransmission(i2caddr);
+        wire->write((uint8_t)0x00);
+        uint16_t bytesOut = 1;
+        while (n--) {
+            if (bytesOut >= WIRE_MAX) {
+                wire->endTransmission();
+                wire->beginTransmission(i2caddr);
+                wire->write((uint8_t)0x00);
+                bytesOut = 1;
+            }
+            wire->write(*c++);
+            bytesOut++;
+        }
+        wire->endTransmission();
+    } else {
+        digitalWrite(dcPin, LOW);
+        while (n--) spi->transfer(*c++);
+    }
+}
+
+void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
+    transaction_start();
+    ssd1306_command1(c);
+    transaction_end();
+}
+
+bool Adafruit_SSD1306::begin(uint8_t vcs, uint8_t addr, bool reset, bool periphBegin) {
+    if (!buffer && !(buffer = (uint8_t*)malloc(WIDTH * ((HEIGHT + 7) / 8)))) return false;
+    clearDisplay();
+    vccstate = vcs;
+    panelOwner = this;
+
+    if (wire) {
+        i2caddr = addr ? addr : ((HEIGHT == 32) ? 0x3C : 0x3D);
+        if (periphBegin) wire->begin();
+        wire->hostSetSink(on_wire);
+    } else {
+        pinMode(dcPin, OUTPUT);
+        pinMode(csPin, OUTPUT);
+        digitalWrite(csPin, HIGH);
+        if (periphBegin) spi->begin();
+        spi->hostSetSink(on_spi);
+    }
+    if (reset && rstPin >= 0) {
+        // Аппаратный сброс очищает состояние контроллера, но не GDDRAM
+        panelOn = false;
+        panelArgsNeeded = 0;
+    }
+
+    transaction_start();
+    static const uint8_t init1[] = {SSD1306_DISPLAYOFF, SSD1306_SETDISPLAYCLOCKDIV, 0x80, SSD1306_SETMULTIPLEX};
+    ssd1306_commandList(init1, sizeof(init1));
+    ssd1306_command1(HEIGHT - 1);
+
+    static const uint8_t init2[] = {SSD1306_SETDISPLAYOFFSET, 0x0, SSD1306_SETSTARTLINE | 0x0, SSD1306_CHARGEPUMP};
+    ssd1306_commandList(init2, sizeof(init2));
+    ssd1306_command1((vccstate == SSD1306_EXTERNALVCC) ? 0x10 : 0x14);
+
+    static const uint8_t init3[] = {SSD1306_MEMORYMODE, 0x00, SSD1306_SEGREMAP | 0x1, SSD1306_COMSCANDEC};
+    ssd1306_commandList(init3, sizeof(init3));
+
+    uint8_t comPins = 0x02;
+    contrast = 0x8F;
+    if ((WIDTH == 128) && (HEIGHT == 64)) {
+        comPins = 0x12;
+        contrast = (vccstate == SSD1306_EXTERNALVCC) ? 0x9F : 0xCF;
+    } else if ((WIDTH == 96) && (HEIGHT == 16)) {
+        comPins = 0x2;
+        contrast = (vccstate == SSD1306_EXTERNALVCC) ? 0x10 : 0xAF;
+    }
+    ssd1306_command1(SSD1306_SETCOMPINS);
+    ssd1306_command1(comPins);
+    ssd1306_command1(SSD1306_SETCONTRAST);
+    ssd1306_command1(contrast);
+    ssd1306_command1(SSD1306_SETPRECHARGE);
+    ssd1306_command1((vccstate == SSD1306_EXTERNALVCC) ? 0x22 : 0xF1);
+
+    static const uint8_t init5[] = {SSD1306_SETVCOMDETECT, 0x40, SSD1306_DISPLAYALLON_RESUME,
+                                    SSD1306_NORMALDISPLAY, SSD1306_DEACTIVATE_SCROLL, SSD1306_DISPLAYON};
+    ssd1306_commandList(init5, sizeof(init5));
+    transaction_end();
+    return true;
+}
+
+void Adafruit_SSD1306::display() {
+    transaction_start();
+    static const uint8_t dlist1[] = {SSD1306_PAGEADDR, 0, 0xFF, SSD1306_COLUMNADDR, 0};
+    ssd1306_commandList(dlist1, sizeof(dlist1));
+    ssd1306_command1(WIDTH - 1);
+
+    uint16_t count = WIDTH * ((HEIGHT + 7) / 8);
+    uint8_t* ptr = buffer;
+    if (wire) {
+        wire->beginTransmission(i2caddr);
+        wire->write((uint8_t)0x40);
+        uint16_t bytesOut = 1;
+        while (count--) {
+            if (bytesOut >= WIRE_MAX) {
+                wire->endTransmission();
+                wire->beginTransmission(i2caddr);
+                wire->write((uint8_t)0x40);
+                bytesOut = 1;
+            }
+            wire->write(*ptr++);
+            bytesOut++;
+        }
+        wire->endTransmission();
+    } else {
+        digitalWrite(dcPin, HIGH);
+        while (count--) spi->transfer(*ptr++);
+    }
+    transaction_end();
+}
+
+void Adafruit_SSD1306::clearDisplay() {
+    memset(buffer, 0, WIDTH * ((HEIGHT + 7) / 8));
+}
+
+void Adafruit_SSD1306::invertDisplay(bool i) {
+    ssd1306_command(i ? SSD1306_INVERTDISPLAY : SSD1306_NORMALDISPLAY);
+}
+
+void Adafruit_SSD1306::dim(bool dim) {
+    transaction_start();
+    ssd1306_command1(SSD1306_SETCONTRAST);
+    ssd1306_command1(dim ? 0 : contrast);
+    transaction_end();
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if ((x >= 0) && (x < width()) && (y >= 0) && (y < height())) {
+        int16_t t;
+        switch (getRotation()) {
+            case 1:
+                t = x; x = y; y = t;
+                x = WIDTH - x - 1;
+                break;
+            case 2:
+                x = WIDTH - x - 1;
+                y = HEIGHT - y - 1;
+                break;
+            case 3:
+                t = x; x = y; y = t;
+                y = HEIGHT - y - 1;
+                break;
+        }
+        switch (color) {
+            case SSD1306_WHITE:   buffer[x + (y / 8) * WIDTH] |= (1 << (y & 7)); break;
+            case SSD1306_BLACK:   buffer[x + (y / 8) * WIDTH] &= ~(1 << (y & 7)); break;
+            case SSD1306_INVERSE: buffer[x + (y / 8) * WIDTH] ^= (1 << (y & 7)); break;
+        }
+    }
+}
+
+// Результат тот же, что у построчных версий библиотеки (отсечение по каждому пикселю)
+void Adafruit_SSD1306::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    for (int16_t i = 0; i < w; i++) drawPixel(x + i, y, color);
+}
+
+void Adafruit_SSD1306::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    for (int16_t i = 0; i < h; i++) drawPixel(x, y + i, color);
+}
+
+bool Adafruit_SSD1306::getPixel(int16_t x, int16_t y) {
+    if ((x >= 0) && (x < width()) && (y >= 0) && (y < height())) {
+        int16_t t;
+        switch (getRotation()) {
+            case 1:
+                t = x; x = y; y = t;
+                x = WIDTH - x - 1;
+                break;
+            case 2:
+                x = WIDTH - x - 1;
+                y = HEIGHT - y - 1;
+                break;
+            case 3:
+                t = x; x = y; y = t;
+                y = HEIGHT - y - 1;
+                break;
+        }
+        return (buffer[x + (y / 8) * WIDTH] & (1 << (y & 7)));
+    }
+    return false;
+}
+
+// === МОДЕЛЬ КОНТРОЛЛЕРА ===
+bool Adafruit_SSD1306::hostPanelMatchesBuffer() const {
+    return buffer && memcmp(panelRam, buffer, WIDTH * ((HEIGHT + 7) / 8)) == 0;
+}
+
+void Adafruit_SSD1306::on_wire(uint8_t address, const uint8_t* data, size_t len) {
+    Adafruit_SSD1306* self = panelOwner;
+    if (!self || !self->wire || address != self->i2caddr || len == 0) return;
+    // Co=0: после control byte весь остаток транзакции - команды (0x00) или данные (0x40)
+    uint8_t control = data[0];
+    if (control != 0x00 && control != 0x40) {
+        self->hostProtocolErrors++;
+        return;
+    }
+    for (size_t i = 1; i < len; i++) self->panel_byte(control == 0x40, data[i]);
+}
+
+void Adafruit_SSD1306::on_spi(const uint8_t* data, size_t len) {
+    Adafruit_SSD1306* self = panelOwner;
+    if (!self || !self->spi) return;
+    if (host_pin_level(self->csPin) != LOW) {
+        self->hostProtocolErrors++;
+        return;
+    }
+    bool isData = host_pin_level(self->dcPin) == HIGH;
+    for (size_t i = 0; i < len; i++) self->panel_byte(isData, data[i]);
+}
+
+// Число аргументов команды SSD1306
+static uint8_t command_args(uint8_t c) {
+    switch (c) {
+        case SSD1306_COLUMNADDR:
+        case SSD1306_PAGEADDR:
+        case SSD1306_SET_VERTICAL_SCROLL_AREA:
+            return 2;
+        case SSD1306_RIGHT_HORIZONTAL_SCROLL:
+        case SSD1306_LEFT_HORIZONTAL_SCROLL:
+            return 6;
+        case SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL:
+        case SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL:
+            return 5;
+        case SSD1306_MEMORYMODE:
+        case SSD1306_SETCONTRAST:
+        case SSD1306_CHARGEPUMP:
+        case SSD1306_SETMULTIPLEX:
+        case SSD1306_SETDISPLAYOFFSET:
+        case SSD1306_SETDISPLAYCLOCKDIV:
+        case SSD1306_SETPRECHARGE:
+        case SSD1306_SETCOMPINS:
+        case SSD1306_SETVCOMDETECT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+void Adafruit_SSD1306::panel_byte(bool isData, uint8_t b) {
+    if (isData) {
+        // Горизонтальная адресация: столбец, затем страница, по кругу внутри окна
+        panelRam[page * 128 + column] = b;
+        if (column >= columnEnd) {
+            column = columnStart;
+            page = page >= pageEnd ? pageStart : page + 1;
+        } else {
+            column++;
+        }
+        return;
+    }
+
+    if (panelArgsNeeded > 0) {
+        panelArgs[panelArgCount++] = b;
+        if (--panelArgsNeeded > 0) return;
+        if (panelCommand == SSD1306_COLUMNADDR) {
+            columnStart = column = panelArgs[0] & 0x7F;
+            columnEnd = panelArgs[1] & 0x7F;
+        } else if (panelCommand == SSD1306_PAGEADDR) {
+            pageStart = page = panelArgs[0] & 0x07;
+            pageEnd = panelArgs[1] & 0x07;
+        } else if (panelCommand == SSD1306_MEMORYMODE && panelArgs[0] != 0x00) {
+            hostProtocolErrors++;  // Модель знает только горизонтальную адресацию
+        }
+        return;
+    }
+
+    if (b == SSD1306_DISPLAYON) panelOn = true;
+    if (b == SSD1306_DISPLAYOFF) panelOn = false;
+    panelCommand = b;
+    panelArgCount = 0;
+    panelArgsNeeded = command_args(b);
+}
@@ -0,0 +1,123 @@
+#ifndef HOST_ADAFRUIT_SSD1306_H
+#define HOST_ADAFRUIT_SSD1306_H
+
+// === ADAFRUIT SSD1306 НА ПК ===
+// Буфер 1bpp и drawPixel/повороты как в Adafruit_SSD1306 2.5. display(),
+// ssd1306_command() и begin() шлют по Wire/SPI те же транзакции, что и
+// библиотека (список команд, control byte 0x40 на каждые 126 байт данных,
+// смена частоты I2C на время транзакции), поэтому счетчики шины в Wire/SPI -
+// реальные байты устройства. На другом конце шины - модель контроллера:
+// разбирает команды (PAGEADDR/COLUMNADDR, горизонтальная адресация) и пишет
+// данные в свою GDDRAM. Тест сравнивает ее с буфером: так проверяется и то,
+// что частичные flush (бегущая строка) попадают в нужные столбцы.
+// Заставка Adafruit в begin() не рисуется - буфер просто очищается.
+
+#include <Adafruit_GFX.h>
+#include <Wire.h>
+#include <SPI.h>
+
+#define SSD1306_BLACK   0
+#define SSD1306_WHITE   1
+#define SSD1306_INVERSE 2
+
+#define BLACK   SSD1306_BLACK
+#define WHITE   SSD1306_WHITE
+#define INVERSE SSD1306_INVERSE
+
+#define SSD1306_MEMORYMODE          0x20
+#define SSD1306_COLUMNADDR          0x21
+#define SSD1306_PAGEADDR            0x22
+#define SSD1306_SETCONTRAST         0x81
+#define SSD1306_CHARGEPUMP          0x8D
+#define SSD1306_SEGREMAP            0xA0
+#define SSD1306_DISPLAYALLON_RESUME 0xA4
+#define SSD1306_DISPLAYALLON        0xA5
+#define SSD1306_NORMALDISPLAY       0xA6
+#define SSD1306_INVERTDISPLAY       0xA7
+#define SSD1306_SETMULTIPLEX        0xA8
+#define SSD1306_DISPLAYOFF          0xAE
+#define SSD1306_DISPLAYON           0xAF
+#define SSD1306_COMSCANINC          0xC0
+#define SSD1306_COMSCANDEC          0xC8
+#define SSD1306_SETDISPLAYOFFSET    0xD3
+#define SSD1306_SETDISPLAYCLOCKDIV  0xD5
+#define SSD1306_SETPRECHARGE        0xD9
+#define SSD1306_SETCOMPINS          0xDA
+#define SSD1306_SETVCOMDETECT       0xDB
+#define SSD1306_SETLOWCOLUMN        0x00
+#define SSD1306_SETHIGHCOLUMN       0x10
+#define SSD1306_SETSTARTLINE        0x40
+#define SSD1306_EXTERNALVCC         0x01
+#define SSD1306_SWITCHCAPVCC        0x02
+#define SSD1306_RIGHT_HORIZONTAL_SCROLL              0x26
+#define SSD1306_LEFT_HORIZONTAL_SCROLL               0x27
+#define SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL 0x29
+#define SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL  0x2A
+#define SSD1306_DEACTIVATE_SCROLL                    0x2E
+#define SSD1306_ACTIVATE_SCROLL                      0x2F
+#define SSD1306_SET_VERTICAL_SCROLL_AREA             0xA3
+
+#define SSD1306_PANEL_PAGES 8  // GDDRAM контроллера: 128 x 64 независимо от панели
+
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi = &Wire, int8_t rst_pin = -1,
+                     uint32_t clkDuring = 400000UL, uint32_t clkAfter = 100000UL);
+    Adafruit_SSD1306(uint8_t w, uint8_t h, SPIClass* spi, int8_t dc_pin, int8_t rst_pin, int8_t cs_pin,
+                     uint32_t bitrate = 8000000UL);
+    ~Adafruit_SSD1306();
+
+    bool begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t i2caddr = 0, bool reset = true,
+               bool periphBegin = true);
+    void display();
+    void clearDisplay();
+    void invertDisplay(bool i);
+    void dim(bool dim);
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void ssd1306_command(uint8_t c);
+    bool getPixel(int16_t x, int16_t y);
+    uint8_t* getBuffer() { return buffer; }
+
+    // --- Только на ПК: модель контроллера на другом конце шины ---
+    const uint8_t* hostPanelRam() const { return panelRam; }
+    bool hostPanelOn() const { return panelOn; }
+    bool hostPanelMatchesBuffer() const;     // Видимые страницы GDDRAM == буфер
+    unsigned long hostProtocolErrors = 0;    // Неизвестный control byte, данные без CS и т.п.
+
+private:
+    void ssd1306_command1(uint8_t c);
+    void ssd1306_commandList(const uint8_t* c, uint8_t n);
+    void transaction_start();
+    void transaction_end();
+
+    static void on_wire(uint8_t address, const uint8_t* data, size_t len);
+    static void on_spi(const uint8_t* data, size_t len);
+    void panel_byte(bool isData, uint8_t b);
+
+    uint8_t* buffer = nullptr;
+    TwoWire* wire = nullptr;
+    SPIClass* spi = nullptr;
+    SPISettings spiSettings;
+    int8_t dcPin = -1;
+    int8_t csPin = -1;
+    int8_t rstPin = -1;
+    uint8_t i2caddr = 0;
+    uint8_t vccstate = SSD1306_SWITCHCAPVCC;
+    uint8_t contrast = 0x8F;
+    uint32_t wireClk;
+    uint32_t restoreClk;
+
+    // Модель контроллера
+    uint8_t panelRam[SSD1306_PANEL_PAGES * 128];
+    bool panelOn = false;
+    uint8_t panelCommand = 0;      // Команда, ждущая аргументов
+    uint8_t panelArgs[6];
+    uint8_t panelArgCount = 0;
+    uint8_t panelArgsNeeded = 0;
+    uint8_t columnStart = 0, columnEnd = 127, column = 0;
+    uint8_t pageStart = 0, pageEnd = 7, page = 0;
+};
+
+#endif // HOST_ADAFRUIT_SSD1306_H
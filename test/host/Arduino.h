@@ -0,0 +1,219 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// === ARDUINO ДЛЯ СБОРКИ НА ПК (тесты в test/) ===
+// Только то, что используют исходники src/, и с тем же поведением, что у ядра
+// arduino-esp32: String, Print, Serial, millis()/micros(), random(), ESP.
+// Время виртуальное (host_env.h): двигается только delay() и явными шагами теста,
+// поэтому замеры micros() в прошивке детерминированы и не зависят от скорости ПК.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include "freertos/FreeRTOS.h"  // Как в ядре: Arduino.h тянет FreeRTOS
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define IRAM_ATTR
+#define PROGMEM
+#define HIGH 0x1
+#define LOW  0x0
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+#define MSBFIRST 1
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+
+// Как в arduino-esp32 2.x: min/max/abs из std (типы аргументов должны совпадать)
+using std::abs;
+using std::max;
+using std::min;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#if !defined(__GLIBC__) || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+uint32_t esp_random();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// Прерывание по пину: на ПК обработчик вызывает host_pin_set при смене уровня
+#define digitalPinToInterrupt(pin) (pin)
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+// === STRING ===
+class String {
+public:
+    String() {}
+    String(const char* text) : _s(text ? text : "") {}
+    String(const std::string& text) : _s(text) {}
+    String(const String& other) = default;
+    String(String&& other) = default;
+    explicit String(char c) : _s(1, c) {}
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimals = 2);
+    explicit String(double value, unsigned int decimals = 2);
+
+    String& operator=(const String& other) = default;
+    String& operator=(String&& other) = default;
+    String& operator=(const char* text) { _s = text ? text : ""; return *this; }
+
+    bool reserve(unsigned int size) { _s.reserve(size); return true; }
+    unsigned int length() const { return _s.length(); }
+    bool isEmpty() const { return _s.empty(); }
+    const char* c_str() const { return _s.c_str(); }
+    const std::string& str() const { return _s; }
+
+    String& operator+=(const String& other) { _s += other._s; return *this; }
+    String& operator+=(const char* text) { if (text) _s += text; return *this; }
+    String& operator+=(char c) { _s += c; return *this; }
+    String& operator+=(int value) { return *this += String(value); }
+    String& operator+=(unsigned int value) { return *this += String(value); }
+    String& operator+=(long value) { return *this += String(value); }
+    String& operator+=(unsigned long value) { return *this += String(value); }
+    bool concat(const String& other) { _s += other._s; return true; }
+
+    bool equals(const String& other) const { return _s == other._s; }
+    bool equals(const char* text) const { return text && _s == text; }
+    bool equalsIgnoreCase(const String& other) const;
+    bool startsWith(const String& prefix) const { return _s.compare(0, prefix._s.size(), prefix._s) == 0; }
+    bool endsWith(const String& suffix) const;
+    int compareTo(const String& other) const { return _s.compare(other._s); }
+
+    char charAt(unsigned int index) const { return index < _s.size() ? _s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& text, unsigned int from = 0) const;
+    String substring(unsigned int from) const { return substring(from, _s.size()); }
+    String substring(unsigned int from, unsigned int to) const;
+    void remove(unsigned int index) { if (index < _s.size()) _s.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < _s.size()) _s.erase(index, count); }
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(_s.c_str(), nullptr); }
+
+    bool operator==(const String& other) const { return _s == other._s; }
+    bool operator==(const char* text) const { return equals(text); }
+    bool operator!=(const String& other) const { return _s != other._s; }
+    bool operator!=(const char* text) const { return !equals(text); }
+    bool operator<(const String& other) const { return _s < other._s; }
+
+private:
+    std::string _s;
+};
+
+String operator+(const String& a, const String& b);
+String operator+(const String& a, const char* b);
+String operator+(const char* a, const String& b);
+String operator+(const String& a, char b);
+
+// === PRINT ===
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+    size_t print(const char* text) { return write(text); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = 10) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = 10) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = 10) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = 10);
+    size_t print(unsigned long value, int base = 10);
+    size_t print(long long value, int base = 10) { return print((long)value, base); }
+    size_t print(unsigned long long value, int base = 10) { return print((unsigned long)value, base); }
+    size_t print(double value, int digits = 2);
+
+    size_t println() { return print("\r\n"); }
+    template <typename T>
+    size_t println(const T& value) { size_t n = print(value); return n + println(); }
+};
+
+// === STREAM ===
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+
+    size_t readBytes(uint8_t* buffer, size_t length) {
+        size_t n = 0;
+        while (n < length && available() > 0) buffer[n++] = (uint8_t)read();
+        return n;
+    }
+    size_t readBytes(char* buffer, size_t length) { return readBytes((uint8_t*)buffer, length); }
+    String readString() {
+        std::string s;
+        while (available() > 0) s += (char)read();
+        return String(s);
+    }
+};
+
+// === SERIAL ===
+// Вывод копится в host_serial_output() и печатается в stdout при HOST_SERIAL=1
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long baud) {}
+    void flush() {}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+// === ESP ===
+// Heap - модель (host_env.h): из размера heap устройства вычитаются живые выделения,
+// сделанные кодом прошивки (операторы new в контексте устройства)
+class EspClass {
+public:
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+    uint32_t getHeapSize();
+    void restart();
+};
+
+extern EspClass ESP;
+
+#endif // HOST_ARDUINO_H
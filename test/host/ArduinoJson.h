@@ -0,0 +1,606 @@
+#ifndef HOST_ARDUINOJSON_H
+#define HOST_ARDUINOJSON_H
+
+// === ARDUINOJSON 7 (ПОДМНОЖЕСТВО) НА ПК ===
+// Только то, что вызывает src/ (и AsyncJson.h): JsonDocument, чтение через
+// operator[] и "|", as<T>/is<T>/to<T> для нужных типов, запись присваиванием,
+// обход JsonArray, serializeJson в Print и deserializeJson из Stream или буфера.
+// Новый вызов в прошивке - сюда же, иначе тест не соберется.
+// Узлы дерева выделяются через new - на ПК они попадают в модель heap так же,
+// как пул JsonDocument на устройстве.
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define ARDUINOJSON_DEFAULT_NESTING_LIMIT 10
+
+namespace host_json {
+
+struct Node {
+    enum Type { Null, Bool, Int, Float, Text, Array, Object };
+    Type type = Null;
+    bool boolean = false;
+    long long integer = 0;
+    double real = 0;
+    std::string text;
+    std::vector<std::unique_ptr<Node>> items;
+    std::vector<std::pair<std::string, std::unique_ptr<Node>>> members;
+
+    void reset(Type t) {
+        type = t;
+        text.clear();
+        items.clear();
+        members.clear();
+    }
+    Node* member(const char* key) const {
+        if (type != Object) return nullptr;
+        for (const auto& m : members) {
+            if (m.first == key) return m.second.get();
+        }
+        return nullptr;
+    }
+    bool isNumber() const { return type == Int || type == Float; }
+    double number() const { return type == Int ? (double)integer : real; }
+};
+
+}  // namespace host_json
+
+class JsonObject;
+class JsonArray;
+
+// Ссылка на значение. Несуществующий ключ помнит родителя и имя:
+// присваивание создает член объекта, как MemberProxy в ArduinoJson
+class JsonVariant {
+public:
+    JsonVariant() {}
+    explicit JsonVariant(host_json::Node* node) : _node(node) {}
+    JsonVariant(host_json::Node* parent, const char* key) : _parent(parent), _key(key) {}
+
+    JsonVariant operator[](const char* key) const {
+        if (_node) {
+            host_json::Node* child = _node->member(key);
+            if (child) return JsonVariant(child);
+            if (_node->type == host_json::Node::Object || _node->type == host_json::Node::Null) {
+                return JsonVariant(_node, key);
+            }
+            return JsonVariant();
+        }
+        return JsonVariant();
+    }
+
+    template <typename T>
+    T as() const;
+
+    template <typename T>
+    bool is() const;
+
+    template <typename T>
+    T to();
+
+    // Неявное чтение строки: const char* type = op["op"]
+    operator const char*() const;
+    operator JsonObject() const;
+
+    JsonVariant& operator=(const JsonVariant& other) = default;
+    JsonVariant& operator=(const char* value) {
+        host_json::Node* n = resolve();
+        if (n) {
+            n->reset(value ? host_json::Node::Text : host_json::Node::Null);
+            if (value) n->text = value;
+        }
+        return *this;
+    }
+    JsonVariant& operator=(const String& value) { return *this = value.c_str(); }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    JsonVariant& operator=(T value) {
+        host_json::Node* n = resolve();
+        if (n) {
+            n->reset(host_json::Node::Int);
+            n->integer = (long long)value;
+        }
+        return *this;
+    }
+    template <typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+    JsonVariant& operator=(T value) {
+        host_json::Node* n = resolve();
+        if (n) {
+            n->reset(host_json::Node::Float);
+            n->real = value;
+        }
+        return *this;
+    }
+
+    host_json::Node* node() const { return _node; }
+
+    // Создает узел для несуществующего ключа
+    host_json::Node* resolve() {
+        if (_node) return _node;
+        if (!_parent) return nullptr;
+        if (_parent->type == host_json::Node::Null) _parent->reset(host_json::Node::Object);
+        if (_parent->type != host_json::Node::Object) return nullptr;
+        _parent->members.emplace_back(_key, std::unique_ptr<host_json::Node>(new host_json::Node()));
+        _node = _parent->members.back().second.get();
+        _parent = nullptr;
+        return _node;
+    }
+
+private:
+    host_json::Node* _node = nullptr;
+    host_json::Node* _parent = nullptr;
+    std::string _key;
+};
+
+typedef JsonVariant JsonVariantConst;
+
+class JsonObject {
+public:
+    JsonObject() {}
+    explicit JsonObject(host_json::Node* node) : _node(node) {}
+
+    JsonVariant operator[](const char* key) const {
+        if (!_node || _node->type != host_json::Node::Object) return JsonVariant();
+        host_json::Node* child = _node->member(key);
+        return child ? JsonVariant(child) : JsonVariant(_node, key);
+    }
+
+private:
+    host_json::Node* _node = nullptr;
+};
+
+class JsonArray {
+public:
+    class iterator {
+    public:
+        iterator(host_json::Node* node, size_t index) : _node(node), _index(index) {}
+        JsonVariant operator*() const { return JsonVariant(_node->items[_index].get()); }
+        iterator& operator++() {
+            _index++;
+            return *this;
+        }
+        bool operator!=(const iterator& other) const { return _node != other._node || _index != other._index; }
+
+    private:
+        host_json::Node* _node;
+        size_t _index;
+    };
+
+    JsonArray() {}
+    explicit JsonArray(host_json::Node* node) : _node(node) {}
+
+    bool isNull() const { return !_node || _node->type != host_json::Node::Array; }
+    size_t size() const { return isNull() ? 0 : _node->items.size(); }
+    iterator begin() const { return iterator(_node, 0); }
+    iterator end() const { return iterator(_node, size()); }
+
+    template <typename T>
+    T add();
+
+    template <typename T>
+    bool add(const T& value) {
+        if (isNull()) return false;
+        _node->items.emplace_back(new host_json::Node());
+        JsonVariant(_node->items.back().get()) = value;
+        return true;
+    }
+
+private:
+    host_json::Node* _node = nullptr;
+};
+
+typedef JsonArray JsonArrayConst;
+
+template <>
+inline JsonObject JsonArray::add<JsonObject>() {
+    if (isNull()) return JsonObject();
+    _node->items.emplace_back(new host_json::Node());
+    _node->items.back()->reset(host_json::Node::Object);
+    return JsonObject(_node->items.back().get());
+}
+
+// --- as<T> ---
+template <>
+inline const char* JsonVariant::as<const char*>() const {
+    return _node && _node->type == host_json::Node::Text ? _node->text.c_str() : nullptr;
+}
+template <>
+inline String JsonVariant::as<String>() const {
+    if (!_node) return String("null");
+    switch (_node->type) {
+        case host_json::Node::Text:  return String(_node->text.c_str());
+        case host_json::Node::Null:  return String("null");
+        case host_json::Node::Bool:  return String(_node->boolean ? "true" : "false");
+        case host_json::Node::Int:   return String((long)_node->integer);
+        case host_json::Node::Float: return String(_node->real, 6);
+        default:                     return String();
+    }
+}
+template <>
+inline JsonObject JsonVariant::as<JsonObject>() const {
+    return _node && _node->type == host_json::Node::Object ? JsonObject(_node) : JsonObject();
+}
+template <>
+inline JsonArray JsonVariant::as<JsonArray>() const {
+    return _node && _node->type == host_json::Node::Array ? JsonArray(_node) : JsonArray();
+}
+template <>
+inline JsonVariant JsonVariant::as<JsonVariant>() const { return *this; }
+
+inline JsonVariant::operator const char*() const { return as<const char*>(); }
+inline JsonVariant::operator JsonObject() const { return as<JsonObject>(); }
+
+// --- is<T> ---
+template <>
+inline bool JsonVariant::is<const char*>() const { return _node && _node->type == host_json::Node::Text; }
+template <>
+inline bool JsonVariant::is<JsonObject>() const { return _node && _node->type == host_json::Node::Object; }
+
+// --- to<T> ---
+template <>
+inline JsonObject JsonVariant::to<JsonObject>() {
+    host_json::Node* n = resolve();
+    if (!n) return JsonObject();
+    n->reset(host_json::Node::Object);
+    return JsonObject(n);
+}
+template <>
+inline JsonArray JsonVariant::to<JsonArray>() {
+    host_json::Node* n = resolve();
+    if (!n) return JsonArray();
+    n->reset(host_json::Node::Array);
+    return JsonArray(n);
+}
+
+// --- Значение по умолчанию: variant | default ---
+inline const char* operator|(const JsonVariant& v, const char* fallback) {
+    const char* s = v.as<const char*>();
+    return s ? s : fallback;
+}
+template <typename T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value, int>::type = 0>
+inline T operator|(const JsonVariant& v, T fallback) {
+    host_json::Node* n = v.node();
+    if (std::is_same<T, bool>::value) return n && n->type == host_json::Node::Bool ? (T)n->boolean : fallback;
+    if (!n || !n->isNumber()) return fallback;
+    if (std::is_floating_point<T>::value) return (T)n->number();
+    return (T)(n->type == host_json::Node::Int ? n->integer : (long long)n->real);
+}
+
+// === ДОКУМЕНТ ===
+class JsonDocument {
+public:
+    JsonDocument() : _root(new host_json::Node()) {}
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+
+    JsonVariant operator[](const char* key) { return JsonVariant(_root.get())[key]; }
+
+    template <typename T>
+    T as() const { return JsonVariant(_root.get()).as<T>(); }
+    template <typename T>
+    bool is() const { return JsonVariant(_root.get()).is<T>(); }
+    template <typename T>
+    T to() {
+        JsonVariant v(_root.get());
+        return v.to<T>();
+    }
+
+    host_json::Node* root() const { return _root.get(); }
+
+private:
+    std::unique_ptr<host_json::Node> _root;
+};
+
+// === ОШИБКИ РАЗБОРА ===
+class DeserializationError {
+public:
+    enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, TooDeep };
+
+    DeserializationError(Code code = Ok) : _code(code) {}
+    explicit operator bool() const { return _code != Ok; }
+    const char* c_str() const {
+        static const char* const names[] = {"Ok", "EmptyInput", "IncompleteInput", "InvalidInput", "TooDeep"};
+        return names[_code];
+    }
+
+private:
+    Code _code;
+};
+
+// === РАЗБОР И ВЫВОД ===
+namespace host_json {
+
+class Parser {
+public:
+    Parser(const char* data, size_t length) : _p(data), _end(data + length) {}
+
+    DeserializationError parse(Node& root) {
+        skip_space();
+        if (_p >= _end) return DeserializationError::EmptyInput;
+        DeserializationError error = value(root, 0);
+        return error;
+    }
+
+private:
+    const char* _p;
+    const char* _end;
+
+    void skip_space() {
+        while (_p < _end && (*_p == ' ' || *_p == '\n' || *_p == '\r' || *_p == '\t')) _p++;
+    }
+    bool literal(const char* word) {
+        size_t n = strlen(word);
+        if ((size_t)(_end - _p) < n) return false;
+        if (strncmp(_p, word, n) != 0) return false;
+        _p += n;
+        return true;
+    }
+
+    DeserializationError value(Node& out, int depth) {
+        skip_space();
+        if (_p >= _end) return DeserializationError::IncompleteInput;
+        char c = *_p;
+        if (c == '{') return object(out, depth + 1);
+        if (c == '[') return array(out, depth + 1);
+        if (c == '"') {
+            out.reset(Node::Text);
+            return string(out.text);
+        }
+        if (c == 't' || c == 'f' || c == 'n') {
+            size_t left = _end - _p;
+            const char* word = c == 't' ? "true" : c == 'f' ? "false" : "null";
+            if (left < strlen(word) && strncmp(_p, word, left) == 0) return DeserializationError::IncompleteInput;
+            if (!literal(word)) return DeserializationError::InvalidInput;
+            if (c == 'n') {
+                out.reset(Node::Null);
+            } else {
+                out.reset(Node::Bool);
+                out.boolean = c == 't';
+            }
+            return DeserializationError::Ok;
+        }
+        if (c == '-' || (c >= '0' && c <= '9')) return number(out);
+        return DeserializationError::InvalidInput;
+    }
+
+    DeserializationError number(Node& out) {
+        const char* start = _p;
+        bool real = false;
+        if (*_p == '-') _p++;
+        while (_p < _end && ((*_p >= '0' && *_p <= '9') || *_p == '.' || *_p == 'e' || *_p == 'E' ||
+                             *_p == '+' || *_p == '-')) {
+            if (*_p == '.' || *_p == 'e' || *_p == 'E') real = true;
+            _p++;
+        }
+        std::string text(start, _p);
+        if (text == "-") return DeserializationError::InvalidInput;
+        if (real) {
+            out.reset(Node::Float);
+            out.real = strtod(text.c_str(), nullptr);
+        } else {
+            out.reset(Node::Int);
+            out.integer = strtoll(text.c_str(), nullptr, 10);
+        }
+        return DeserializationError::Ok;
+    }
+
+    static void append_utf8(std::string& s, uint32_t cp) {
+        if (cp < 0x80) {
+            s += (char)cp;
+        } else if (cp < 0x800) {
+            s += (char)(0xC0 | (cp >> 6));
+            s += (char)(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            s += (char)(0xE0 | (cp >> 12));
+            s += (char)(0x80 | ((cp >> 6) & 0x3F));
+            s += (char)(0x80 | (cp & 0x3F));
+        } else {
+            s += (char)(0xF0 | (cp >> 18));
+            s += (char)(0x80 | ((cp >> 12) & 0x3F));
+            s += (char)(0x80 | ((cp >> 6) & 0x3F));
+            s += (char)(0x80 | (cp & 0x3F));
+        }
+    }
+
+    DeserializationError string(std::string& out) {
+        _p++;  // "
+        while (_p < _end) {
+            char c = *_p++;
+            if (c == '"') return DeserializationError::Ok;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (_p >= _end) break;
+            char e = *_p++;
+            switch (e) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    if (_end - _p < 4) return DeserializationError::IncompleteInput;
+                    uint32_t cp = (uint32_t)strtoul(std::string(_p, 4).c_str(), nullptr, 16);
+                    _p += 4;
+                    // Суррогатная пара
+                    if (cp >= 0xD800 && cp < 0xDC00 && _end - _p >= 6 && _p[0] == '\\' && _p[1] == 'u') {
+                        uint32_t low = (uint32_t)strtoul(std::string(_p + 2, 4).c_str(), nullptr, 16);
+                        if (low >= 0xDC00 && low < 0xE000) {
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                            _p += 6;
+                        }
+                    }
+                    append_utf8(out, cp);
+                    break;
+                }
+                default:
+                    return DeserializationError::InvalidInput;
+            }
+        }
+        return DeserializationError::IncompleteInput;
+    }
+
+    DeserializationError array(Node& out, int depth) {
+        if (depth > ARDUINOJSON_DEFAULT_NESTING_LIMIT) return DeserializationError::TooDeep;
+        out.reset(Node::Array);
+        _p++;  // [
+        skip_space();
+        if (_p < _end && *_p == ']') {
+            _p++;
+            return DeserializationError::Ok;
+        }
+        while (true) {
+            out.items.emplace_back(new Node());
+            DeserializationError error = value(*out.items.back(), depth);
+            if (error) return error;
+            skip_space();
+            if (_p >= _end) return DeserializationError::IncompleteInput;
+            if (*_p == ',') {
+                _p++;
+                continue;
+            }
+            if (*_p == ']') {
+                _p++;
+                return DeserializationError::Ok;
+            }
+            return DeserializationError::InvalidInput;
+        }
+    }
+
+    DeserializationError object(Node& out, int depth) {
+        if (depth > ARDUINOJSON_DEFAULT_NESTING_LIMIT) return DeserializationError::TooDeep;
+        out.reset(Node::Object);
+        _p++;  // {
+        skip_space();
+        if (_p < _end && *_p == '}') {
+            _p++;
+            return DeserializationError::Ok;
+        }
+        while (true) {
+            skip_space();
+            if (_p >= _end) return DeserializationError::IncompleteInput;
+            if (*_p != '"') return DeserializationError::InvalidInput;
+            std::string key;
+            DeserializationError error = string(key);
+            if (error) return error;
+            skip_space();
+            if (_p >= _end) return DeserializationError::IncompleteInput;
+            if (*_p++ != ':') return DeserializationError::InvalidInput;
+            std::unique_ptr<Node> child(new Node());
+            error = value(*child, depth);
+            if (error) return error;
+            // Повтор ключа: как ArduinoJson, остается последнее значение
+            Node* existing = out.member(key.c_str());
+            if (existing) *existing = std::move(*child);
+            else out.members.emplace_back(key, std::move(child));
+            skip_space();
+            if (_p >= _end) return DeserializationError::IncompleteInput;
+            if (*_p == ',') {
+                _p++;
+                continue;
+            }
+            if (*_p == '}') {
+                _p++;
+                return DeserializationError::Ok;
+            }
+            return DeserializationError::InvalidInput;
+        }
+    }
+};
+
+inline void write_string(Print& out, const std::string& s, size_t& n) {
+    n += out.write('"');
+    for (unsigned char c : s) {
+        const char* escape = nullptr;
+        switch (c) {
+            case '"': escape = "\\\""; break;
+            case '\\': escape = "\\\\"; break;
+            case '\b': escape = "\\b"; break;
+            case '\f': escape = "\\f"; break;
+            case '\n': escape = "\\n"; break;
+            case '\r': escape = "\\r"; break;
+            case '\t': escape = "\\t"; break;
+        }
+        if (escape) {
+            n += out.print(escape);
+        } else if (c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            n += out.print(buf);
+        } else {
+            n += out.write(c);
+        }
+    }
+    n += out.write('"');
+}
+
+inline void write_node(Print& out, const Node& node, size_t& n) {
+    switch (node.type) {
+        case Node::Null: n += out.print("null"); break;
+        case Node::Bool: n += out.print(node.boolean ? "true" : "false"); break;
+        case Node::Int: {
+            char buf[24];
+            snprintf(buf, sizeof(buf), "%lld", node.integer);
+            n += out.print(buf);
+            break;
+        }
+        case Node::Float: {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%.9g", node.real);
+            n += out.print(buf);
+            break;
+        }
+        case Node::Text: write_string(out, node.text, n); break;
+        case Node::Array:
+            n += out.write('[');
+            for (size_t i = 0; i < node.items.size(); i++) {
+                if (i) n += out.write(',');
+                write_node(out, *node.items[i], n);
+            }
+            n += out.write(']');
+            break;
+        case Node::Object:
+            n += out.write('{');
+            for (size_t i = 0; i < node.members.size(); i++) {
+                if (i) n += out.write(',');
+                write_string(out, node.members[i].first, n);
+                n += out.write(':');
+                write_node(out, *node.members[i].second, n);
+            }
+            n += out.write('}');
+            break;
+    }
+}
+
+}  // namespace host_json
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input, size_t length) {
+    doc.root()->reset(host_json::Node::Null);
+    if (!input) return DeserializationError::EmptyInput;
+    return host_json::Parser(input, length).parse(*doc.root());
+}
+
+inline DeserializationError deserializeJson(JsonDocument& doc, Stream& input) {
+    std::string data;
+    while (input.available() > 0) {
+        uint8_t chunk[256];
+        size_t n = input.readBytes(chunk, sizeof(chunk));
+        if (n == 0) break;
+        data.append((const char*)chunk, n);
+    }
+    return deserializeJson(doc, data.data(), data.size());
+}
+
+inline size_t serializeJson(const JsonDocument& doc, Print& out) {
+    size_t n = 0;
+    host_json::write_node(out, *doc.root(), n);
+    return n;
+}
+
+#endif // HOST_ARDUINOJSON_H
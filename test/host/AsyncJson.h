@@ -0,0 +1,62 @@
+#ifndef HOST_ASYNCJSON_H
+#define HOST_ASYNCJSON_H
+
+// === AsyncJson НА ПК ===
+// AsyncCallbackJsonWebHandler: тело POST/PUT/PATCH с Content-Type application/json
+// копируется в _tempObject запроса, разбирается в handleRequest и передается
+// обработчику как JsonVariant. Как в библиотеке: тело больше maxContentLength
+// не копируется (ответ 413), неразобранный JSON - 400.
+
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+
+#define DEFAULT_MAX_JSON_CONTENT_LENGTH 16384
+
+typedef std::function<void(AsyncWebServerRequest* request, JsonVariant& json)> ArJsonRequestHandlerFunction;
+
+class AsyncCallbackJsonWebHandler : public AsyncWebHandler {
+public:
+    AsyncCallbackJsonWebHandler(const String& uri, ArJsonRequestHandlerFunction onRequest = nullptr)
+        : _uri(uri), _onRequest(onRequest) {}
+
+    void setMethod(WebRequestMethodComposite method) { _method = method; }
+    void setMaxContentLength(int maxContentLength) { _maxContentLength = maxContentLength; }
+    void onRequest(ArJsonRequestHandlerFunction fn) { _onRequest = fn; }
+
+    bool canHandle(AsyncWebServerRequest* request) override {
+        if (!_onRequest || !(_method & request->method())) return false;
+        if (_uri.length() && _uri != request->url() && !request->url().startsWith(_uri + "/")) return false;
+        return request->contentType().equalsIgnoreCase("application/json");
+    }
+
+    void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) override {
+        if (!_onRequest || total >= (size_t)_maxContentLength) return;
+        if (index == 0) {
+            delete[] (uint8_t*)request->_tempObject;
+            request->_tempObject = new uint8_t[total + 1];
+        }
+        if (request->_tempObject) memcpy((uint8_t*)request->_tempObject + index, data, len);
+    }
+
+    void handleRequest(AsyncWebServerRequest* request) override {
+        if (!_onRequest) return request->send(500);
+        if (!request->_tempObject) return request->send(request->contentLength() >= (size_t)_maxContentLength ? 413 : 400);
+        JsonDocument doc;
+        DeserializationError error = deserializeJson(doc, (const char*)request->_tempObject, request->contentLength());
+        delete[] (uint8_t*)request->_tempObject;
+        request->_tempObject = nullptr;
+        if (error) return request->send(400);
+        JsonVariant json = doc.as<JsonVariant>();
+        _onRequest(request, json);
+    }
+
+    bool isRequestHandlerTrivial() override { return false; }
+
+private:
+    String _uri;
+    WebRequestMethodComposite _method = HTTP_POST | HTTP_PUT | HTTP_PATCH;
+    ArJsonRequestHandlerFunction _onRequest;
+    int _maxContentLength = DEFAULT_MAX_JSON_CONTENT_LENGTH;
+};
+
+#endif // HOST_ASYNCJSON_H
@@ -0,0 +1,61 @@
+#ifndef HOST_ASYNCTCP_H
+#define HOST_ASYNCTCP_H
+
+// === AsyncTCP НА ПК ===
+// Соединение со стороны устройства. На другом конце - клиент теста (host_net.h),
+// между ними модель сети из host_async_web.cpp: общий канал WiFi с ограниченной
+// скоростью, RTT и буфер отправки lwIP (TCP_SND_BUF). write() копирует данные,
+// как lwIP с TCP_WRITE_FLAG_COPY: копия живет в модели heap до подтверждения (ACK).
+// Подтверждения и обрыв соединения приходят событиями задачи AsyncTCP.
+
+#include <Arduino.h>
+#include <memory>
+
+#define TCP_SND_BUF 5744   // CONFIG_LWIP_TCP_SND_BUF_DEFAULT arduino-esp32
+#define TCP_MSS     1436
+
+struct HostTcpState;
+class AsyncClient;
+
+typedef std::function<void(void*, AsyncClient*, size_t len, uint32_t time)> AcAckHandler;
+typedef std::function<void(void*, AsyncClient*)> AcConnectHandler;
+typedef std::function<void(void*, AsyncClient*, void* data, size_t len)> AcDataHandler;
+
+class AsyncClient {
+public:
+    explicit AsyncClient(std::shared_ptr<HostTcpState> state);
+    ~AsyncClient();
+    AsyncClient(const AsyncClient&) = delete;
+    AsyncClient& operator=(const AsyncClient&) = delete;
+
+    size_t space() const;
+    bool canSend() const { return space() > 0; }
+    size_t write(const char* data, size_t len);
+    size_t write(const char* data) { return write(data, strlen(data)); }
+    bool connected() const;
+    bool freeable() const { return !connected(); }
+    void close(bool now = false);
+    void abort() { close(true); }
+
+    void onAck(AcAckHandler cb, void* arg = nullptr);
+    void onDisconnect(AcConnectHandler cb, void* arg = nullptr);
+    void onData(AcDataHandler cb, void* arg = nullptr);
+
+    // --- Только на ПК ---
+    void hostAcked(size_t len);    // Событие сети: ACK пришел
+    void hostReceived(const uint8_t* data, size_t len);   // Событие сети: сегмент от клиента
+    void hostPeerClosed();         // Событие сети: клиент закрыл соединение
+    void hostDisconnected();       // Вызвать onDisconnect (один раз)
+
+private:
+    std::shared_ptr<HostTcpState> _state;
+    AcAckHandler _ackCb;
+    void* _ackArg = nullptr;
+    AcConnectHandler _disconnectCb;
+    void* _disconnectArg = nullptr;
+    AcDataHandler _dataCb;
+    void* _dataArg = nullptr;
+    bool _disconnectFired = false;
+};
+
+#endif // HOST_ASYNCTCP_H
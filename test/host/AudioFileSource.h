@@ -0,0 +1,25 @@
+#ifndef HOST_AUDIOFILESOURCE_H
+#define HOST_AUDIOFILESOURCE_H
+
+// === ESP8266Audio НА ПК: ИСТОЧНИК ДАННЫХ ===
+// Интерфейс как у AudioFileSource из ESP8266Audio. Содержимое потока не важно
+// (декодер на ПК - модель, host_audio.cpp), важны количество байт и время их прихода.
+
+#include <Arduino.h>
+
+class AudioFileSource {
+public:
+    AudioFileSource() {}
+    virtual ~AudioFileSource() {}
+    virtual bool open(const char* filename) { return false; }
+    virtual uint32_t read(void* data, uint32_t len) = 0;
+    virtual uint32_t readNonBlock(void* data, uint32_t len) { return read(data, len); }
+    virtual bool seek(int32_t pos, int dir) { return false; }
+    virtual bool close() { return false; }
+    virtual bool isOpen() { return false; }
+    virtual uint32_t getSize() { return 0; }
+    virtual uint32_t getPos() { return 0; }
+    virtual bool loop() { return true; }
+};
+
+#endif // HOST_AUDIOFILESOURCE_H
@@ -0,0 +1,33 @@
+#ifndef HOST_AUDIOFILESOURCEBUFFER_H
+#define HOST_AUDIOFILESOURCEBUFFER_H
+
+// === ESP8266Audio НА ПК: БУФЕР ПОТОКА ===
+// Кольцо заданного размера выделяется через new, как в ESP8266Audio -
+// 128KB буфера видны в модели heap. Байты учитываются счетчиком заполнения.
+
+#include "AudioFileSource.h"
+
+class AudioFileSourceBuffer : public AudioFileSource {
+public:
+    AudioFileSourceBuffer(AudioFileSource* in, uint32_t bufferBytes);
+    ~AudioFileSourceBuffer() override;
+
+    uint32_t read(void* data, uint32_t len) override;
+    bool close() override { return _src ? _src->close() : false; }
+    bool isOpen() override { return _src && _src->isOpen(); }
+    uint32_t getSize() override { return _src ? _src->getSize() : 0; }
+    uint32_t getPos() override { return _src ? _src->getPos() - _fill : 0; }
+    bool loop() override;
+
+    uint32_t getFillLevel() { return _fill; }
+
+private:
+    void fill();
+
+    AudioFileSource* _src;
+    uint8_t* _buffer;
+    uint32_t _size;
+    uint32_t _fill = 0;
+};
+
+#endif // HOST_AUDIOFILESOURCEBUFFER_H
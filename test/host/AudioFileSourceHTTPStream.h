@@ -0,0 +1,33 @@
+#ifndef HOST_AUDIOFILESOURCEHTTPSTREAM_H
+#define HOST_AUDIOFILESOURCEHTTPSTREAM_H
+
+// === ESP8266Audio НА ПК: ПОТОК СТАНЦИИ ===
+// Сервер станции: сначала отдает host_audio_model().streamBurstBytes сразу,
+// дальше - с битрейтом потока по виртуальным часам. read() не ждет:
+// возвращает то, что уже пришло (как readNonBlock у настоящего класса).
+
+#include "AudioFileSource.h"
+
+class AudioFileSourceHTTPStream : public AudioFileSource {
+public:
+    AudioFileSourceHTTPStream();
+    explicit AudioFileSourceHTTPStream(const char* url);
+    ~AudioFileSourceHTTPStream() override {}
+
+    bool open(const char* url) override;
+    uint32_t read(void* data, uint32_t len) override;
+    bool close() override { _open = false; return true; }
+    bool isOpen() override { return _open; }
+    uint32_t getSize() override { return 0; }  // Радио - без длины
+    uint32_t getPos() override { return (uint32_t)_consumed; }
+
+    // --- Только на ПК ---
+    uint64_t hostArrived() const;   // Байт пришло к текущему моменту
+
+private:
+    bool _open = false;
+    uint64_t _openedAt = 0;
+    uint64_t _consumed = 0;
+};
+
+#endif // HOST_AUDIOFILESOURCEHTTPSTREAM_H
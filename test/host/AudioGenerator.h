@@ -0,0 +1,25 @@
+#ifndef HOST_AUDIOGENERATOR_H
+#define HOST_AUDIOGENERATOR_H
+
+// === ESP8266Audio НА ПК: БАЗОВЫЙ ДЕКОДЕР ===
+
+#include "AudioFileSource.h"
+#include "AudioOutput.h"
+
+class AudioGenerator {
+public:
+    AudioGenerator() {}
+    virtual ~AudioGenerator() {}
+    virtual bool begin(AudioFileSource* source, AudioOutput* output) { return false; }
+    virtual bool loop() { return false; }
+    virtual bool stop() { return false; }
+    virtual bool isRunning() { return running; }
+
+protected:
+    bool running = false;
+    AudioFileSource* file = nullptr;
+    AudioOutput* output = nullptr;
+    int16_t lastSample[2] = {0, 0};
+};
+
+#endif // HOST_AUDIOGENERATOR_H
@@ -0,0 +1,35 @@
+#ifndef HOST_AUDIOGENERATORMP3_H
+#define HOST_AUDIOGENERATORMP3_H
+
+// === ESP8266Audio НА ПК: MP3 ===
+// Модель декодера вместо libmad: кадр - frameBytes байт из источника и
+// frameDecodeUs виртуального времени CPU, на выходе 1152 сэмпла (синус).
+// loop() устроен как у AudioGeneratorMP3: сначала повтор сэмпла, не принятого
+// в прошлый раз, потом сэмплы по одному, пока выход их принимает; новый кадр
+// декодируется, когда текущий закончился. Не хватает байт на кадр - ждет
+// следующего loop(), как libmad на MAD_ERROR_BUFLEN.
+
+#include "AudioGenerator.h"
+
+class AudioGeneratorMP3 : public AudioGenerator {
+public:
+    AudioGeneratorMP3() {}
+    ~AudioGeneratorMP3() override;
+
+    bool begin(AudioFileSource* source, AudioOutput* output) override;
+    bool loop() override;
+    bool stop() override;
+    bool isRunning() override { return running; }
+
+private:
+    bool decode_frame();
+
+    uint8_t* _state = nullptr;     // Рабочая память libmad (stream/frame/synth) - в модели heap
+    uint8_t* _input = nullptr;
+    uint32_t _inputFill = 0;
+    uint32_t _pcmLeft = 0;         // Сэмплов текущего кадра не отдано
+    bool _pending = false;         // lastSample не принят выходом
+    uint32_t _phase = 0;
+};
+
+#endif // HOST_AUDIOGENERATORMP3_H
@@ -0,0 +1,34 @@
+#ifndef HOST_AUDIOOUTPUT_H
+#define HOST_AUDIOOUTPUT_H
+
+// === ESP8266Audio НА ПК: БАЗОВЫЙ ВЫХОД ===
+
+#include <Arduino.h>
+
+class AudioOutput {
+public:
+    AudioOutput() {}
+    virtual ~AudioOutput() {}
+    virtual bool SetRate(int hz) { hertz = hz; return true; }
+    virtual bool SetBitsPerSample(int bits) { bps = bits; return true; }
+    virtual bool SetChannels(int chan) { channels = chan; return true; }
+    virtual bool SetGain(float f) {
+        if (f > 4.0f) f = 4.0f;
+        if (f < 0.0f) f = 0.0f;
+        gainF2P6 = (uint8_t)(f * (1 << 6));
+        return true;
+    }
+    virtual bool begin() { return false; }
+    virtual bool ConsumeSample(int16_t sample[2]) = 0;
+    virtual bool stop() { return false; }
+    virtual void flush() {}
+    virtual bool loop() { return true; }
+
+protected:
+    int hertz = 44100;
+    int bps = 16;
+    int channels = 2;
+    uint8_t gainF2P6 = 1 << 6;
+};
+
+#endif // HOST_AUDIOOUTPUT_H
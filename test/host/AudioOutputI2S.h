@@ -0,0 +1,38 @@
+#ifndef HOST_AUDIOOUTPUTI2S_H
+#define HOST_AUDIOOUTPUTI2S_H
+
+// === ESP8266Audio НА ПК: I2S ===
+// DMA - dma_buf_count буферов по 128 сэмплов, проигрываются по виртуальным часам
+// с частотой SetRate. ConsumeSample() возвращает false, когда DMA полон (декодер
+// повторит сэмпл позже), как i2s_write с нулевым таймаутом. Если к приходу
+// следующего сэмпла DMA уже опустел - на выходе была тишина: это пропуск звука,
+// он считается в host_audio_stats().
+
+#include "AudioOutput.h"
+
+#define EXTERNAL_I2S  0
+#define INTERNAL_DAC  1
+#define INTERNAL_PDM  2
+#define APLL_AUTO    -1
+#define APLL_ENABLE   1
+#define APLL_DISABLE  0
+
+class AudioOutputI2S : public AudioOutput {
+public:
+    AudioOutputI2S(int port = 0, int output_mode = EXTERNAL_I2S, int dma_buf_count = 8, int use_apll = APLL_DISABLE);
+    ~AudioOutputI2S() override;
+
+    bool SetPinout(int bclkPin, int wclkPin, int doutPin);
+    bool begin() override;
+    bool ConsumeSample(int16_t sample[2]) override;
+    bool stop() override;
+    void flush() override;
+
+private:
+    uint8_t* _dma;           // Буферы DMA - в модели heap
+    uint32_t _dmaSamples;
+    bool _playing = false;
+    double _drainedAt = 0;   // Момент (мкс), когда DMA опустеет
+};
+
+#endif // HOST_AUDIOOUTPUTI2S_H
@@ -0,0 +1,506 @@
+#ifndef HOST_ESPASYNCWEBSERVER_H
+#define HOST_ESPASYNCWEBSERVER_H
+
+// === ESPAsyncWebServer НА ПК ===
+// API и поведение ESPAsyncWebServer-esphome 3.x в той части, что вызывает прошивка
+// и проверяют тесты (новый вызов в src/ - сюда же):
+// - выбор обработчика: по порядку регистрации, filter() && canHandle(), иначе onNotFound;
+//   AsyncCallbackWebHandler совпадает и с "uri/..." (как в библиотеке);
+// - ответ: заголовки и первый кусок уходят из request->send(), дальше - по куску
+//   на каждый ACK (AsyncAbstractResponse::_ack): chunked-ответ получает maxLen =
+//   свободное место в буфере TCP - 8, буфер куска выделяется в heap;
+// - WebSocket: очередь WS_MAX_QUEUED_MESSAGES сообщений, в полете одно сообщение,
+//   переполнение очереди закрывает соединение;
+// - SSE: очередь до SSE_MAX_QUEUED_MESSAGES, лишние сообщения отбрасываются.
+// Тело multipart/form-data (импорт станций) не разбирается: тестов на него нет.
+// Запросы разбирает задача AsyncTCP: событие сети из host_async_web.cpp.
+
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <LittleFS.h>
+#include <vector>
+
+#ifndef WS_MAX_QUEUED_MESSAGES
+#define WS_MAX_QUEUED_MESSAGES 32
+#endif
+#ifndef SSE_MAX_QUEUED_MESSAGES
+#define SSE_MAX_QUEUED_MESSAGES 32
+#endif
+
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+typedef enum {
+    HTTP_GET     = 0b00000001,
+    HTTP_POST    = 0b00000010,
+    HTTP_DELETE  = 0b00000100,
+    HTTP_PUT     = 0b00001000,
+    HTTP_PATCH   = 0b00010000,
+    HTTP_HEAD    = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY     = 0b01111111,
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+class AsyncWebHandler;
+
+typedef std::function<void(void)> ArDisconnectHandler;
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data,
+                           size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total)>
+    ArBodyHandlerFunction;
+typedef std::function<bool(AsyncWebServerRequest* request)> ArRequestFilterFunction;
+typedef std::function<size_t(uint8_t* buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+// === ЗАГОЛОВКИ И ПАРАМЕТРЫ ===
+class AsyncWebHeader {
+public:
+    AsyncWebHeader(const String& name, const String& value) : _name(name), _value(value) {}
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+    String toString() const { return _name + ": " + _value + "\r\n"; }
+
+private:
+    String _name;
+    String _value;
+};
+
+class AsyncWebParameter {
+public:
+    AsyncWebParameter(const String& name, const String& value, bool form) : _name(name), _value(value), _isForm(form) {}
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+    bool isPost() const { return _isForm; }
+
+private:
+    String _name;
+    String _value;
+    bool _isForm;
+};
+
+// === ЗАПРОС ===
+class AsyncWebServerRequest {
+    friend class AsyncWebServer;
+
+public:
+    AsyncWebServerRequest(AsyncWebServer* server, AsyncClient* client);
+    ~AsyncWebServerRequest();
+
+    AsyncClient* client() { return _client; }
+    const String& url() const { return _url; }
+    const String& contentType() const { return _contentType; }
+    size_t contentLength() const { return _contentLength; }
+    WebRequestMethodComposite method() const { return _method; }
+
+    void onDisconnect(ArDisconnectHandler fn) { _onDisconnectfn = fn; }
+
+    void redirect(const String& url);
+    void send(AsyncWebServerResponse* response);
+    void send(int code, const String& contentType = String(), const String& content = String());
+    void send(int code, const String& contentType, const char* content) { send(code, contentType, String(content)); }
+
+    AsyncWebServerResponse* beginResponse(int code, const String& contentType = String(),
+                                          const String& content = String());
+    AsyncWebServerResponse* beginResponse_P(int code, const String& contentType, const uint8_t* content, size_t len);
+    AsyncWebServerResponse* beginChunkedResponse(const String& contentType, AwsResponseFiller callback);
+    class AsyncResponseStream* beginResponseStream(const String& contentType, size_t bufferSize = 1460);
+
+    size_t headers() const { return _headers.size(); }
+    bool hasHeader(const String& name) const { return getHeader(name) != nullptr; }
+    AsyncWebHeader* getHeader(const String& name) const;
+    AsyncWebHeader* getHeader(size_t num) const { return num < _headers.size() ? _headers[num] : nullptr; }
+    const String& header(const char* name) const;
+
+    // Файловых параметров нет: multipart не разбирается
+    bool hasParam(const String& name, bool post = false, bool file = false) const {
+        return !file && getParam(name, post) != nullptr;
+    }
+    AsyncWebParameter* getParam(const String& name, bool post = false) const;
+
+    void* _tempObject = nullptr;
+
+    // --- Только на ПК ---
+    void _onAck(size_t len, uint32_t time);
+    void _onData(const uint8_t* data, size_t len);
+    void _onDisconnect();
+
+private:
+    enum { PARSE_REQ_HEADERS, PARSE_REQ_BODY, PARSE_REQ_END };
+
+    bool _parseHead(const std::string& head);
+    void _parseForm(const std::string& body);
+    void _endBody();
+
+    AsyncClient* _client;
+    AsyncWebServer* _server;
+    AsyncWebHandler* _handler = nullptr;
+    AsyncWebServerResponse* _response = nullptr;
+    ArDisconnectHandler _onDisconnectfn;
+    String _url;
+    String _contentType;
+    size_t _contentLength = 0;
+    WebRequestMethodComposite _method = HTTP_GET;
+    std::vector<AsyncWebHeader*> _headers;
+    std::vector<AsyncWebParameter*> _params;
+    uint8_t _parseState = PARSE_REQ_HEADERS;
+    std::string _temp;             // Заголовок запроса или тело формы до конца приема
+    size_t _parsedLength = 0;
+    bool _isPlainPost = false;
+    bool* _destroyed = nullptr;    // Ответ upgrade удалил запрос внутри _onAck
+};
+
+// === ОТВЕТЫ ===
+class AsyncWebServerResponse {
+public:
+    AsyncWebServerResponse();
+    virtual ~AsyncWebServerResponse() {}
+
+    virtual void setCode(int code) { if (_state == RESPONSE_SETUP) _code = code; }
+    virtual void addHeader(const String& name, const String& value) { _headers.push_back(AsyncWebHeader(name, value)); }
+    virtual String _assembleHead(uint8_t version);
+    virtual bool _started() const { return _state > RESPONSE_SETUP; }
+    virtual bool _finished() const { return _state > RESPONSE_WAIT_ACK; }
+    virtual bool _failed() const { return _state == RESPONSE_FAILED; }
+    virtual bool _sourceValid() const { return false; }
+    virtual void _respond(AsyncWebServerRequest* request);
+    virtual size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t time);
+
+    static const char* responseCodeToString(int code);
+
+protected:
+    enum { RESPONSE_SETUP, RESPONSE_HEADERS, RESPONSE_CONTENT, RESPONSE_WAIT_ACK, RESPONSE_END, RESPONSE_FAILED };
+
+    int _code = 0;
+    std::vector<AsyncWebHeader> _headers;
+    String _contentType;
+    size_t _contentLength = 0;
+    bool _sendContentLength = true;
+    bool _chunked = false;
+    size_t _headLength = 0;
+    size_t _sentLength = 0;
+    size_t _ackedLength = 0;
+    size_t _writtenLength = 0;
+    uint8_t _state = RESPONSE_SETUP;
+};
+
+// Ответ целиком из String (send(code, type, content))
+class AsyncBasicResponse : public AsyncWebServerResponse {
+public:
+    AsyncBasicResponse(int code, const String& contentType = String(), const String& content = String());
+    void _respond(AsyncWebServerRequest* request) override;
+    size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t time) override;
+    bool _sourceValid() const override { return true; }
+
+private:
+    String _content;
+};
+
+// Ответ, тело которого читается кусками по мере ACK
+class AsyncAbstractResponse : public AsyncWebServerResponse {
+public:
+    void _respond(AsyncWebServerRequest* request) override;
+    size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t time) override;
+    bool _sourceValid() const override { return false; }
+    virtual size_t _fillBuffer(uint8_t* buf, size_t maxLen) { return 0; }
+
+protected:
+    String _head;
+};
+
+class AsyncProgmemResponse : public AsyncAbstractResponse {
+public:
+    AsyncProgmemResponse(int code, const String& contentType, const uint8_t* content, size_t len);
+    bool _sourceValid() const override { return true; }
+    size_t _fillBuffer(uint8_t* buf, size_t maxLen) override;
+
+private:
+    const uint8_t* _content;
+    size_t _readLength = 0;
+};
+
+class AsyncChunkedResponse : public AsyncAbstractResponse {
+public:
+    AsyncChunkedResponse(const String& contentType, AwsResponseFiller callback);
+    bool _sourceValid() const override { return !!(_content); }
+    size_t _fillBuffer(uint8_t* buf, size_t maxLen) override;
+
+private:
+    AwsResponseFiller _content;
+    size_t _filledLength = 0;
+};
+
+class AsyncResponseStream : public AsyncAbstractResponse, public Print {
+public:
+    AsyncResponseStream(const String& contentType, size_t bufferSize);
+    bool _sourceValid() const override { return _state < RESPONSE_END; }
+    size_t _fillBuffer(uint8_t* buf, size_t maxLen) override;
+    size_t write(const uint8_t* data, size_t len) override;
+    size_t write(uint8_t data) override { return write(&data, 1); }
+    using Print::write;
+    size_t available() const { return _content.size() - _readPosition; }
+
+private:
+    std::string _content;
+    size_t _readPosition = 0;
+};
+
+// === ОБРАБОТЧИКИ ===
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() {}
+    AsyncWebHandler& setFilter(ArRequestFilterFunction fn) {
+        _filter = fn;
+        return *this;
+    }
+    bool filter(AsyncWebServerRequest* request) { return !_filter || _filter(request); }
+    virtual bool canHandle(AsyncWebServerRequest* request) { return false; }
+    virtual void handleRequest(AsyncWebServerRequest* request) {}
+    virtual void handleUpload(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data,
+                              size_t len, bool final) {}
+    virtual void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {}
+    virtual bool isRequestHandlerTrivial() { return true; }
+
+protected:
+    ArRequestFilterFunction _filter;
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+public:
+    AsyncCallbackWebHandler() {}
+    void setUri(const String& uri) { _uri = uri; }
+    void setMethod(WebRequestMethodComposite method) { _method = method; }
+    void onRequest(ArRequestHandlerFunction fn) { _onRequest = fn; }
+    void onUpload(ArUploadHandlerFunction fn) { _onUpload = fn; }
+    void onBody(ArBodyHandlerFunction fn) { _onBody = fn; }
+
+    bool canHandle(AsyncWebServerRequest* request) override;
+    void handleRequest(AsyncWebServerRequest* request) override;
+    void handleUpload(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data, size_t len,
+                      bool final) override {
+        if (_onUpload) _onUpload(request, filename, index, data, len, final);
+    }
+    void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) override {
+        if (_onBody) _onBody(request, data, len, index, total);
+    }
+    bool isRequestHandlerTrivial() override { return !_onBody && !_onUpload; }
+
+protected:
+    String _uri;
+    WebRequestMethodComposite _method = HTTP_ANY;
+    ArRequestHandlerFunction _onRequest;
+    ArUploadHandlerFunction _onUpload;
+    ArBodyHandlerFunction _onBody;
+};
+
+// Только цепочка настроек: файлов на ПК не отдает (canHandle всегда false)
+class AsyncStaticWebHandler : public AsyncWebHandler {
+public:
+    bool canHandle(AsyncWebServerRequest* request) override;
+    void handleRequest(AsyncWebServerRequest* request) override;
+    AsyncStaticWebHandler& setDefaultFile(const char* filename) { return *this; }
+    AsyncStaticWebHandler& setCacheControl(const char* cache_control) { return *this; }
+};
+
+// === WEBSOCKET ===
+typedef enum { WS_DISCONNECTED, WS_CONNECTED, WS_DISCONNECTING } AwsClientStatus;
+typedef enum { WS_CONTINUATION, WS_TEXT, WS_BINARY, WS_DISCONNECT = 0x08, WS_PING, WS_PONG } AwsFrameType;
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+
+typedef struct {
+    uint8_t message_opcode;
+    uint32_t num;
+    uint8_t final;
+    uint8_t masked;
+    uint8_t opcode;
+    uint64_t len;
+    uint8_t mask[4];
+    uint64_t index;
+} AwsFrameInfo;
+
+class AsyncWebSocket;
+
+class AsyncWebSocketClient {
+public:
+    AsyncWebSocketClient(AsyncWebServerRequest* request, AsyncWebSocket* server);
+    ~AsyncWebSocketClient();
+
+    uint32_t id() const { return _clientId; }
+    AwsClientStatus status() const { return _status; }
+
+    void close(uint16_t code = 0, const char* message = nullptr);
+    bool queueIsFull() const { return _messageQueue.size() >= WS_MAX_QUEUED_MESSAGES || _status != WS_CONNECTED; }
+    void binary(const uint8_t* message, size_t len) { _queueMessage(WS_BINARY, message, len); }
+
+private:
+    struct Message {
+        uint8_t opcode;
+        std::vector<uint8_t> frame;   // Кадр целиком (заголовок + данные)
+        bool sent;
+        size_t acked;
+    };
+
+    void _queueMessage(uint8_t opcode, const uint8_t* data, size_t len);
+    void _queueControl(uint8_t opcode, const uint8_t* data, size_t len);
+    void _runQueue();
+    void _onAck(size_t len);
+    void _onData(const uint8_t* data, size_t len);
+    void _onDisconnect();
+
+    AsyncClient* _client;
+    AsyncWebSocket* _server;
+    uint32_t _clientId;
+    AwsClientStatus _status;
+    std::vector<Message> _messageQueue;
+    std::vector<Message> _controlQueue;
+    std::string _rxBuffer;         // Недочитанный кадр от клиента
+};
+
+typedef std::function<void(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg,
+                           uint8_t* data, size_t len)> AwsEventHandler;
+
+class AsyncWebSocket : public AsyncWebHandler {
+    friend class AsyncWebSocketClient;
+
+public:
+    explicit AsyncWebSocket(const String& url) : _url(url) {}
+    ~AsyncWebSocket() override;
+
+    const char* url() const { return _url.c_str(); }
+    void onEvent(AwsEventHandler handler) { _eventHandler = handler; }
+
+    size_t count() const;
+    AsyncWebSocketClient* client(uint32_t id);
+
+    bool canHandle(AsyncWebServerRequest* request) override;
+    void handleRequest(AsyncWebServerRequest* request) override;
+
+    // --- Только на ПК ---
+    void _handleEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+        if (_eventHandler) _eventHandler(this, client, type, arg, data, len);
+    }
+
+private:
+    void _addClient(AsyncWebSocketClient* client) { _clients.push_back(client); }
+    void _handleDisconnect(AsyncWebSocketClient* client);
+    uint32_t _getNextId() { return _cNextId++; }
+
+    String _url;
+    std::vector<AsyncWebSocketClient*> _clients;
+    uint32_t _cNextId = 1;
+    AwsEventHandler _eventHandler;
+};
+
+class AsyncWebSocketResponse : public AsyncWebServerResponse {
+public:
+    AsyncWebSocketResponse(const String& key, AsyncWebSocket* server);
+    void _respond(AsyncWebServerRequest* request) override;
+    size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t time) override;
+    bool _sourceValid() const override { return true; }
+
+private:
+    AsyncWebSocket* _server;
+};
+
+// === SSE ===
+class AsyncEventSource;
+
+class AsyncEventSourceClient {
+public:
+    AsyncEventSourceClient(AsyncWebServerRequest* request, AsyncEventSource* server);
+    ~AsyncEventSourceClient();
+
+    void close();
+    void write(const char* message, size_t len);
+    void send(const char* message, const char* event = nullptr, uint32_t id = 0, uint32_t reconnect = 0);
+    bool connected() const { return _client && _client->connected(); }
+    size_t packetsWaiting() const { return _messageQueue.size(); }
+
+private:
+    struct Message {
+        std::string data;
+        size_t sent;
+        size_t acked;
+    };
+
+    void _queueMessage(const std::string& data);
+    void _runQueue();
+    void _onAck(size_t len);
+    void _onDisconnect();
+
+    AsyncClient* _client;
+    AsyncEventSource* _server;
+    std::vector<Message> _messageQueue;
+};
+
+typedef std::function<void(AsyncEventSourceClient* client)> ArEventHandlerFunction;
+
+class AsyncEventSource : public AsyncWebHandler {
+    friend class AsyncEventSourceClient;
+
+public:
+    explicit AsyncEventSource(const String& url) : _url(url) {}
+    ~AsyncEventSource() override;
+
+    const char* url() const { return _url.c_str(); }
+    void onConnect(ArEventHandlerFunction cb) { _connectcb = cb; }
+    void send(const char* message, const char* event = nullptr, uint32_t id = 0, uint32_t reconnect = 0);
+    size_t count() const;
+    size_t avgPacketsWaiting() const;
+
+    bool canHandle(AsyncWebServerRequest* request) override;
+    void handleRequest(AsyncWebServerRequest* request) override;
+
+private:
+    void _addClient(AsyncEventSourceClient* client);
+    void _handleDisconnect(AsyncEventSourceClient* client);
+
+    String _url;
+    std::vector<AsyncEventSourceClient*> _clients;
+    ArEventHandlerFunction _connectcb;
+};
+
+class AsyncEventSourceResponse : public AsyncWebServerResponse {
+public:
+    explicit AsyncEventSourceResponse(AsyncEventSource* server);
+    void _respond(AsyncWebServerRequest* request) override;
+    size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t time) override;
+    bool _sourceValid() const override { return true; }
+
+private:
+    AsyncEventSource* _server;
+};
+
+// === СЕРВЕР ===
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t port) : _port(port) {}
+    ~AsyncWebServer();
+
+    void begin();
+    void end();
+
+    AsyncWebHandler& addHandler(AsyncWebHandler* handler);
+
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody = nullptr);
+    AsyncStaticWebHandler& serveStatic(const char* uri, FS& fs, const char* path, const char* cache_control = nullptr);
+
+    void onNotFound(ArRequestHandlerFunction fn) { _catchAllHandler.onRequest(fn); }
+    void reset();
+
+    // --- Только на ПК ---
+    void _attachHandler(AsyncWebServerRequest* request);
+    void _handleDisconnect(AsyncWebServerRequest* request) { delete request; }
+
+private:
+    uint16_t _port;
+    std::vector<AsyncWebHandler*> _handlers;
+    AsyncCallbackWebHandler _catchAllHandler;
+};
+
+#endif // HOST_ESPASYNCWEBSERVER_H
@@ -0,0 +1,90 @@
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+// === LITTLEFS НА ПК ===
+// Файлы в памяти процесса. Чтение и запись двигают виртуальное время по модели
+// стоимости flash (накладные расходы вызова + время на байт), поэтому код,
+// который мерит micros() вокруг file.read(), видит "медленную" flash и на ПК.
+// Модель грубая и настраивается тестом (host_fs_set_cost), это не замер C3.
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+namespace fs {
+
+struct HostNode {
+    std::vector<uint8_t> data;
+};
+
+class File : public Stream {
+public:
+    File() {}
+    File(const std::string& path, std::shared_ptr<HostNode> node, bool writable, size_t position)
+        : _path(path), _node(node), _writable(writable), _position(position) {}
+
+    explicit operator bool() const { return (bool)_node; }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    int available() override { return _node ? (int)(_node->data.size() - _position) : 0; }
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buffer, size_t size);
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const { return _position; }
+    size_t size() const { return _node ? _node->data.size() : 0; }
+    void close() { _node.reset(); }
+    const char* path() const { return _path.c_str(); }
+    const char* name() const;
+    bool isDirectory() const { return false; }
+
+private:
+    std::string _path;
+    std::shared_ptr<HostNode> _node;
+    bool _writable = false;
+    size_t _position = 0;
+};
+
+class FS {
+public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+               const char* partitionLabel = "spiffs") { return hostMounted; }
+    void end() {}
+    bool format() { _files.clear(); return true; }
+    File open(const char* path, const char* mode = "r", bool create = false);
+    File open(const String& path, const char* mode = "r", bool create = false) { return open(path.c_str(), mode, create); }
+    bool exists(const char* path) { return _files.count(path) > 0; }
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path) { return _files.erase(path) > 0; }
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+    size_t totalBytes() { return 1408 * 1024; }
+    size_t usedBytes();
+
+    // --- Только на ПК ---
+    bool hostMounted = true;
+    void hostWriteFile(const char* path, const std::string& content);
+    std::string hostReadFile(const char* path);
+
+private:
+    std::map<std::string, std::shared_ptr<HostNode>> _files;
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+
+extern fs::FS LittleFS;
+
+// Модель стоимости: вызов read()/write() + наносекунды на байт
+void host_fs_set_cost(uint32_t readCallUs, uint32_t readNsPerByte, uint32_t writeCallUs, uint32_t writeNsPerByte);
+
+#endif // HOST_LITTLEFS_H
@@ -0,0 +1,52 @@
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+// === SPI НА ПК ===
+// Байты уходят наблюдателю шины (модель OLED) вместе с уровнем линии D/C,
+// время на шине - 8 бит на байт на частоте текущей транзакции.
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+class SPISettings {
+public:
+    SPISettings() : clock(1000000), bitOrder(MSBFIRST), dataMode(SPI_MODE0) {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+        : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+
+    uint32_t clock;
+    uint8_t bitOrder;
+    uint8_t dataMode;
+};
+
+class SPIClass {
+public:
+    typedef void (*Sink)(const uint8_t* data, size_t len);
+
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1);
+    void end();
+    void beginTransaction(SPISettings settings);
+    void endTransaction();
+    uint8_t transfer(uint8_t data);
+    void write(uint8_t data);
+    void writeBytes(const uint8_t* data, uint32_t size);
+
+    // --- Только на ПК ---
+    void hostSetSink(Sink sink) { _sink = sink; }
+    unsigned long hostBytes = 0;
+    unsigned long hostTransactions = 0;
+    uint64_t hostBusMicros = 0;
+
+private:
+    SPISettings _settings;
+    bool _inTransaction = false;
+    Sink _sink = nullptr;
+};
+
+extern SPIClass SPI;
+
+#endif // HOST_SPI_H
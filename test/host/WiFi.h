@@ -0,0 +1,117 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+// === WIFI НА ПК ===
+// Состояние радио задает тест через host* поля: статус, RSSI, адреса,
+// результаты сканирования. Прошивка видит их через обычный API WiFi.
+
+#include <Arduino.h>
+#include <vector>
+
+class IPAddress {
+public:
+    IPAddress() : _address(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : _address((uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24) {}
+    IPAddress(uint32_t address) : _address(address) {}
+
+    bool fromString(const char* text);
+    bool fromString(const String& text) { return fromString(text.c_str()); }
+    String toString() const;
+
+    // Как в arduino-esp32: байты в сетевом порядке, [0] - первый октет
+    uint8_t operator[](int index) const { return (uint8_t)(_address >> (8 * index)); }
+    operator uint32_t() const { return _address; }
+    bool operator==(const IPAddress& other) const { return _address == other._address; }
+    bool operator!=(const IPAddress& other) const { return _address != other._address; }
+
+private:
+    uint32_t _address;
+};
+
+#define INADDR_NONE IPAddress(0, 0, 0, 0)
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+    WIFI_AUTH_WPA2_ENTERPRISE,
+    WIFI_AUTH_WPA3_PSK,
+    WIFI_AUTH_WPA2_WPA3_PSK
+} wifi_auth_mode_t;
+
+typedef enum { WIFI_POWER_19_5dBm = 78, WIFI_POWER_11dBm = 44, WIFI_POWER_2dBm = 8 } wifi_power_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED  (-2)
+
+struct HostScanResult {
+    String ssid;
+    int8_t rssi;
+    wifi_auth_mode_t auth;
+};
+
+class WiFiClass {
+public:
+    wl_status_t status() { return hostStatus; }
+    int8_t RSSI() { return hostStatus == WL_CONNECTED ? hostRssi : 0; }
+    String SSID() { return hostStatus == WL_CONNECTED ? hostSsid : String(); }
+    IPAddress localIP() { return hostStatus == WL_CONNECTED ? hostLocalIP : IPAddress(); }
+    IPAddress softAPIP() { return hostSoftAPIP; }
+    uint8_t softAPgetStationNum() { return hostSoftAPStations; }
+
+    wifi_mode_t getMode() { return hostMode; }
+    bool mode(wifi_mode_t m) { hostMode = m; return true; }
+    wl_status_t begin(const char* ssid, const char* password = nullptr);
+    bool disconnect(bool wifiOff = false, bool eraseAp = false);
+    bool softAP(const char* ssid, const char* password = nullptr) { hostMode = WIFI_AP; return true; }
+    bool softAPdisconnect(bool wifiOff = false) { return true; }
+    bool setAutoReconnect(bool autoReconnect) { return true; }
+    bool setSleep(bool enabled) { return true; }
+    bool setTxPower(wifi_power_t power) { return true; }
+
+    // Сканирование: асинхронное завершается через hostScanDelayMs виртуального времени
+    int16_t scanNetworks(bool async = false);
+    int16_t scanComplete();
+    void scanDelete() { _scanReady = false; }
+    String SSID(uint8_t i) { return _scanReady && i < hostScanResults.size() ? hostScanResults[i].ssid : String(); }
+    int32_t RSSI(uint8_t i) { return _scanReady && i < hostScanResults.size() ? hostScanResults[i].rssi : 0; }
+    wifi_auth_mode_t encryptionType(uint8_t i) {
+        return _scanReady && i < hostScanResults.size() ? hostScanResults[i].auth : WIFI_AUTH_OPEN;
+    }
+
+    // --- Только на ПК ---
+    wl_status_t hostStatus = WL_DISCONNECTED;
+    wifi_mode_t hostMode = WIFI_OFF;
+    int8_t hostRssi = -60;
+    String hostSsid = "HostNet";
+    IPAddress hostLocalIP = IPAddress(192, 168, 1, 50);
+    IPAddress hostSoftAPIP = IPAddress(192, 168, 4, 1);
+    uint8_t hostSoftAPStations = 0;
+    bool hostConnectOnBegin = true;        // begin() сразу подключает
+    std::vector<HostScanResult> hostScanResults;
+    uint32_t hostScanDelayMs = 2000;
+
+private:
+    bool _scanRunning = false;
+    bool _scanReady = false;
+    unsigned long _scanStarted = 0;
+};
+
+extern WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
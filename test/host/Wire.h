@@ -0,0 +1,52 @@
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+// === I2C (TwoWire) НА ПК ===
+// Транзакции копятся в буфере на I2C_BUFFER_LENGTH байт, как в arduino-esp32:
+// лишние байты write() отбрасывает. endTransmission() отдает транзакцию
+// наблюдателю шины (модель OLED) и двигает виртуальное время на длительность
+// передачи: 9 бит на байт (8 + ACK) плюс адресный байт, START и STOP.
+// Накладные расходы драйвера не моделируются - только время на проводе.
+
+#include <Arduino.h>
+
+#define I2C_BUFFER_LENGTH 128
+
+class TwoWire : public Print {
+public:
+    // Наблюдатель шины: адрес и байты транзакции без адресного байта
+    typedef void (*Sink)(uint8_t address, const uint8_t* data, size_t len);
+
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    bool end();
+    bool setClock(uint32_t frequency);
+    uint32_t getClock() const { return _clock; }
+
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(bool sendStop = true);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t len) override;
+    using Print::write;
+
+    // --- Только на ПК ---
+    void hostSetSink(Sink sink) { _sink = sink; }
+    unsigned long hostBytes = 0;         // Байт данных на шине (без адресных)
+    unsigned long hostTransactions = 0;
+    unsigned long hostDropped = 0;       // Байт, не влезших в буфер транзакции
+    uint64_t hostBusMicros = 0;          // Модельное время на шине
+
+private:
+    bool push(uint8_t c);
+
+    uint32_t _clock = 100000;
+    bool _started = false;
+    bool _inTransmission = false;
+    uint8_t _address = 0;
+    uint8_t _buffer[I2C_BUFFER_LENGTH];
+    size_t _length = 0;
+    Sink _sink = nullptr;
+};
+
+extern TwoWire Wire;
+
+#endif // HOST_WIRE_H
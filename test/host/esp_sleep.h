@@ -0,0 +1,20 @@
+#ifndef HOST_ESP_SLEEP_H
+#define HOST_ESP_SLEEP_H
+
+#include <cstdint>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+typedef enum {
+    ESP_GPIO_WAKEUP_GPIO_LOW = 0,
+    ESP_GPIO_WAKEUP_GPIO_HIGH = 1,
+} esp_deepsleep_gpio_wake_up_mode_t;
+
+esp_err_t esp_deep_sleep_enable_gpio_wakeup(uint64_t gpioPinMask, esp_deepsleep_gpio_wake_up_mode_t mode);
+
+// На устройстве не возвращается. На ПК отмечает сон (host_deep_sleeping) и возвращается:
+// вызывающий код дальше не должен ничего делать
+void esp_deep_sleep_start();
+
+#endif // HOST_ESP_SLEEP_H
@@ -0,0 +1,38 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+// === FREERTOS НА ПК ===
+// Прошивка на ПК выполняется в одном потоке: события AsyncTCP вытесняют loop()
+// посреди host_time_advance (host_env.h), но не внутри мьютекса или критической
+// секции - там они ждут освобождения, как задача, заблокированная на мьютексе.
+// Мьютекс считает захваты и ловит повторный захват без освобождения.
+
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  pdTRUE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+struct portMUX_TYPE {
+    uint32_t owner;
+    uint32_t count;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED {0, 0}
+
+void host_lock_enter();
+void host_lock_exit();
+
+inline void taskENTER_CRITICAL(portMUX_TYPE* mux) { mux->count++; host_lock_enter(); }
+inline void taskEXIT_CRITICAL(portMUX_TYPE* mux) { mux->count--; host_lock_exit(); }
+#define portENTER_CRITICAL(mux) taskENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL(mux) taskEXIT_CRITICAL(mux)
+
+#endif // HOST_FREERTOS_H
@@ -0,0 +1,11 @@
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+
+// Стек loopTask на ПК не кончается: запас как у свежей задачи на 8KB
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) { return 6144; }
+
+#endif // HOST_FREERTOS_TASK_H
@@ -0,0 +1,410 @@
+#include <Arduino.h>
+#include <new>
+#include <vector>
+#include <freertos/semphr.h>
+#include "host_env.h"
+
+// === ВИРТУАЛЬНОЕ ВРЕМЯ ===
+static uint64_t clockMicros = 0;
+
+static HostPreemptor* preemptor = nullptr;
+static bool preempting = false;   // Выполняется событие: его самого не вытесняют
+static uint32_t locksHeld = 0;    // Мьютексы и критические секции loop()
+
+uint64_t host_time_us() { return clockMicros; }
+void host_time_reset() { clockMicros = 0; }
+void host_set_preemptor(HostPreemptor* p) { preemptor = p; }
+
+// Время текущей задачи идет на us. Наступившие события выполняются в свой срок,
+// а прерванная задача продолжается после них - на время событий позже
+void host_time_advance(uint64_t us) {
+    uint64_t target = clockMicros + us;
+    while (preemptor && !preempting && locksHeld == 0) {
+        uint64_t due = preemptor->nextDueUs();
+        if (due > target) break;
+        if (due > clockMicros) clockMicros = due;
+        uint64_t start = clockMicros;
+        preempting = true;
+        preemptor->runNext();
+        preempting = false;
+        target += clockMicros - start;
+    }
+    clockMicros = target;
+}
+
+void host_time_set(uint64_t us) { if (us > clockMicros) host_time_advance(us - clockMicros); }
+
+void host_lock_enter() { locksHeld++; }
+
+void host_lock_exit() {
+    if (locksHeld > 0) locksHeld--;
+    if (locksHeld == 0) host_time_advance(0);  // События, ждавшие освобождения
+}
+
+unsigned long millis() { return (unsigned long)(clockMicros / 1000); }
+unsigned long micros() { return (unsigned long)clockMicros; }
+void delay(uint32_t ms) { host_time_advance((uint64_t)ms * 1000); }
+void delayMicroseconds(uint32_t us) { host_time_advance(us); }
+void yield() {}
+
+#if !defined(__GLIBC__) || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t length = strlen(src);
+    if (size > 0) {
+        size_t n = length < size - 1 ? length : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return length;
+}
+#endif
+
+// === СЛУЧАЙНЫЕ ЧИСЛА ===
+// Свой генератор (xorshift32), чтобы кадры визуализаторов совпадали на любой libc
+static uint32_t randomState = 1;
+
+static uint32_t next_random() {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+void randomSeed(unsigned long seed) { randomState = seed ? (uint32_t)seed : 1; }
+
+long random(long howbig) {
+    if (howbig <= 0) return 0;
+    return next_random() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+    if (howsmall >= howbig) return howsmall;
+    return howsmall + random(howbig - howsmall);
+}
+
+uint32_t esp_random() { return next_random(); }
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    if (inMax == inMin) return outMin;
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// Уровни пинов: то, что записала прошивка или выставил тест (кнопки, D/C дисплея)
+static uint8_t pinLevels[64];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < sizeof(pinLevels) && mode == INPUT_PULLUP) pinLevels[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < sizeof(pinLevels)) pinLevels[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) { return pin < sizeof(pinLevels) ? pinLevels[pin] : LOW; }
+
+int host_pin_level(uint8_t pin) { return digitalRead(pin); }
+
+static void (*pinHandlers[64])(void);
+static int pinModes[64];
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {
+    if (pin < sizeof(pinLevels)) {
+        pinHandlers[pin] = handler;
+        pinModes[pin] = mode;
+    }
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (pin < sizeof(pinLevels)) pinHandlers[pin] = nullptr;
+}
+
+// Внешний сигнал: как у GPIO, обработчик срабатывает на фронт, заданный attachInterrupt
+void host_pin_set(uint8_t pin, int level) {
+    if (pin >= sizeof(pinLevels)) return;
+    int before = pinLevels[pin];
+    pinLevels[pin] = level ? HIGH : LOW;
+    if (!pinHandlers[pin] || before == pinLevels[pin]) return;
+    int edge = pinLevels[pin] ? RISING : FALLING;
+    if (pinModes[pin] == CHANGE || pinModes[pin] == edge) pinHandlers[pin]();
+}
+
+// === STRING ===
+static std::string format_integer(unsigned long long value, bool negative, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    char buf[72];
+    size_t pos = sizeof(buf);
+    buf[--pos] = '\0';
+    do {
+        unsigned digit = value % base;
+        buf[--pos] = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+        value /= base;
+    } while (value);
+    if (negative) buf[--pos] = '-';
+    return std::string(buf + pos);
+}
+
+String::String(int value, unsigned char base) : String((long)value, base) {}
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+String::String(long value, unsigned char base)
+    : _s(base == 10 && value < 0 ? format_integer(-(unsigned long long)value, true, base)
+                                 : format_integer((unsigned long)value, false, base)) {}
+String::String(unsigned long value, unsigned char base) : _s(format_integer(value, false, base)) {}
+String::String(float value, unsigned int decimals) : String((double)value, decimals) {}
+String::String(double value, unsigned int decimals) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+    _s = buf;
+}
+
+bool String::equalsIgnoreCase(const String& other) const {
+    if (_s.size() != other._s.size()) return false;
+    for (size_t i = 0; i < _s.size(); i++) {
+        if (tolower((unsigned char)_s[i]) != tolower((unsigned char)other._s[i])) return false;
+    }
+    return true;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return _s.size() >= suffix._s.size() &&
+           _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t pos = _s.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& text, unsigned int from) const {
+    size_t pos = _s.find(text._s, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _s.size()) return String();
+    return String(_s.substr(from, std::min<size_t>(to, _s.size()) - from));
+}
+
+void String::toLowerCase() {
+    for (auto& c : _s) c = (char)tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+    for (auto& c : _s) c = (char)toupper((unsigned char)c);
+}
+
+void String::trim() {
+    size_t begin = _s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        _s.clear();
+        return;
+    }
+    size_t end = _s.find_last_not_of(" \t\r\n");
+    _s = _s.substr(begin, end - begin + 1);
+}
+
+String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+String operator+(const String& a, char b) { String r(a); r += b; return r; }
+
+// === PRINT ===
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        if (!write(*buffer++)) break;
+        n++;
+    }
+    return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char small[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(small, sizeof(small), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+    if ((size_t)length < sizeof(small)) return write((const uint8_t*)small, length);
+
+    std::string big(length + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&big[0], big.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)big.data(), length);
+}
+
+size_t Print::print(long value, int base) {
+    return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long value, int base) {
+    return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(double value, int digits) {
+    return print(String(value, (unsigned int)digits));
+}
+
+// === SERIAL ===
+#define HOST_SERIAL_KEEP (1024 * 1024)  // Больше - отбрасываем начало
+
+static std::string serialOutput;
+static int serialEcho = -1;
+
+std::string& host_serial_output() { return serialOutput; }
+void host_serial_clear() { serialOutput.clear(); }
+
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (serialEcho < 0) {
+        const char* env = getenv("HOST_SERIAL");
+        serialEcho = env && env[0] == '1';
+    }
+    if (serialEcho) fwrite(buffer, 1, size, stdout);
+    HostDeviceScope console(false);  // Копия вывода для теста - не память устройства
+    if (serialOutput.size() + size > HOST_SERIAL_KEEP) serialOutput.erase(0, serialOutput.size() / 2);
+    serialOutput.append((const char*)buffer, size);
+    return size;
+}
+
+// === МОДЕЛЬ HEAP ===
+// Каждое выделение через new получает заголовок с размером и признаком "устройство",
+// чтобы delete из любого контекста вычитал ровно то, что было учтено
+struct alignas(16) AllocHeader {
+    size_t size;
+    bool device;
+};
+
+static uint32_t heapSize = 160 * 1024;  // Свободный heap C3 после WiFi и буфера потока - порядок величины
+static uint64_t heapInUse = 0;
+static uint64_t heapPeak = 0;
+static bool deviceContext = false;
+
+void host_heap_set_size(uint32_t bytes) { heapSize = bytes; }
+uint32_t host_heap_in_use() { return (uint32_t)heapInUse; }
+uint32_t host_heap_peak() { return (uint32_t)heapPeak; }
+void host_heap_reset_min() { heapPeak = heapInUse; }
+
+HostDeviceScope::HostDeviceScope(bool device) : _previous(deviceContext) { deviceContext = device; }
+HostDeviceScope::~HostDeviceScope() { deviceContext = _previous; }
+
+static void* tracked_alloc(size_t size) {
+    AllocHeader* header = (AllocHeader*)malloc(sizeof(AllocHeader) + size);
+    if (!header) throw std::bad_alloc();
+    header->size = size;
+    header->device = deviceContext;
+    if (header->device) {
+        heapInUse += size;
+        if (heapInUse > heapPeak) heapPeak = heapInUse;
+    }
+    return header + 1;
+}
+
+static void tracked_free(void* p) {
+    if (!p) return;
+    AllocHeader* header = (AllocHeader*)p - 1;
+    if (header->device) heapInUse -= header->size;
+    free(header);
+}
+
+void* operator new(size_t size) { return tracked_alloc(size); }
+void* operator new[](size_t size) { return tracked_alloc(size); }
+void operator delete(void* p) noexcept { tracked_free(p); }
+void operator delete[](void* p) noexcept { tracked_free(p); }
+void operator delete(void* p, size_t) noexcept { tracked_free(p); }
+void operator delete[](void* p, size_t) noexcept { tracked_free(p); }
+
+EspClass ESP;
+
+uint32_t EspClass::getFreeHeap() {
+    return heapInUse >= heapSize ? 0 : heapSize - (uint32_t)heapInUse;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    return heapPeak >= heapSize ? 0 : heapSize - (uint32_t)heapPeak;
+}
+
+// Фрагментация не моделируется: наибольший блок - весь свободный heap
+uint32_t EspClass::getMaxAllocHeap() { return getFreeHeap(); }
+uint32_t EspClass::getHeapSize() { return heapSize; }
+
+void EspClass::restart() {
+    Serial.println("[host] ESP.restart()");
+}
+
+// === СБРОС И СОН ===
+#include <esp_sleep.h>
+
+static esp_reset_reason_t resetReason = ESP_RST_POWERON;
+static bool deepSleeping = false;
+
+esp_reset_reason_t esp_reset_reason() { return resetReason; }
+void host_set_reset_reason(esp_reset_reason_t reason) { resetReason = reason; }
+bool host_deep_sleeping() { return deepSleeping; }
+
+esp_err_t esp_deep_sleep_enable_gpio_wakeup(uint64_t gpioPinMask, esp_deepsleep_gpio_wake_up_mode_t mode) {
+    return ESP_OK;
+}
+
+void esp_deep_sleep_start() {
+    deepSleeping = true;
+    Serial.println("[host] esp_deep_sleep_start()");
+}
+
+// === FREERTOS ===
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    if (!semaphore) return pdFALSE;
+    if (semaphore->taken) {
+        fprintf(stderr, "[host] xSemaphoreTake: мьютекс уже захвачен (взаимоблокировка на устройстве)\n");
+        abort();
+    }
+    semaphore->taken = true;
+    semaphore->takes++;
+    host_lock_enter();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    if (!semaphore || !semaphore->taken) return pdFALSE;
+    semaphore->taken = false;
+    host_lock_exit();
+    return pdTRUE;
+}
+
+struct HostQueue {
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    std::vector<uint8_t> items;   // Кольцо length * itemSize
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    HostQueue* queue = new HostQueue{length, itemSize, {}, 0, 0};
+    queue->items.resize((size_t)length * itemSize);
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    if (!queue || queue->count >= queue->length) return pdFALSE;
+    UBaseType_t slot = (queue->head + queue->count) % queue->length;
+    memcpy(&queue->items[(size_t)slot * queue->itemSize], item, queue->itemSize);
+    queue->count++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    if (!queue || queue->count == 0) return pdFALSE;
+    memcpy(item, &queue->items[(size_t)queue->head * queue->itemSize], queue->itemSize);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) { return queue ? queue->count : 0; }
@@ -0,0 +1,1434 @@
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include "host_env.h"
+#include "host_net.h"
+
+// === СОБЫТИЯ СЕТИ ===
+// Одна очередь на все: ACK и данные для прошивки (задача AsyncTCP) и доставка
+// байт клиентам теста. Порядок - по сроку, при равном сроке - по порядку постановки.
+// Выполняются из host_time_advance (host_env.h): событие прошивки вытесняет loop(),
+// время, которое оно тратит, сдвигает loop() на столько же
+namespace {
+
+struct NetEvent {
+    bool device;                  // Код прошивки: new/delete учитываются в heap
+    std::function<void()> fn;
+};
+
+class NetQueue : public HostPreemptor {
+public:
+    uint64_t nextDueUs() override { return _events.empty() ? UINT64_MAX : _events.begin()->first.first; }
+
+    void runNext() override {
+        auto it = _events.begin();
+        NetEvent event = std::move(it->second);
+        _events.erase(it);
+        HostDeviceScope scope(event.device);
+        event.fn();
+    }
+
+    // Лямбда превращается в std::function уже вне учета heap устройства
+    template <typename F>
+    void post(uint64_t due, bool device, F&& fn) {
+        HostDeviceScope scope(false);
+        _events.emplace(std::make_pair(due, _seq++), NetEvent{device, std::function<void()>(std::forward<F>(fn))});
+    }
+
+private:
+    std::multimap<std::pair<uint64_t, uint64_t>, NetEvent> _events;
+    uint64_t _seq = 0;
+};
+
+NetQueue& net_queue() {
+    static NetQueue* queue = nullptr;
+    if (!queue) {
+        HostDeviceScope scope(false);
+        queue = new NetQueue();
+        host_set_preemptor(queue);
+    }
+    return *queue;
+}
+
+uint64_t downlinkFreeAt = 0;   // Канал WiFi к клиентам занят до
+uint64_t uplinkFreeAt = 0;
+AsyncWebServer* listeningServer = nullptr;
+
+// Вызов библиотеки из loop(): события ждут его окончания. На устройстве задача AsyncTCP
+// может вклиниться и посреди, но гонки внутри библиотеки - не то, что проверяют тесты
+class LibraryCall {
+public:
+    LibraryCall() { host_lock_enter(); }
+    ~LibraryCall() { host_lock_exit(); }
+};
+
+uint64_t transfer_us(size_t bytes) {
+    return (uint64_t)bytes * 1000000ULL / host_net_model().linkBytesPerSecond;
+}
+
+}  // namespace
+
+HostNetModel& host_net_model() {
+    static HostNetModel model;
+    return model;
+}
+
+// === СОЕДИНЕНИЕ TCP ===
+struct HostPeer {
+    virtual ~HostPeer() {}
+    virtual void received(const std::string& bytes) = 0;
+    virtual void closed() = 0;
+
+    std::shared_ptr<HostTcpState> tcp;
+};
+
+struct HostTcpState {
+    AsyncClient* client = nullptr;      // Сторона прошивки (nullptr - еще не принято или удалено)
+    std::weak_ptr<HostPeer> peer;
+    bool accepted = false;
+    bool deviceOpen = true;
+    bool peerOpen = true;
+    size_t unacked = 0;                 // Записано прошивкой, ACK еще не пришел
+    size_t segments = 0;
+    size_t ackPending = 0;              // Доставлено с последнего ACK
+    std::deque<std::pair<uint8_t*, size_t>> blocks;   // Копии данных в heap устройства до ACK
+    size_t frontAcked = 0;
+};
+
+// Данные прошивки уходят клиенту сегментами по общему каналу; ACK - через сегмент
+// и в конце записи, через RTT после отправки сегмента
+static void net_transmit(const std::shared_ptr<HostTcpState>& state, const char* data, size_t len) {
+    HostDeviceScope scope(false);
+    HostNetModel& model = host_net_model();
+    uint64_t now = host_time_us();
+    for (size_t offset = 0; offset < len;) {
+        size_t segment = std::min((size_t)TCP_MSS, len - offset);
+        uint64_t done = std::max(now, downlinkFreeAt) + transfer_us(segment);
+        downlinkFreeAt = done;
+        std::weak_ptr<HostPeer> peer = state->peer;
+        std::string payload(data + offset, segment);
+        net_queue().post(done + model.rttUs / 2, false, [peer, payload]() {
+            if (std::shared_ptr<HostPeer> p = peer.lock()) p->received(payload);
+        });
+        offset += segment;
+        state->ackPending += segment;
+        if (++state->segments % 2 == 0 || offset == len) {
+            size_t acked = state->ackPending;
+            state->ackPending = 0;
+            std::shared_ptr<HostTcpState> s = state;
+            net_queue().post(done + model.rttUs, true, [s, acked]() {
+                host_time_advance(host_net_model().ackCpuUs);
+                s->unacked -= acked;
+                for (size_t left = acked; left > 0 && !s->blocks.empty();) {
+                    size_t take = std::min(left, s->blocks.front().second - s->frontAcked);
+                    s->frontAcked += take;
+                    left -= take;
+                    if (s->frontAcked == s->blocks.front().second) {
+                        delete[] s->blocks.front().first;
+                        s->blocks.pop_front();
+                        s->frontAcked = 0;
+                    }
+                }
+                if (s->client && s->deviceOpen) s->client->hostAcked(acked);
+            });
+        }
+    }
+}
+
+// Клиент узнает о закрытии после всех данных, уже стоящих в канале
+static void net_notify_peer_closed(const std::shared_ptr<HostTcpState>& state) {
+    std::weak_ptr<HostPeer> peer = state->peer;
+    uint64_t at = std::max(host_time_us(), downlinkFreeAt) + host_net_model().rttUs / 2;
+    net_queue().post(at, false, [peer]() {
+        if (std::shared_ptr<HostPeer> p = peer.lock()) p->closed();
+    });
+}
+
+// Закрытие со стороны клиента: прошивка получает FIN
+static void net_peer_closed(const std::shared_ptr<HostTcpState>& state) {
+    if (!state->peerOpen) return;
+    state->peerOpen = false;
+    if (!state->deviceOpen) return;
+    state->deviceOpen = false;
+    if (state->client) state->client->hostDisconnected();
+}
+
+// Байты клиента приходят прошивке событием на каждый сегмент. Первый сегмент
+// принимает соединение: AsyncServer создает AsyncClient и запрос сервера
+static void net_send_to_device(const std::shared_ptr<HostTcpState>& state, const std::string& bytes, uint64_t start) {
+    HostDeviceScope scope(false);
+    HostNetModel& model = host_net_model();
+    for (size_t offset = 0; offset < bytes.size();) {
+        size_t segment = std::min((size_t)TCP_MSS, bytes.size() - offset);
+        uint64_t done = std::max(start, uplinkFreeAt) + transfer_us(segment);
+        uplinkFreeAt = done;
+        std::string payload = bytes.substr(offset, segment);
+        std::shared_ptr<HostTcpState> s = state;
+        net_queue().post(done + model.rttUs / 2, true, [s, payload]() {
+            if (!s->deviceOpen) return;
+            if (!s->accepted) {
+                s->accepted = true;
+                if (!listeningServer) {
+                    s->deviceOpen = false;
+                    net_notify_peer_closed(s);
+                    return;
+                }
+                AsyncClient* client = new AsyncClient(s);
+                new AsyncWebServerRequest(listeningServer, client);
+            }
+            if (s->client) s->client->hostReceived((const uint8_t*)payload.data(), payload.size());
+        });
+        offset += segment;
+    }
+}
+
+// Соединение клиента: SYN/SYN-ACK - один RTT до первых данных
+static std::shared_ptr<HostTcpState> net_connect(const std::shared_ptr<HostPeer>& peer, const std::string& request) {
+    HostDeviceScope scope(false);
+    net_queue();
+    std::shared_ptr<HostTcpState> state = std::make_shared<HostTcpState>();
+    state->peer = peer;
+    peer->tcp = state;
+    net_send_to_device(state, request, host_time_us() + host_net_model().rttUs);
+    return state;
+}
+
+static void net_peer_close(const std::shared_ptr<HostTcpState>& state) {
+    if (!state) return;
+    HostDeviceScope scope(false);
+    std::shared_ptr<HostTcpState> s = state;
+    net_queue().post(host_time_us() + host_net_model().rttUs / 2, true, [s]() { net_peer_closed(s); });
+}
+
+// --- AsyncClient ---
+AsyncClient::AsyncClient(std::shared_ptr<HostTcpState> state) : _state(state) { _state->client = this; }
+
+AsyncClient::~AsyncClient() {
+    _state->client = nullptr;
+    if (_state->deviceOpen) {
+        _state->deviceOpen = false;
+        net_notify_peer_closed(_state);
+    }
+}
+
+size_t AsyncClient::space() const { return connected() ? TCP_SND_BUF - _state->unacked : 0; }
+bool AsyncClient::connected() const { return _state->deviceOpen && _state->peerOpen; }
+
+// Как tcp_write с копированием: данные лежат в heap, пока их не подтвердят
+size_t AsyncClient::write(const char* data, size_t len) {
+    size_t n = std::min(len, space());
+    if (n == 0) return 0;
+    uint8_t* copy = new uint8_t[n];
+    memcpy(copy, data, n);
+    _state->blocks.push_back(std::make_pair(copy, n));
+    _state->unacked += n;
+    net_transmit(_state, data, n);
+    HostNetModel& model = host_net_model();
+    host_time_advance(model.writeCallUs + (uint64_t)n * model.writeNsPerByte / 1000);
+    return n;
+}
+
+// onDisconnect - событием: обработчик удаляет и этот объект, и своего владельца
+void AsyncClient::close(bool now) {
+    if (!_state->deviceOpen) return;
+    _state->deviceOpen = false;
+    net_notify_peer_closed(_state);
+    std::shared_ptr<HostTcpState> s = _state;
+    net_queue().post(host_time_us(), true, [s]() {
+        if (s->client) s->client->hostDisconnected();
+    });
+}
+
+void AsyncClient::onAck(AcAckHandler cb, void* arg) {
+    _ackCb = cb;
+    _ackArg = arg;
+}
+
+void AsyncClient::onDisconnect(AcConnectHandler cb, void* arg) {
+    _disconnectCb = cb;
+    _disconnectArg = arg;
+}
+
+void AsyncClient::onData(AcDataHandler cb, void* arg) {
+    _dataCb = cb;
+    _dataArg = arg;
+}
+
+void AsyncClient::hostAcked(size_t len) {
+    if (_ackCb) _ackCb(_ackArg, this, len, host_net_model().rttUs / 1000);
+}
+
+void AsyncClient::hostReceived(const uint8_t* data, size_t len) {
+    if (_dataCb) _dataCb(_dataArg, this, (void*)data, len);
+}
+
+void AsyncClient::hostPeerClosed() { net_peer_closed(_state); }
+
+void AsyncClient::hostDisconnected() {
+    if (_disconnectFired) return;
+    _disconnectFired = true;
+    if (_disconnectCb) _disconnectCb(_disconnectArg, this);   // Может удалить this
+}
+
+// === ЗАПРОС ===
+static String url_decode(const std::string& text) {
+    std::string out;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '+') {
+            out += ' ';
+        } else if (text[i] == '%' && i + 2 < text.size()) {
+            out += (char)strtol(text.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        } else {
+            out += text[i];
+        }
+    }
+    return String(out);
+}
+
+AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer* server, AsyncClient* client)
+    : _client(client), _server(server) {
+    client->onAck([](void* r, AsyncClient* c, size_t len, uint32_t time) {
+        ((AsyncWebServerRequest*)r)->_onAck(len, time);
+    }, this);
+    client->onDisconnect([](void* r, AsyncClient* c) {
+        ((AsyncWebServerRequest*)r)->_onDisconnect();
+        delete c;
+    }, this);
+    client->onData([](void* r, AsyncClient* c, void* data, size_t len) {
+        ((AsyncWebServerRequest*)r)->_onData((const uint8_t*)data, len);
+    }, this);
+}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+    if (_destroyed) *_destroyed = true;
+    for (AsyncWebHeader* h : _headers) delete h;
+    for (AsyncWebParameter* p : _params) delete p;
+    delete _response;
+    delete[] (uint8_t*)_tempObject;
+}
+
+AsyncWebHeader* AsyncWebServerRequest::getHeader(const String& name) const {
+    for (AsyncWebHeader* h : _headers) {
+        if (h->name().equalsIgnoreCase(name)) return h;
+    }
+    return nullptr;
+}
+
+const String& AsyncWebServerRequest::header(const char* name) const {
+    static const String empty;
+    AsyncWebHeader* h = getHeader(name);
+    return h ? h->value() : empty;
+}
+
+AsyncWebParameter* AsyncWebServerRequest::getParam(const String& name, bool post) const {
+    for (AsyncWebParameter* p : _params) {
+        if (p->name() == name && p->isPost() == post) return p;
+    }
+    return nullptr;
+}
+
+void AsyncWebServerRequest::_parseForm(const std::string& body) {
+    size_t start = 0;
+    while (start < body.size()) {
+        size_t end = body.find('&', start);
+        if (end == std::string::npos) end = body.size();
+        std::string pair = body.substr(start, end - start);
+        size_t eq = pair.find('=');
+        if (!pair.empty()) {
+            _params.push_back(new AsyncWebParameter(url_decode(pair.substr(0, eq)),
+                                                    eq == std::string::npos ? String() : url_decode(pair.substr(eq + 1)),
+                                                    _parseState != PARSE_REQ_HEADERS));
+        }
+        start = end + 1;
+    }
+}
+
+bool AsyncWebServerRequest::_parseHead(const std::string& head) {
+    size_t lineEnd = head.find("\r\n");
+    std::string line = head.substr(0, lineEnd);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = line.find(' ', sp1 + 1);
+    if (sp1 == std::string::npos || sp2 == std::string::npos) return false;
+    std::string method = line.substr(0, sp1);
+    std::string url = line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+    if (method == "GET") _method = HTTP_GET;
+    else if (method == "POST") _method = HTTP_POST;
+    else if (method == "DELETE") _method = HTTP_DELETE;
+    else if (method == "PUT") _method = HTTP_PUT;
+    else if (method == "PATCH") _method = HTTP_PATCH;
+    else if (method == "HEAD") _method = HTTP_HEAD;
+    else if (method == "OPTIONS") _method = HTTP_OPTIONS;
+    else return false;
+
+    size_t query = url.find('?');
+    _url = url_decode(url.substr(0, query));
+    if (query != std::string::npos) _parseForm(url.substr(query + 1));
+
+    size_t pos = lineEnd + 2;
+    while (pos < head.size()) {
+        size_t end = head.find("\r\n", pos);
+        if (end == std::string::npos) end = head.size();
+        std::string h = head.substr(pos, end - pos);
+        pos = end + 2;
+        size_t colon = h.find(':');
+        if (colon == std::string::npos) continue;
+        String name(h.substr(0, colon));
+        String value(h.substr(colon + 1));
+        value.trim();
+        if (name.equalsIgnoreCase("Content-Type")) {
+            int semicolon = value.indexOf(';');
+            _contentType = semicolon < 0 ? value : value.substring(0, semicolon);
+        } else if (name.equalsIgnoreCase("Content-Length")) {
+            _contentLength = strtoul(value.c_str(), nullptr, 10);
+        }
+        _headers.push_back(new AsyncWebHeader(name, value));
+    }
+    return true;
+}
+
+void AsyncWebServerRequest::_endBody() {
+    _parseState = PARSE_REQ_END;
+    if (_isPlainPost) _parseForm(_temp);
+    _temp.clear();
+    if (_handler) _handler->handleRequest(this);
+    else send(501);
+}
+
+void AsyncWebServerRequest::_onData(const uint8_t* data, size_t len) {
+    if (_parseState == PARSE_REQ_HEADERS) {
+        _temp.append((const char*)data, len);
+        size_t end = _temp.find("\r\n\r\n");
+        if (end == std::string::npos) return;
+        std::string body = _temp.substr(end + 4);
+        _temp.erase(end);
+        host_time_advance(host_net_model().requestCpuUs);
+        if (!_parseHead(_temp)) {
+            _temp.clear();
+            send(400);
+            return;
+        }
+        _temp.clear();
+        _server->_attachHandler(this);
+        if (_contentLength == 0) {
+            _endBody();
+            return;
+        }
+        _parseState = PARSE_REQ_BODY;
+        _isPlainPost = _contentType.startsWith("application/x-www-form-urlencoded");
+        if (body.empty()) return;
+        _onData((const uint8_t*)body.data(), body.size());
+        return;
+    }
+    if (_parseState != PARSE_REQ_BODY) return;
+
+    size_t n = std::min(len, _contentLength - _parsedLength);
+    if (_isPlainPost) {
+        _temp.append((const char*)data, n);
+    } else if (_handler) {
+        _handler->handleBody(this, (uint8_t*)data, n, _parsedLength, _contentLength);
+    }
+    _parsedLength += n;
+    if (_parsedLength == _contentLength) _endBody();
+}
+
+void AsyncWebServerRequest::_onAck(size_t len, uint32_t time) {
+    if (!_response) return;
+    bool destroyed = false;
+    _destroyed = &destroyed;
+    if (!_response->_finished()) _response->_ack(this, len, time);
+    if (destroyed) return;   // Ответ upgrade передал соединение клиенту WebSocket/SSE
+    _destroyed = nullptr;
+    // Ответ отдан и подтвержден: "Connection: close"
+    if (_response && _response->_finished()) {
+        delete _response;
+        _response = nullptr;
+        if (_client) _client->close();
+    }
+}
+
+void AsyncWebServerRequest::_onDisconnect() {
+    if (_onDisconnectfn) _onDisconnectfn();
+    _server->_handleDisconnect(this);
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* response) {
+    if (_response) {
+        delete response;
+        return;
+    }
+    _response = response;
+    if (!_response) {
+        _client->close(true);
+        return;
+    }
+    if (!_response->_sourceValid()) {
+        delete response;
+        _response = nullptr;
+        send(500);
+        return;
+    }
+    _response->_respond(this);
+}
+
+void AsyncWebServerRequest::send(int code, const String& contentType, const String& content) {
+    send(beginResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::redirect(const String& url) {
+    AsyncWebServerResponse* response = beginResponse(302);
+    response->addHeader("Location", url);
+    send(response);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(int code, const String& contentType, const String& content) {
+    return new AsyncBasicResponse(code, contentType, content);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse_P(int code, const String& contentType,
+                                                               const uint8_t* content, size_t len) {
+    return new AsyncProgmemResponse(code, contentType, content, len);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginChunkedResponse(const String& contentType,
+                                                                    AwsResponseFiller callback) {
+    return new AsyncChunkedResponse(contentType, callback);
+}
+
+AsyncResponseStream* AsyncWebServerRequest::beginResponseStream(const String& contentType, size_t bufferSize) {
+    return new AsyncResponseStream(contentType, bufferSize);
+}
+
+// === ОТВЕТЫ ===
+AsyncWebServerResponse::AsyncWebServerResponse() {}
+
+const char* AsyncWebServerResponse::responseCodeToString(int code) {
+    switch (code) {
+        case 101: return "Switching Protocols";
+        case 200: return "OK";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 302: return "Found";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 404: return "Not Found";
+        case 409: return "Conflict";
+        case 413: return "Request Entity Too Large";
+        case 416: return "Requested range not satisfiable";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default:  return "";
+    }
+}
+
+String AsyncWebServerResponse::_assembleHead(uint8_t version) {
+    if (_chunked) addHeader("Transfer-Encoding", "chunked");
+    String out;
+    char buf[300];
+    snprintf(buf, sizeof(buf), "HTTP/1.%d %d %s\r\n", version, _code, responseCodeToString(_code));
+    out += buf;
+    if (_sendContentLength) {
+        snprintf(buf, sizeof(buf), "Content-Length: %u\r\n", (unsigned)_contentLength);
+        out += buf;
+    }
+    if (_contentType.length()) out += "Content-Type: " + _contentType + "\r\n";
+    for (const AsyncWebHeader& h : _headers) out += h.toString();
+    _headers.clear();
+    out += "\r\n";
+    _headLength = out.length();
+    return out;
+}
+
+void AsyncWebServerResponse::_respond(AsyncWebServerRequest* request) {
+    _state = RESPONSE_END;
+    request->client()->close();
+}
+
+size_t AsyncWebServerResponse::_ack(AsyncWebServerRequest* request, size_t len, uint32_t time) { return 0; }
+
+// --- Ответ из String: заголовок и тело пишутся, сколько влезет, остальное - по ACK ---
+AsyncBasicResponse::AsyncBasicResponse(int code, const String& contentType, const String& content) {
+    _code = code;
+    _content = content;
+    _contentType = contentType;
+    if (_content.length()) {
+        _contentLength = _content.length();
+        if (!_contentType.length()) _contentType = "text/plain";
+    }
+    addHeader("Connection", "close");
+}
+
+void AsyncBasicResponse::_respond(AsyncWebServerRequest* request) {
+    _state = RESPONSE_HEADERS;
+    _content = _assembleHead(1) + _content;
+    _state = RESPONSE_CONTENT;
+    _ack(request, 0, 0);
+}
+
+size_t AsyncBasicResponse::_ack(AsyncWebServerRequest* request, size_t len, uint32_t time) {
+    _ackedLength += len;
+    if (_state == RESPONSE_CONTENT) {
+        size_t available = _content.length() - _sentLength;
+        size_t n = std::min(available, request->client()->space());
+        if (n > 0) {
+            size_t written = request->client()->write(_content.c_str() + _sentLength, n);
+            _sentLength += written;
+            _writtenLength += written;
+        }
+        if (_sentLength == _content.length()) _state = RESPONSE_WAIT_ACK;
+        return n;
+    }
+    if (_state == RESPONSE_WAIT_ACK && _ackedLength >= _writtenLength) _state = RESPONSE_END;
+    return 0;
+}
+
+// --- Ответ, который читает тело кусками: один кусок на ACK ---
+void AsyncAbstractResponse::_respond(AsyncWebServerRequest* request) {
+    addHeader("Connection", "close");
+    _head = _assembleHead(1);
+    _state = RESPONSE_HEADERS;
+    _ack(request, 0, 0);
+}
+
+size_t AsyncAbstractResponse::_ack(AsyncWebServerRequest* request, size_t len, uint32_t time) {
+    if (!_sourceValid()) {
+        _state = RESPONSE_FAILED;
+        request->client()->close();
+        return 0;
+    }
+    _ackedLength += len;
+    size_t space = request->client()->space();
+    size_t headLen = _head.length();
+    if (_state == RESPONSE_HEADERS) {
+        if (space >= headLen) {
+            _state = RESPONSE_CONTENT;
+            space -= headLen;
+        } else {
+            String out = _head.substring(0, space);
+            _head = _head.substring(space);
+            _writtenLength += request->client()->write(out.c_str(), out.length());
+            return out.length();
+        }
+    }
+
+    if (_state == RESPONSE_CONTENT) {
+        size_t outLen;
+        if (_chunked) {
+            if (space <= 8) return 0;
+            outLen = space;
+        } else if (!_sendContentLength) {
+            outLen = space;
+        } else {
+            outLen = std::min(_contentLength - _sentLength, space);
+        }
+
+        // Буфер куска - в heap, как malloc в библиотеке
+        uint8_t* buf = new uint8_t[outLen + headLen];
+        if (headLen) memcpy(buf, _head.c_str(), headLen);
+        size_t readLen;
+        if (_chunked) {
+            readLen = _fillBuffer(buf + headLen + 6, outLen - 8);
+            if (readLen == RESPONSE_TRY_AGAIN) {
+                delete[] buf;
+                return 0;
+            }
+            outLen = sprintf((char*)buf + headLen, "%x", (unsigned)readLen) + headLen;
+            while (outLen < headLen + 4) buf[outLen++] = ' ';
+            buf[outLen++] = '\r';
+            buf[outLen++] = '\n';
+            outLen += readLen;
+            buf[outLen++] = '\r';
+            buf[outLen++] = '\n';
+        } else {
+            readLen = _fillBuffer(buf + headLen, outLen);
+            if (readLen == RESPONSE_TRY_AGAIN) {
+                delete[] buf;
+                return 0;
+            }
+            outLen = readLen + headLen;
+        }
+        if (headLen) _head = String();
+        if (outLen) _writtenLength += request->client()->write((const char*)buf, outLen);
+        _sentLength += _chunked ? readLen : outLen - headLen;
+        delete[] buf;
+
+        if ((_chunked && readLen == 0) || (!_sendContentLength && outLen == 0) ||
+            (!_chunked && _sentLength == _contentLength)) {
+            _state = RESPONSE_WAIT_ACK;
+        }
+        return outLen;
+    }
+
+    if (_state == RESPONSE_WAIT_ACK && (!_sendContentLength || _ackedLength >= _writtenLength)) {
+        _state = RESPONSE_END;
+    }
+    return 0;
+}
+
+AsyncProgmemResponse::AsyncProgmemResponse(int code, const String& contentType, const uint8_t* content, size_t len)
+    : _content(content) {
+    _code = code;
+    _contentType = contentType;
+    _contentLength = len;
+}
+
+size_t AsyncProgmemResponse::_fillBuffer(uint8_t* buf, size_t maxLen) {
+    size_t left = std::min(maxLen, _contentLength - _readLength);
+    memcpy(buf, _content + _readLength, left);
+    _readLength += left;
+    return left;
+}
+
+AsyncChunkedResponse::AsyncChunkedResponse(const String& contentType, AwsResponseFiller callback)
+    : _content(callback) {
+    _code = 200;
+    _contentType = contentType;
+    _sendContentLength = false;
+    _chunked = true;
+}
+
+size_t AsyncChunkedResponse::_fillBuffer(uint8_t* buf, size_t maxLen) {
+    size_t ret = _content(buf, maxLen, _filledLength);
+    if (ret != RESPONSE_TRY_AGAIN) _filledLength += ret;
+    return ret;
+}
+
+AsyncResponseStream::AsyncResponseStream(const String& contentType, size_t bufferSize) {
+    _code = 200;
+    _contentType = contentType;
+    _content.reserve(bufferSize);
+}
+
+size_t AsyncResponseStream::write(const uint8_t* data, size_t len) {
+    if (_started()) return 0;
+    _content.append((const char*)data, len);
+    _contentLength += len;
+    return len;
+}
+
+size_t AsyncResponseStream::_fillBuffer(uint8_t* buf, size_t maxLen) {
+    size_t n = std::min(maxLen, _content.size() - _readPosition);
+    memcpy(buf, _content.data() + _readPosition, n);
+    _readPosition += n;
+    return n;
+}
+
+// === ОБРАБОТЧИКИ ===
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest* request) {
+    if (!_onRequest || !(_method & request->method())) return false;
+    if (_uri.length() && _uri.endsWith("*")) {
+        return request->url().startsWith(_uri.substring(0, _uri.length() - 1));
+    }
+    return !_uri.length() || _uri == request->url() || request->url().startsWith(_uri + "/");
+}
+
+void AsyncCallbackWebHandler::handleRequest(AsyncWebServerRequest* request) {
+    if (_onRequest) _onRequest(request);
+    else request->send(500);
+}
+
+// Страницы прошивка отдает своими маршрутами: файлы через serveStatic тесты не запрашивают
+bool AsyncStaticWebHandler::canHandle(AsyncWebServerRequest* request) { return false; }
+
+void AsyncStaticWebHandler::handleRequest(AsyncWebServerRequest* request) { request->send(404); }
+
+// === WEBSOCKET ===
+static std::vector<uint8_t> ws_frame(uint8_t opcode, const uint8_t* data, size_t len) {
+    std::vector<uint8_t> frame;
+    frame.reserve(len + 4);
+    frame.push_back(0x80 | opcode);
+    if (len < 126) {
+        frame.push_back((uint8_t)len);
+    } else {
+        frame.push_back(126);
+        frame.push_back((uint8_t)(len >> 8));
+        frame.push_back((uint8_t)len);
+    }
+    frame.insert(frame.end(), data, data + len);
+    return frame;
+}
+
+AsyncWebSocketClient::AsyncWebSocketClient(AsyncWebServerRequest* request, AsyncWebSocket* server)
+    : _client(request->client()), _server(server), _clientId(server->_getNextId()), _status(WS_CONNECTED) {
+    _client->onAck([](void* r, AsyncClient* c, size_t len, uint32_t time) {
+        ((AsyncWebSocketClient*)r)->_onAck(len);
+    }, this);
+    _client->onDisconnect([](void* r, AsyncClient* c) {
+        ((AsyncWebSocketClient*)r)->_onDisconnect();
+        delete c;
+    }, this);
+    _client->onData([](void* r, AsyncClient* c, void* data, size_t len) {
+        ((AsyncWebSocketClient*)r)->_onData((const uint8_t*)data, len);
+    }, this);
+    _server->_addClient(this);
+    _server->_handleEvent(this, WS_EVT_CONNECT, request, nullptr, 0);
+    delete request;
+}
+
+AsyncWebSocketClient::~AsyncWebSocketClient() { _server->_handleEvent(this, WS_EVT_DISCONNECT, nullptr, nullptr, 0); }
+
+void AsyncWebSocketClient::close(uint16_t code, const char* message) {
+    LibraryCall call;
+    if (_status != WS_CONNECTED) return;
+    uint8_t payload[2] = {(uint8_t)(code >> 8), (uint8_t)code};
+    _status = WS_DISCONNECTING;
+    _queueControl(WS_DISCONNECT, payload, code ? 2 : 0);
+}
+
+// Очередь полна - соединение закрывается (медленный клиент не копит память)
+void AsyncWebSocketClient::_queueMessage(uint8_t opcode, const uint8_t* data, size_t len) {
+    LibraryCall call;
+    if (_status != WS_CONNECTED) return;
+    if (_messageQueue.size() >= WS_MAX_QUEUED_MESSAGES) {
+        _status = WS_DISCONNECTED;
+        _client->close(true);
+        return;
+    }
+    _messageQueue.push_back(Message{opcode, ws_frame(opcode, data, len), false, 0});
+    if (_client->canSend()) _runQueue();
+}
+
+void AsyncWebSocketClient::_queueControl(uint8_t opcode, const uint8_t* data, size_t len) {
+    _controlQueue.push_back(Message{opcode, ws_frame(opcode, data, len), false, 0});
+    if (_client->canSend()) _runQueue();
+}
+
+// В полете одно сообщение: следующее уходит после ACK предыдущего
+void AsyncWebSocketClient::_runQueue() {
+    while (!_messageQueue.empty() && _messageQueue.front().sent &&
+           _messageQueue.front().acked >= _messageQueue.front().frame.size()) {
+        _messageQueue.erase(_messageQueue.begin());
+    }
+    bool betweenFrames = _messageQueue.empty() || !_messageQueue.front().sent;
+    if (!_controlQueue.empty() && !_controlQueue.front().sent && betweenFrames &&
+        _client->space() >= _controlQueue.front().frame.size()) {
+        Message& control = _controlQueue.front();
+        control.sent = true;
+        _client->write((const char*)control.frame.data(), control.frame.size());
+    } else if (!_messageQueue.empty() && !_messageQueue.front().sent &&
+               _client->space() >= _messageQueue.front().frame.size()) {
+        Message& message = _messageQueue.front();
+        message.sent = true;
+        _client->write((const char*)message.frame.data(), message.frame.size());
+    }
+}
+
+void AsyncWebSocketClient::_onAck(size_t len) {
+    if (!_controlQueue.empty() && _controlQueue.front().sent) {
+        Message& control = _controlQueue.front();
+        size_t n = std::min(len, control.frame.size() - control.acked);
+        control.acked += n;
+        len -= n;
+        if (control.acked >= control.frame.size()) {
+            bool closing = _status == WS_DISCONNECTING && control.opcode == WS_DISCONNECT;
+            _controlQueue.erase(_controlQueue.begin());
+            if (closing) {
+                _status = WS_DISCONNECTED;
+                _client->close(true);
+                return;
+            }
+        }
+    }
+    if (len && !_messageQueue.empty() && _messageQueue.front().sent) _messageQueue.front().acked += len;
+    _runQueue();
+}
+
+// Кадры от клиента (маскированные, как из браузера)
+void AsyncWebSocketClient::_onData(const uint8_t* data, size_t len) {
+    _rxBuffer.append((const char*)data, len);
+    while (_rxBuffer.size() >= 2) {
+        const uint8_t* p = (const uint8_t*)_rxBuffer.data();
+        uint8_t opcode = p[0] & 0x0F;
+        bool masked = p[1] & 0x80;
+        size_t payloadLen = p[1] & 0x7F;
+        size_t header = 2;
+        if (payloadLen == 126) {
+            if (_rxBuffer.size() < 4) return;
+            payloadLen = (p[2] << 8) | p[3];
+            header = 4;
+        }
+        uint8_t mask[4] = {0, 0, 0, 0};
+        if (masked) {
+            if (_rxBuffer.size() < header + 4) return;
+            memcpy(mask, p + header, 4);
+            header += 4;
+        }
+        if (_rxBuffer.size() < header + payloadLen) return;
+        std::vector<uint8_t> payload(p + header, p + header + payloadLen);
+        for (size_t i = 0; i < payloadLen; i++) payload[i] ^= mask[i % 4];
+        _rxBuffer.erase(0, header + payloadLen);
+
+        host_time_advance(host_net_model().wsFrameCpuUs);
+        if (opcode == WS_DISCONNECT) {
+            if (_status == WS_DISCONNECTING) {
+                _status = WS_DISCONNECTED;
+                _client->close(true);
+            } else {
+                _status = WS_DISCONNECTING;
+                _queueControl(WS_DISCONNECT, payload.data(), std::min((size_t)2, payload.size()));
+            }
+            return;
+        }
+        if (opcode == WS_PING) {
+            _queueControl(WS_PONG, payload.data(), payload.size());
+            continue;
+        }
+        if (opcode == WS_PONG) {
+            _server->_handleEvent(this, WS_EVT_PONG, nullptr, payload.data(), payload.size());
+            continue;
+        }
+        AwsFrameInfo info = {};
+        info.message_opcode = opcode;
+        info.opcode = opcode;
+        info.final = 1;
+        info.masked = masked;
+        info.len = payloadLen;
+        memcpy(info.mask, mask, 4);
+        _server->_handleEvent(this, WS_EVT_DATA, &info, payload.data(), payload.size());
+        if (_status == WS_DISCONNECTED) return;
+    }
+}
+
+void AsyncWebSocketClient::_onDisconnect() {
+    _client = nullptr;
+    _server->_handleDisconnect(this);
+}
+
+// Статические объекты прошивки разрушаются при выходе из процесса: клиентов не трогаем
+AsyncWebSocket::~AsyncWebSocket() {}
+
+size_t AsyncWebSocket::count() const {
+    return std::count_if(_clients.begin(), _clients.end(),
+                         [](AsyncWebSocketClient* c) { return c->status() == WS_CONNECTED; });
+}
+
+AsyncWebSocketClient* AsyncWebSocket::client(uint32_t id) {
+    for (AsyncWebSocketClient* c : _clients) {
+        if (c->id() == id && c->status() == WS_CONNECTED) return c;
+    }
+    return nullptr;
+}
+
+void AsyncWebSocket::_handleDisconnect(AsyncWebSocketClient* client) {
+    _clients.erase(std::remove(_clients.begin(), _clients.end(), client), _clients.end());
+    delete client;
+}
+
+bool AsyncWebSocket::canHandle(AsyncWebServerRequest* request) {
+    if (request->method() != HTTP_GET || request->url() != _url) return false;
+    return request->header("Upgrade").equalsIgnoreCase("websocket");
+}
+
+void AsyncWebSocket::handleRequest(AsyncWebServerRequest* request) {
+    if (!request->hasHeader("Sec-WebSocket-Version") || !request->hasHeader("Sec-WebSocket-Key")) {
+        return request->send(400);
+    }
+    request->send(new AsyncWebSocketResponse(request->header("Sec-WebSocket-Key"), this));
+}
+
+// Sec-WebSocket-Accept на ПК не считается: клиент теста его не проверяет
+AsyncWebSocketResponse::AsyncWebSocketResponse(const String& key, AsyncWebSocket* server) : _server(server) {
+    _code = 101;
+    _sendContentLength = false;
+    addHeader("Connection", "Upgrade");
+    addHeader("Upgrade", "websocket");
+    addHeader("Sec-WebSocket-Accept", key);
+}
+
+void AsyncWebSocketResponse::_respond(AsyncWebServerRequest* request) {
+    String out = _assembleHead(1);
+    request->client()->write(out.c_str(), _headLength);
+    _state = RESPONSE_WAIT_ACK;
+}
+
+size_t AsyncWebSocketResponse::_ack(AsyncWebServerRequest* request, size_t len, uint32_t time) {
+    if (len) new AsyncWebSocketClient(request, _server);   // Удаляет запрос (и этот ответ)
+    return 0;
+}
+
+// === SSE ===
+static std::string sse_message(const char* message, const char* event, uint32_t id, uint32_t reconnect) {
+    std::string ev;
+    char buf[32];
+    if (reconnect) {
+        snprintf(buf, sizeof(buf), "retry: %lu\r\n", (unsigned long)reconnect);
+        ev += buf;
+    }
+    if (id) {
+        snprintf(buf, sizeof(buf), "id: %lu\r\n", (unsigned long)id);
+        ev += buf;
+    }
+    if (event) {
+        ev += "event: ";
+        ev += event;
+        ev += "\r\n";
+    }
+    if (message) {
+        const char* line = message;
+        while (true) {
+            size_t n = strcspn(line, "\r\n");
+            ev += "data: ";
+            ev.append(line, n);
+            ev += "\r\n";
+            line += n;
+            if (!*line) break;
+            if (line[0] == '\r' && line[1] == '\n') line++;
+            line++;
+        }
+    }
+    ev += "\r\n";
+    return ev;
+}
+
+AsyncEventSourceClient::AsyncEventSourceClient(AsyncWebServerRequest* request, AsyncEventSource* server)
+    : _client(request->client()), _server(server) {
+    _client->onAck([](void* r, AsyncClient* c, size_t len, uint32_t time) {
+        ((AsyncEventSourceClient*)r)->_onAck(len);
+    }, this);
+    _client->onDisconnect([](void* r, AsyncClient* c) {
+        ((AsyncEventSourceClient*)r)->_onDisconnect();
+        delete c;
+    }, this);
+    _client->onData(nullptr, nullptr);
+    _server->_addClient(this);
+    delete request;
+}
+
+AsyncEventSourceClient::~AsyncEventSourceClient() {}
+
+void AsyncEventSourceClient::close() {
+    LibraryCall call;
+    if (_client) _client->close();
+}
+
+void AsyncEventSourceClient::write(const char* message, size_t len) {
+    LibraryCall call;
+    _queueMessage(std::string(message, len));
+}
+
+void AsyncEventSourceClient::send(const char* message, const char* event, uint32_t id, uint32_t reconnect) {
+    LibraryCall call;
+    _queueMessage(sse_message(message, event, id, reconnect));
+}
+
+// Больше SSE_MAX_QUEUED_MESSAGES - сообщение отбрасывается
+void AsyncEventSourceClient::_queueMessage(const std::string& data) {
+    if (!connected() || _messageQueue.size() >= SSE_MAX_QUEUED_MESSAGES) return;
+    _messageQueue.push_back(Message{data, 0, 0});
+    if (_client->canSend()) _runQueue();
+}
+
+void AsyncEventSourceClient::_runQueue() {
+    while (!_messageQueue.empty() && _messageQueue.front().acked >= _messageQueue.front().data.size()) {
+        _messageQueue.erase(_messageQueue.begin());
+    }
+    for (Message& m : _messageQueue) {
+        if (m.sent == m.data.size()) continue;
+        size_t n = std::min(m.data.size() - m.sent, _client->space());
+        if (n == 0) break;
+        m.sent += _client->write(m.data.data() + m.sent, n);
+    }
+}
+
+void AsyncEventSourceClient::_onAck(size_t len) {
+    while (len && !_messageQueue.empty()) {
+        Message& m = _messageQueue.front();
+        size_t n = std::min(len, m.data.size() - m.acked);
+        m.acked += n;
+        len -= n;
+        if (m.acked < m.data.size()) break;
+        _messageQueue.erase(_messageQueue.begin());
+    }
+    _runQueue();
+}
+
+void AsyncEventSourceClient::_onDisconnect() {
+    _client = nullptr;
+    _server->_handleDisconnect(this);
+}
+
+AsyncEventSource::~AsyncEventSource() {}
+
+void AsyncEventSource::send(const char* message, const char* event, uint32_t id, uint32_t reconnect) {
+    LibraryCall call;
+    std::string ev = sse_message(message, event, id, reconnect);
+    for (AsyncEventSourceClient* c : _clients) {
+        if (c->connected()) c->write(ev.data(), ev.size());
+    }
+}
+
+size_t AsyncEventSource::count() const {
+    return std::count_if(_clients.begin(), _clients.end(), [](AsyncEventSourceClient* c) { return c->connected(); });
+}
+
+size_t AsyncEventSource::avgPacketsWaiting() const {
+    size_t queued = 0;
+    size_t connected = 0;
+    for (AsyncEventSourceClient* c : _clients) {
+        if (!c->connected()) continue;
+        queued += c->packetsWaiting();
+        connected++;
+    }
+    return connected ? (queued + connected / 2) / connected : 0;
+}
+
+void AsyncEventSource::_addClient(AsyncEventSourceClient* client) {
+    _clients.push_back(client);
+    if (_connectcb) _connectcb(client);
+}
+
+void AsyncEventSource::_handleDisconnect(AsyncEventSourceClient* client) {
+    _clients.erase(std::remove(_clients.begin(), _clients.end(), client), _clients.end());
+    delete client;
+}
+
+bool AsyncEventSource::canHandle(AsyncWebServerRequest* request) {
+    return request->method() == HTTP_GET && request->url() == _url;
+}
+
+void AsyncEventSource::handleRequest(AsyncWebServerRequest* request) {
+    request->send(new AsyncEventSourceResponse(this));
+}
+
+AsyncEventSourceResponse::AsyncEventSourceResponse(AsyncEventSource* server) : _server(server) {
+    _code = 200;
+    _contentType = "text/event-stream";
+    _sendContentLength = false;
+    addHeader("Cache-Control", "no-cache");
+    addHeader("Connection", "keep-alive");
+}
+
+void AsyncEventSourceResponse::_respond(AsyncWebServerRequest* request) {
+    String out = _assembleHead(1);
+    request->client()->write(out.c_str(), _headLength);
+    _state = RESPONSE_WAIT_ACK;
+}
+
+size_t AsyncEventSourceResponse::_ack(AsyncWebServerRequest* request, size_t len, uint32_t time) {
+    if (len) new AsyncEventSourceClient(request, _server);   // Удаляет запрос (и этот ответ)
+    return 0;
+}
+
+// === СЕРВЕР ===
+AsyncWebServer::~AsyncWebServer() {}
+
+void AsyncWebServer::begin() {
+    net_queue();
+    listeningServer = this;
+}
+
+void AsyncWebServer::end() {
+    if (listeningServer == this) listeningServer = nullptr;
+}
+
+AsyncWebHandler& AsyncWebServer::addHandler(AsyncWebHandler* handler) {
+    _handlers.push_back(handler);
+    return *handler;
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest) {
+    return on(uri, method, onRequest, nullptr, nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload,
+                                            ArBodyHandlerFunction onBody) {
+    AsyncCallbackWebHandler* handler = new AsyncCallbackWebHandler();
+    handler->setUri(uri);
+    handler->setMethod(method);
+    handler->onRequest(onRequest);
+    handler->onUpload(onUpload);
+    handler->onBody(onBody);
+    addHandler(handler);
+    return *handler;
+}
+
+AsyncStaticWebHandler& AsyncWebServer::serveStatic(const char* uri, FS& fs, const char* path,
+                                                   const char* cache_control) {
+    AsyncStaticWebHandler* handler = new AsyncStaticWebHandler();
+    addHandler(handler);
+    return *handler;
+}
+
+// Библиотека удаляет и обработчики из addHandler; на ПК список только забывается -
+// прошивка передает туда и статические объекты
+void AsyncWebServer::reset() {
+    _handlers.clear();
+    _catchAllHandler.onRequest(nullptr);
+}
+
+void AsyncWebServer::_attachHandler(AsyncWebServerRequest* request) {
+    for (AsyncWebHandler* h : _handlers) {
+        if (h->filter(request) && h->canHandle(request)) {
+            request->_handler = h;
+            return;
+        }
+    }
+    request->_handler = &_catchAllHandler;
+}
+
+// === КЛИЕНТЫ ТЕСТА ===
+namespace {
+
+// Заголовок ответа HTTP, дальше - тело по протоколу наследника
+struct HttpPeer : HostPeer {
+    std::string inbox;
+    bool headDone = false;
+    bool aborted = false;
+    int code = 0;
+    std::vector<std::pair<String, String>> headers;
+
+    void received(const std::string& bytes) override {
+        if (aborted) return;
+        HostDeviceScope scope(false);
+        inbox += bytes;
+        if (!headDone) {
+            size_t end = inbox.find("\r\n\r\n");
+            if (end == std::string::npos) return;
+            parseHead(inbox.substr(0, end));
+            inbox.erase(0, end + 4);
+            headDone = true;
+            onHead();
+        }
+        onData();
+    }
+
+    void parseHead(const std::string& head) {
+        size_t lineEnd = head.find("\r\n");
+        std::string status = head.substr(0, lineEnd);
+        size_t sp = status.find(' ');
+        code = sp == std::string::npos ? 0 : atoi(status.c_str() + sp + 1);
+        size_t pos = lineEnd == std::string::npos ? head.size() : lineEnd + 2;
+        while (pos < head.size()) {
+            size_t end = head.find("\r\n", pos);
+            if (end == std::string::npos) end = head.size();
+            std::string line = head.substr(pos, end - pos);
+            pos = end + 2;
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            String value(line.substr(colon + 1));
+            value.trim();
+            headers.push_back(std::make_pair(String(line.substr(0, colon)), value));
+        }
+    }
+
+    String header(const char* name) const {
+        for (const auto& h : headers) {
+            if (h.first.equalsIgnoreCase(name)) return h.second;
+        }
+        return String();
+    }
+
+    void sendFrame(uint8_t opcode, const uint8_t* data, size_t len) {
+        static const uint8_t mask[4] = {0x37, 0xfa, 0x21, 0x3d};
+        std::string frame;
+        frame += (char)(0x80 | opcode);
+        if (len < 126) {
+            frame += (char)(0x80 | len);
+        } else {
+            frame += (char)(0x80 | 126);
+            frame += (char)(len >> 8);
+            frame += (char)len;
+        }
+        frame.append((const char*)mask, 4);
+        for (size_t i = 0; i < len; i++) frame += (char)(data[i] ^ mask[i % 4]);
+        net_send_to_device(tcp, frame, host_time_us());
+    }
+
+    virtual void onHead() {}
+    virtual void onData() {}
+};
+
+std::string build_request(const HostHttpRequest& request) {
+    const std::string& body = request.body;
+    const String& contentType = request.contentType;
+    std::string out = request.method.str() + " " + request.url.str() + " HTTP/1.1\r\nHost: 192.168.1.50\r\n";
+    for (const auto& h : request.headers) out += h.first.str() + ": " + h.second.str() + "\r\n";
+    if (contentType.length()) out += "Content-Type: " + contentType.str() + "\r\n";
+    if (!body.empty() || request.method == "POST") out += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    out += "\r\n";
+    return out + body;
+}
+
+struct HttpExchangePeer : HttpPeer {
+    std::weak_ptr<HostHttpExchange> owner;
+    long contentLength = -1;
+    std::string chunkBuffer;
+
+    void onHead() override {
+        auto ex = owner.lock();
+        if (!ex) return;
+        ex->code = code;
+        ex->headers = headers;
+        String length = header("Content-Length");
+        if (length.length()) contentLength = strtol(length.c_str(), nullptr, 10);
+        ex->chunked = header("Transfer-Encoding").equalsIgnoreCase("chunked");
+    }
+
+    void onData() override {
+        auto ex = owner.lock();
+        if (!ex || ex->done || ex->failed) return;
+        if (ex->chunked) {
+            while (true) {
+                size_t lineEnd = inbox.find("\r\n");
+                if (lineEnd == std::string::npos) return;
+                size_t size = strtoul(inbox.c_str(), nullptr, 16);
+                if (inbox.size() < lineEnd + 2 + size + 2) return;
+                if (size == 0) {
+                    inbox.clear();
+                    finish(*ex, false);
+                    return;
+                }
+                ex->body.append(inbox, lineEnd + 2, size);
+                ex->chunks.push_back(size);
+                inbox.erase(0, lineEnd + 2 + size + 2);
+            }
+        }
+        ex->body += inbox;
+        inbox.clear();
+        if (contentLength >= 0 && (long)ex->body.size() >= contentLength) finish(*ex, false);
+    }
+
+    void closed() override {
+        auto ex = owner.lock();
+        if (!ex || ex->done || ex->failed) return;
+        HostDeviceScope scope(false);
+        // Без длины и chunked конец ответа - закрытие соединения
+        finish(*ex, !headDone || ex->chunked || contentLength >= 0);
+    }
+
+    void finish(HostHttpExchange& ex, bool failed) {
+        ex.done = !failed;
+        ex.failed = failed;
+        ex.doneAt = host_time_us();
+    }
+};
+
+struct WebSocketPeer : HttpPeer {
+    std::weak_ptr<HostWebSocket> owner;
+    bool closeSent = false;
+
+    void onHead() override {
+        auto ws = owner.lock();
+        if (!ws) return;
+        ws->upgradeCode = code;
+        ws->open = code == 101;
+    }
+
+    void onData() override {
+        auto ws = owner.lock();
+        if (!ws || !ws->open) {
+            inbox.clear();
+            return;
+        }
+        while (inbox.size() >= 2) {
+            const uint8_t* p = (const uint8_t*)inbox.data();
+            size_t len = p[1] & 0x7F;
+            size_t header = 2;
+            if (len == 126) {
+                if (inbox.size() < 4) return;
+                len = (p[2] << 8) | p[3];
+                header = 4;
+            }
+            if (inbox.size() < header + len) return;
+            HostWsMessage message{(uint8_t)(p[0] & 0x0F), inbox.substr(header, len), host_time_us()};
+            inbox.erase(0, header + len);
+            if (message.opcode == WS_DISCONNECT) {
+                if (message.payload.size() >= 2) {
+                    ws->closeCode = ((uint8_t)message.payload[0] << 8) | (uint8_t)message.payload[1];
+                }
+                ws->open = false;
+                if (!closeSent) {
+                    closeSent = true;
+                    sendFrame(WS_DISCONNECT, (const uint8_t*)message.payload.data(), std::min((size_t)2, message.payload.size()));
+                }
+                continue;
+            }
+            ws->messages.push_back(message);
+            if (ws->onMessage) ws->onMessage(*ws, ws->messages.back());
+        }
+    }
+
+    void closed() override {
+        if (auto ws = owner.lock()) {
+            ws->open = false;
+            ws->closed = true;
+        }
+    }
+};
+
+}  // namespace
+
+String HostHttpExchange::header(const char* name) const {
+    for (const auto& h : headers) {
+        if (h.first.equalsIgnoreCase(name)) return h.second;
+    }
+    return String();
+}
+
+void HostHttpExchange::abort() {
+    if (done || failed || !peer) return;
+    static_cast<HttpPeer*>(peer.get())->aborted = true;
+    failed = true;
+    doneAt = host_time_us();
+    net_peer_close(peer->tcp);
+}
+
+std::shared_ptr<HostHttpExchange> host_http(const HostHttpRequest& request) {
+    HostDeviceScope scope(false);
+    std::shared_ptr<HostHttpExchange> exchange = std::make_shared<HostHttpExchange>();
+    std::shared_ptr<HttpExchangePeer> peer = std::make_shared<HttpExchangePeer>();
+    peer->owner = exchange;
+    exchange->peer = peer;
+    exchange->sentAt = host_time_us();
+    net_connect(peer, build_request(request));
+    return exchange;
+}
+
+std::shared_ptr<HostHttpExchange> host_http_get(const String& url, const String& cookie) {
+    HostHttpRequest request;
+    request.url = url;
+    if (cookie.length()) request.headers.push_back(std::make_pair(String("Cookie"), cookie));
+    return host_http(request);
+}
+
+std::shared_ptr<HostWebSocket> host_websocket(const String& url, const std::vector<std::pair<String, String>>& headers) {
+    HostDeviceScope scope(false);
+    std::shared_ptr<HostWebSocket> ws = std::make_shared<HostWebSocket>();
+    std::shared_ptr<WebSocketPeer> peer = std::make_shared<WebSocketPeer>();
+    peer->owner = ws;
+    ws->peer = peer;
+    HostHttpRequest request;
+    request.url = url;
+    request.headers = headers;
+    request.headers.push_back(std::make_pair(String("Upgrade"), String("websocket")));
+    request.headers.push_back(std::make_pair(String("Connection"), String("Upgrade")));
+    request.headers.push_back(std::make_pair(String("Sec-WebSocket-Key"), String("dGhlIHNhbXBsZSBub25jZQ==")));
+    request.headers.push_back(std::make_pair(String("Sec-WebSocket-Version"), String("13")));
+    net_connect(peer, build_request(request));
+    return ws;
+}
+
+void HostWebSocket::sendBinary(const uint8_t* data, size_t len) {
+    if (!open || !peer) return;
+    HostDeviceScope scope(false);
+    static_cast<HttpPeer*>(peer.get())->sendFrame(WS_BINARY, data, len);
+}
+
+void HostWebSocket::close() {
+    if (!open || !peer) return;
+    HostDeviceScope scope(false);
+    WebSocketPeer* p = static_cast<WebSocketPeer*>(peer.get());
+    if (p->closeSent) return;
+    p->closeSent = true;
+    uint8_t code[2] = {0x03, 0xE8};   // 1000 Normal Closure
+    p->sendFrame(WS_DISCONNECT, code, sizeof(code));
+}
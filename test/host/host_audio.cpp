@@ -0,0 +1,165 @@
+// === ESP8266Audio НА ПК: МОДЕЛЬ ПОТОКА, ДЕКОДЕРА И I2S ===
+#include <AudioFileSourceHTTPStream.h>
+#include <AudioFileSourceBuffer.h>
+#include <AudioGeneratorMP3.h>
+#include <AudioOutputI2S.h>
+#include "host_env.h"
+
+#define MP3_FRAME_SAMPLES 1152
+#define I2S_DMA_BUF_LEN   128
+
+static HostAudioModel audioModel;
+static HostAudioStats audioStats;
+
+HostAudioModel& host_audio_model() { return audioModel; }
+const HostAudioStats& host_audio_stats() { return audioStats; }
+void host_audio_reset_stats() { audioStats = HostAudioStats(); }
+
+// === ПОТОК СТАНЦИИ ===
+AudioFileSourceHTTPStream::AudioFileSourceHTTPStream() {}
+
+AudioFileSourceHTTPStream::AudioFileSourceHTTPStream(const char* url) { open(url); }
+
+bool AudioFileSourceHTTPStream::open(const char* url) {
+    _open = url && (strncmp(url, "http://", 7) == 0 || strncmp(url, "https://", 8) == 0);
+    _openedAt = host_time_us();
+    _consumed = 0;
+    return _open;
+}
+
+uint64_t AudioFileSourceHTTPStream::hostArrived() const {
+    if (!_open) return 0;
+    return audioModel.streamBurstBytes + (host_time_us() - _openedAt) * audioModel.streamBytesPerSecond / 1000000;
+}
+
+uint32_t AudioFileSourceHTTPStream::read(void* data, uint32_t len) {
+    if (!_open) return 0;
+    host_time_advance(audioModel.streamReadCallUs);
+    uint64_t ready = hostArrived() - _consumed;
+    uint32_t n = (uint32_t)min((uint64_t)len, ready);
+    if (data && n > 0) memset(data, 0, n);
+    _consumed += n;
+    return n;
+}
+
+// === БУФЕР ===
+AudioFileSourceBuffer::AudioFileSourceBuffer(AudioFileSource* in, uint32_t bufferBytes)
+    : _src(in), _buffer(new uint8_t[bufferBytes]), _size(bufferBytes) {}
+
+AudioFileSourceBuffer::~AudioFileSourceBuffer() { delete[] _buffer; }
+
+void AudioFileSourceBuffer::fill() {
+    if (!_src || _fill >= _size) return;
+    _fill += _src->read(nullptr, _size - _fill);
+}
+
+bool AudioFileSourceBuffer::loop() {
+    fill();
+    return true;
+}
+
+uint32_t AudioFileSourceBuffer::read(void* data, uint32_t len) {
+    if (_fill < len) fill();
+    uint32_t n = min(len, _fill);
+    if (data && n > 0) memset(data, 0, n);
+    _fill -= n;
+    return n;
+}
+
+// === I2S ===
+AudioOutputI2S::AudioOutputI2S(int port, int output_mode, int dma_buf_count, int use_apll)
+    : _dmaSamples((uint32_t)dma_buf_count * I2S_DMA_BUF_LEN) {
+    _dma = new uint8_t[_dmaSamples * 4];  // 16 бит, стерео
+}
+
+AudioOutputI2S::~AudioOutputI2S() { delete[] _dma; }
+
+bool AudioOutputI2S::SetPinout(int bclkPin, int wclkPin, int doutPin) { return true; }
+
+bool AudioOutputI2S::begin() { return true; }
+
+bool AudioOutputI2S::ConsumeSample(int16_t sample[2]) {
+    double now = (double)host_time_us();
+    double period = 1e6 / (hertz > 0 ? hertz : audioModel.sampleRate);
+    if (_playing && now > _drainedAt) {
+        // DMA опустел раньше, чем пришел сэмпл: на выходе была тишина
+        uint64_t gap = (uint64_t)(now - _drainedAt);
+        if (gap > 0) {
+            audioStats.gaps++;
+            audioStats.gapMicros += gap;
+            if (gap > audioStats.maxGapMicros) audioStats.maxGapMicros = gap;
+        }
+    }
+    if (!_playing || _drainedAt < now) _drainedAt = now;
+    if ((_drainedAt - now) / period >= _dmaSamples) return false;
+    _drainedAt += period;
+    _playing = true;
+    audioStats.samples++;
+    return true;
+}
+
+bool AudioOutputI2S::stop() {
+    _playing = false;
+    return true;
+}
+
+void AudioOutputI2S::flush() {}
+
+// === MP3 ===
+AudioGeneratorMP3::~AudioGeneratorMP3() { stop(); }
+
+bool AudioGeneratorMP3::begin(AudioFileSource* source, AudioOutput* out) {
+    if (!source || !out) return false;
+    file = source;
+    output = out;
+    if (!file->isOpen()) return false;
+    _state = new uint8_t[audioModel.mp3WorkBytes];
+    _input = new uint8_t[audioModel.frameBytes];
+    _inputFill = 0;
+    _pcmLeft = 0;
+    _pending = false;
+    output->SetRate(audioModel.sampleRate);
+    output->SetChannels(2);
+    output->begin();
+    running = true;
+    return true;
+}
+
+bool AudioGeneratorMP3::decode_frame() {
+    _inputFill += file->read(_input + _inputFill, audioModel.frameBytes - _inputFill);
+    if (_inputFill < audioModel.frameBytes) return false;
+    _inputFill = 0;
+    host_time_advance(audioModel.frameDecodeUs);
+    audioStats.frames++;
+    _pcmLeft = MP3_FRAME_SAMPLES;
+    return true;
+}
+
+bool AudioGeneratorMP3::loop() {
+    if (!running) return false;
+    // Сначала сэмпл, не принятый в прошлый раз
+    if (_pending && output->ConsumeSample(lastSample)) _pending = false;
+    while (running && !_pending) {
+        if (_pcmLeft == 0 && !decode_frame()) break;
+        // Синус ~440 Гц: визуализатору есть что показать
+        _phase = (_phase + 1) % 100;
+        int16_t value = (int16_t)(8000 * sin(_phase * 2 * M_PI / 100));
+        lastSample[0] = value;
+        lastSample[1] = value;
+        _pcmLeft--;
+        if (!output->ConsumeSample(lastSample)) _pending = true;
+    }
+    file->loop();
+    output->loop();
+    return running;
+}
+
+bool AudioGeneratorMP3::stop() {
+    if (running && output) output->stop();
+    running = false;
+    delete[] _state;
+    _state = nullptr;
+    delete[] _input;
+    _input = nullptr;
+    return true;
+}
@@ -0,0 +1,107 @@
+#include <Wire.h>
+#include <SPI.h>
+#include "host_env.h"
+
+// Модельное время на шине: дробные микросекунды копятся, чтобы короткие
+// транзакции не округлялись до нуля
+static uint64_t bus_micros(uint64_t bits, uint32_t frequency, uint64_t& remainderBits) {
+    if (frequency == 0) frequency = 100000;
+    uint64_t scaled = bits * 1000000 + remainderBits;
+    remainderBits = scaled % frequency;
+    return scaled / frequency;
+}
+
+// === I2C ===
+TwoWire Wire;
+static uint64_t wireRemainder = 0;
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+    _started = true;
+    if (frequency) _clock = frequency;
+    return true;
+}
+
+bool TwoWire::end() {
+    _started = false;
+    _inTransmission = false;
+    return true;
+}
+
+bool TwoWire::setClock(uint32_t frequency) {
+    _clock = frequency;
+    return true;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    _address = address;
+    _length = 0;
+    _inTransmission = true;
+}
+
+bool TwoWire::push(uint8_t c) {
+    if (!_inTransmission || _length >= I2C_BUFFER_LENGTH) return false;
+    _buffer[_length++] = c;
+    return true;
+}
+
+size_t TwoWire::write(uint8_t c) {
+    if (push(c)) return 1;
+    hostDropped++;
+    return 0;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t len) {
+    size_t n = 0;
+    while (n < len && push(data[n])) n++;
+    hostDropped += len - n;
+    return n;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    if (!_inTransmission) return 4;
+    _inTransmission = false;
+    if (!_started) return 4;
+
+    // START + адрес (9 бит) + данные по 9 бит + STOP
+    uint64_t spent = bus_micros(1 + 9 + _length * 9 + 1, _clock, wireRemainder);
+    hostBusMicros += spent;
+    host_time_advance(spent);
+    hostBytes += _length;
+    hostTransactions++;
+    if (_sink) _sink(_address, _buffer, _length);
+    return 0;
+}
+
+// === SPI ===
+SPIClass SPI;
+static uint64_t spiRemainder = 0;
+
+void SPIClass::begin(int8_t sck, int8_t miso, int8_t mosi, int8_t ss) {}
+void SPIClass::end() {}
+
+void SPIClass::beginTransaction(SPISettings settings) {
+    _settings = settings;
+    _inTransaction = true;
+    hostTransactions++;
+}
+
+void SPIClass::endTransaction() {
+    _inTransaction = false;
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+    writeBytes(&data, 1);
+    return 0xFF;
+}
+
+void SPIClass::write(uint8_t data) {
+    writeBytes(&data, 1);
+}
+
+void SPIClass::writeBytes(const uint8_t* data, uint32_t size) {
+    uint64_t spent = bus_micros((uint64_t)size * 8, _settings.clock, spiRemainder);
+    hostBusMicros += spent;
+    host_time_advance(spent);
+    hostBytes += size;
+    if (_sink) _sink(data, size);
+}
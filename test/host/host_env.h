@@ -0,0 +1,91 @@
+#ifndef HOST_ENV_H
+#define HOST_ENV_H
+
+// === УПРАВЛЕНИЕ ОКРУЖЕНИЕМ ПРОШИВКИ НА ПК ===
+// Виртуальные часы, модель heap и вывод Serial. Заголовок только для тестов:
+// исходники src/ его не включают.
+
+#include <Arduino.h>
+#include <string>
+
+// --- Виртуальное время (мкс с "включения") ---
+uint64_t host_time_us();
+void host_time_advance(uint64_t us);   // Процессор занят или ждет: время идет вперед
+void host_time_set(uint64_t us);       // Только вперед
+void host_time_reset();                // Новый прогон теста с нуля
+
+// --- Вытеснение (задача AsyncTCP на ПК) ---
+// Пока время идет в коде прошивки (host_time_advance, delay, стоимость flash и шины),
+// события с наступившим сроком выполняются посреди него, как задача AsyncTCP
+// (приоритет 5) вытесняет loopTask. Внутри мьютекса или критической секции событие
+// ждет освобождения. События друг друга не вытесняют.
+class HostPreemptor {
+public:
+    virtual ~HostPreemptor() {}
+    virtual uint64_t nextDueUs() = 0;   // UINT64_MAX - событий нет
+    virtual void runNext() = 0;         // Выполнить самое раннее
+};
+
+void host_set_preemptor(HostPreemptor* preemptor);
+
+// --- Модель heap ---
+// Учитываются выделения через new, сделанные внутри HostDeviceScope (код прошивки).
+// Свободно = размер heap - живые учтенные выделения. Наименьший свободный - минимум
+// за прогон, сбрасывается host_heap_reset_min()
+void host_heap_set_size(uint32_t bytes);
+uint32_t host_heap_in_use();
+uint32_t host_heap_peak();             // Максимум живых учтенных выделений
+void host_heap_reset_min();
+
+// Пока объект жив, new/delete считаются кодом устройства
+// (HostDeviceScope(false) - кодом теста, например клиента на другом конце сети)
+class HostDeviceScope {
+public:
+    explicit HostDeviceScope(bool device = true);
+    ~HostDeviceScope();
+    HostDeviceScope(const HostDeviceScope&) = delete;
+    HostDeviceScope& operator=(const HostDeviceScope&) = delete;
+
+private:
+    bool _previous;
+};
+
+// --- Пины ---
+int host_pin_level(uint8_t pin);
+void host_pin_set(uint8_t pin, int level);   // Внешний сигнал (кнопка энкодера)
+
+// --- Сброс и сон ---
+#include <esp_system.h>
+void host_set_reset_reason(esp_reset_reason_t reason);
+bool host_deep_sleeping();             // Прошивка вызвала esp_deep_sleep_start()
+
+// --- Аудио (ESP8266Audio на ПК) ---
+// Параметры модели потока и декодера - предположения, а не замеры C3:
+// тест может менять их до подключения к станции
+struct HostAudioModel {
+    uint32_t streamBytesPerSecond = 16000;  // 128 кбит/с
+    uint32_t streamBurstBytes = 65536;      // Сервер станции отдает начало потока сразу
+    uint32_t streamReadCallUs = 20;         // Вызов read() потока (lwIP)
+    uint32_t frameBytes = 418;              // Кадр MP3 128 кбит/с, 44.1 кГц
+    uint32_t frameDecodeUs = 6000;          // CPU на декодирование кадра
+    uint32_t sampleRate = 44100;
+    uint32_t mp3WorkBytes = 29 * 1024;      // Память libmad на время воспроизведения
+};
+
+struct HostAudioStats {
+    uint64_t samples;        // Сэмплов принято I2S
+    uint32_t frames;         // Кадров декодировано
+    uint32_t gaps;           // Сколько раз DMA опустел во время воспроизведения
+    uint64_t gapMicros;      // Суммарная тишина из-за пустого DMA
+    uint64_t maxGapMicros;
+};
+
+HostAudioModel& host_audio_model();
+const HostAudioStats& host_audio_stats();
+void host_audio_reset_stats();
+
+// --- Serial ---
+std::string& host_serial_output();     // Все, что напечатано с начала прогона (или последней очистки)
+void host_serial_clear();
+
+#endif // HOST_ENV_H
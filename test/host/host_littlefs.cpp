@@ -0,0 +1,113 @@
+#include <LittleFS.h>
+#include "host_env.h"
+
+fs::FS LittleFS;
+
+// По умолчанию: ~25 мкс на вызов и ~5 МБ/с чтения, запись в несколько раз медленнее
+static uint32_t readCallUs = 25;
+static uint32_t readNsPerByte = 200;
+static uint32_t writeCallUs = 60;
+static uint32_t writeNsPerByte = 1000;
+
+void host_fs_set_cost(uint32_t readCall, uint32_t readPerByte, uint32_t writeCall, uint32_t writePerByte) {
+    readCallUs = readCall;
+    readNsPerByte = readPerByte;
+    writeCallUs = writeCall;
+    writeNsPerByte = writePerByte;
+}
+
+namespace fs {
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!_node || !_writable) return 0;
+    std::vector<uint8_t>& data = _node->data;
+    if (_position + size > data.size()) {
+        HostDeviceScope flash(false);  // Содержимое файлов - во флеше, а не в heap
+        data.resize(_position + size);
+    }
+    memcpy(data.data() + _position, buffer, size);
+    _position += size;
+    host_time_advance(writeCallUs + (uint64_t)size * writeNsPerByte / 1000);
+    return size;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    if (!_node) return 0;
+    size_t n = std::min(size, _node->data.size() - std::min(_position, _node->data.size()));
+    memcpy(buffer, _node->data.data() + _position, n);
+    _position += n;
+    host_time_advance(readCallUs + (uint64_t)n * readNsPerByte / 1000);
+    return n;
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+    if (!_node || _position >= _node->data.size()) return -1;
+    return _node->data[_position];
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!_node) return false;
+    size_t base = mode == SeekSet ? 0 : mode == SeekCur ? _position : _node->data.size();
+    size_t target = base + pos;
+    if (target > _node->data.size()) return false;
+    _position = target;
+    return true;
+}
+
+const char* File::name() const {
+    size_t slash = _path.rfind('/');
+    return _path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+    if (!hostMounted) return File();
+    auto it = _files.find(path);
+    if (mode[0] == 'r') {
+        if (it == _files.end()) return File();
+        return File(path, it->second, mode[1] == '+', 0);
+    }
+    if (mode[0] == 'w' || it == _files.end()) {
+        HostDeviceScope flash(false);
+        auto node = std::make_shared<HostNode>();
+        // Открытые на чтение копии старого файла остаются целыми, как в LittleFS
+        _files[path] = node;
+        return File(path, node, true, 0);
+    }
+    // "a": дописывание в конец
+    return File(path, it->second, true, it->second->data.size());
+}
+
+bool FS::rename(const char* from, const char* to) {
+    auto it = _files.find(from);
+    if (it == _files.end()) return false;
+    HostDeviceScope flash(false);
+    auto node = it->second;
+    _files.erase(it);
+    _files[to] = node;
+    return true;
+}
+
+size_t FS::usedBytes() {
+    size_t total = 0;
+    for (auto& file : _files) total += file.second->data.size();
+    return total;
+}
+
+void FS::hostWriteFile(const char* path, const std::string& content) {
+    auto node = std::make_shared<HostNode>();
+    node->data.assign(content.begin(), content.end());
+    _files[path] = node;
+}
+
+std::string FS::hostReadFile(const char* path) {
+    auto it = _files.find(path);
+    if (it == _files.end()) return std::string();
+    return std::string(it->second->data.begin(), it->second->data.end());
+}
+
+}  // namespace fs
@@ -0,0 +1,88 @@
+#ifndef HOST_NET_H
+#define HOST_NET_H
+
+// === СЕТЬ НА ПК: КЛИЕНТЫ ТЕСТА ===
+// Браузеры на другом конце WiFi. Запрос уходит на AsyncWebServer прошивки через
+// модель сети (host_async_web.cpp): общий канал с ограниченной скоростью, RTT,
+// сегменты по TCP_MSS и ACK через сегмент. Разбор запроса и обработчики идут
+// событием задачи AsyncTCP и вытесняют loop() (host_env.h, HostPreemptor).
+// Ответы клиент получает тоже событиями - обратные вызовы теста выполняются
+// вне учета heap устройства.
+//
+// Параметры модели - предположения, а не замеры C3: тест может менять их до запросов.
+
+#include <Arduino.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct HostNetModel {
+    uint32_t linkBytesPerSecond = 500000;  // ~4 Мбит/с полезной скорости WiFi C3 под нагрузкой
+    uint32_t rttUs = 4000;                 // Телефон/ноутбук в той же сети
+    uint32_t requestCpuUs = 500;           // Прием и разбор запроса в задаче AsyncTCP
+    uint32_t writeCallUs = 30;             // tcp_write + tcp_output
+    uint32_t writeNsPerByte = 20;          // Копирование в pbuf
+    uint32_t ackCpuUs = 40;                // Обработка ACK (lwIP + обратный вызов)
+    uint32_t wsFrameCpuUs = 50;            // Прием кадра WebSocket
+};
+
+HostNetModel& host_net_model();
+
+// --- HTTP ---
+struct HostHttpRequest {
+    String method = "GET";
+    String url = "/";
+    std::vector<std::pair<String, String>> headers;
+    String contentType;            // Пусто - без тела
+    std::string body;
+};
+
+struct HostHttpExchange {
+    bool done = false;             // Ответ получен целиком
+    bool failed = false;           // Соединение закрыто до конца ответа
+    int code = 0;
+    std::vector<std::pair<String, String>> headers;
+    std::string body;              // Без разметки chunked
+    std::vector<size_t> chunks;    // Размеры кусков chunked-ответа
+    bool chunked = false;
+    uint64_t sentAt = 0;           // Первый байт запроса ушел (мкс)
+    uint64_t doneAt = 0;           // Ответ закончен или оборван
+
+    String header(const char* name) const;
+    uint64_t latencyUs() const { return doneAt - sentAt; }
+    void abort();                  // Клиент закрывает соединение (вкладка закрыта)
+
+    std::shared_ptr<struct HostPeer> peer;
+};
+
+std::shared_ptr<HostHttpExchange> host_http(const HostHttpRequest& request);
+
+// Простой GET (с cookie, если задан)
+std::shared_ptr<HostHttpExchange> host_http_get(const String& url, const String& cookie = String());
+
+// --- WebSocket ---
+struct HostWsMessage {
+    uint8_t opcode;
+    std::string payload;
+    uint64_t at;
+};
+
+struct HostWebSocket {
+    bool open = false;
+    bool closed = false;
+    int upgradeCode = 0;           // Ответ на upgrade (101 или отказ фильтра)
+    uint16_t closeCode = 0;
+    std::vector<HostWsMessage> messages;
+    std::function<void(HostWebSocket&, const HostWsMessage&)> onMessage;
+
+    void sendBinary(const uint8_t* data, size_t len);
+    void close();
+
+    std::shared_ptr<struct HostPeer> peer;
+};
+
+std::shared_ptr<HostWebSocket> host_websocket(const String& url,
+                                              const std::vector<std::pair<String, String>>& headers = {});
+
+#endif // HOST_NET_H
@@ -0,0 +1,67 @@
+#include <WiFi.h>
+
+WiFiClass WiFi;
+
+bool IPAddress::fromString(const char* text) {
+    uint32_t parts[4];
+    int count = 0;
+    uint32_t value = 0;
+    bool digits = false;
+    for (const char* p = text; ; p++) {
+        if (*p >= '0' && *p <= '9') {
+            value = value * 10 + (*p - '0');
+            if (value > 255) return false;
+            digits = true;
+        } else if (*p == '.' || *p == '\0') {
+            if (!digits || count == 4) return false;
+            parts[count++] = value;
+            value = 0;
+            digits = false;
+            if (*p == '\0') break;
+        } else {
+            return false;
+        }
+    }
+    if (count != 4) return false;
+    *this = IPAddress(parts[0], parts[1], parts[2], parts[3]);
+    return true;
+}
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(buf);
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* password) {
+    hostSsid = ssid;
+    if (hostConnectOnBegin) hostStatus = WL_CONNECTED;
+    return hostStatus;
+}
+
+bool WiFiClass::disconnect(bool wifiOff, bool eraseAp) {
+    hostStatus = WL_DISCONNECTED;
+    if (wifiOff) hostMode = WIFI_OFF;
+    return true;
+}
+
+int16_t WiFiClass::scanNetworks(bool async) {
+    if (hostMode == WIFI_OFF) return WIFI_SCAN_FAILED;
+    _scanReady = false;
+    _scanRunning = true;
+    _scanStarted = millis();
+    if (!async) {
+        delay(hostScanDelayMs);
+        return scanComplete();
+    }
+    return WIFI_SCAN_RUNNING;
+}
+
+int16_t WiFiClass::scanComplete() {
+    if (_scanRunning && millis() - _scanStarted >= hostScanDelayMs) {
+        _scanRunning = false;
+        _scanReady = true;
+    }
+    if (_scanRunning) return WIFI_SCAN_RUNNING;
+    return _scanReady ? (int16_t)hostScanResults.size() : WIFI_SCAN_FAILED;
+}
@@ -0,0 +1,35 @@
+#ifndef HOST_MBEDTLS_MD_H
+#define HOST_MBEDTLS_MD_H
+
+// === MBEDTLS MD НА ПК ===
+// Только SHA-256 (хеш пароля в credentials_helper.cpp), тот же API, что у mbedtls 2.x
+
+#include <cstddef>
+#include <cstdint>
+
+typedef enum {
+    MBEDTLS_MD_NONE = 0,
+    MBEDTLS_MD_SHA256 = 6,
+} mbedtls_md_type_t;
+
+struct mbedtls_md_info_t {
+    mbedtls_md_type_t type;
+};
+
+struct mbedtls_md_context_t {
+    const mbedtls_md_info_t* info;
+    uint32_t state[8];
+    uint64_t length;        // Байт всего
+    uint8_t block[64];
+    size_t blockLength;
+};
+
+const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t type);
+void mbedtls_md_init(mbedtls_md_context_t* ctx);
+int mbedtls_md_setup(mbedtls_md_context_t* ctx, const mbedtls_md_info_t* info, int hmac);
+int mbedtls_md_starts(mbedtls_md_context_t* ctx);
+int mbedtls_md_update(mbedtls_md_context_t* ctx, const unsigned char* input, size_t length);
+int mbedtls_md_finish(mbedtls_md_context_t* ctx, unsigned char* output);
+void mbedtls_md_free(mbedtls_md_context_t* ctx);
+
+#endif // HOST_MBEDTLS_MD_H
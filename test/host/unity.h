@@ -0,0 +1,112 @@
+#ifndef HOST_UNITY_H
+#define HOST_UNITY_H
+
+// === UNITY (ПОДМНОЖЕСТВО) ===
+// Те же макросы, что у Unity из тестового фреймворка PlatformIO, ровно столько,
+// сколько нужно тестам в test/. Упавшая проверка прерывает тест (longjmp)
+// и печатает файл:строку, остальные тесты выполняются дальше.
+
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+void setUp(void);
+void tearDown(void);
+
+struct UnityState {
+    const char* test = nullptr;
+    unsigned tests = 0;
+    unsigned failures = 0;
+    jmp_buf abort;
+};
+
+inline UnityState& unity_state() {
+    static UnityState state;
+    return state;
+}
+
+[[noreturn]] inline void unity_fail(const char* file, int line, const char* message) {
+    UnityState& u = unity_state();
+    printf("%s:%d:%s:FAIL: %s\n", file, line, u.test ? u.test : "?", message);
+    longjmp(u.abort, 1);
+}
+
+inline void unity_run(void (*fn)(), const char* name, const char* file, int line) {
+    UnityState& u = unity_state();
+    u.test = name;
+    u.tests++;
+    if (setjmp(u.abort) == 0) {
+        setUp();
+        fn();
+        tearDown();
+        printf("%s:%d:%s:PASS\n", file, line, name);
+    } else {
+        u.failures++;
+        tearDown();
+    }
+    fflush(stdout);
+}
+
+inline int unity_end() {
+    UnityState& u = unity_state();
+    printf("\n-----------------------\n%u Tests %u Failures 0 Ignored\n%s\n", u.tests, u.failures,
+           u.failures ? "FAIL" : "OK");
+    return u.failures ? 1 : 0;
+}
+
+#define UNITY_BEGIN() (unity_state().tests = 0, unity_state().failures = 0)
+#define UNITY_END() unity_end()
+#define RUN_TEST(fn) unity_run(fn, #fn, __FILE__, __LINE__)
+
+#define TEST_MESSAGE(message) printf("%s:%d:%s:INFO: %s\n", __FILE__, __LINE__, unity_state().test, (message))
+#define TEST_FAIL_MESSAGE(message) unity_fail(__FILE__, __LINE__, (message))
+
+#define TEST_ASSERT_TRUE_MESSAGE(condition, message) \
+    do { if (!(condition)) unity_fail(__FILE__, __LINE__, (message)); } while (0)
+#define TEST_ASSERT_TRUE(condition) TEST_ASSERT_TRUE_MESSAGE(condition, "Expected TRUE: " #condition)
+#define TEST_ASSERT_FALSE(condition) TEST_ASSERT_TRUE_MESSAGE(!(condition), "Expected FALSE: " #condition)
+#define TEST_ASSERT(condition) TEST_ASSERT_TRUE(condition)
+
+#define UNITY_COMPARE(expected, actual, op, message)                                              \
+    do {                                                                                          \
+        long long e_ = (long long)(expected), a_ = (long long)(actual);                           \
+        if (!(a_ op e_)) {                                                                        \
+            char buf_[256];                                                                       \
+            snprintf(buf_, sizeof(buf_), "Expected %s %lld, was %lld. %s", #op, e_, a_, (message)); \
+            unity_fail(__FILE__, __LINE__, buf_);                                                 \
+        }                                                                                         \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL_MESSAGE(expected, actual, message) UNITY_COMPARE(expected, actual, ==, message)
+#define TEST_ASSERT_EQUAL(expected, actual) UNITY_COMPARE(expected, actual, ==, "")
+#define TEST_ASSERT_EQUAL_INT(expected, actual) UNITY_COMPARE(expected, actual, ==, "")
+#define TEST_ASSERT_EQUAL_UINT(expected, actual) UNITY_COMPARE(expected, actual, ==, "")
+#define TEST_ASSERT_EQUAL_UINT32(expected, actual) UNITY_COMPARE(expected, actual, ==, "")
+#define TEST_ASSERT_LESS_OR_EQUAL(threshold, actual) UNITY_COMPARE(threshold, actual, <=, "")
+#define TEST_ASSERT_LESS_THAN(threshold, actual) UNITY_COMPARE(threshold, actual, <, "")
+#define TEST_ASSERT_GREATER_THAN(threshold, actual) UNITY_COMPARE(threshold, actual, >, "")
+#define TEST_ASSERT_GREATER_OR_EQUAL(threshold, actual) UNITY_COMPARE(threshold, actual, >=, "")
+#define TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(threshold, actual, message) UNITY_COMPARE(threshold, actual, <=, message)
+#define TEST_ASSERT_GREATER_THAN_MESSAGE(threshold, actual, message) UNITY_COMPARE(threshold, actual, >, message)
+
+#define TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, actual, message)                             \
+    do {                                                                                        \
+        const char* e_ = (expected);                                                            \
+        const char* a_ = (actual);                                                              \
+        if (strcmp(e_, a_) != 0) {                                                              \
+            char buf_[512];                                                                     \
+            snprintf(buf_, sizeof(buf_), "Expected '%.200s' Was '%.200s'. %s", e_, a_, (message)); \
+            unity_fail(__FILE__, __LINE__, buf_);                                               \
+        }                                                                                       \
+    } while (0)
+#define TEST_ASSERT_EQUAL_STRING(expected, actual) TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, actual, "")
+
+#define TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, actual, len, message)              \
+    do {                                                                              \
+        if (memcmp((expected), (actual), (len)) != 0) unity_fail(__FILE__, __LINE__, \
+            "Memory Mismatch. " message);                                             \
+    } while (0)
+#define TEST_ASSERT_EQUAL_MEMORY(expected, actual, len) TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, actual, len, "")
+
+#endif // HOST_UNITY_H
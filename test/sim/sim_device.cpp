@@ -0,0 +1,110 @@
+#include "sim_device.h"
+#include <fstream>
+#include <sstream>
+#include <LittleFS.h>
+#include "audio_manager.h"
+
+void setup();
+void loop();
+
+static SimOptions simOptions;
+static SimLoopStats loopStats;
+static uint64_t lastLoopStart = 0;
+static String sessionCookie;
+
+static std::string read_data_file(const char* name) {
+    std::ifstream in(std::string(DATA_DIR) + "/" + name, std::ios::binary);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+// Страницы кладутся без сжатия (на плате - .html.gz): отдавать больше байт - только строже
+static void populate_filesystem(size_t stationCount) {
+    LittleFS.format();
+    LittleFS.hostWriteFile("/index.html", read_data_file("index.html"));
+    LittleFS.hostWriteFile("/register.html", read_data_file("register.html"));
+    LittleFS.hostWriteFile("/ap_mode.html", read_data_file("ap_mode.html"));
+    LittleFS.hostWriteFile("/wifi.json", "{\"ssid\":\"HostNet\",\"password\":\"hostpass123\"}");
+
+    std::string list = "[";
+    for (size_t i = 0; i < stationCount; i++) {
+        if (i) list += ",";
+        list += "{\"name\":\"Station " + std::to_string(i + 1) + "\",\"url\":\"http://stream.host/" +
+                std::to_string(i + 1) + ".mp3\"}";
+    }
+    LittleFS.hostWriteFile("/stations.json", list + "]");
+}
+
+void sim_boot(const SimOptions& options) {
+    simOptions = options;
+    host_heap_set_size(options.heapBytes);
+    populate_filesystem(options.stations);
+    {
+        HostDeviceScope device;
+        setup();
+    }
+    host_heap_reset_min();
+    sim_reset_loop_stats();
+}
+
+static void sim_loop_once() {
+    uint64_t start = host_time_us();
+    if (lastLoopStart) {
+        uint64_t gap = start - lastLoopStart;
+        loopStats.loops++;
+        loopStats.totalGapUs += gap;
+        if (gap > loopStats.maxGapUs) loopStats.maxGapUs = gap;
+    }
+    lastLoopStart = start;
+    HostDeviceScope device;
+    loop();
+    host_time_advance(simOptions.loopOverheadUs);
+}
+
+void sim_run_for(uint64_t us) {
+    uint64_t end = host_time_us() + us;
+    while (host_time_us() < end) sim_loop_once();
+}
+
+bool sim_run_until(std::function<bool()> done, uint64_t timeoutUs) {
+    uint64_t end = host_time_us() + timeoutUs;
+    while (!done()) {
+        if (host_time_us() >= end) return false;
+        sim_loop_once();
+    }
+    return true;
+}
+
+const SimLoopStats& sim_loop_stats() { return loopStats; }
+
+void sim_reset_loop_stats() {
+    loopStats = SimLoopStats();
+    lastLoopStart = 0;
+}
+
+std::shared_ptr<HostHttpExchange> sim_fetch(const HostHttpRequest& request, uint64_t timeoutUs) {
+    std::shared_ptr<HostHttpExchange> exchange = host_http(request);
+    sim_run_until([&]() { return exchange->done || exchange->failed; }, timeoutUs);
+    return exchange;
+}
+
+static HostHttpRequest form_post(const char* url, const std::string& body) {
+    HostHttpRequest request;
+    request.method = "POST";
+    request.url = url;
+    request.contentType = "application/x-www-form-urlencoded";
+    request.body = body;
+    return request;
+}
+
+String sim_login() {
+    if (sessionCookie.length()) return sessionCookie;
+    const std::string credentials = "username=hostadmin&password=hostsecret";
+    sim_fetch(form_post("/register", credentials));
+    std::shared_ptr<HostHttpExchange> login = sim_fetch(form_post("/login", credentials));
+    String cookie = login->header("Set-Cookie");
+    int end = cookie.indexOf(';');
+    sessionCookie = end < 0 ? cookie : cookie.substring(0, end);
+    return sessionCookie;
+}
@@ -0,0 +1,41 @@
+#ifndef SIM_DEVICE_H
+#define SIM_DEVICE_H
+
+// === ПРОШИВКА ЦЕЛИКОМ НА ПК ===
+// setup() и loop() из src/main.cpp со всеми модулями: аудио (ESP8266Audio на ПК),
+// веб-сервер (ESPAsyncWebServer на ПК, host_net.h), дисплей, LittleFS.
+// Образ ФС - data/*.html и конфиги: WiFi, список станций. Устройство одно на процесс:
+// как и на плате, состояние прошивки живет от setup() до конца прогона.
+
+#include <Arduino.h>
+#include <functional>
+#include "host_env.h"
+#include "host_net.h"
+
+struct SimOptions {
+    uint32_t heapBytes = 240 * 1024;   // Свободный heap C3 после WiFi, до буфера потока
+    uint32_t loopOverheadUs = 200;     // yield() и задачи WiFi между итерациями loop()
+    size_t stations = 20;
+};
+
+// Время между началами итераций loop(): столько loop_audio() не вызывался
+struct SimLoopStats {
+    uint64_t loops;
+    uint64_t maxGapUs;
+    uint64_t totalGapUs;
+};
+
+void sim_boot(const SimOptions& options = SimOptions());
+void sim_run_for(uint64_t us);
+bool sim_run_until(std::function<bool()> done, uint64_t timeoutUs);
+
+const SimLoopStats& sim_loop_stats();
+void sim_reset_loop_stats();
+
+// Регистрация (один раз) и вход: cookie "session=..." для запросов с сессией
+String sim_login();
+
+// Запрос целиком: loop() крутится, пока не придет ответ
+std::shared_ptr<HostHttpExchange> sim_fetch(const HostHttpRequest& request, uint64_t timeoutUs = 5000000);
+
+#endif // SIM_DEVICE_H
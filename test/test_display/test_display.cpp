@@ -0,0 +1,324 @@
+// === ЭКРАНЫ OLED НА ПК ===
+// display_manager.cpp и визуализаторы рисуют в эмулятор SSD1306 (test/host):
+// - снимки всех экранов сравниваются с test/snapshots/*.pbm
+//   (UPDATE_SNAPSHOTS=1 - перезаписать эталоны, при расхождении рядом с
+//   бинарником теста появляется <имя>.actual.pbm);
+// - байты, реально ушедшие по Wire/SPI, сверяются с учетом шины
+//   (displayBusBytes, displayLastFlushBytes) на каждом flush;
+// - модель контроллера на шине должна получить ровно буфер кадра, в том
+//   числе после частичных flush бегущей строки;
+// - печатается стоимость отрисовки каждого экрана: CPU на ПК и модельное
+//   время шины (I2C 400 kHz / SPI 8 MHz).
+
+#include <unity.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <Wire.h>
+#include <SPI.h>
+#include <WiFi.h>
+#include <Adafruit_SSD1306.h>
+#include "host_env.h"
+#include "config.h"
+#include "audio_manager.h"
+#include "display_manager.h"
+#include "visualizer_manager.h"
+
+// --- То, что на устройстве определяют config.cpp и audio_manager.cpp ---
+WiFiCredentials wifiConfig;
+std::vector<RadioStation> stations;
+int totalStations = 0;
+SemaphoreHandle_t stationsMutex = nullptr;
+VisualizerStyle visualizerStyle = STYLE_BARS;
+uint8_t displayRotation = 2;  // Как по умолчанию на устройстве
+
+int currentStation = 0;
+float volume = 0.5f;
+AudioState audioState = AUDIO_PLAYING;
+std::atomic<bool> audio_decoding_active(false);
+unsigned long audioDecodeMicros = 0;
+int get_audio_buffer_fill_percent() { return 80; }
+
+extern Adafruit_SSD1306 display;
+extern DisplayMode currentDisplayMode;
+
+#ifdef DISPLAY_TRANSPORT_SPI
+#define BUS SPI
+#define BUS_NAME "SPI"
+#define DISPLAY_COMMAND_BYTES 1
+#define FULL_FRAME_BYTES 518   // 5 + 1 команд + 512 данных
+#else
+#define BUS Wire
+#define BUS_NAME "I2C"
+#define DISPLAY_COMMAND_BYTES 2  // Control byte + команда
+#define FULL_FRAME_BYTES 525   // 6 + 2 команд + 512 данных + 5 control byte
+#endif
+
+// --- Снимки ---
+class StringPrint : public Print {
+public:
+    std::string data;
+    size_t write(uint8_t c) override { data += (char)c; return 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { data.append((const char*)buffer, size); return size; }
+    using Print::write;
+};
+
+static std::string snapshot_pbm() {
+    StringPrint out;
+    write_display_snapshot_pbm(out);
+    return out.data;
+}
+
+static void check_snapshot(const char* name) {
+    std::string actual = snapshot_pbm();
+    std::string path = std::string(SNAPSHOT_DIR) + "/" + name + ".pbm";
+
+    const char* update = getenv("UPDATE_SNAPSHOTS");
+    if (update && update[0] == '1') {
+        std::ofstream(path, std::ios::binary) << actual;
+        return;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream expected;
+    expected << in.rdbuf();
+    if (expected.str() != actual) {
+        std::string actualPath = std::string(name) + ".actual.pbm";
+        std::ofstream(actualPath, std::ios::binary) << actual;
+        std::string message = "Снимок " + path + " не совпал, получено: " + actualPath;
+        TEST_FAIL_MESSAGE(message.c_str());
+    }
+}
+
+// --- Учет шины ---
+// Счетчики прошивки и реальные байты на шине за один вызов loop_display()
+struct FrameBus {
+    unsigned long busBytes;       // По Wire/SPI
+    unsigned long countedBytes;   // displayBusBytes
+    unsigned long flushes;
+    uint64_t busMicros;           // Модельное время на шине
+    double cpuMicros;             // Отрисовка на ПК (без шины)
+};
+
+static FrameBus render_frame() {
+    unsigned long bytes0 = BUS.hostBytes;
+    uint64_t micros0 = BUS.hostBusMicros;
+    unsigned long counted0 = displayBusBytes;
+    unsigned long flushes0 = displayFlushes;
+
+    auto t0 = std::chrono::steady_clock::now();
+    loop_display();
+    auto t1 = std::chrono::steady_clock::now();
+
+    FrameBus f;
+    f.busBytes = BUS.hostBytes - bytes0;
+    f.countedBytes = displayBusBytes - counted0;
+    f.flushes = displayFlushes - flushes0;
+    f.busMicros = BUS.hostBusMicros - micros0;
+    f.cpuMicros = std::chrono::duration<double, std::micro>(t1 - t0).count();
+    return f;
+}
+
+// Каждый flush: учет = шина, контроллер получил ровно буфер
+static FrameBus render_checked() {
+    FrameBus f = render_frame();
+    TEST_ASSERT_EQUAL_MESSAGE(f.busBytes, f.countedBytes, "displayBusBytes расходится с байтами на шине");
+    if (f.flushes > 0) {
+        TEST_ASSERT_TRUE_MESSAGE(display.hostPanelMatchesBuffer(), "GDDRAM контроллера не совпадает с буфером");
+    }
+    TEST_ASSERT_EQUAL(0, display.hostProtocolErrors);
+    TEST_ASSERT_EQUAL(0, Wire.hostDropped);
+    return f;
+}
+
+static void report_cost(const char* screen, const FrameBus& f) {
+    printf("  %-22s cpu %7.1f us | bus %4lu B %6llu us | flushes %lu\n", screen, f.cpuMicros, f.busBytes,
+           (unsigned long long)f.busMicros, f.flushes);
+}
+
+static void set_station(const char* name) {
+    stations.clear();
+    stations.push_back({"Radio One", "http://example.com/one", true, 0});
+    stations.push_back({name, "http://example.com/two", true, 0});
+    totalStations = stations.size();
+    currentStation = 1;
+}
+
+static void go_info() {
+    reset_inactivity_timer();
+    currentDisplayMode = INFO;
+    invalidate_display();
+}
+
+// Шкала громкости доезжает до значения за ~20 кадров
+static void settle() {
+    for (int i = 0; i < 40; i++) render_checked();
+}
+
+void setUp() {
+    displayRotation = 2;
+    display.setRotation(displayRotation);
+    WiFi.hostStatus = WL_CONNECTED;
+    WiFi.hostRssi = -61;
+    volume = 0.5f;
+    set_station("Jazz FM");
+    go_info();
+    settle();
+    invalidate_display();  // Первый кадр теста - полный
+}
+
+void tearDown() {}
+
+// === ТЕСТЫ ===
+void test_full_frame_matches_bus() {
+    FrameBus f = render_checked();
+    TEST_ASSERT_EQUAL(1, f.flushes);
+    TEST_ASSERT_EQUAL(FULL_FRAME_BYTES, f.busBytes);
+    TEST_ASSERT_EQUAL(FULL_FRAME_BYTES, displayLastFlushBytes);
+}
+
+void test_unchanged_screen_skips_flush() {
+    render_checked();
+    unsigned long skipped = displayFramesSkipped;
+    FrameBus f = render_checked();
+    TEST_ASSERT_EQUAL(0, f.flushes);
+    TEST_ASSERT_EQUAL(0, f.busBytes);
+    TEST_ASSERT_EQUAL(skipped + 1, displayFramesSkipped);
+}
+
+void test_info_screens() {
+    render_checked();
+    check_snapshot("info");
+
+    volume = 0.0f;
+    settle();
+    check_snapshot("info_volume_zero");
+
+    stations.clear();
+    totalStations = 0;
+    render_checked();
+    check_snapshot("info_no_stations");
+
+    displayRotation = 0;
+    display.setRotation(0);
+    set_station("Jazz FM");
+    volume = 0.5f;
+    settle();
+    check_snapshot("info_rotation0");
+}
+
+// Длинное имя: кадры, где меняется только сдвиг, шлют одну страницу.
+// Имя каждый раз новое - полоса перерисовывается и отсчет сдвига идет от этого вызова
+static void check_marquee(uint8_t rotation, const char* name, const char* snapshot) {
+    displayRotation = rotation;
+    display.setRotation(rotation);
+    set_station(name);
+    go_info();
+    settle();
+    invalidate_display();
+
+    FrameBus full = render_checked();
+    TEST_ASSERT_EQUAL(FULL_FRAME_BYTES, full.busBytes);
+
+    host_time_advance((DISPLAY_MARQUEE_PAUSE_MS + 10 * DISPLAY_MARQUEE_STEP_MS) * 1000UL);
+    unsigned long marqueeFrames0 = marqueeFrames;
+    FrameBus step = render_checked();
+    TEST_ASSERT_EQUAL(1, step.flushes);
+    TEST_ASSERT_EQUAL(1, marqueeFrames - marqueeFrames0);
+    TEST_ASSERT_EQUAL(step.busBytes, displayLastFlushBytes);
+    TEST_ASSERT_LESS_THAN(FULL_FRAME_BYTES / 3, step.busBytes);
+    check_snapshot(snapshot);
+
+    report_cost("full frame (marquee)", full);
+    report_cost("marquee step", step);
+}
+
+void test_marquee_partial_flush() {
+    check_marquee(2, "Classic Rock Legends Around The Clock", "info_marquee");
+    check_marquee(0, "Smooth Jazz Lounge All Night Long", "info_marquee_rotation0");
+}
+
+void test_visualizer_styles() {
+    static const int bands[VISUALIZER_BANDS] = {2, 5, 9, 12, 15, 13, 10, 8, 6, 9, 11, 14, 7, 4, 3, 1};
+    randomSeed(42);
+    for (int style = 0; style < VISUALIZER_STYLE_COUNT; style++) {
+        memcpy(visualizerBands, bands, sizeof(bands));
+        visualizerManager.setStyle((VisualizerStyle)style);
+        go_info();
+        host_time_advance((DISPLAY_INACTIVITY_TIMEOUT + 1) * 1000UL);
+        render_checked();  // INFO -> VISUALIZER
+        TEST_ASSERT_EQUAL(VISUALIZER, currentDisplayMode);
+
+        FrameBus f;
+        for (int i = 0; i < 3; i++) {  // Визуализаторы с инерцией - пара кадров
+            host_time_advance(16 * 1000);
+            f = render_checked();
+            TEST_ASSERT_EQUAL(1, f.flushes);
+            TEST_ASSERT_EQUAL(FULL_FRAME_BYTES, f.busBytes);
+        }
+        std::string name = std::string("visualizer_") + VisualizerManager::getStyleName((VisualizerStyle)style);
+        for (auto& c : name) c = tolower(c);
+        check_snapshot(name.c_str());
+        report_cost(name.c_str(), f);
+    }
+    visualizerManager.setStyle(STYLE_BARS);
+}
+
+void test_ap_message_ip_shutdown() {
+    set_display_mode_ap("192.168.4.1");  // Рисует сразу
+    TEST_ASSERT_EQUAL(AP_MODE, currentDisplayMode);
+    TEST_ASSERT_TRUE(display.hostPanelMatchesBuffer());
+    check_snapshot("ap_mode");
+    report_cost("ap_mode (repeat)", render_checked());
+
+    show_message("Connecting WiFi", "HomeNetwork");
+    TEST_ASSERT_EQUAL(MESSAGE, currentDisplayMode);
+    TEST_ASSERT_TRUE(display.hostPanelMatchesBuffer());
+    check_snapshot("message");
+
+    show_ip_address("192.168.1.50", 3000);
+    host_time_advance(1000 * 1000);
+    FrameBus ip = render_checked();
+    TEST_ASSERT_EQUAL(1, ip.flushes);
+    check_snapshot("ip_display");
+    report_cost("ip_display", ip);
+
+    pause_ip_display();
+    host_time_advance(5000 * 1000);
+    host_time_advance(600000 - host_time_us() % 600000 + 150000);  // Спиннер: кадр '/' при любой шине
+    render_checked();
+    TEST_ASSERT_EQUAL(IP_DISPLAY, currentDisplayMode);
+    check_snapshot("ip_display_paused");
+    resume_ip_display();
+    TEST_ASSERT_EQUAL(INFO, currentDisplayMode);
+
+    show_shutdown_progress(0.5f);
+    FrameBus shutdown = render_checked();
+    TEST_ASSERT_EQUAL(SHUTDOWN_ANIM, currentDisplayMode);
+    check_snapshot("shutdown");
+    report_cost("shutdown", shutdown);
+
+    unsigned long bytes0 = BUS.hostBytes;
+    turn_off_display();
+    TEST_ASSERT_FALSE(display.hostPanelOn());
+    TEST_ASSERT_TRUE(display.hostPanelMatchesBuffer());
+    TEST_ASSERT_EQUAL(FULL_FRAME_BYTES + DISPLAY_COMMAND_BYTES, BUS.hostBytes - bytes0);
+}
+
+int main() {
+    setup_display();
+    if (!display.hostPanelOn()) {
+        printf("Дисплей не инициализирован\n");
+        return 1;
+    }
+
+    printf("Стоимость кадра (%s):\n", BUS_NAME);
+    UNITY_BEGIN();
+    RUN_TEST(test_full_frame_matches_bus);
+    RUN_TEST(test_unchanged_screen_skips_flush);
+    RUN_TEST(test_info_screens);
+    RUN_TEST(test_marquee_partial_flush);
+    RUN_TEST(test_visualizer_styles);
+    RUN_TEST(test_ap_message_ip_shutdown);
+    return UNITY_END();
+}
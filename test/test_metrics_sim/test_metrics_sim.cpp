@@ -0,0 +1,206 @@
+// === /api/metrics В ФОРМАТЕ PROMETHEUS (ПК) ===
+// Прошивка целиком (test/sim) играет станцию, тест снимает /api/metrics как Prometheus.
+// Проверяется:
+// - без сессии метрики не отдаются; Content-Type - text/plain; version=0.0.4;
+// - у каждой серии есть # HELP и # TYPE семейства, значения - числа, серии не повторяются;
+// - гистограммы: корзины по возрастанию le, счетчики не убывают, +Inf == _count, есть _sum;
+// - счетчики между снятиями не убывают; сэмплы декодера и итерации loop() растут
+//   вместе с тем, что насчитала модель I2S и стенд;
+// - heap: минимум свободного <= свободного, наибольший блок <= свободного.
+
+#include <unity.h>
+#include <map>
+#include <cmath>
+#include <sstream>
+#include "sim_device.h"
+#include "audio_manager.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+struct Exposition {
+    std::map<std::string, std::string> help;    // Семейство -> текст
+    std::map<std::string, std::string> type;    // Семейство -> counter/gauge/histogram/summary
+    std::map<std::string, double> samples;      // "name{labels}" -> значение
+    std::vector<std::string> order;             // Серии в порядке вывода
+    std::vector<std::string> errors;
+};
+
+// Семейство серии: для histogram/summary - без суффикса _bucket/_sum/_count
+static std::string family_of(const Exposition& e, const std::string& name) {
+    static const char* const suffixes[] = {"_bucket", "_sum", "_count"};
+    for (const char* suffix : suffixes) {
+        size_t n = strlen(suffix);
+        if (name.size() > n && name.compare(name.size() - n, n, suffix) == 0) {
+            std::string base = name.substr(0, name.size() - n);
+            auto it = e.type.find(base);
+            if (it != e.type.end() && (it->second == "histogram" || it->second == "summary")) return base;
+        }
+    }
+    return name;
+}
+
+static Exposition parse(const std::string& body) {
+    Exposition e;
+    std::istringstream in(body);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        if (line.compare(0, 7, "# HELP ") == 0 || line.compare(0, 7, "# TYPE ") == 0) {
+            size_t space = line.find(' ', 7);
+            std::string name = line.substr(7, space == std::string::npos ? std::string::npos : space - 7);
+            std::string text = space == std::string::npos ? "" : line.substr(space + 1);
+            (line[2] == 'H' ? e.help : e.type)[name] = text;
+            continue;
+        }
+        if (line[0] == '#') continue;
+        size_t split = line.rfind(' ');
+        if (split == std::string::npos) {
+            e.errors.push_back("нет значения: " + line);
+            continue;
+        }
+        std::string series = line.substr(0, split);
+        char* end = nullptr;
+        double value = strtod(line.c_str() + split + 1, &end);
+        if (*end != '\0') e.errors.push_back("не число: " + line);
+        if (e.samples.count(series)) e.errors.push_back("повтор: " + series);
+        std::string name = series.substr(0, series.find('{'));
+        std::string family = family_of(e, name);
+        if (!e.help.count(family) || !e.type.count(family)) e.errors.push_back("без HELP/TYPE: " + series);
+        e.samples[series] = value;
+        e.order.push_back(series);
+    }
+    return e;
+}
+
+static std::shared_ptr<HostHttpExchange> scrape(const String& cookie) {
+    HostHttpRequest request;
+    request.url = "/api/metrics";
+    if (cookie.length()) request.headers.push_back(std::make_pair(String("Cookie"), cookie));
+    return sim_fetch(request);
+}
+
+static double value(const Exposition& e, const std::string& series) {
+    auto it = e.samples.find(series);
+    TEST_ASSERT_TRUE_MESSAGE(it != e.samples.end(), series.c_str());
+    return it->second;
+}
+
+static void print_errors(const Exposition& e) {
+    for (const std::string& error : e.errors) printf("  %s\n", error.c_str());
+}
+
+static void test_metrics_require_session() {
+    TEST_ASSERT_TRUE(sim_run_until([]() { return audioState == AUDIO_PLAYING; }, 10000000));
+    std::shared_ptr<HostHttpExchange> response = scrape(String());
+    TEST_ASSERT_TRUE(response->done);
+    TEST_ASSERT_TRUE(response->code != 200);
+}
+
+static void test_exposition_format() {
+    std::shared_ptr<HostHttpExchange> response = scrape(sim_login());
+    TEST_ASSERT_EQUAL(200, response->code);
+    TEST_ASSERT_TRUE(response->header("Content-Type").startsWith("text/plain; version=0.0.4"));
+    Exposition e = parse(response->body);
+    print_errors(e);
+    TEST_ASSERT_EQUAL(0, e.errors.size());
+    for (auto& family : e.type) {
+        const std::string& type = family.second;
+        TEST_ASSERT_TRUE_MESSAGE(type == "counter" || type == "gauge" || type == "histogram" || type == "summary",
+                                 family.first.c_str());
+        TEST_ASSERT_TRUE_MESSAGE(e.help.count(family.first), family.first.c_str());
+        if (type == "counter") {
+            TEST_ASSERT_TRUE_MESSAGE(family.first.size() > 6 &&
+                                     family.first.compare(family.first.size() - 6, 6, "_total") == 0,
+                                     family.first.c_str());
+        }
+    }
+    // Подсистемы из одного места: декодер, поток, Wi-Fi, логи, флеш, дисплей, heap, loop()
+    static const char* const required[] = {
+        "audio_decoded_samples_total", "audio_underruns_total", "audio_buffer_fill_percent",
+        "audio_stream_connects_total", "audio_station_failures_total", "wifi_reconnects_total",
+        "log_writes_total", "flash_bytes_written_total", "display_bus_bytes_total", "display_fps",
+        "system_heap_free_bytes", "system_heap_largest_block_bytes", "main_loop_duration_seconds"};
+    for (const char* family : required) TEST_ASSERT_TRUE_MESSAGE(e.type.count(family), family);
+}
+
+// Корзины одной гистограммы (одного набора меток без le) подряд, le по возрастанию
+static void test_histograms_are_cumulative() {
+    Exposition e = parse(scrape(sim_login())->body);
+    size_t histograms = 0;
+    for (auto& family : e.type) {
+        if (family.second != "histogram") continue;
+        std::map<std::string, std::vector<std::pair<double, double>>> buckets;  // метки -> (le, значение)
+        std::string prefix = family.first + "_bucket";
+        for (const std::string& series : e.order) {
+            if (series.compare(0, prefix.size() + 1, prefix + "{") != 0) continue;
+            size_t le = series.find("le=\"");
+            TEST_ASSERT_TRUE_MESSAGE(le != std::string::npos, series.c_str());
+            std::string bound = series.substr(le + 4, series.find('"', le + 4) - le - 4);
+            std::string labels = series.substr(prefix.size(), le - prefix.size());
+            double upper = bound == "+Inf" ? INFINITY : atof(bound.c_str());
+            buckets[labels].push_back(std::make_pair(upper, e.samples[series]));
+        }
+        TEST_ASSERT_TRUE_MESSAGE(!buckets.empty(), family.first.c_str());
+        for (auto& set : buckets) {
+            const std::vector<std::pair<double, double>>& b = set.second;
+            for (size_t i = 1; i < b.size(); i++) {
+                TEST_ASSERT_TRUE_MESSAGE(b[i].first > b[i - 1].first, (family.first + set.first).c_str());
+                TEST_ASSERT_TRUE_MESSAGE(b[i].second >= b[i - 1].second, (family.first + set.first).c_str());
+            }
+            TEST_ASSERT_TRUE_MESSAGE(std::isinf(b.back().first), (family.first + set.first).c_str());
+            // Метки без le: "{}" -> "", "{route=..,method=..,}" -> "{route=..,method=..}"
+            std::string rest = set.first.substr(1);
+            if (!rest.empty() && rest.back() == ',') rest.pop_back();
+            std::string labels = rest.empty() ? "" : "{" + rest + "}";
+            TEST_ASSERT_EQUAL(b.back().second, value(e, family.first + "_count" + labels));
+            value(e, family.first + "_sum" + labels);
+            histograms++;
+        }
+    }
+    printf("  гистограмм (с метками): %u\n", (unsigned)histograms);
+    TEST_ASSERT_GREATER_THAN(2, histograms);
+}
+
+static void test_counters_follow_the_device() {
+    String cookie = sim_login();
+    Exposition before = parse(scrape(cookie)->body);
+    uint64_t samples = host_audio_stats().samples;
+    sim_reset_loop_stats();
+    sim_run_for(3000000);
+    uint64_t loops = sim_loop_stats().loops;
+    samples = host_audio_stats().samples - samples;
+    Exposition after = parse(scrape(cookie)->body);
+
+    for (auto& sample : before.samples) {
+        std::string name = sample.first.substr(0, sample.first.find('{'));
+        std::string family = family_of(before, name);
+        bool cumulative = before.type[family] == "counter" || name != family;  // _bucket/_sum/_count
+        if (!cumulative || !after.samples.count(sample.first)) continue;
+        TEST_ASSERT_TRUE_MESSAGE(after.samples[sample.first] >= sample.second, sample.first.c_str());
+    }
+
+    double decoded = value(after, "audio_decoded_samples_total") - value(before, "audio_decoded_samples_total");
+    double iterations = value(after, "main_loop_duration_seconds_count") - value(before, "main_loop_duration_seconds_count");
+    printf("  за 3 с: сэмплов %.0f (I2S принял %llu), итераций loop() %.0f (стенд %llu)\n", decoded,
+           (unsigned long long)samples, iterations, (unsigned long long)loops);
+    // Между снятиями - еще и итерации на время самих запросов; DMA держит десятки мс звука
+    TEST_ASSERT_TRUE(decoded >= samples * 0.9 && decoded <= samples * 1.2);
+    TEST_ASSERT_TRUE(iterations >= loops && iterations <= loops * 1.1);
+    TEST_ASSERT_EQUAL(0, value(after, "audio_underruns_total"));
+
+    double freeHeap = value(after, "system_heap_free_bytes");
+    TEST_ASSERT_TRUE(value(after, "system_heap_min_free_bytes") <= freeHeap);
+    TEST_ASSERT_TRUE(value(after, "system_heap_largest_block_bytes") <= freeHeap);
+    TEST_ASSERT_TRUE(freeHeap > 0 && freeHeap <= ESP.getHeapSize());
+}
+
+int main() {
+    sim_boot();
+    UNITY_BEGIN();
+    RUN_TEST(test_metrics_require_session);
+    RUN_TEST(test_exposition_format);
+    RUN_TEST(test_histograms_are_cumulative);
+    RUN_TEST(test_counters_follow_the_device);
+    return UNITY_END();
+}
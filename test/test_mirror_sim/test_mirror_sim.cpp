@@ -0,0 +1,260 @@
+// === ЗЕРКАЛО OLED ПО WEBSOCKET (ПК) ===
+// Прошивка целиком (test/sim) играет станцию, браузер открывает /api/display/mirror.
+// Клиент теста сам декодирует сообщения [тип][seq][поворот][PackBits]:
+// 0x02 - ключевой кадр, 0x01 - XOR с прошлым кадром.
+// Проверяется:
+// - без сессии upgrade отклоняется;
+// - первое сообщение - ключевой кадр (экран - визуализатор), каждое декодируется ровно в 512 байт
+//   и совпадает с кадром, который был на экране после одной из итераций loop();
+// - не чаще WEB_MIRROR_FPS_MAX, третий зритель закрывается кодом 1013;
+// - байты и кадры на клиента в /api/metrics равны полученным;
+// - медленный канал: кадры отбрасываются, цепочка восстанавливается ключевым кадром;
+// - буфер, очищенный без flush (reset_inactivity_timer), к зрителям не уходит.
+
+#include <unity.h>
+#include <set>
+#include <Adafruit_SSD1306.h>
+#include <ESPAsyncWebServer.h>
+#include "sim_device.h"
+#include "config.h"
+#include "display_manager.h"
+#include "audio_manager.h"
+
+#define MIRROR_FRAME_BYTES (SCREEN_WIDTH * SCREEN_HEIGHT / 8)
+
+extern Adafruit_SSD1306 display;
+extern DisplayMode currentDisplayMode;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Кадры, которые были на OLED после итераций loop() - GDDRAM модели контроллера,
+// а не буфер: зритель должен видеть только то, что ушло на экран
+static std::set<std::string> shownFrames;
+
+static bool run_watching(std::function<bool()> done, uint64_t timeoutUs) {
+    return sim_run_until([&]() {
+        shownFrames.insert(std::string((const char*)display.hostPanelRam(), MIRROR_FRAME_BYTES));
+        return done();
+    }, timeoutUs);
+}
+
+struct MirrorViewer {
+    std::shared_ptr<HostWebSocket> ws;
+    uint8_t frame[MIRROR_FRAME_BYTES];
+    bool haveFrame = false;
+    uint32_t keyframes = 0;
+    uint32_t deltas = 0;
+    uint32_t unknownFrames = 0;   // Не совпал ни с одним кадром экрана
+    uint32_t decodeErrors = 0;
+    uint32_t deltaWithoutBase = 0;
+    uint64_t payloadBytes = 0;
+    std::vector<uint64_t> arrivals;
+};
+
+// PackBits -> out; false, если длина не 512 байт или поток оборван
+static bool unpack(const std::string& payload, size_t offset, uint8_t* out) {
+    size_t n = 0;
+    size_t i = offset;
+    while (i < payload.size()) {
+        uint8_t control = (uint8_t)payload[i++];
+        if (control < 128) {
+            size_t count = control + 1;
+            if (i + count > payload.size() || n + count > MIRROR_FRAME_BYTES) return false;
+            memcpy(out + n, payload.data() + i, count);
+            i += count;
+            n += count;
+        } else if (control > 128) {
+            size_t count = 257 - control;
+            if (i >= payload.size() || n + count > MIRROR_FRAME_BYTES) return false;
+            memset(out + n, (uint8_t)payload[i++], count);
+            n += count;
+        } else {
+            return false;
+        }
+    }
+    return n == MIRROR_FRAME_BYTES;
+}
+
+static void on_mirror_message(MirrorViewer& viewer, const HostWsMessage& message) {
+    if (message.opcode != WS_BINARY) return;
+    viewer.payloadBytes += message.payload.size();
+    viewer.arrivals.push_back(message.at);
+    if (message.payload.size() < 3 || (uint8_t)message.payload[2] != displayRotation) {
+        viewer.decodeErrors++;
+        return;
+    }
+    uint8_t decoded[MIRROR_FRAME_BYTES];
+    if (!unpack(message.payload, 3, decoded)) {
+        viewer.decodeErrors++;
+        return;
+    }
+    uint8_t type = (uint8_t)message.payload[0];
+    if (type == 0x02) {
+        memcpy(viewer.frame, decoded, MIRROR_FRAME_BYTES);
+        viewer.haveFrame = true;
+        viewer.keyframes++;
+    } else if (type == 0x01) {
+        if (!viewer.haveFrame) {
+            viewer.deltaWithoutBase++;
+            return;
+        }
+        for (size_t i = 0; i < MIRROR_FRAME_BYTES; i++) viewer.frame[i] ^= decoded[i];
+        viewer.deltas++;
+    } else {
+        viewer.decodeErrors++;
+        return;
+    }
+    if (!shownFrames.count(std::string((const char*)viewer.frame, MIRROR_FRAME_BYTES))) viewer.unknownFrames++;
+}
+
+static std::shared_ptr<MirrorViewer> open_viewer(const String& cookie) {
+    std::shared_ptr<MirrorViewer> viewer = std::make_shared<MirrorViewer>();
+    std::vector<std::pair<String, String>> headers;
+    if (cookie.length()) headers.push_back(std::make_pair(String("Cookie"), cookie));
+    viewer->ws = host_websocket("/api/display/mirror", headers);
+    MirrorViewer* raw = viewer.get();
+    viewer->ws->onMessage = [raw](HostWebSocket&, const HostWsMessage& message) { on_mirror_message(*raw, message); };
+    run_watching([&]() { return viewer->ws->open || viewer->ws->closed || viewer->ws->upgradeCode != 0; }, 2000000);
+    return viewer;
+}
+
+static void close_viewer(std::shared_ptr<MirrorViewer> viewer) {
+    viewer->ws->close();
+    run_watching([&]() { return viewer->ws->closed; }, 2000000);
+}
+
+// Значение строки метрики "name{labels} value" (или -1)
+static long metric_value(const std::string& body, const std::string& series) {
+    size_t at = body.find("\n" + series + " ");
+    if (at == std::string::npos) return -1;
+    return atol(body.c_str() + at + series.size() + 2);
+}
+
+static void test_mirror_requires_session() {
+    TEST_ASSERT_TRUE(run_watching([]() { return audioState == AUDIO_PLAYING; }, 10000000));
+    std::shared_ptr<MirrorViewer> viewer = open_viewer(String());
+    TEST_ASSERT_FALSE(viewer->ws->open);
+    TEST_ASSERT_TRUE(viewer->ws->upgradeCode != 101);
+}
+
+// Визуализатор (после DISPLAY_INACTIVITY_TIMEOUT без ввода) меняет кадр каждую итерацию экрана
+static void test_mirror_frames_match_screen() {
+    String cookie = sim_login();
+    TEST_ASSERT_TRUE(run_watching([]() { return currentDisplayMode == VISUALIZER; }, DISPLAY_INACTIVITY_TIMEOUT * 2000ULL));
+    std::shared_ptr<MirrorViewer> viewer = open_viewer(cookie);
+    TEST_ASSERT_TRUE(viewer->ws->open);
+    uint64_t start = host_time_us();
+    run_watching([]() { return false; }, 5000000);
+    uint64_t seconds = (host_time_us() - start) / 1000000;
+
+    printf("  зеркало: ключевых %u, дельт %u, %llu байт за %llu с\n", viewer->keyframes, viewer->deltas,
+           (unsigned long long)viewer->payloadBytes, (unsigned long long)seconds);
+    TEST_ASSERT_EQUAL(1, viewer->keyframes);
+    TEST_ASSERT_GREATER_THAN(0, viewer->deltas);
+    TEST_ASSERT_EQUAL(0, viewer->decodeErrors);
+    TEST_ASSERT_EQUAL(0, viewer->deltaWithoutBase);
+    TEST_ASSERT_EQUAL(0, viewer->unknownFrames);
+    // Частота: сообщения уходят не чаще раза в 1000 / WEB_MIRROR_FPS_MAX мс (+1 на границы окна)
+    TEST_ASSERT_LESS_OR_EQUAL(WEB_MIRROR_FPS_MAX * seconds + 1, viewer->arrivals.size());
+
+    // Статистика клиента - до закрытия, пока клиент в /api/metrics
+    HostHttpRequest request;
+    request.url = "/api/metrics";
+    request.headers.push_back(std::make_pair(String("Cookie"), cookie));
+    std::shared_ptr<HostHttpExchange> metrics = sim_fetch(request);
+    uint64_t received = viewer->payloadBytes;
+    size_t messages = viewer->arrivals.size();
+    TEST_ASSERT_EQUAL(200, metrics->code);
+    size_t at = metrics->body.find("web_mirror_bytes_total{client=\"");
+    TEST_ASSERT_TRUE(at != std::string::npos);
+    std::string id = metrics->body.substr(at + 31, metrics->body.find('"', at + 31) - at - 31);
+    long bytes = metric_value(metrics->body, "web_mirror_bytes_total{client=\"" + id + "\"}");
+    long sent = metric_value(metrics->body, "web_mirror_frames_total{client=\"" + id + "\",result=\"sent\"}");
+    // Сообщения, поставленные в очередь до снятия метрик, но еще не полученные клиентом
+    run_watching([]() { return false; }, 200000);
+    TEST_ASSERT_TRUE(bytes >= (long)received && bytes <= (long)viewer->payloadBytes);
+    TEST_ASSERT_TRUE(sent >= (long)messages && sent <= (long)viewer->arrivals.size());
+    close_viewer(viewer);
+}
+
+static void test_third_viewer_is_refused() {
+    String cookie = sim_login();
+    std::shared_ptr<MirrorViewer> first = open_viewer(cookie);
+    std::shared_ptr<MirrorViewer> second = open_viewer(cookie);
+    std::shared_ptr<MirrorViewer> third = open_viewer(cookie);
+    run_watching([&]() { return third->ws->closed; }, 2000000);
+    run_watching([]() { return false; }, 1000000);
+
+    TEST_ASSERT_TRUE(first->ws->open && !first->ws->closed);
+    TEST_ASSERT_TRUE(second->ws->open && !second->ws->closed);
+    TEST_ASSERT_TRUE(third->ws->closed);
+    TEST_ASSERT_EQUAL(1013, third->ws->closeCode);
+    TEST_ASSERT_EQUAL(0, third->keyframes + third->deltas);
+    TEST_ASSERT_EQUAL(1, second->keyframes);
+    TEST_ASSERT_EQUAL(0, second->unknownFrames);
+    close_viewer(first);
+    close_viewer(second);
+}
+
+// Канал 300 Б/с, а дельта визуализатора - около сотни байт несколько раз в секунду:
+// очередь клиента заполняется, дельты отбрасываются, после освобождения очереди
+// приходит новый ключевой кадр
+static void test_slow_link_recovers_with_keyframe() {
+    String cookie = sim_login();
+    uint32_t link = host_net_model().linkBytesPerSecond;
+    host_net_model().linkBytesPerSecond = 300;
+    host_audio_reset_stats();
+    std::shared_ptr<MirrorViewer> viewer = open_viewer(cookie);
+    TEST_ASSERT_TRUE(viewer->ws->open);
+    run_watching([]() { return false; }, 10000000);
+    host_net_model().linkBytesPerSecond = link;
+    run_watching([]() { return false; }, 2000000);
+
+    printf("  медленный канал: ключевых %u, дельт %u, %llu байт\n", viewer->keyframes, viewer->deltas,
+           (unsigned long long)viewer->payloadBytes);
+    TEST_ASSERT_TRUE(viewer->ws->open && !viewer->ws->closed);
+    TEST_ASSERT_GREATER_THAN(1, viewer->keyframes);
+    TEST_ASSERT_EQUAL(0, viewer->decodeErrors);
+    TEST_ASSERT_EQUAL(0, viewer->deltaWithoutBase);
+    TEST_ASSERT_EQUAL(0, viewer->unknownFrames);
+    TEST_ASSERT_EQUAL(0, host_audio_stats().gaps);
+    close_viewer(viewer);
+}
+
+// Нажатие кнопки на визуализаторе очищает буфер без flush, а кадр зеркала в это время
+// может ждать отправки из loop_web_events: уйти должен кадр с экрана, а не пустой буфер
+static void test_cleared_buffer_is_not_mirrored() {
+    String cookie = sim_login();
+    std::shared_ptr<MirrorViewer> viewer = open_viewer(cookie);
+    TEST_ASSERT_TRUE(viewer->ws->open);
+    uint64_t lastPress = 0;
+    uint32_t presses = 0;
+    run_watching([&]() {
+        uint64_t now = host_time_us();
+        if (now - lastPress >= 150000) {
+            currentDisplayMode = VISUALIZER;
+            reset_inactivity_timer();
+            lastPress = now;
+            presses++;
+        }
+        return false;
+    }, 5000000);
+
+    printf("  нажатий %u: ключевых %u, дельт %u\n", presses, viewer->keyframes, viewer->deltas);
+    TEST_ASSERT_GREATER_THAN(0, viewer->deltas);
+    TEST_ASSERT_EQUAL(0, viewer->decodeErrors);
+    TEST_ASSERT_EQUAL(0, viewer->unknownFrames);
+    close_viewer(viewer);
+}
+
+int main() {
+    sim_boot();
+    UNITY_BEGIN();
+    RUN_TEST(test_mirror_requires_session);
+    RUN_TEST(test_mirror_frames_match_screen);
+    RUN_TEST(test_third_viewer_is_refused);
+    RUN_TEST(test_slow_link_recovers_with_keyframe);
+    RUN_TEST(test_cleared_buffer_is_not_mirrored);
+    return UNITY_END();
+}
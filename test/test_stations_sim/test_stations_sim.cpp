@@ -0,0 +1,118 @@
+// === ЗАПИСИ СПИСКА СТАНЦИЙ ВО ФЛЕШ (ПК) ===
+// Прошивка целиком (test/sim) с 25 станциями: одни и те же 25 правок URL сначала
+// по одной (/api/update), потом одним пакетом (/api/stations/batch).
+// Проверяется:
+// - каждая одиночная правка - полная перезапись stations.json (25 сохранений);
+// - пакет - одно сохранение, байт не больше, чем у одной одиночной правки;
+// - правки пакета доходят до файла.
+
+#include <unity.h>
+#include <LittleFS.h>
+#include "sim_device.h"
+#include "config.h"
+#include "audio_manager.h"
+#include "telemetry.h"
+
+#define EDITED_STATIONS 25
+
+void setUp(void) {}
+void tearDown(void) {}
+
+struct FlashCounters {
+    unsigned long saves;
+    unsigned long stationBytes;
+    uint32_t flashBytes;   // Все записи: stations.json и лог
+};
+
+static FlashCounters counters() {
+    return {stationsSaveCount, stationsBytesWritten, flashBytesWritten.load()};
+}
+
+// URL той же длины в обоих проходах: размер файла после правок одинаковый
+static String edited_url(int station, char pass) {
+    return "http://stream.host/" + String(station) + ".mp3?" + String(pass);
+}
+
+static std::string form_value(const String& value) {
+    std::string out;
+    for (const char* p = value.c_str(); *p; p++) {
+        if (*p == ' ') out += '+';
+        else if (*p == ':' || *p == '/' || *p == '?') {
+            char hex[4];
+            snprintf(hex, sizeof(hex), "%%%02X", (unsigned char)*p);
+            out += hex;
+        } else out += *p;
+    }
+    return out;
+}
+
+static FlashCounters before;
+static unsigned long largestSingleSave = 0;
+
+static void test_single_edits_rewrite_the_file() {
+    TEST_ASSERT_TRUE(sim_run_until([]() { return audioState == AUDIO_PLAYING; }, 10000000));
+    String cookie = sim_login();
+    before = counters();
+    for (int i = 1; i <= EDITED_STATIONS; i++) {
+        String name = "Station " + String(i);
+        HostHttpRequest request;
+        request.method = "POST";
+        request.url = "/api/update";
+        request.headers.push_back(std::make_pair(String("Cookie"), cookie));
+        request.contentType = "application/x-www-form-urlencoded";
+        request.body = "originalName=" + form_value(name) + "&name=" + form_value(name) +
+                       "&url=" + form_value(edited_url(i, 'a'));
+        unsigned long bytes = stationsBytesWritten;
+        TEST_ASSERT_EQUAL(200, sim_fetch(request)->code);
+        sim_run_for(100000);  // Сохранение идет из loop() через очередь команд
+        if (stationsBytesWritten - bytes > largestSingleSave) largestSingleSave = stationsBytesWritten - bytes;
+    }
+    FlashCounters after = counters();
+    printf("  %d правок по одной: сохранений %lu, stations.json %lu байт (одно - до %lu), всего во флеш %lu\n",
+           EDITED_STATIONS, after.saves - before.saves, after.stationBytes - before.stationBytes,
+           largestSingleSave, (unsigned long)(after.flashBytes - before.flashBytes));
+    TEST_ASSERT_EQUAL(EDITED_STATIONS, after.saves - before.saves);
+    before = after;
+}
+
+static void test_batch_writes_once() {
+    String body = "{\"ops\":[";
+    for (int i = 1; i <= EDITED_STATIONS; i++) {
+        if (i > 1) body += ",";
+        String name = "Station " + String(i);
+        body += "{\"op\":\"update\",\"originalName\":\"" + name + "\",\"name\":\"" + name +
+                "\",\"url\":\"" + edited_url(i, 'b') + "\"}";
+    }
+    body += "]}";
+    HostHttpRequest request;
+    request.method = "POST";
+    request.url = "/api/stations/batch";
+    request.headers.push_back(std::make_pair(String("Cookie"), sim_login()));
+    request.contentType = "application/json";
+    request.body = body.c_str();
+    TEST_ASSERT_EQUAL(200, sim_fetch(request)->code);
+    sim_run_for(100000);
+
+    FlashCounters after = counters();
+    unsigned long batchBytes = after.stationBytes - before.stationBytes;
+    printf("  пакет из %d правок: сохранений %lu, stations.json %lu байт, всего во флеш %lu\n", EDITED_STATIONS,
+           after.saves - before.saves, batchBytes, (unsigned long)(after.flashBytes - before.flashBytes));
+    TEST_ASSERT_EQUAL(1, after.saves - before.saves);
+    TEST_ASSERT_TRUE(batchBytes > 0);
+    TEST_ASSERT_LESS_OR_EQUAL(largestSingleSave, batchBytes);
+
+    std::string saved = LittleFS.hostReadFile("/stations.json");
+    for (int i = 1; i <= EDITED_STATIONS; i++) {
+        TEST_ASSERT_TRUE(saved.find(edited_url(i, 'b').c_str()) != std::string::npos);
+    }
+}
+
+int main() {
+    SimOptions options;
+    options.stations = EDITED_STATIONS;
+    sim_boot(options);
+    UNITY_BEGIN();
+    RUN_TEST(test_single_edits_rewrite_the_file);
+    RUN_TEST(test_batch_writes_once);
+    return UNITY_END();
+}
@@ -0,0 +1,104 @@
+// === ВЕБ-СЕРВЕР ВО ВРЕМЯ ВОСПРОИЗВЕДЕНИЯ (ПК) ===
+// Прошивка целиком (test/sim) играет станцию, браузеры грузят страницу параллельно.
+// Страница отдается кусками по ACK (begin_sliced_file_response): между кусками
+// loop() с декодером работает, DMA I2S не пустеет.
+// Проверяется:
+// - несколько волн одновременных загрузок index.html - ни одного провала звука;
+// - тела ответов совпадают с файлом, куски chunked не больше WEB_FILE_CHUNK_MAX;
+// - медленная флеш-память: куски уменьшаются до бюджета WEB_FILE_CHUNK_BUDGET_US.
+
+#include <unity.h>
+#include <LittleFS.h>
+#include "sim_device.h"
+#include "config.h"
+#include "audio_manager.h"
+
+#define PAGE_LOADS_PER_WAVE 4
+#define PAGE_WAVES          5
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void print_stats(const char* label) {
+    const HostAudioStats& audio = host_audio_stats();
+    const SimLoopStats& loops = sim_loop_stats();
+    printf("  %s: кадров %u, провалов %u (%llu мкс), loop() макс %llu мкс, heap мин %u\n", label,
+           audio.frames, audio.gaps, (unsigned long long)audio.gapMicros, (unsigned long long)loops.maxGapUs,
+           ESP.getMinFreeHeap());
+}
+
+static void test_station_plays() {
+    TEST_ASSERT_TRUE(sim_run_until([]() { return audioState == AUDIO_PLAYING; }, 10000000));
+    host_audio_reset_stats();
+    sim_reset_loop_stats();
+    sim_run_for(3000000);
+    print_stats("без клиентов");
+    TEST_ASSERT_TRUE(host_audio_stats().frames > 0);
+    TEST_ASSERT_EQUAL(0, host_audio_stats().gaps);
+}
+
+static void test_concurrent_page_loads_keep_audio() {
+    String cookie = sim_login();
+    TEST_ASSERT_TRUE(cookie.startsWith("session="));
+    std::string page = LittleFS.hostReadFile("/index.html");
+
+    host_audio_reset_stats();
+    sim_reset_loop_stats();
+    host_heap_reset_min();
+    uint64_t worstLatency = 0;
+    for (int wave = 0; wave < PAGE_WAVES; wave++) {
+        std::vector<std::shared_ptr<HostHttpExchange>> loads;
+        for (int i = 0; i < PAGE_LOADS_PER_WAVE; i++) loads.push_back(host_http_get("/", cookie));
+        bool finished = sim_run_until([&]() {
+            for (auto& load : loads) {
+                if (!load->done && !load->failed) return false;
+            }
+            return true;
+        }, 10000000);
+        TEST_ASSERT_TRUE(finished);
+        for (auto& load : loads) {
+            TEST_ASSERT_TRUE(load->done);
+            TEST_ASSERT_EQUAL(200, load->code);
+            TEST_ASSERT_TRUE(load->chunked);
+            TEST_ASSERT_TRUE(load->body == page);
+            for (size_t chunk : load->chunks) TEST_ASSERT_TRUE(chunk <= WEB_FILE_CHUNK_MAX);
+            if (load->latencyUs() > worstLatency) worstLatency = load->latencyUs();
+        }
+        sim_run_for(500000);
+    }
+    printf("  %d x %d загрузок index.html (%u байт), худшая %llu мс\n", PAGE_WAVES, PAGE_LOADS_PER_WAVE,
+           (unsigned)page.size(), (unsigned long long)(worstLatency / 1000));
+    print_stats("с загрузками");
+    TEST_ASSERT_EQUAL(0, host_audio_stats().gaps);
+}
+
+// Чтение 1436 байт дольше бюджета: после первых кусков размер падает к WEB_FILE_CHUNK_MIN
+static void test_slow_flash_shrinks_chunks() {
+    String cookie = sim_login();
+    std::string page = LittleFS.hostReadFile("/index.html");
+    host_fs_set_cost(25, 2000, 60, 1000);
+    host_audio_reset_stats();
+    std::shared_ptr<HostHttpExchange> load = host_http_get("/", cookie);
+    sim_run_until([&]() { return load->done || load->failed; }, 10000000);
+    host_fs_set_cost(25, 200, 60, 1000);
+
+    TEST_ASSERT_TRUE(load->done);
+    TEST_ASSERT_TRUE(load->body == page);
+    TEST_ASSERT_GREATER_THAN(3, load->chunks.size());
+    // Последний кусок - остаток файла, первые три - путь вниз от WEB_FILE_CHUNK_MAX
+    for (size_t i = 3; i + 1 < load->chunks.size(); i++) {
+        TEST_ASSERT_LESS_OR_EQUAL(2 * WEB_FILE_CHUNK_MIN, load->chunks[i]);
+    }
+    printf("  медленная флеш: %u кусков, загрузка %llu мс\n", (unsigned)load->chunks.size(),
+           (unsigned long long)(load->latencyUs() / 1000));
+    TEST_ASSERT_EQUAL(0, host_audio_stats().gaps);
+}
+
+int main() {
+    sim_boot();
+    UNITY_BEGIN();
+    RUN_TEST(test_station_plays);
+    RUN_TEST(test_concurrent_page_loads_keep_audio);
+    RUN_TEST(test_slow_flash_shrinks_chunks);
+    return UNITY_END();
+}
@@ -0,0 +1,472 @@
+// === НАГРУЗОЧНЫЙ СТЕНД ВЕБ-API НА ПК ===
+// То же, что scripts/web_load_test.py, но без платы: прошивка целиком (test/sim)
+// играет станцию, обработчики web_server_manager.cpp отвечают через модель сети
+// (test/host/host_net.h), время виртуальное - прогон повторяем.
+//
+//   ./build-host/web_harness -c 4 -d 30 -s stations,logs,volume,page
+//   ./build-host/web_harness -c 2 -d 5 -s drag --drag-hz 60
+//   ./build-host/web_harness -c 2 -d 10 -s volume,control
+//
+// Параллельные клиенты гоняют сценарии: список станций, логи, изменение громкости
+// (серия из 5 POST /api/player/volume, каждый после ответа на предыдущий), загрузку
+// главной страницы и перетаскивание слайдера (drag: DRAG_POSTS POST громкости с
+// частотой --drag-hz, не дожидаясь ответов) и ту же серию громкости через канал
+// управления (control: WebSocket /api/control открыт один раз, команда - после
+// подтверждения предыдущей). Отчет:
+//   - задержка p50/p99/max по сценариям (со стороны клиента) и ошибки (503, обрывы, таймауты)
+//   - heap: пик занятого кодом прошивки и минимум свободного за прогон
+//   - голодание аудио: самый долгий промежуток между итерациями loop() и провалы DMA I2S
+//   - громкость одной командой: HTTP POST против /api/control, от отправки до ответа
+//     (модель сети ПК - на плате эти цифры не снимались)
+//   - почтовый ящик настроек по /api/metrics: каждая принятая запись применена или
+//     перезаписана более новой (при drag перезаписи обязаны быть), применение - не позже
+//     следующей итерации loop(), громкость в конце - последняя отправленная
+// Код выхода 1 - были обрывы/таймауты, провалы звука или нарушены условия почтового ящика (для ctest).
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_device.h"
+#include "audio_manager.h"
+
+static const char* const SCENARIOS[] = {"stations", "logs", "volume", "page", "drag", "control"};
+#define SCENARIO_COUNT    (sizeof(SCENARIOS) / sizeof(SCENARIOS[0]))
+#define VOLUME_BURST      5
+#define DRAG_POSTS        30
+#define CONTROL_VOLUME    0x01   // ControlOp в web_server_manager.cpp: [op][seq][громкость 0-100]
+#define REQUEST_TIMEOUT_US 10000000ULL
+
+struct HarnessOptions {
+    int clients = 4;
+    double durationSeconds = 30;
+    std::vector<String> mix;
+    double thinkSeconds = 0;
+    double dragHz = 60;      // input-события слайдера в браузере - частота кадров
+    uint32_t seed = 1;
+};
+
+struct ScenarioStats {
+    std::vector<uint64_t> latencyUs;
+    std::map<String, uint32_t> errors;   // "503", "обрыв", "таймаут"
+};
+
+// Клиент - конечный автомат: сценарий идет запросами, следующий запрос
+// отправляется между итерациями loop() после ответа на предыдущий
+struct VirtualClient {
+    const char* scenario = nullptr;
+    std::shared_ptr<HostHttpExchange> exchange;
+    std::vector<std::shared_ptr<HostHttpExchange>> dragPosts;  // drag: все POST в полете
+    std::shared_ptr<HostWebSocket> control;  // control: соединение живет между сценариями
+    size_t controlSeen = 0;                  // Сообщений канала уже разобрано
+    uint8_t controlSeq = 0;
+    bool controlInFlight = false;            // Команда отправлена, подтверждения нет
+    uint64_t scenarioStart = 0;
+    uint64_t requestStart = 0;
+    uint64_t nextAt = 0;
+    uint64_t nextPostAt = 0;
+    int volumeStep = 0;
+    float volume = 0;
+};
+
+static HarnessOptions options;
+static std::map<String, ScenarioStats> stats;
+static std::mt19937 rng;
+static String cookie;
+static float lastVolumePosted = -1;   // Значение последнего отправленного POST громкости
+static uint32_t volumePostsOk = 0;    // Ответов 200 на POST громкости и подтверждений "ok" канала
+static std::vector<uint64_t> httpVolumeUs;     // Одна команда громкости: POST -> ответ
+static std::vector<uint64_t> controlVolumeUs;  // Команда канала -> подтверждение
+
+static float uniform(float low, float high) {
+    return std::uniform_real_distribution<float>(low, high)(rng);
+}
+
+static std::shared_ptr<HostHttpExchange> send_request(const char* method, const char* url, const std::string& body) {
+    HostHttpRequest request;
+    request.method = method;
+    request.url = url;
+    request.headers.push_back(std::make_pair(String("Cookie"), cookie));
+    if (!body.empty()) {
+        request.contentType = "application/x-www-form-urlencoded";
+        request.body = body;
+    }
+    if (strcmp(url, "/") == 0) request.headers.push_back(std::make_pair(String("Accept-Encoding"), String("gzip")));
+    return host_http(request);
+}
+
+static void send_volume(VirtualClient& client) {
+    client.volume = std::min(1.0f, std::max(0.0f, client.volume + uniform(-0.05f, 0.05f)));
+    char body[32];
+    snprintf(body, sizeof(body), "volume=%.2f", client.volume);
+    lastVolumePosted = atof(body + 7);
+    client.exchange = send_request("POST", "/api/player/volume", body);
+}
+
+// drag: следующий POST по расписанию слайдера, ответы не ждем
+static void send_drag_posts(VirtualClient& client, uint64_t now) {
+    uint64_t periodUs = (uint64_t)(1000000 / options.dragHz);
+    while (client.dragPosts.size() < DRAG_POSTS && now >= client.nextPostAt) {
+        send_volume(client);
+        client.dragPosts.push_back(client.exchange);
+        client.requestStart = now;
+        client.nextPostAt += periodUs;
+    }
+}
+
+// control: следующая команда серии; seq в подтверждении связывает его с командой
+static void send_control_volume(VirtualClient& client, uint64_t now) {
+    client.volume = std::min(1.0f, std::max(0.0f, client.volume + uniform(-0.05f, 0.05f)));
+    uint8_t percent = (uint8_t)lroundf(client.volume * 100);
+    uint8_t command[3] = {CONTROL_VOLUME, ++client.controlSeq, percent};
+    lastVolumePosted = percent / 100.0f;
+    client.requestStart = now;
+    client.controlInFlight = true;
+    client.control->sendBinary(command, sizeof(command));
+}
+
+static void start_scenario(VirtualClient& client, uint64_t now) {
+    client.scenario = options.mix[std::uniform_int_distribution<size_t>(0, options.mix.size() - 1)(rng)].c_str();
+    client.scenarioStart = now;
+    client.requestStart = now;
+    if (strcmp(client.scenario, "stations") == 0) {
+        client.exchange = send_request("GET", "/api/stations", "");
+    } else if (strcmp(client.scenario, "logs") == 0) {
+        client.exchange = send_request("GET", "/api/logs", "");
+    } else if (strcmp(client.scenario, "page") == 0) {
+        client.exchange = send_request("GET", "/", "");
+    } else if (strcmp(client.scenario, "drag") == 0) {
+        client.volume = uniform(0.1f, 0.9f);
+        client.dragPosts.clear();
+        client.nextPostAt = now;
+        send_drag_posts(client, now);
+    } else if (strcmp(client.scenario, "control") == 0) {
+        client.volume = uniform(0.1f, 0.9f);
+        client.volumeStep = 0;
+        client.controlInFlight = false;
+        if (!client.control || client.control->closed) {
+            client.control = host_websocket("/api/control", {std::make_pair(String("Cookie"), cookie)});
+            client.controlSeen = 0;
+        }
+    } else {
+        client.volume = uniform(0.1f, 0.9f);
+        client.volumeStep = 0;
+        send_volume(client);
+    }
+}
+
+static void finish_scenario(VirtualClient& client, uint64_t now, const String& error) {
+    ScenarioStats& s = stats[client.scenario];
+    if (error.length()) {
+        s.errors[error]++;
+    } else {
+        s.latencyUs.push_back(now - client.scenarioStart);
+    }
+    client.exchange.reset();
+    client.dragPosts.clear();
+    client.scenario = nullptr;
+    client.nextAt = now + (uint64_t)(options.thinkSeconds * 1000000);
+}
+
+// drag закончен, когда отправлены и завершились все POST; ошибка - первая по порядку
+static void poll_drag(VirtualClient& client, uint64_t now) {
+    send_drag_posts(client, now);
+    if (client.dragPosts.size() < DRAG_POSTS) return;
+    for (auto& post : client.dragPosts) {
+        if (post->done || post->failed) continue;
+        if (now - client.requestStart <= REQUEST_TIMEOUT_US) return;
+        post->abort();
+    }
+    String error;
+    for (auto& post : client.dragPosts) {
+        if (post->done && post->code == 200) {
+            volumePostsOk++;
+        } else if (error.length() == 0) {
+            error = post->failed ? "обрыв" : !post->done ? "таймаут" : String(post->code);
+        }
+    }
+    finish_scenario(client, now, error);
+}
+
+// Соединение открылось - первая команда; ответ - следующая или конец серии
+static void poll_control(VirtualClient& client, uint64_t now) {
+    HostWebSocket& ws = *client.control;
+    if (ws.closed) {
+        // 1013 - все слоты канала заняты (WEB_CONTROL_MAX_CLIENTS)
+        finish_scenario(client, now, ws.closeCode == 1013 ? "1013" : "обрыв");
+        return;
+    }
+    if (!ws.open) {
+        if (now - client.requestStart > REQUEST_TIMEOUT_US) finish_scenario(client, now, "таймаут");
+        return;
+    }
+    if (!client.controlInFlight) {
+        send_control_volume(client, now);
+        return;
+    }
+    bool acked = false;
+    uint8_t status = 0;
+    uint64_t ackAt = 0;
+    for (; client.controlSeen < ws.messages.size(); client.controlSeen++) {
+        const HostWsMessage& message = ws.messages[client.controlSeen];
+        if (message.payload.size() == 3 && (uint8_t)message.payload[0] == (CONTROL_VOLUME | 0x80) &&
+            (uint8_t)message.payload[1] == client.controlSeq) {
+            acked = true;
+            status = message.payload[2];
+            ackAt = message.at;
+        }
+    }
+    if (!acked) {
+        if (now - client.requestStart > REQUEST_TIMEOUT_US) {
+            ws.close();
+            finish_scenario(client, now, "таймаут");
+        }
+        return;
+    }
+    if (status != 0) {
+        finish_scenario(client, now, "status " + String(status));
+        return;
+    }
+    volumePostsOk++;
+    controlVolumeUs.push_back(ackAt - client.requestStart);
+    client.controlInFlight = false;
+    if (++client.volumeStep < VOLUME_BURST) {
+        send_control_volume(client, now);
+        return;
+    }
+    finish_scenario(client, now, String());
+}
+
+// Между итерациями loop(): ответы, следующие запросы серии громкости, новые сценарии
+static void poll_client(VirtualClient& client, uint64_t now) {
+    if (!client.scenario) {
+        if (now >= client.nextAt) start_scenario(client, now);
+        return;
+    }
+    if (strcmp(client.scenario, "drag") == 0) {
+        poll_drag(client, now);
+        return;
+    }
+    if (strcmp(client.scenario, "control") == 0) {
+        poll_control(client, now);
+        return;
+    }
+    HostHttpExchange& exchange = *client.exchange;
+    if (!exchange.done && !exchange.failed) {
+        if (now - client.requestStart > REQUEST_TIMEOUT_US) {
+            exchange.abort();
+            finish_scenario(client, now, "таймаут");
+        }
+        return;
+    }
+    if (exchange.failed) {
+        finish_scenario(client, now, "обрыв");
+        return;
+    }
+    if (exchange.code != 200) {
+        finish_scenario(client, now, String(exchange.code));
+        return;
+    }
+    if (strcmp(client.scenario, "volume") == 0) {
+        volumePostsOk++;
+        httpVolumeUs.push_back(exchange.latencyUs());
+    }
+    if (strcmp(client.scenario, "volume") == 0 && ++client.volumeStep < VOLUME_BURST) {
+        client.requestStart = now;
+        send_volume(client);
+        return;
+    }
+    finish_scenario(client, now, String());
+}
+
+static uint64_t percentile(std::vector<uint64_t> values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, (size_t)(p / 100.0 * (values.size() - 1) + 0.5));
+    return values[index];
+}
+
+static String format_ms(const std::vector<uint64_t>& values, double p) {
+    if (values.empty()) return "-";
+    char text[16];
+    snprintf(text, sizeof(text), "%.1f", percentile(values, p) / 1000.0);
+    return text;
+}
+
+// Значение серии "name value" из /api/metrics (или -1)
+static double metric_value(const std::string& body, const char* series) {
+    std::string line = std::string("\n") + series + " ";
+    size_t at = body.find(line);
+    return at == std::string::npos ? -1 : atof(body.c_str() + at + line.size());
+}
+
+struct MailboxMetrics {
+    double posted, coalesced, applied, lagMaxSeconds;
+};
+
+static MailboxMetrics scrape_mailbox() {
+    HostHttpRequest request;
+    request.url = "/api/metrics";
+    request.headers.push_back(std::make_pair(String("Cookie"), cookie));
+    std::string body = sim_fetch(request)->body;
+    return MailboxMetrics{metric_value(body, "settings_posted_total"), metric_value(body, "settings_coalesced_total"),
+                          metric_value(body, "settings_apply_lag_seconds_count"),
+                          metric_value(body, "settings_apply_lag_max_seconds")};
+}
+
+static void usage(const char* name) {
+    printf("Использование: %s [-c клиентов] [-d секунд] [-s сценарии] [--think секунд] [--drag-hz n] [--seed n]\n"
+           "  сценарии через запятую: stations,logs,volume,page,drag,control\n", name);
+}
+
+static bool parse_args(int argc, char** argv) {
+    String scenarios = "stations,logs,volume,page";
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) return false;
+        if (strcmp(arg, "-c") == 0 || strcmp(arg, "--clients") == 0) {
+            options.clients = atoi(value);
+        } else if (strcmp(arg, "-d") == 0 || strcmp(arg, "--duration") == 0) {
+            options.durationSeconds = atof(value);
+        } else if (strcmp(arg, "-s") == 0 || strcmp(arg, "--scenarios") == 0) {
+            scenarios = value;
+        } else if (strcmp(arg, "--think") == 0) {
+            options.thinkSeconds = atof(value);
+        } else if (strcmp(arg, "--drag-hz") == 0) {
+            options.dragHz = atof(value);
+        } else if (strcmp(arg, "--seed") == 0) {
+            options.seed = (uint32_t)atol(value);
+        } else {
+            return false;
+        }
+        i++;
+    }
+    int start = 0;
+    while (start <= (int)scenarios.length()) {
+        int comma = scenarios.indexOf(',', start);
+        if (comma < 0) comma = scenarios.length();
+        String name = scenarios.substring(start, comma);
+        name.trim();
+        start = comma + 1;
+        if (name.length() == 0) continue;
+        bool known = false;
+        for (size_t i = 0; i < SCENARIO_COUNT; i++) known = known || name == SCENARIOS[i];
+        if (!known) {
+            printf("Неизвестный сценарий: %s\n", name.c_str());
+            return false;
+        }
+        options.mix.push_back(name);
+    }
+    return options.clients > 0 && options.durationSeconds > 0 && options.dragHz > 0 && !options.mix.empty();
+}
+
+int main(int argc, char** argv) {
+    if (!parse_args(argc, argv)) {
+        usage(argv[0]);
+        return 2;
+    }
+    rng.seed(options.seed);
+    sim_boot();
+    if (!sim_run_until([]() { return audioState == AUDIO_PLAYING; }, 10000000)) {
+        printf("Станция не заиграла - голодание не оценивается\n");
+        return 1;
+    }
+    cookie = sim_login();
+    if (!cookie.startsWith("session=")) {
+        printf("Вход не удался\n");
+        return 1;
+    }
+
+    MailboxMetrics mailboxBefore = scrape_mailbox();
+    std::vector<VirtualClient> clients(options.clients);
+    host_audio_reset_stats();
+    sim_reset_loop_stats();
+    host_heap_reset_min();
+    uint32_t heapInUseBefore = host_heap_in_use();
+    uint64_t deadline = host_time_us() + (uint64_t)(options.durationSeconds * 1000000);
+
+    // Новые сценарии до конца времени, затем ждем начатые
+    sim_run_until([&]() {
+        uint64_t now = host_time_us();
+        bool busy = false;
+        for (VirtualClient& client : clients) {
+            if (!client.scenario && now >= deadline) continue;
+            poll_client(client, now);
+            busy = busy || client.scenario;
+        }
+        return now >= deadline && !busy;
+    }, (uint64_t)(options.durationSeconds * 1000000) + REQUEST_TIMEOUT_US * 2);
+
+    const SimLoopStats& loops = sim_loop_stats();
+    uint64_t maxLoopGapUs = loops.maxGapUs;   // До снятия метрик: тот же прогон, что у клиентов
+    sim_run_for(100000);                      // Запись, пришедшая на последней итерации
+    MailboxMetrics mailbox = scrape_mailbox();
+
+    uint32_t transportErrors = 0;
+    printf("\n== Клиент: %d x %.0f с (виртуальных), сценарии", options.clients, options.durationSeconds);
+    for (size_t i = 0; i < options.mix.size(); i++) printf("%s%s", i ? "," : " ", options.mix[i].c_str());
+    printf(" ==\n%-10s %6s %8s %8s %8s  ошибки\n", "сценарий", "ok", "p50 мс", "p99 мс", "max мс");
+    for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+        if (std::find(options.mix.begin(), options.mix.end(), String(SCENARIOS[i])) == options.mix.end()) continue;
+        ScenarioStats& s = stats[SCENARIOS[i]];
+        String errors;
+        for (auto& error : s.errors) {
+            if (errors.length()) errors += ", ";
+            errors += error.first + ": " + String(error.second);
+            if (error.first == "обрыв" || error.first == "таймаут") transportErrors += error.second;
+        }
+        printf("%-10s %6u %8s %8s %8s  %s\n", SCENARIOS[i], (unsigned)s.latencyUs.size(),
+               format_ms(s.latencyUs, 50).c_str(), format_ms(s.latencyUs, 99).c_str(),
+               format_ms(s.latencyUs, 100).c_str(), errors.length() ? errors.c_str() : "-");
+    }
+
+    const HostAudioStats& audio = host_audio_stats();
+    printf("\n== Heap и аудио ==\n");
+    printf("heap прошивки: было занято %u байт, пик %u байт, минимум свободного %u из %u байт\n",
+           heapInUseBefore, host_heap_peak(), ESP.getMinFreeHeap(), ESP.getHeapSize());
+    printf("loop(): %llu итераций, средний промежуток %llu мкс, максимум %llu мкс\n",
+           (unsigned long long)loops.loops, (unsigned long long)(loops.loops ? loops.totalGapUs / loops.loops : 0),
+           (unsigned long long)maxLoopGapUs);
+    printf("декодер: %u кадров, провалов DMA %u (тишина %llu мс, самая долгая %llu мс)\n", audio.frames,
+           audio.gaps, (unsigned long long)(audio.gapMicros / 1000), (unsigned long long)(audio.maxGapMicros / 1000));
+
+    // Одна и та же команда двумя путями; время - модели сети ПК, не платы
+    if (!httpVolumeUs.empty() || !controlVolumeUs.empty()) {
+        printf("\n== Громкость одной командой: HTTP против /api/control (модель ПК, не плата) ==\n");
+        printf("%-24s %6s %8s %8s %8s\n", "путь", "команд", "p50 мс", "p99 мс", "max мс");
+        printf("%-24s %6u %8s %8s %8s\n", "POST /api/player/volume", (unsigned)httpVolumeUs.size(),
+               format_ms(httpVolumeUs, 50).c_str(), format_ms(httpVolumeUs, 99).c_str(),
+               format_ms(httpVolumeUs, 100).c_str());
+        printf("%-24s %6u %8s %8s %8s\n", "WS /api/control", (unsigned)controlVolumeUs.size(),
+               format_ms(controlVolumeUs, 50).c_str(), format_ms(controlVolumeUs, 99).c_str(),
+               format_ms(controlVolumeUs, 100).c_str());
+    }
+
+    // Почтовый ящик: только громкость, поэтому каждая запись либо применена (свой
+    // проход applyPendingSettings), либо перезаписана следующей до применения
+    bool mailboxOk = true;
+    double posted = mailbox.posted - mailboxBefore.posted;
+    if (volumePostsOk > 0) {
+        double coalesced = mailbox.coalesced - mailboxBefore.coalesced;
+        double applied = mailbox.applied - mailboxBefore.applied;
+        // drag шлет быстрее итерации с кадром дисплея - без перезаписей ящик не работает
+        bool dragged = stats["drag"].latencyUs.size() > 0;
+        bool accounted = posted == volumePostsOk && posted == coalesced + applied && (!dragged || coalesced > 0);
+        bool lagBounded = mailbox.lagMaxSeconds * 1000000 <= maxLoopGapUs;
+        bool lastWins = fabsf(volume - lastVolumePosted) < 0.001f;
+        mailboxOk = accounted && lagBounded && lastWins;
+        printf("\n== Почтовый ящик настроек (/api/metrics) ==\n");
+        printf("записей %.0f (ответов 200: %u), перезаписано до применения %.0f, применений %.0f%s\n", posted,
+               volumePostsOk, coalesced, applied, accounted ? "" : "  <- не сходится");
+        printf("задержка применения: макс. %.2f мс, самый долгий промежуток loop() %.2f мс%s\n",
+               mailbox.lagMaxSeconds * 1000, maxLoopGapUs / 1000.0, lagBounded ? "" : "  <- дольше итерации");
+        printf("громкость %.2f, последняя отправленная %.2f%s\n", volume, lastVolumePosted,
+               lastWins ? "" : "  <- не последняя");
+    }
+
+    return transportErrors == 0 && audio.gaps == 0 && mailboxOk ? 0 : 1;
+}